@@ -273,7 +273,7 @@ bool StartDB()
     }
 
     // NOTE: While authserver is singlethreaded you should keep synch_threads == 1. Increasing it is just silly since only 1 will be used ever.
-    if (!LoginDatabase.Initialize(dbstring.c_str()))
+    if (!LoginDatabase.Initialize(dbstring.c_str(), synch_threads))
     {
         sLog->outError("Cannot connect to database");
         return false;
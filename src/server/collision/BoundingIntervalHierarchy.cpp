@@ -20,6 +20,9 @@
 
 #include "BoundingIntervalHierarchy.h"
 
+#include <ace/Atomic_Op.h>
+#include <ace/Thread_Mutex.h>
+
 void BIH::buildHierarchy(std::vector<uint32> &tempTree, buildData &dat, BuildStats &stats)
 {
     // create space for the first node
@@ -305,3 +308,16 @@ void BIH::BuildStats::printStats()
     printf("  * BVH2 nodes:     %d (%3d%%)\n", numBVH2, 100 * numBVH2 / (numNodes + numLeaves - 2 * numBVH2));
 }
 
+
+// written by a config reload while the map threads trace rays
+static ACE_Atomic_Op<ACE_Thread_Mutex, long> raySimdEnabled(1);
+
+bool isRaySimdEnabled()
+{
+    return raySimdEnabled.value() != 0;
+}
+
+void setRaySimdEnabled(bool enable)
+{
+    raySimdEnabled = enable ? 1 : 0;
+}
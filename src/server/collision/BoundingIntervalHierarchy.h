@@ -35,6 +35,16 @@
 
 #define MAX_STACK_SIZE 64
 
+// 4 wide ray packets and triangle tests, SSE2 is part of every x86-64 cpu
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define BIH_SSE2
+#endif
+
+// the SSE2 paths are used while enabled (vmap.enableSimd), the scalar ones otherwise
+bool isRaySimdEnabled();
+void setRaySimdEnabled(bool enable);
+
 #ifdef _MSC_VER
     #define isnan(x) _isnan(x)
 #else
@@ -119,6 +129,39 @@ class BIH
 
         template<typename RayCallback>
         void intersectRay(const Ray &r, RayCallback& intersectCallback, float &maxDist, bool stopAtFirst=false) const
+        {
+            ObjectLeafCallback<RayCallback> leafCallback(intersectCallback);
+            intersectRayLeaves(r, leafCallback, maxDist, stopAtFirst);
+        }
+
+        /* Traces count rays in packets of 4 through the tree, every node is fetched once per packet.
+           intersectCallback(rayIndex, ray, entry, maxDist, stopAtFirst) works like the callback
+           of intersectRay, maxDist holds the distance of every ray. */
+        template<typename PacketCallback>
+        void intersectRayPacket(const Ray* rays, uint32 count, PacketCallback& intersectCallback, float* maxDist, bool stopAtFirst=false) const
+        {
+            for (uint32 first = 0; first < count; first += 4)
+            {
+                uint32 n = std::min<uint32>(count - first, 4);
+#ifdef BIH_SSE2
+                if (isRaySimdEnabled())
+                {
+                    intersectPacket4(rays + first, first, n, intersectCallback, maxDist + first, stopAtFirst);
+                    continue;
+                }
+#endif
+                for (uint32 i = 0; i < n; ++i)
+                {
+                    PacketLaneCallback<PacketCallback> laneCallback(intersectCallback, first + i);
+                    intersectRay(rays[first + i], laneCallback, maxDist[first + i], stopAtFirst);
+                }
+            }
+        }
+
+        /* intersectRay with one call per leaf, leafCallback(ray, entries, count, maxDist, stopAtFirst)
+           gets the objects of the leaf and returns true if one was hit. */
+        template<typename LeafCallback>
+        void intersectRayLeaves(const Ray &r, LeafCallback& leafCallback, float &maxDist, bool stopAtFirst=false) const
         {
             float intervalMin = -1.f;
             float intervalMax = -1.f;
@@ -216,12 +259,8 @@ class BIH
                         {
                             // leaf - test some objects
                             int n = tree[node + 1];
-                            while (n > 0) {
-                                bool hit = intersectCallback(r, objects[offset], maxDist, stopAtFirst);
-                                if (stopAtFirst && hit) return;
-                                --n;
-                                ++offset;
-                            }
+                            if (n > 0 && leafCallback(r, &objects[offset], n, maxDist, stopAtFirst) && stopAtFirst)
+                                return;
                             break;
                         }
                     }
@@ -342,6 +381,196 @@ class BIH
         std::vector<uint32> objects;
         AABox bounds;
 
+        // calls the per object callback of intersectRay for each object of a leaf
+        template<typename RayCallback>
+        struct ObjectLeafCallback
+        {
+            ObjectLeafCallback(RayCallback& cb) : callback(cb) {}
+            bool operator()(const Ray& r, const uint32* entries, int count, float& maxDist, bool stopAtFirst)
+            {
+                for (int i = 0; i < count; ++i)
+                    if (callback(r, entries[i], maxDist, stopAtFirst) && stopAtFirst)
+                        return true;
+                return false;
+            }
+            RayCallback& callback;
+        };
+
+        // a single ray of intersectRayPacket traced with intersectRay
+        template<typename PacketCallback>
+        struct PacketLaneCallback
+        {
+            PacketLaneCallback(PacketCallback& cb, uint32 index) : callback(cb), rayIndex(index) {}
+            bool operator()(const Ray& r, uint32 entry, float& maxDist, bool stopAtFirst)
+            {
+                return callback(rayIndex, r, entry, maxDist, stopAtFirst);
+            }
+            PacketCallback& callback;
+            uint32 rayIndex;
+        };
+
+#ifdef BIH_SSE2
+        struct PacketStackNode
+        {
+            __m128 tnear;
+            __m128 tfar;
+            uint32 node;
+        };
+
+        static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        /* Up to 4 rays at once, every lane has its own [tnear, tfar] interval and a lane is
+           active while tnear <= tfar. Children are visited when any lane enters them, the
+           order does not matter for any hit queries and only costs a few more leaves for
+           the closest hit ones. */
+        template<typename PacketCallback>
+        void intersectPacket4(const Ray* rays, uint32 firstIndex, uint32 n, PacketCallback& intersectCallback, float* maxDist, bool stopAtFirst) const
+        {
+            float org[3][4], invDir[3][4], limit[4];
+            for (uint32 i = 0; i < 4; ++i)
+            {
+                // unused lanes repeat the first ray with an empty interval
+                const Ray& r = rays[i < n ? i : 0];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float d = r.direction()[axis];
+                    org[axis][i] = r.origin()[axis];
+                    // a huge finite factor instead of inf keeps 0 * inf NaNs out of the interval math
+                    invDir[axis][i] = fabs(d) > 1e-20f ? 1.f / d : (d < 0.f ? -1e30f : 1e30f);
+                }
+                limit[i] = i < n ? maxDist[i] : -1.f;
+            }
+
+            __m128 o[3], inv[3], neg[3];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                o[axis] = _mm_loadu_ps(org[axis]);
+                inv[axis] = _mm_loadu_ps(invDir[axis]);
+                neg[axis] = _mm_cmplt_ps(inv[axis], _mm_setzero_ps());
+            }
+
+            // clip against the bounds of the tree
+            __m128 tmin = _mm_setzero_ps();
+            __m128 tmax = _mm_loadu_ps(limit);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds.low()[axis]), o[axis]), inv[axis]);
+                __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds.high()[axis]), o[axis]), inv[axis]);
+                tmin = _mm_max_ps(tmin, _mm_min_ps(t1, t2));
+                tmax = _mm_min_ps(tmax, _mm_max_ps(t1, t2));
+            }
+
+            PacketStackNode stack[MAX_STACK_SIZE];
+            int stackPos = 0;
+            uint32 node = 0;
+            if (!_mm_movemask_ps(_mm_cmple_ps(tmin, tmax)))
+                return;
+
+            while (true) {
+                while (true)
+                {
+                    uint32 tn = tree[node];
+                    uint32 axis = (tn & (3 << 30)) >> 30;
+                    bool BVH2 = tn & (1 << 29);
+                    uint32 offset = tn & ~(7 << 29);
+                    if (!BVH2)
+                    {
+                        if (axis < 3)
+                        {
+                            // left child below the left clip plane, right child above the right one
+                            __m128 tl = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(intBitsToFloat(tree[node + 1])), o[axis]), inv[axis]);
+                            __m128 tr = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(intBitsToFloat(tree[node + 2])), o[axis]), inv[axis]);
+                            __m128 leftMin = select(neg[axis], _mm_max_ps(tmin, tl), tmin);
+                            __m128 leftMax = select(neg[axis], tmax, _mm_min_ps(tmax, tl));
+                            __m128 rightMin = select(neg[axis], tmin, _mm_max_ps(tmin, tr));
+                            __m128 rightMax = select(neg[axis], _mm_min_ps(tmax, tr), tmax);
+                            bool left = _mm_movemask_ps(_mm_cmple_ps(leftMin, leftMax)) != 0;
+                            bool right = _mm_movemask_ps(_mm_cmple_ps(rightMin, rightMax)) != 0;
+                            if (left && right)
+                            {
+                                stack[stackPos].node = offset + 3;
+                                stack[stackPos].tnear = rightMin;
+                                stack[stackPos].tfar = rightMax;
+                                stackPos++;
+                            }
+                            if (left)
+                            {
+                                node = offset;
+                                tmin = leftMin;
+                                tmax = leftMax;
+                                continue;
+                            }
+                            if (right)
+                            {
+                                node = offset + 3;
+                                tmin = rightMin;
+                                tmax = rightMax;
+                                continue;
+                            }
+                            break;
+                        }
+                        else
+                        {
+                            // leaf - test the objects with every lane that reaches it
+                            float laneMin[4], laneMax[4];
+                            _mm_storeu_ps(laneMin, tmin);
+                            _mm_storeu_ps(laneMax, tmax);
+                            uint32 count = tree[node + 1];
+                            bool lanesLeft = false;
+                            for (uint32 i = 0; i < n; ++i)
+                            {
+                                if (limit[i] < 0.f)
+                                    continue;
+                                bool done = false;
+                                if (laneMin[i] <= laneMax[i])
+                                {
+                                    for (uint32 k = 0; k < count && !done; ++k)
+                                        done = intersectCallback(firstIndex + i, rays[i], objects[offset + k], maxDist[i], stopAtFirst) && stopAtFirst;
+                                }
+                                // closest hit queries shrink the lane, any hit queries finish it
+                                limit[i] = done ? -1.f : maxDist[i];
+                                lanesLeft |= !done;
+                            }
+                            if (!lanesLeft)
+                                return;
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        if (axis>2)
+                            return; // should not happen
+                        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(intBitsToFloat(tree[node + 1])), o[axis]), inv[axis]);
+                        __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(intBitsToFloat(tree[node + 2])), o[axis]), inv[axis]);
+                        node = offset;
+                        tmin = _mm_max_ps(tmin, _mm_min_ps(t1, t2));
+                        tmax = _mm_min_ps(tmax, _mm_max_ps(t1, t2));
+                        if (!_mm_movemask_ps(_mm_cmple_ps(tmin, tmax)))
+                            break;
+                        continue;
+                    }
+                } // traversal loop
+                do
+                {
+                    // stack is empty?
+                    if (stackPos == 0)
+                        return;
+                    // move back up the stack, lanes that hit meanwhile are clipped away
+                    stackPos--;
+                    tmin = stack[stackPos].tnear;
+                    tmax = _mm_min_ps(stack[stackPos].tfar, _mm_loadu_ps(limit));
+                    if (!_mm_movemask_ps(_mm_cmple_ps(tmin, tmax)))
+                        continue;
+                    node = stack[stackPos].node;
+                    break;
+                } while (true);
+            }
+        }
+#endif
+
         struct buildData
         {
             uint32 *indices;
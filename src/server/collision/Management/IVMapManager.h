@@ -38,6 +38,14 @@ namespace VMAP
     #define VMAP_INVALID_HEIGHT       -100000.0f            // for check
     #define VMAP_INVALID_HEIGHT_VALUE -200000.0f            // real assigned value in unknown height case
 
+    // one line of sight check of a batch, see IVMapManager::isInLineOfSight
+    struct LineOfSightRay
+    {
+        float x1, y1, z1;
+        float x2, y2, z2;
+        bool result;                                        // set by the check
+    };
+
     class IVMapManager
     {
         private:
@@ -57,6 +65,8 @@ namespace VMAP
             virtual void unloadMap(unsigned int pMapId) = 0;
 
             virtual bool isInLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2) = 0;
+            // checks all rays of one map with a single lookup of its tree, sets their result
+            virtual void isInLineOfSight(unsigned int pMapId, LineOfSightRay* rays, uint32 count) = 0;
             virtual float getHeight(unsigned int pMapId, float x, float y, float z, float maxSearchDist) = 0;
             /*
             test if we hit an object. return true if we hit one. rx, ry, rz will hold the hit position or the dest position, if no intersection was found
@@ -78,6 +88,16 @@ namespace VMAP
             It is enabled by default. If it is enabled in mid game the maps have to loaded manualy
             */
             void setEnableHeightCalc(bool pVal) { iEnableHeightCalc = pVal; }
+            /*
+            Enable/disable the SSE2 ray packet and triangle kernels, the scalar code is used otherwise
+            */
+            virtual void setEnableRaySimd(bool pVal) = 0;
+            /*
+            Append the line of sight queries passed to recordLineOfSight to this file, an empty path stops recording.
+            The maps record every query they are asked, including the ones answered by their cache.
+            */
+            virtual bool setLineOfSightRecordFile(const std::string& path) = 0;
+            virtual void recordLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2) = 0;
 
             bool isLineOfSightCalcEnabled() const { return(iEnableLineOfSightCalc); }
             bool isHeightCalcEnabled() const { return(iEnableHeightCalc); }
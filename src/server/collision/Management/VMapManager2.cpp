@@ -28,12 +28,13 @@
 #include <iomanip>
 #include <string>
 #include <sstream>
+#include <vector>
 
 using G3D::Vector3;
 
 namespace VMAP
 {
-    VMapManager2::VMapManager2()
+    VMapManager2::VMapManager2() : iLosRecordFile(NULL), iLosRecording(0)
     {
     }
 
@@ -47,6 +48,56 @@ namespace VMAP
         {
             delete i->second.getModel();
         }
+        if (iLosRecordFile)
+            fclose(iLosRecordFile);
+    }
+
+    void VMapManager2::setEnableRaySimd(bool pVal)
+    {
+        setRaySimdEnabled(pVal);
+    }
+
+    bool VMapManager2::setLineOfSightRecordFile(const std::string& path)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLosRecordLock, false);
+        iLosRecording = 0;
+        if (iLosRecordFile)
+        {
+            fclose(iLosRecordFile);
+            iLosRecordFile = NULL;
+        }
+        if (path.empty())
+            return true;
+
+        iLosRecordFile = fopen(path.c_str(), "wb");
+        if (!iLosRecordFile)
+            return false;
+        uint32 version = LOS_RECORD_VERSION;
+        if (fwrite(LOS_RECORD_MAGIC, 1, 4, iLosRecordFile) != 4 || fwrite(&version, sizeof(uint32), 1, iLosRecordFile) != 1)
+        {
+            fclose(iLosRecordFile);
+            iLosRecordFile = NULL;
+            return false;
+        }
+        iLosRecording = 1;
+        return true;
+    }
+
+    void VMapManager2::recordLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2)
+    {
+        if (!iLosRecording.value())
+            return;
+
+        // the file may have been closed by a config reload since the flag was read
+        ACE_GUARD(ACE_Thread_Mutex, guard, iLosRecordLock);
+        if (!iLosRecordFile)
+            return;
+
+        LineOfSightRecord record;
+        record.mapId = pMapId;
+        record.x1 = x1; record.y1 = y1; record.z1 = z1;
+        record.x2 = x2; record.y2 = y2; record.z2 = z2;
+        fwrite(&record, sizeof(LineOfSightRecord), 1, iLosRecordFile);
     }
 
     Vector3 VMapManager2::convertPositionToInternalRep(float x, float y, float z) const
@@ -153,6 +204,32 @@ namespace VMAP
         return result;
     }
 
+    void VMapManager2::isInLineOfSight(unsigned int pMapId, LineOfSightRay* rays, uint32 count)
+    {
+        if (!count)
+            return;
+
+        InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.find(pMapId);
+        if (!isLineOfSightCalcEnabled() || instanceTree == iInstanceMapTrees.end())
+        {
+            for (uint32 i = 0; i < count; ++i)
+                rays[i].result = true;
+            return;
+        }
+
+        std::vector<Vector3> pos1(count), pos2(count);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            pos1[i] = convertPositionToInternalRep(rays[i].x1, rays[i].y1, rays[i].z1);
+            pos2[i] = convertPositionToInternalRep(rays[i].x2, rays[i].y2, rays[i].z2);
+        }
+
+        std::vector<uint8> results(count);
+        instanceTree->second->isInLineOfSight(&pos1[0], &pos2[0], &results[0], count);
+        for (uint32 i = 0; i < count; ++i)
+            rays[i].result = results[i] != 0;
+    }
+
     /*
     get the hit position and return true if we hit something
     otherwise the result pos will be the dest pos
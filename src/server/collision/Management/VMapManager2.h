@@ -26,10 +26,18 @@
 #include "Define.h"
 #include "G3D/Vector3.h"
 
+#include <ace/Atomic_Op.h>
+#include <ace/Thread_Mutex.h>
+#include <cstdio>
+
 #define MAP_FILENAME_EXTENSION2 ".vmtree"
 
 #define FILENAMEBUFFER_SIZE 500
 
+// recorded line of sight queries, header followed by LineOfSightRecord entries
+#define LOS_RECORD_MAGIC "LOSQ"
+#define LOS_RECORD_VERSION 1
+
 /*
 This is the main Class to manage loading and unloading of maps, line of sight, height calculation and so on.
 For each map or map tile to load it reads a directory file that contains the ModelContainer files used by this map or map tile.
@@ -56,6 +64,13 @@ namespace VMAP
             int iRefCount;
     };
 
+    struct LineOfSightRecord
+    {
+        uint32 mapId;
+        float x1, y1, z1;
+        float x2, y2, z2;
+    };
+
     typedef UNORDERED_MAP<uint32 , StaticMapTree *> InstanceTreeMap;
     typedef UNORDERED_MAP<std::string, ManagedModel> ModelFileMap;
 
@@ -66,6 +81,12 @@ namespace VMAP
             ModelFileMap iLoadedModelFiles;
             InstanceTreeMap iInstanceMapTrees;
 
+            // queries are appended to this file while it is open, iLosRecording lets the
+            // map threads skip the lock while nothing is recorded
+            FILE* iLosRecordFile;
+            ACE_Thread_Mutex iLosRecordLock;
+            ACE_Atomic_Op<ACE_Thread_Mutex, long> iLosRecording;
+
             bool _loadMap(uint32 pMapId, const std::string &basePath, uint32 tileX, uint32 tileY);
             /* void _unloadMap(uint32 pMapId, uint32 x, uint32 y); */
 
@@ -84,6 +105,7 @@ namespace VMAP
             void unloadMap(unsigned int pMapId);
 
             bool isInLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2) ;
+            void isInLineOfSight(unsigned int pMapId, LineOfSightRay* rays, uint32 count);
             // fill the hit pos and return true, if an object was hit
             bool getObjectHitPos(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float &ry, float& rz, float pModifyDist);
             float getHeight(unsigned int pMapId, float x, float y, float z, float maxSearchDist);
@@ -102,6 +124,13 @@ namespace VMAP
                 return getMapFileName(pMapId);
             }
             virtual bool existsMap(const char* pBasePath, unsigned int pMapId, int x, int y);
+
+            const InstanceTreeMap& getInstanceMapTree() const { return iInstanceMapTrees; }
+
+            void setEnableRaySimd(bool pVal);
+            // starts recording the line of sight queries for replaying them with the vmap benchmark, empty path stops it
+            bool setLineOfSightRecordFile(const std::string& path);
+            void recordLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2);
     };
 }
 #endif
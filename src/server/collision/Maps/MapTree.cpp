@@ -49,6 +49,22 @@ namespace VMAP
             bool hit;
     };
 
+    class MapPacketRayCallback
+    {
+        public:
+            MapPacketRayCallback(ModelInstance *val, uint8* hits): prims(val), hit(hits) {}
+            bool operator()(uint32 rayIndex, const G3D::Ray& ray, uint32 entry, float& distance, bool pStopAtFirstHit=true)
+            {
+                bool result = prims[entry].intersectRay(ray, distance, pStopAtFirstHit);
+                if (result)
+                    hit[rayIndex] = 1;
+                return result;
+            }
+        protected:
+            ModelInstance *prims;
+            uint8* hit;
+    };
+
     class AreaInfoCallback
     {
         public:
@@ -162,6 +178,40 @@ namespace VMAP
         return true;
     }
 
+    void StaticMapTree::isInLineOfSight(const Vector3* pos1, const Vector3* pos2, uint8* results, uint32 count) const
+    {
+        // rays too short to trace are always in line of sight, the rest goes through the tree as packets
+        std::vector<G3D::Ray> rays;
+        std::vector<float> maxDist;
+        std::vector<uint32> rayIndex;
+        rays.reserve(count);
+        maxDist.reserve(count);
+        rayIndex.reserve(count);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            float dist = (pos2[i] - pos1[i]).magnitude();
+            ASSERT(dist < std::numeric_limits<float>::max());
+            if (dist < 1e-10f)
+                continue;
+            rays.push_back(G3D::Ray::fromOriginAndDirection(pos1[i], (pos2[i] - pos1[i])/dist));
+            maxDist.push_back(dist);
+            rayIndex.push_back(i);
+        }
+
+        std::vector<uint8> hits(rays.size(), 0);
+        if (!rays.empty())
+        {
+            MapPacketRayCallback intersectionCallBack(iTreeValues, &hits[0]);
+            iTree.intersectRayPacket(&rays[0], rays.size(), intersectionCallBack, &maxDist[0], true);
+        }
+
+        for (uint32 i = 0; i < count; ++i)
+            results[i] = 1;
+        for (uint32 i = 0; i < rays.size(); ++i)
+            if (hits[i])
+                results[rayIndex[i]] = 0;
+    }
+
     /*
     When moving from pos1 to pos2 check if we hit an object. Return true and the position if we hit one
     Return the hit pos or the original dest pos
@@ -71,6 +71,8 @@ namespace VMAP
             ~StaticMapTree();
 
             bool isInLineOfSight(const G3D::Vector3& pos1, const G3D::Vector3& pos2) const;
+            // line of sight from each pos1 to the pos2 of the same index, results gets 1 or 0 per ray
+            void isInLineOfSight(const G3D::Vector3* pos1, const G3D::Vector3* pos2, uint8* results, uint32 count) const;
             bool getObjectHitPos(const G3D::Vector3& pos1, const G3D::Vector3& pos2, G3D::Vector3& pResultHitPos, float pModifyDist) const;
             float getHeight(const G3D::Vector3& pPos, float maxSearchDist) const;
             bool getAreaInfo(G3D::Vector3 &pos, uint32 &flags, int32 &adtId, int32 &rootId, int32 &groupId) const;
@@ -82,6 +84,8 @@ namespace VMAP
             void UnloadMapTile(uint32 tileX, uint32 tileY, VMapManager2 *vm);
             bool isTiled() const { return iIsTiled; }
             uint32 numLoadedTiles() const { return iLoadedTiles.size(); }
+            // all spawns of the map, only those of loaded tiles have their model set
+            void getModelInstances(ModelInstance* &models, uint32 &count) const { models = iTreeValues; count = iNTreeValues; }
     };
 
     struct AreaInfo
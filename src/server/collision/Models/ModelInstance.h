@@ -68,6 +68,7 @@ namespace VMAP
             ModelInstance(): iModel(0) {}
             ModelInstance(const ModelSpawn &spawn, WorldModel *model);
             void setUnloaded() { iModel = 0; }
+            WorldModel* getWorldModel() const { return iModel; }
             bool intersectRay(const G3D::Ray& pRay, float& pMaxDist, bool pStopAtFirstHit) const;
             void intersectPoint(const G3D::Vector3& p, AreaInfo &info) const;
             bool GetLocationInfo(const G3D::Vector3& p, LocationInfo &info) const;
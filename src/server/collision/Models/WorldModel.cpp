@@ -82,6 +82,72 @@ namespace VMAP
         return false;
     }
 
+#ifdef BIH_SSE2
+    /* IntersectTriangle for up to 4 triangles at once, count below 4 repeats the last
+       triangle. Same tests as above, distance gets the closest hit of all of them. */
+    bool IntersectTriangles4(const MeshTriangle* const* tris, uint32 count, std::vector<Vector3>::const_iterator points, const G3D::Ray &ray, float &distance)
+    {
+        float v0[3][4], e1[3][4], e2[3][4];
+        for (uint32 i = 0; i < 4; ++i)
+        {
+            const MeshTriangle& tri = *tris[i < count ? i : count - 1];
+            const Vector3& p0 = points[tri.idx0];
+            const Vector3& p1 = points[tri.idx1];
+            const Vector3& p2 = points[tri.idx2];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                v0[axis][i] = p0[axis];
+                e1[axis][i] = p1[axis] - p0[axis];
+                e2[axis][i] = p2[axis] - p0[axis];
+            }
+        }
+
+        const __m128 e1x = _mm_loadu_ps(e1[0]), e1y = _mm_loadu_ps(e1[1]), e1z = _mm_loadu_ps(e1[2]);
+        const __m128 e2x = _mm_loadu_ps(e2[0]), e2y = _mm_loadu_ps(e2[1]), e2z = _mm_loadu_ps(e2[2]);
+        const __m128 dx = _mm_set1_ps(ray.direction().x), dy = _mm_set1_ps(ray.direction().y), dz = _mm_set1_ps(ray.direction().z);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        // p = dir x e2, a = e1 . p
+        const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        const __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        const __m128 absA = _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+        __m128 valid = _mm_cmpge_ps(absA, _mm_set1_ps(1e-5f));
+        if (!_mm_movemask_ps(valid))
+            return false;
+
+        const __m128 f = _mm_div_ps(one, a);
+        const __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin().x), _mm_loadu_ps(v0[0]));
+        const __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin().y), _mm_loadu_ps(v0[1]));
+        const __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin().z), _mm_loadu_ps(v0[2]));
+        const __m128 u = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+
+        // q = s x e1
+        const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        const __m128 v = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+
+        const __m128 t = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, _mm_set1_ps(distance))));
+
+        int mask = _mm_movemask_ps(valid);
+        if (!mask)
+            return false;
+
+        float dist[4];
+        _mm_storeu_ps(dist, t);
+        for (uint32 i = 0; i < 4; ++i)
+            if ((mask & (1 << i)) && dist[i] < distance)
+                distance = dist[i];
+        return true;
+    }
+#endif
+
     class TriBoundFunc
     {
         public:
@@ -353,6 +419,33 @@ namespace VMAP
             if (result)  hit=true;
             return hit;
         }
+        // all triangles of a BIH leaf, 4 at a time
+        bool operator()(const G3D::Ray& ray, const uint32* entries, int count, float& distance, bool pStopAtFirstHit)
+        {
+#ifdef BIH_SSE2
+            if (count > 1 && isRaySimdEnabled())
+            {
+                const MeshTriangle* tris[4];
+                for (int i = 0; i < count; i += 4)
+                {
+                    int n = std::min(count - i, 4);
+                    for (int k = 0; k < n; ++k)
+                        tris[k] = &triangles[entries[i + k]];
+                    if (IntersectTriangles4(tris, n, vertices, ray, distance))
+                    {
+                        hit = true;
+                        if (pStopAtFirstHit)
+                            return true;
+                    }
+                }
+                return hit;
+            }
+#endif
+            for (int i = 0; i < count; ++i)
+                if ((*this)(ray, entries[i], distance, pStopAtFirstHit) && pStopAtFirstHit)
+                    return true;
+            return hit;
+        }
         std::vector<Vector3>::const_iterator vertices;
         std::vector<MeshTriangle>::const_iterator triangles;
         bool hit;
@@ -363,7 +456,7 @@ namespace VMAP
         if (triangles.empty())
             return false;
         GModelRayCallback callback(triangles, vertices);
-        meshTree.intersectRay(ray, callback, distance, stopAtFirstHit);
+        meshTree.intersectRayLeaves(ray, callback, distance, stopAtFirstHit);
         return callback.hit;
     }
 
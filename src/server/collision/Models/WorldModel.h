@@ -57,6 +57,7 @@ namespace VMAP
             uint32 GetType() const { return iType; }
             float *GetHeightStorage() { return iHeight; }
             uint8 *GetFlagsStorage() { return iFlags; }
+            void getPosInfo(uint32 &tilesX, uint32 &tilesY, Vector3 &corner) const { tilesX = iTilesX; tilesY = iTilesY; corner = iCorner; }
             uint32 GetFileSize();
             bool writeToFile(FILE *wf);
             static bool readFromFile(FILE *rf, WmoLiquid *&liquid);
@@ -92,6 +93,10 @@ namespace VMAP
             const G3D::AABox& GetBound() const { return iBound; }
             uint32 GetMogpFlags() const { return iMogpFlags; }
             uint32 GetWmoID() const { return iGroupWMOID; }
+            // geometry access for the mmaps generator
+            const std::vector<Vector3>& GetVertices() const { return vertices; }
+            const std::vector<MeshTriangle>& GetTriangles() const { return triangles; }
+            WmoLiquid* GetLiquid() const { return iLiquid; }
         protected:
             G3D::AABox iBound;
             uint32 iMogpFlags;// 0x8 outdor; 0x2000 indoor
@@ -115,6 +120,7 @@ namespace VMAP
             bool GetLocationInfo(const G3D::Vector3 &p, const G3D::Vector3 &down, float &dist, LocationInfo &info) const;
             bool writeFile(const std::string &filename);
             bool readFile(const std::string &filename);
+            const std::vector<GroupModel>& getGroupModels() const { return groupModels; }
             uint32 Flags;
         protected:
             uint32 RootWMOID;
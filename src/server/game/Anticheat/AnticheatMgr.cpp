@@ -11,7 +11,7 @@ AnticheatMgr::~AnticheatMgr()
 void AnticheatMgr::HandlePlayerLogin(Player* player)
 {
     // we initialize the pos of lastMovementPosition var
-    m_Players[player->GetGUIDLow()].SetPosition(player->GetPositionX(), player->GetPositionY(), player->GetPositionZ(), player->GetOrientation());
+    GetPlayerData(player->GetGUIDLow()).SetPosition(player->GetPositionX(), player->GetPositionY(), player->GetPositionZ(), player->GetOrientation());
 }
 
 void AnticheatMgr::HandlePlayerLogout(Player* player)
@@ -29,8 +29,8 @@ void AnticheatMgr::StartHackDetection(Player* player, MovementInfo movementInfo,
 
     if (player->isInFlight() || player->GetTransport())
     {
-        m_Players[key].SetLastMovementInfo(movementInfo);
-        m_Players[key].SetLastOpcode(opcode);
+        GetPlayerData(key).SetLastMovementInfo(movementInfo);
+        GetPlayerData(key).SetLastOpcode(opcode);
         return;
     }
 
@@ -41,8 +41,23 @@ void AnticheatMgr::StartHackDetection(Player* player, MovementInfo movementInfo,
     JumpHackDetection(player, movementInfo, opcode);
     ClimbHackDetection(player, movementInfo, opcode);
 
-    m_Players[key].SetLastMovementInfo(movementInfo);
-    m_Players[key].SetLastOpcode(opcode);
+    GetPlayerData(key).SetLastMovementInfo(movementInfo);
+    GetPlayerData(key).SetLastOpcode(opcode);
+}
+
+AnticheatData& AnticheatMgr::GetPlayerData(uint32 key)
+{
+    // entries are never removed and each one is only used by the map thread of its player,
+    // so the lock only has to cover the lookup, movement of different maps is checked in parallel
+    {
+        TRINITY_READ_GUARD(ACE_RW_Thread_Mutex, m_lock);
+        AnticheatPlayersDataMap::iterator itr = m_Players.find(key);
+        if (itr != m_Players.end())
+            return itr->second;
+    }
+
+    TRINITY_WRITE_GUARD(ACE_RW_Thread_Mutex, m_lock);
+    return m_Players[key];
 }
 
 void AnticheatMgr::BuildReport(Player* player, uint8 reportType, uint8 reportAction)
@@ -50,20 +65,20 @@ void AnticheatMgr::BuildReport(Player* player, uint8 reportType, uint8 reportAct
     uint32 key = player->GetGUIDLow();
     uint32 actualTime = getMSTime();
 
-    if (!m_Players[key].GetTempReportsTimer(reportType))
-        m_Players[key].SetTempReportsTimer(actualTime,reportType);
+    if (!GetPlayerData(key).GetTempReportsTimer(reportType))
+        GetPlayerData(key).SetTempReportsTimer(actualTime,reportType);
 
-    if (getMSTimeDiff(m_Players[key].GetTempReportsTimer(reportType), actualTime) < 3000)
+    if (getMSTimeDiff(GetPlayerData(key).GetTempReportsTimer(reportType), actualTime) < 3000)
     {
-        m_Players[key].SetTempReports(m_Players[key].GetTempReports(reportType) + 1, reportType);
+        GetPlayerData(key).SetTempReports(GetPlayerData(key).GetTempReports(reportType) + 1, reportType);
 
-        if (m_Players[key].GetTempReports(reportType) < 3)
+        if (GetPlayerData(key).GetTempReports(reportType) < 3)
             return;
     }
     else
     {
-        m_Players[key].SetTempReportsTimer(actualTime, reportType);
-        m_Players[key].SetTempReports(1, reportType);
+        GetPlayerData(key).SetTempReportsTimer(actualTime, reportType);
+        GetPlayerData(key).SetTempReports(1, reportType);
         return;
     }
 
@@ -87,7 +102,7 @@ void AnticheatMgr::BuildReport(Player* player, uint8 reportType, uint8 reportAct
     player->GetName(), key, player->GetSession()->GetAccountId(), player->GetSession()->GetLatency(), player->GetSession()->GetRemoteAddress().c_str(), reportType);
 
     sLog->outWarden("AntiCheat Detail: Player: %s, report ID: %u, moveFlags: %u, moveFlags2: %u, opcode: %u",
-        player->GetName(), reportType, m_Players[key].GetLastMovementInfo().moveFlags, m_Players[key].GetLastMovementInfo().moveFlags2, m_Players[key].GetLastOpcode());
+        player->GetName(), reportType, GetPlayerData(key).GetLastMovementInfo().moveFlags, GetPlayerData(key).GetLastMovementInfo().moveFlags2, GetPlayerData(key).GetLastOpcode());
 };
 
 void AnticheatMgr::SpeedHackDetection(Player* player, MovementInfo movementInfo)
@@ -97,10 +112,10 @@ void AnticheatMgr::SpeedHackDetection(Player* player, MovementInfo movementInfo)
     // We also must check the map because the movementFlag can be modified by the client
     // If we just check the flag, they could always add that flag and always skip the speed hacking detection
     // 369 == DEEPRUN TRAM
-    if (m_Players[key].GetLastMovementInfo().HasMovementFlag(MOVEFLAG_ONTRANSPORT) && player->GetMapId() == 369)
+    if (GetPlayerData(key).GetLastMovementInfo().HasMovementFlag(MOVEFLAG_ONTRANSPORT) && player->GetMapId() == 369)
         return;
 
-    uint32 distance2D = (uint32)movementInfo.pos.GetExactDist2d(&m_Players[key].GetLastMovementInfo().pos);
+    uint32 distance2D = (uint32)movementInfo.pos.GetExactDist2d(&GetPlayerData(key).GetLastMovementInfo().pos);
     uint8 moveType = 0;
 
     // we need to know HOW is the player moving
@@ -118,7 +133,7 @@ void AnticheatMgr::SpeedHackDetection(Player* player, MovementInfo movementInfo)
     uint32 speedRate = (uint32)(player->GetSpeed(UnitMoveType(moveType)) + movementInfo.j_xyspeed);
 
     // how long the player took to move to here.
-    uint32 timeDiff = getMSTimeDiff(m_Players[key].GetLastMovementInfo().time, movementInfo.time);
+    uint32 timeDiff = getMSTimeDiff(GetPlayerData(key).GetLastMovementInfo().time, movementInfo.time);
 
     if (!timeDiff)
         timeDiff = 1;
@@ -134,7 +149,7 @@ void AnticheatMgr::SpeedHackDetection(Player* player, MovementInfo movementInfo)
 void AnticheatMgr::FlyHackDetection(Player* player, MovementInfo movementInfo)
 {
     uint32 key = player->GetGUIDLow();
-    if (!m_Players[key].GetLastMovementInfo().HasMovementFlag(MovementFlags(MOVEFLAG_FLYING | MOVEFLAG_FLYING2)))
+    if (!GetPlayerData(key).GetLastMovementInfo().HasMovementFlag(MovementFlags(MOVEFLAG_FLYING | MOVEFLAG_FLYING2)))
         return;
 
     if (player->HasAuraType(SPELL_AURA_FLY) ||
@@ -144,14 +159,14 @@ void AnticheatMgr::FlyHackDetection(Player* player, MovementInfo movementInfo)
         player->HasAuraType(SPELL_AURA_MOD_FLIGHT_SPEED_MOUNTED_NOT_STACKING))
         return;
 
-    uint8 reportType = m_Players[key].GetLastMovementInfo().HasMovementFlag(MOVEFLAG_FLYING) ? FLY_HACK_REPORT : MAELSTROM_FLY_HACK_REPORT;
+    uint8 reportType = GetPlayerData(key).GetLastMovementInfo().HasMovementFlag(MOVEFLAG_FLYING) ? FLY_HACK_REPORT : MAELSTROM_FLY_HACK_REPORT;
     BuildReport(player, reportType, ACTION_NOTIFY);
 }
 
 void AnticheatMgr::WalkOnWaterHackDetection(Player* player, MovementInfo /* movementInfo */)
 {
     uint32 key = player->GetGUIDLow();
-    if (!m_Players[key].GetLastMovementInfo().HasMovementFlag(MOVEFLAG_WATERWALKING))
+    if (!GetPlayerData(key).GetLastMovementInfo().HasMovementFlag(MOVEFLAG_WATERWALKING))
         return;
 
     // if we are a ghost we can walk on water
@@ -169,14 +184,14 @@ void AnticheatMgr::WalkOnWaterHackDetection(Player* player, MovementInfo /* move
 void AnticheatMgr::TeleportHackDetection(Player* player, MovementInfo movementInfo)
 {
     uint32 key = player->GetGUIDLow();
-    if (!m_Players[key].GetLastMovementInfo().HasMovementFlag(MOVEFLAG_NONE))
+    if (!GetPlayerData(key).GetLastMovementInfo().HasMovementFlag(MOVEFLAG_NONE))
         return;
 }
 
 void AnticheatMgr::JumpHackDetection(Player* player, MovementInfo movementInfo, uint32 opcode)
 {
     uint32 key = player->GetGUIDLow();
-    if (m_Players[key].GetLastOpcode() == MSG_MOVE_JUMP && opcode == MSG_MOVE_JUMP)
+    if (GetPlayerData(key).GetLastOpcode() == MSG_MOVE_JUMP && opcode == MSG_MOVE_JUMP)
         BuildReport(player, JUMP_HACK_REPORT, ACTION_KICK);
 }
 
@@ -184,7 +199,7 @@ void AnticheatMgr::TeleportPlaneHackDetection(Player* player, MovementInfo movem
 {
     uint32 key = player->GetGUIDLow();
 
-    if (m_Players[key].GetLastMovementInfo().pos.GetPositionZ() != 0 ||
+    if (GetPlayerData(key).GetLastMovementInfo().pos.GetPositionZ() != 0 ||
         movementInfo.pos.GetPositionZ() != 0)
         return;
 
@@ -208,7 +223,7 @@ void AnticheatMgr::ClimbHackDetection(Player *player, MovementInfo movementInfo,
 {
     uint32 key = player->GetGUIDLow();
 
-    if (m_Players[key].GetLastOpcode() != MSG_MOVE_HEARTBEAT || 
+    if (GetPlayerData(key).GetLastOpcode() != MSG_MOVE_HEARTBEAT || 
         opcode != MSG_MOVE_HEARTBEAT)
         return;
 
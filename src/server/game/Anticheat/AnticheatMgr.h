@@ -62,8 +62,10 @@ private:
     void ClimbHackDetection(Player *player, MovementInfo movementInfo, uint32 opcode);
 
     void BuildReport(Player* player,uint8 reportType, uint8 reportAction);
+    AnticheatData& GetPlayerData(uint32 key);
 
     AnticheatPlayersDataMap m_Players;
+    ACE_RW_Thread_Mutex m_lock;                             // movement opcodes are handled on the map threads
 };
 
 #define sAnticheatMgr ACE_Singleton<AnticheatMgr, ACE_Null_Mutex>::instance()
@@ -229,7 +229,10 @@ BattleGround::~BattleGround()
     sBattleGroundMgr->RemoveBattleGround(GetInstanceID());
     // unload map
     if (m_Map)
+    {
+        m_Map->SetBG(NULL);
         m_Map->SetUnload();
+    }
     // remove from bg free slot queue
     this->RemoveFromBGFreeSlotQueue();
 
@@ -536,6 +539,7 @@ void BattleGround::SetTeamStartLoc(uint32 TeamID, float X, float Y, float Z, flo
 
 void BattleGround::SendPacketToAll(WorldPacket *packet)
 {
+    WorldPacketPtr shared;
     for (std::map<uint64, BattleGroundPlayer>::iterator itr = m_Players.begin(); itr != m_Players.end(); ++itr)
     {
         if (itr->second.LastOnlineTime)
@@ -543,7 +547,7 @@ void BattleGround::SendPacketToAll(WorldPacket *packet)
 
         Player *plr = sObjectMgr->GetPlayer(itr->first);
         if (plr)
-            plr->GetSession()->SendPacket(packet);
+            plr->GetSession()->SendPacket(packet, &shared);
         else
             sLog->outError("BattleGround: Player (GUID: %u) not found!", GUID_LOPART(itr->first));
     }
@@ -719,6 +723,9 @@ void BattleGround::UpdateWorldStateForPlayer(uint32 Field, uint32 Value, Player
 
 void BattleGround::EndBattleGround(uint32 winner)
 {
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, sharedLock);
+
     this->RemoveFromBGFreeSlotQueue();
     uint32 almost_winning_team = HORDE;
     ArenaTeam * winner_arena_team = NULL;
@@ -1175,6 +1182,9 @@ void BattleGround::BlockMovement(Player *plr)
 
 void BattleGround::RemovePlayerAtLeave(uint64 guid, bool Transport, bool SendPacket)
 {
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, sharedLock);
+
     uint32 team = GetPlayerTeam(guid);
     bool participant = false;
     // Remove from lists/maps
@@ -1458,6 +1468,8 @@ void BattleGround::EventPlayerLoggedOut(Player* player)
 /* This method should be called only once ... it adds pointer to queue */
 void BattleGround::AddToBGFreeSlotQueue()
 {
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, sharedLock);
     // make sure to add only once
     if (!m_InBGFreeSlotQueue)
     {
@@ -1469,6 +1481,8 @@ void BattleGround::AddToBGFreeSlotQueue()
 /* This method removes this battleground from free queue - it must be called when deleting battleground - not used now*/
 void BattleGround::RemoveFromBGFreeSlotQueue()
 {
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, sharedLock);
     // set to be able to re-add if needed
     m_InBGFreeSlotQueue = false;
     // uncomment this code when battlegrounds will work like instances
@@ -1935,6 +1949,9 @@ void BattleGround::SendMessage2ToAll(int32 entry, ChatMsg type, Player const* so
 
 void BattleGround::EndNow()
 {
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, sharedLock);
+
     RemoveFromBGFreeSlotQueue();
     SetStatus(STATUS_WAIT_LEAVE);
     SetEndTime(TIME_TO_AUTOREMOVE);
@@ -399,6 +399,7 @@ class BattleGround
             ASSERT(m_Map);
             return m_Map;
         }
+        BattleGroundMap* FindBgMap() const { return m_Map; }
 
         void SetTeamStartLoc(uint32 TeamID, float X, float Y, float Z, float O);
         void GetTeamStartLoc(uint32 TeamID, float &X, float &Y, float &Z, float &O) const
@@ -531,6 +532,7 @@ class BattleGround
         void PlayerRelogin(uint64 guid);
 
         void SetDeleteThis() {m_SetDeleteThis = true;}
+        bool IsSetForDelete() const { return m_SetDeleteThis; }
 
         /* virtual score-array - get's used in bg-subclasses */
         int32 m_TeamScores[BG_TEAMS_COUNT];
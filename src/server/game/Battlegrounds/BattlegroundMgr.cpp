@@ -38,6 +38,7 @@
 #include "World.h"
 #include "Chat.h"
 #include "ArenaTeam.h"
+#include "TickTracer.h"
 
 /*********************************************************/
 /***            BATTLEGROUND QUEUE SYSTEM              ***/
@@ -64,53 +65,64 @@ BattleGroundQueue::~BattleGroundQueue()
             delete (*itr);
         }
         m_QueuedGroups[i].clear();
+        m_QueuedGroupsByRating[i].clear();
     }
 }
 
+// check the conditions every eligible group must match, apart from the rating range
+bool BattleGroundQueue::EligibleGroups::IsEligible(GroupQueueInfo * ginfo, uint32 BgTypeId, uint32 side, uint32 MaxPlayers, uint8 ArenaType, bool IsRated, uint32 excludeTeam) const
+{
+    return ginfo->BgTypeId == BgTypeId &&                   // bg type must match
+        ginfo->ArenaType == ArenaType &&                    // arena type must match
+        ginfo->IsRated == IsRated &&                        // israted must match
+        ginfo->IsInvitedToBGInstanceGUID == 0 &&            // leave out already invited groups
+        ginfo->Team == side &&                              // match side
+        ginfo->Players.size() <= MaxPlayers &&              // the group must fit in the bg
+        (!excludeTeam || ginfo->ArenaTeamId != excludeTeam) && // if excludeTeam is specified, leave out those arena team ids
+        // SOLOQUEUE: single players, every size check is done by the selection
+        (ArenaType == ARENA_TYPE_SOLO_3v3 || !IsRated || ginfo->Players.size() == MaxPlayers); // if rated, then pass only if the player count is exact NEEDS TESTING! (but now this should never happen)
+}
+
+static bool JoinedBefore(GroupQueueInfo * a, GroupQueueInfo * b)
+{
+    return a->JoinTime < b->JoinTime;
+}
+
 // initialize eligible groups from the given source matching the given specifications
-void BattleGroundQueue::EligibleGroups::Init(BattleGroundQueue::QueuedGroupsList *source, uint32 BgTypeId, uint32 side, uint32 MaxPlayers, uint8 ArenaType, bool IsRated, uint32 MinRating, uint32 MaxRating, uint32 DisregardTime, uint32 excludeTeam)
+void BattleGroundQueue::EligibleGroups::Init(BattleGroundQueue::QueuedGroupsList *source, BattleGroundQueue::QueuedGroupsRatingIndex *ratingIndex, uint32 BgTypeId, uint32 side, uint32 MaxPlayers, uint8 ArenaType, bool IsRated, uint32 MinRating, uint32 MaxRating, uint32 DisregardTime, uint32 excludeTeam)
 {
     // clear from prev initialization
     clear();
-    BattleGroundQueue::QueuedGroupsList::iterator itr, next;
 
-    if (ArenaType == ARENA_TYPE_SOLO_3v3)
+    if (ArenaType != ARENA_TYPE_SOLO_3v3 && IsRated && DisregardTime && ratingIndex)
     {
-        // iterate through the source
-        for (itr = source->begin(); itr != source->end(); itr = next)
-        {
-            next = itr;
-            ++next;
-            if ((*itr)->BgTypeId == BgTypeId &&     // bg type must match
-                (*itr)->ArenaType == ArenaType &&   // arena type must match
-                (*itr)->IsRated == IsRated &&       // israted must match
-                (*itr)->IsInvitedToBGInstanceGUID == 0 && // leave out already invited groups
-                (*itr)->Team == side &&             // match side
-                (*itr)->Players.size() <= MaxPlayers &&   // the group must fit in the bg
-                (!excludeTeam || (*itr)->ArenaTeamId != excludeTeam))// if excludeTeam is specified, leave out those arena team ids
-            {
-                // the group matches the conditions
-                // using push_back for proper selecting when inviting
-                push_back((*itr));
-            }
-        }
+        // groups waiting longer than the discard time pass with any rating, they are at the front of the source
+        for (BattleGroundQueue::QueuedGroupsList::iterator itr = source->begin(); itr != source->end() && (*itr)->JoinTime <= DisregardTime; ++itr)
+            if (IsEligible(*itr, BgTypeId, side, MaxPlayers, ArenaType, IsRated, excludeTeam))
+                push_back(*itr);
+
+        // the newer ones pass if they have no rating info or match the rating range
+        size_t waited = size();
+        BattleGroundQueue::QueuedGroupsRatingIndex::iterator ritr;
+        if (MinRating)
+            for (ritr = ratingIndex->begin(); ritr != ratingIndex->end() && ritr->first == 0; ++ritr)
+                if (ritr->second->JoinTime > DisregardTime && IsEligible(ritr->second, BgTypeId, side, MaxPlayers, ArenaType, IsRated, excludeTeam))
+                    push_back(ritr->second);
+        for (ritr = ratingIndex->lower_bound(MinRating); ritr != ratingIndex->end() && ritr->first <= MaxRating; ++ritr)
+            if (ritr->second->JoinTime > DisregardTime && IsEligible(ritr->second, BgTypeId, side, MaxPlayers, ArenaType, IsRated, excludeTeam))
+                push_back(ritr->second);
+
+        // keep the join order, the selection prefers the groups waiting longest
+        std::stable_sort(begin() + waited, end(), JoinedBefore);
     }
     else
     {
         // iterate through the source
-        for (itr = source->begin(); itr != source->end(); itr = next)
+        for (BattleGroundQueue::QueuedGroupsList::iterator itr = source->begin(); itr != source->end(); ++itr)
         {
-            next = itr;
-            ++next;
-            if ((*itr)->BgTypeId == BgTypeId &&     // bg type must match
-                (*itr)->ArenaType == ArenaType &&   // arena type must match
-                (*itr)->IsRated == IsRated &&       // israted must match
-                (*itr)->IsInvitedToBGInstanceGUID == 0 && // leave out already invited groups
-                (*itr)->Team == side &&             // match side
-                (*itr)->Players.size() <= MaxPlayers &&   // the group must fit in the bg
-                (!excludeTeam || (*itr)->ArenaTeamId != excludeTeam) && // if excludeTeam is specified, leave out those arena team ids
-                (!IsRated || (*itr)->Players.size() == MaxPlayers) &&   // if rated, then pass only if the player count is exact NEEDS TESTING! (but now this should never happen)
-                (!DisregardTime || (*itr)->JoinTime <= DisregardTime              // pass if disregard time is greater than join time
+            if (IsEligible(*itr, BgTypeId, side, MaxPlayers, ArenaType, IsRated, excludeTeam) &&
+                (ArenaType == ARENA_TYPE_SOLO_3v3 ||
+                !DisregardTime || (*itr)->JoinTime <= DisregardTime              // pass if disregard time is greater than join time
                     || (*itr)->ArenaTeamRating == 0                 // pass if no rating info
                     || ((*itr)->ArenaTeamRating >= MinRating       // pass if matches the rating range
                     && (*itr)->ArenaTeamRating <= MaxRating)))
@@ -121,6 +133,11 @@ void BattleGroundQueue::EligibleGroups::Init(BattleGroundQueue::QueuedGroupsList
             }
         }
     }
+
+    m_RemainingPlayers.resize(size() + 1);
+    m_RemainingPlayers[size()] = 0;
+    for (size_t i = size(); i > 0; --i)
+        m_RemainingPlayers[i - 1] = m_RemainingPlayers[i] + (*this)[i - 1]->Players.size();
 }
 
 // selection pool initialization, used to clean up from prev selection
@@ -128,7 +145,7 @@ void BattleGroundQueue::SelectionPool::Init(EligibleGroups * curr)
 {
     m_CurrEligGroups = curr;
     SelectedGroups.clear();
-    SoloQueueClass.clear();
+    SoloQueueClassMask = 0;
     PlayerCount = 0;
     hasSoloQueueHealer = false;
 }
@@ -158,17 +175,6 @@ void BattleGroundQueue::SelectionPool::AddGroup(GroupQueueInfo * ginfo)
     PlayerCount+=ginfo->Players.size();
 }
 
-bool BattleGroundQueue::SelectionPool::HasSoloQueueClass(uint8 playerClass)
-{
-    for (std::vector<uint8>::iterator itr = SoloQueueClass.begin(); itr != SoloQueueClass.end(); itr++)
-    {
-        if (*itr == playerClass)
-            return true;
-    }
-
-    return false;
-}
-
 // add group to bg queue with the given leader and bg specifications
 GroupQueueInfo * BattleGroundQueue::AddGroup(Player *leader, uint32 BgTypeId, uint8 ArenaType, bool isRated, uint32 arenaRating, uint32 arenateamid)
 {
@@ -187,15 +193,25 @@ GroupQueueInfo * BattleGroundQueue::AddGroup(Player *leader, uint32 BgTypeId, ui
     ginfo->Team                      = (ArenaType == ARENA_TYPE_SOLO_3v3 ? ALLIANCE : leader->GetTeam()); // SOLOQUEUE: Always add team Alliance to queue info (Cross-faction)
     ginfo->ArenaTeamRating           = arenaRating;
     ginfo->OpponentsTeamRating       = 0;                       //initialize it to 0
+    ginfo->SoloQueueClass            = 0;
+    ginfo->SoloQueueHealer           = false;
 
     ginfo->Players.clear();
 
-    m_QueuedGroups[queue_id].push_back(ginfo);
+    InsertGroup(ginfo, queue_id);
 
     // return ginfo, because it is needed to add players to this group info
     return ginfo;
 }
 
+void BattleGroundQueue::InsertGroup(GroupQueueInfo * ginfo, uint32 queue_id)
+{
+    ginfo->QueueId = queue_id;
+    ginfo->QueuePos = m_QueuedGroups[queue_id].insert(m_QueuedGroups[queue_id].end(), ginfo);
+    if (ginfo->IsRated)
+        ginfo->RatingPos = m_QueuedGroupsByRating[queue_id].insert(std::make_pair(ginfo->ArenaTeamRating, ginfo));
+}
+
 void BattleGroundQueue::AddPlayer(Player *plr, GroupQueueInfo *ginfo)
 {
     uint32 queue_id = plr->GetBattleGroundQueueIdFromLevel(ginfo->BgTypeId);
@@ -210,6 +226,13 @@ void BattleGroundQueue::AddPlayer(Player *plr, GroupQueueInfo *ginfo)
     // add the pinfo to ginfo's list
     ginfo->Players[plr->GetGUID()]  = &info;
 
+    // SOLOQUEUE: the role is taken at join, so matching does not look up every queued player
+    if (ginfo->ArenaType == ARENA_TYPE_SOLO_3v3)
+    {
+        ginfo->SoloQueueClass = plr->getClass();
+        ginfo->SoloQueueHealer = plr->GetTalentSpecialization() == TALENT_SPECIALIZATION_HEALER;
+    }
+
     if (sWorld->getConfig(CONFIG_BATTLEGROUND_QUEUE_ANNOUNCER_ENABLE))
     {
         //announce only once in a time
@@ -323,6 +346,22 @@ void BattleGroundQueue::AddPlayer(Player *plr, GroupQueueInfo *ginfo)
     }
 }
 
+void BattleGroundQueue::UpdateSoloQueueRole(Player *plr)
+{
+    // called from the map thread of the player, the queues are updated by the world and battleground threads
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, sharedLock);
+
+    uint32 queue_id = plr->GetBattleGroundQueueIdFromLevel(BATTLEGROUND_AA);
+    QueuedPlayersMap::iterator itr = m_QueuedPlayers[queue_id].find(plr->GetGUID());
+    if (itr == m_QueuedPlayers[queue_id].end())
+        return;
+
+    GroupQueueInfo* ginfo = itr->second.GroupInfo;
+    if (ginfo->ArenaType == ARENA_TYPE_SOLO_3v3)
+        ginfo->SoloQueueHealer = plr->GetTalentSpecialization() == TALENT_SPECIALIZATION_HEALER;
+}
+
 void BattleGroundQueue::RemovePlayer(uint64 guid, bool decreaseInvitedCount, uint32 bgTypeId)
 {
     Player *plr = sObjectMgr->GetPlayer(guid);
@@ -366,11 +405,8 @@ void BattleGroundQueue::RemovePlayer(uint64 guid, bool decreaseInvitedCount, uin
 
     group = itr->second.GroupInfo;
 
-    for (group_itr=m_QueuedGroups[queue_id].begin(); group_itr != m_QueuedGroups[queue_id].end(); ++group_itr)
-    {
-        if (group == (GroupQueueInfo*)(*group_itr))
-            break;
-    }
+    // the group is only listed in the bracket of its leader
+    group_itr = group->QueueId == uint32(queue_id) ? group->QueuePos : m_QueuedGroups[queue_id].end();
 
     // variables are set (what about leveling up when in queue????)
     // remove player from group
@@ -427,6 +463,8 @@ void BattleGroundQueue::RemovePlayer(uint64 guid, bool decreaseInvitedCount, uin
         if (group->Players.empty())
         {
             m_QueuedGroups[queue_id].erase(group_itr);
+            if (group->IsRated)
+                m_QueuedGroupsByRating[queue_id].erase(group->RatingPos);
             delete group;
         }
         // NEEDS TESTING!
@@ -501,56 +539,44 @@ bool BattleGroundQueue::SelectionPool::Build(uint32 MinPlayers, uint32 MaxPlayer
 {
     if (isSoloQueue)
     {
-        bool LoopAgain = false;
-        // start from the specified start iterator
+        // SOLOQUEUE: a team is one healer and players of other classes, every group is a single player.
+        // The healer only decides which class is taken, so the first healer of each class is tried with
+        // the longest waiting players that still fit instead of backtracking over the whole queue
+        uint32 triedHealerClasses = 0;
         for (EligibleGroups::iterator itr1 = startitr; itr1 != m_CurrEligGroups->end(); ++itr1)
         {
-            // if it fits in, select it
-            if (GetPlayerCount() + (*itr1)->Players.size() <= MaxPlayers)
-            {
-                EligibleGroups::iterator next = itr1;
-                ++next;
+            GroupQueueInfo* healer = *itr1;
+            if (!healer->SoloQueueHealer || (triedHealerClasses & (1 << healer->SoloQueueClass)))
+                continue;
+            triedHealerClasses |= 1 << healer->SoloQueueClass;
 
-                // SOLOQUEUE
-                if (Player* curPlayer = ObjectAccessor::FindPlayer((*itr1)->Players.begin()->first))
-                {
-                    if (curPlayer->GetTalentSpecialization() == TALENT_SPECIALIZATION_HEALER)
-                    {
-                        // Skip if current player is healer and we already have one
-                        if (HasSoloQueueHealer())
-                            continue;
-                        // else
-
-                        // Healer successfully added to group
-                        SetSoloQueueHealer(true);
-                        LoopAgain = true;
-                    }
-                    else
-                    {
-                        // Always add healer first to group so skip if !healer and !havehealer
-                        if (!HasSoloQueueHealer())
-                            continue;
-                    }
+            if (GetPlayerCount() + healer->Players.size() > MaxPlayers)
+                continue;
 
-                    // Skip if we already have the class
-                    if (HasSoloQueueClass(curPlayer->getClass()))
-                        continue;
+            AddGroup(healer);
+            SetSoloQueueHealer(true);
+            SoloQueueClassMask |= 1 << healer->SoloQueueClass;
 
-                    SoloQueueClass.push_back(curPlayer->getClass());
-                }
-                AddGroup((*itr1));
-                if (GetPlayerCount() >= MinPlayers)
-                {
-                    // enough players are selected
-                    return true;
-                }
-                // try building from the rest of the elig. groups
-                // if that succeeds, return true
-                if (Build(MinPlayers, MaxPlayers, (LoopAgain? m_CurrEligGroups->begin() : next), true))
-                    return true;
-                // the rest didn't succeed, so this group cannot be included
-                RemoveGroup((*itr1));
+            for (EligibleGroups::iterator itr2 = startitr; itr2 != m_CurrEligGroups->end() && GetPlayerCount() < MinPlayers; ++itr2)
+            {
+                if ((*itr2)->SoloQueueHealer || HasSoloQueueClass((*itr2)->SoloQueueClass) || GetPlayerCount() + (*itr2)->Players.size() > MaxPlayers)
+                    continue;
+
+                AddGroup(*itr2);
+                SoloQueueClassMask |= 1 << (*itr2)->SoloQueueClass;
             }
+
+            if (GetPlayerCount() >= MinPlayers)
+            {
+                // enough players are selected
+                return true;
+            }
+
+            // no team around this healer, start over with the next one
+            SelectedGroups.clear();
+            PlayerCount = 0;
+            SoloQueueClassMask = 0;
+            SetSoloQueueHealer(false);
         }
     }
     else
@@ -558,6 +584,10 @@ bool BattleGroundQueue::SelectionPool::Build(uint32 MinPlayers, uint32 MaxPlayer
         // start from the specified start iterator
         for (EligibleGroups::iterator itr1 = startitr; itr1 != m_CurrEligGroups->end(); ++itr1)
         {
+            // the rest of the eligible groups cannot fill the team anymore
+            if (GetPlayerCount() + m_CurrEligGroups->GetRemainingPlayers(itr1) < MinPlayers)
+                break;
+
             // if it fits in, select it
             if (GetPlayerCount() + (*itr1)->Players.size() <= MaxPlayers)
              {
@@ -612,7 +642,7 @@ bool BattleGroundQueue::BuildSelectionPool(uint32 bgTypeId, uint32 queue_id, uin
         isSoloQueue = true;
 
     // initiate the groups eligible to create the bg
-    m_EligibleGroups.Init(&(m_QueuedGroups[queue_id]), bgTypeId, side, MaxPlayers, ArenaType, isRated, MinRating, MaxRating, DisregardTime, excludeTeam);
+    m_EligibleGroups.Init(&(m_QueuedGroups[queue_id]), &(m_QueuedGroupsByRating[queue_id]), bgTypeId, side, MaxPlayers, ArenaType, isRated, MinRating, MaxRating, DisregardTime, excludeTeam);
     // init the selected groups (clear)
     // and set m_CurrEligGroups pointer
     // we set it this way to only have one EligibleGroups object to save some memory
@@ -1089,12 +1119,116 @@ void BattleGroundQueue::Update(uint32 bgTypeId, uint32 queue_id, uint8 arenatype
     }
 }
 
+void BattleGroundQueue::BenchmarkMatching(uint32 groupCount, uint8 arenaType, uint32& attempts, uint32& matches, uint64& elapsedUs)
+{
+    uint32 teamSize, groupSize;
+    switch (arenaType)
+    {
+        case ARENA_TYPE_2v2:      teamSize = 2; groupSize = 2; break;
+        case ARENA_TYPE_SOLO_3v3: teamSize = 3; groupSize = 1; break;
+        case ARENA_TYPE_3v3:      teamSize = 3; groupSize = 3; break;
+        default:                  teamSize = 5; groupSize = 5; break;
+    }
+
+    uint32 maxRatingDiff = sBattleGroundMgr->GetMaxRatingDifference() ? sBattleGroundMgr->GetMaxRatingDifference() : 150;
+    uint32 discardTimer = sBattleGroundMgr->GetRatingDiscardTimer() ? sBattleGroundMgr->GetRatingDiscardTimer() : 600000;
+
+    // join times are spread over twice the rating discard timer, so the older half of the queue matches any rating
+    uint32 now = 2 * discardTimer;
+    uint32 discardTime = now - discardTimer;
+
+    static const uint8 classes[] = { CLASS_WARRIOR, CLASS_PALADIN, CLASS_HUNTER, CLASS_ROGUE, CLASS_PRIEST, CLASS_SHAMAN, CLASS_MAGE, CLASS_WARLOCK, CLASS_DRUID };
+
+    for (uint32 i = 0; i < groupCount; ++i)
+    {
+        GroupQueueInfo* ginfo = new GroupQueueInfo;
+        ginfo->BgTypeId                  = BATTLEGROUND_AA;
+        ginfo->ArenaType                 = arenaType;
+        ginfo->ArenaTeamId               = i + 1;
+        ginfo->IsRated                   = true;
+        ginfo->IsInvitedToBGInstanceGUID = 0;
+        ginfo->JoinTime                  = uint32(uint64(now) * i / groupCount);
+        ginfo->Team                      = (arenaType == ARENA_TYPE_SOLO_3v3 || urand(0, 1)) ? ALLIANCE : HORDE;
+        ginfo->ArenaTeamRating           = urand(1000, 2500);
+        ginfo->OpponentsTeamRating       = 0;
+        ginfo->SoloQueueClass            = classes[urand(0, 8)];
+        ginfo->SoloQueueHealer           = (ginfo->SoloQueueClass == CLASS_PALADIN || ginfo->SoloQueueClass == CLASS_PRIEST ||
+            ginfo->SoloQueueClass == CLASS_SHAMAN || ginfo->SoloQueueClass == CLASS_DRUID) && !urand(0, 2);
+
+        for (uint32 j = 0; j < groupSize; ++j)
+        {
+            uint64 guid = uint64(i) * groupSize + j + 1;
+            PlayerQueueInfo& info = m_QueuedPlayers[0][guid];
+            info.InviteTime     = 0;
+            info.LastInviteTime = 0;
+            info.LastOnlineTime = now;
+            info.GroupInfo      = ginfo;
+            ginfo->Players[guid] = &info;
+        }
+
+        InsertGroup(ginfo, 0);
+    }
+
+    // every group triggers the update it would cause when joining, in join order
+    // a match marks the selected groups invited, like the invitation of the real update
+    attempts = 0;
+    matches = 0;
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (QueuedGroupsList::iterator itr = m_QueuedGroups[0].begin(); itr != m_QueuedGroups[0].end(); ++itr)
+    {
+        if ((*itr)->IsInvitedToBGInstanceGUID)
+            continue;
+
+        ++attempts;
+        uint32 rating = (*itr)->ArenaTeamRating;
+        uint32 minRating = rating <= maxRatingDiff ? 0 : rating - maxRatingDiff;
+        uint32 maxRating = rating + maxRatingDiff;
+
+        SelectionPoolBuildMode mode1 = NORMAL_ALLIANCE, mode2 = NORMAL_HORDE;
+        if (!BuildSelectionPool(BATTLEGROUND_AA, 0, teamSize, teamSize, mode1, arenaType, true, minRating, maxRating, discardTime) ||
+            !BuildSelectionPool(BATTLEGROUND_AA, 0, teamSize, teamSize, mode2, arenaType, true, minRating, maxRating, discardTime))
+        {
+            // one faction match, the first team is moved to the other side while the second one is selected
+            uint32 side = (*itr)->Team;
+            uint32 otherSide = side == ALLIANCE ? HORDE : ALLIANCE;
+            mode1 = side == ALLIANCE ? ONESIDE_ALLIANCE_TEAM1 : ONESIDE_HORDE_TEAM1;
+            mode2 = side == ALLIANCE ? ONESIDE_ALLIANCE_TEAM2 : ONESIDE_HORDE_TEAM2;
+            if (!BuildSelectionPool(BATTLEGROUND_AA, 0, teamSize, teamSize, mode1, arenaType, true, minRating, maxRating, discardTime))
+                continue;
+
+            std::list<GroupQueueInfo*>::iterator sitr;
+            for (sitr = m_SelectionPools[mode1].SelectedGroups.begin(); sitr != m_SelectionPools[mode1].SelectedGroups.end(); ++sitr)
+                (*sitr)->Team = otherSide;
+
+            bool found = BuildSelectionPool(BATTLEGROUND_AA, 0, teamSize, teamSize, mode2, arenaType, true, minRating, maxRating, discardTime, (*(m_SelectionPools[mode1].SelectedGroups.begin()))->ArenaTeamId);
+
+            for (sitr = m_SelectionPools[mode1].SelectedGroups.begin(); sitr != m_SelectionPools[mode1].SelectedGroups.end(); ++sitr)
+                (*sitr)->Team = side;
+
+            if (!found)
+                continue;
+        }
+
+        ++matches;
+        for (std::list<GroupQueueInfo*>::iterator sitr = m_SelectionPools[mode1].SelectedGroups.begin(); sitr != m_SelectionPools[mode1].SelectedGroups.end(); ++sitr)
+            (*sitr)->IsInvitedToBGInstanceGUID = matches;
+        for (std::list<GroupQueueInfo*>::iterator sitr = m_SelectionPools[mode2].SelectedGroups.begin(); sitr != m_SelectionPools[mode2].SelectedGroups.end(); ++sitr)
+            (*sitr)->IsInvitedToBGInstanceGUID = matches;
+    }
+    ACE_Time_Value elapsed = ACE_OS::gettimeofday() - start;
+    elapsedUs = uint64(elapsed.sec()) * 1000000 + elapsed.usec();
+}
+
 /*********************************************************/
 /***            BATTLEGROUND QUEUE EVENTS              ***/
 /*********************************************************/
 
 bool BGQueueInviteEvent::Execute(uint64 /*e_time*/, uint32 /*p_time*/)
 {
+    // runs on the map thread of the player, the queues are also changed by the battleground maps
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD_RETURN(ACE_Recursive_Thread_Mutex, guard, sharedLock, true);
+
     Player* plr = sObjectMgr->GetPlayer(m_PlayerGuid);
 
     // player logged off (we should do nothing, he is correctly removed from queue in another procedure)
@@ -1139,6 +1273,10 @@ void BGQueueInviteEvent::Abort(uint64 /*e_time*/)
 
 bool BGQueueRemoveEvent::Execute(uint64 /*e_time*/, uint32 /*p_time*/)
 {
+    // runs on the map thread of the player, the queues are also changed by the battleground maps
+    ACE_Recursive_Thread_Mutex& sharedLock = sBattleGroundMgr->GetSharedStateLock();
+    ACE_GUARD_RETURN(ACE_Recursive_Thread_Mutex, guard, sharedLock, true);
+
     Player* plr = sObjectMgr->GetPlayer(m_PlayerGuid);
     if (!plr)
         // player logged off (we should do nothing, he is correctly removed from queue in another procedure)
@@ -1219,15 +1357,19 @@ void BattleGroundMgr::DeleteAlllBattleGrounds()
     }
 }
 
-// used to update running battlegrounds, and delete finished ones
+// used to delete finished battlegrounds, running ones are updated by their BattleGroundMap
 void BattleGroundMgr::Update(time_t diff)
 {
+    TRACE_SPAN("BattleGroundMgr::Update");
+
     BattleGroundSet::iterator itr, next;
     for (itr = m_BattleGrounds.begin(); itr != m_BattleGrounds.end(); itr = next)
     {
         next = itr;
         ++next;
-        itr->second->Update(diff);
+        // a battleground without map has no map thread to drive it
+        if (!itr->second->FindBgMap())
+            itr->second->Update(diff);
         // use the SetDeleteThis variable
         // direct deletion caused crashes
         if (itr->second->m_SetDeleteThis)
@@ -1828,13 +1970,39 @@ void BattleGroundMgr::InitAutomaticArenaPointDistribution()
     }
 }
 
+// writes the given columns of the arena teams and their members, a transaction per batch of teams
+static void SaveArenaTeamBatches(std::vector<uint32> const& teamIds, char const* teamColumns, char const* memberColumns)
+{
+    for (size_t i = 0; i < teamIds.size(); i += ARENA_FLUSH_BATCH_ROWS)
+    {
+        std::ostringstream ids;
+        for (size_t j = i; j < teamIds.size() && j < i + ARENA_FLUSH_BATCH_ROWS; ++j)
+            ids << (j == i ? "" : ", ") << teamIds[j];
+
+        CharacterDatabase.BeginTransaction();
+        CharacterDatabase.PExecute("UPDATE arena_team_stats SET %s WHERE arenateamid IN (%s)", teamColumns, ids.str().c_str());
+        CharacterDatabase.PExecute("UPDATE arena_team_member SET %s WHERE arenateamid IN (%s)", memberColumns, ids.str().c_str());
+        CharacterDatabase.CommitTransaction();
+    }
+}
+
+// adds the points of one batch of offline players, points holds the "WHEN guid THEN points" cases
+static void AddArenaPointsBatch(std::ostringstream& points, std::ostringstream& guids)
+{
+    std::string sql = "UPDATE characters SET arenaPoints = arenaPoints + CASE guid" + points.str() + " END WHERE guid IN (" + guids.str() + ")";
+    CharacterDatabase.Execute(sql.c_str());
+    points.str("");
+    guids.str("");
+}
+
 void BattleGroundMgr::DistributeArenaPoints()
 {
     // used to distribute arena points based on last week's stats
-    sWorld->SendGlobalText("Flushing Arena points based on team ratings, this may take a few minutes. Please stand by...", NULL);
-
     sWorld->SendGlobalText("Distributing arena points to players...", NULL);
 
+    // arena teams are also changed by the arena maps when a match ends
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_SharedStateLock);
+
     // Temporary structure for storing maximum points to add values for all players
     std::map<uint32, uint32> PlayerPoints;
 
@@ -1843,36 +2011,74 @@ void BattleGroundMgr::DistributeArenaPoints()
         if (ArenaTeam * at = team_itr->second)
             at->UpdateArenaPointsHelper(PlayerPoints);
 
-    // Cycle that gives points to all players
+    // Online players get their points right away, offline ones by a batched update per ARENA_FLUSH_BATCH_ROWS players.
+    // The database thread runs the statements in order, before the character load of anyone logging in afterwards.
+    std::ostringstream points, guids;
+    uint32 rows = 0;
     for (std::map<uint32, uint32>::iterator plr_itr = PlayerPoints.begin(); plr_itr != PlayerPoints.end(); ++plr_itr)
     {
-        // Add points to player if online
         if (Player* pl = sObjectMgr->GetPlayer(plr_itr->first))
+        {
             pl->ModifyArenaPoints(plr_itr->second);
-        else // Update database
-            CharacterDatabase.PExecute("UPDATE characters SET arenaPoints = arenaPoints + '%u' WHERE guid = '%u'", plr_itr->second, plr_itr->first);
-    }
+            continue;
+        }
+
+        if (!plr_itr->second)
+            continue;
 
-    PlayerPoints.clear();
+        points << " WHEN " << plr_itr->first << " THEN " << plr_itr->second;
+        guids << (rows ? ", " : "") << plr_itr->first;
 
-    sWorld->SendGlobalText("Finished setting arena points for online players.", NULL);
+        if (++rows == ARENA_FLUSH_BATCH_ROWS)
+        {
+            AddArenaPointsBatch(points, guids);
+            rows = 0;
+        }
+    }
+    if (rows)
+        AddArenaPointsBatch(points, guids);
 
-    sWorld->SendGlobalText("Modifying played count, arena points etc. for loaded arena teams, sending updated stats to online players...", NULL);
+    // reset the weekly stats, the other columns are saved at the end of every match
+    std::vector<uint32> teamIds;
     for (ObjectMgr::ArenaTeamMap::iterator titr = sObjectMgr->GetArenaTeamMapBegin(); titr != sObjectMgr->GetArenaTeamMapEnd(); ++titr)
     {
         if (ArenaTeam * at = titr->second)
         {
             at->FinishWeek();                              // set played this week etc values to 0 in memory, too
-            at->SaveToDB();                                // save changes
             at->NotifyStatsChanged();                      // notify the players of the changes
+            teamIds.push_back(at->GetId());
         }
     }
 
-    sWorld->SendGlobalText("Modification done.", NULL);
+    SaveArenaTeamBatches(teamIds, "games = 0, wins = 0", "played_week = 0, wons_week = 0");
 
     sWorld->SendGlobalText("Done flushing Arena points.", NULL);
 }
 
+void BattleGroundMgr::FinishArenaSeason()
+{
+    sWorld->SendGlobalText("Resetting arena team ratings for the new season...", NULL);
+
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_SharedStateLock);
+
+    std::vector<uint32> teamIds;
+    for (ObjectMgr::ArenaTeamMap::iterator titr = sObjectMgr->GetArenaTeamMapBegin(); titr != sObjectMgr->GetArenaTeamMapEnd(); ++titr)
+    {
+        if (ArenaTeam * at = titr->second)
+        {
+            at->FinishSeason();
+            at->NotifyStatsChanged();
+            teamIds.push_back(at->GetId());
+        }
+    }
+
+    char teamColumns[128];
+    snprintf(teamColumns, 128, "rating = %u, games = 0, played = 0, wins = 0, wins2 = 0", ARENA_NEW_TEAM_RATING);
+    SaveArenaTeamBatches(teamIds, teamColumns, "played_week = 0, wons_week = 0, played_season = 0, wons_season = 0, personal_rating = 0");
+
+    sWorld->SendGlobalText("Arena season finished.", NULL);
+}
+
 void BattleGroundMgr::CancelAutomaticArenaPointDistribution()
 {
     m_NextAutoDistributionTime = 0;
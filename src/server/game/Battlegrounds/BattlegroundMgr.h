@@ -23,6 +23,7 @@
 
 #include "Battleground.h"
 #include <ace/Singleton.h>
+#include <ace/Recursive_Thread_Mutex.h>
 
 class BattleGround;
 
@@ -40,6 +41,8 @@ typedef std::list<BattleGround*> BGFreeSlotQueueType;
 
 #define BATTLEGROUND_ARENA_POINT_DISTRIBUTION_DAY    86400     // seconds in a day
 
+#define ARENA_FLUSH_BATCH_ROWS                       500       // players or arena teams per statement of an arena flush
+
 struct GroupQueueInfo;                                      // type predefinition
 struct PlayerQueueInfo                                      // stores information for players in queue
 {
@@ -61,6 +64,11 @@ struct GroupQueueInfo                                       // stores informatio
     uint32  IsInvitedToBGInstanceGUID;                      // was invited to certain BG
     uint32  ArenaTeamRating;                                // if rated match, inited to the rating of the team
     uint32  OpponentsTeamRating;                            // for rated arena matches
+    uint32  QueueId;                                        // level bracket the group is queued in
+    std::list<GroupQueueInfo*>::iterator QueuePos;          // position in the queued groups list of the bracket
+    std::multimap<uint32, GroupQueueInfo*>::iterator RatingPos; // position in the rating index of the bracket, rated groups only
+    uint8   SoloQueueClass;                                 // SOLOQUEUE: class of the player, stored at join
+    bool    SoloQueueHealer;                                // SOLOQUEUE: healer specialization, refreshed when a talent is learned
 };
 
 class BattleGround;
@@ -74,6 +82,8 @@ class BattleGroundQueue
 
         GroupQueueInfo * AddGroup(Player * leader, uint32 BgTypeId, uint8 ArenaType, bool isRated, uint32 ArenaRating, uint32 ArenaTeamId = 0);
         void AddPlayer(Player *plr, GroupQueueInfo *ginfo);
+        // SOLOQUEUE: takes the healer flag again after a talent change of a queued player
+        void UpdateSoloQueueRole(Player *plr);
         void RemovePlayer(uint64 guid, bool decreaseInvitedCount, uint32 bgTypeId);
         void DecreaseGroupLength(uint32 queueId, uint32 AsGroup);
         void BGEndedRemoveInvites(BattleGround * bg);
@@ -81,14 +91,28 @@ class BattleGroundQueue
         typedef std::map<uint64, PlayerQueueInfo> QueuedPlayersMap;
         QueuedPlayersMap m_QueuedPlayers[MAX_BATTLEGROUND_QUEUES];
 
+        // groups in join order, so the ones waiting longer than the rating discard time are always at the front
         typedef std::list<GroupQueueInfo*> QueuedGroupsList;
         QueuedGroupsList m_QueuedGroups[MAX_BATTLEGROUND_QUEUES];
 
+        // rated groups by team rating, used to find the opponents of a joining team without scanning the whole bracket
+        typedef std::multimap<uint32, GroupQueueInfo*> QueuedGroupsRatingIndex;
+        QueuedGroupsRatingIndex m_QueuedGroupsByRating[MAX_BATTLEGROUND_QUEUES];
+
+        // links an already filled group info into the queue indexes of the bracket
+        void InsertGroup(GroupQueueInfo * ginfo, uint32 queue_id);
+
         // class to hold pointers to the groups eligible for a specific selection pool building mode
-        class EligibleGroups : public std::list<GroupQueueInfo *>
+        class EligibleGroups : public std::vector<GroupQueueInfo *>
         {
         public:
-            void Init(QueuedGroupsList * source, uint32 BgTypeId, uint32 side, uint32 MaxPlayers, uint8 ArenaType = 0, bool IsRated = false, uint32 MinRating = 0, uint32 MaxRating = 0, uint32 DisregardTime = 0, uint32 excludeTeam = 0);
+            void Init(QueuedGroupsList * source, QueuedGroupsRatingIndex * ratingIndex, uint32 BgTypeId, uint32 side, uint32 MaxPlayers, uint8 ArenaType = 0, bool IsRated = false, uint32 MinRating = 0, uint32 MaxRating = 0, uint32 DisregardTime = 0, uint32 excludeTeam = 0);
+            // players of the groups from itr to the end, lets the selection give up as soon as the rest cannot fill a team
+            uint32 GetRemainingPlayers(const_iterator itr) const { return m_RemainingPlayers[itr - begin()]; }
+        private:
+            bool IsEligible(GroupQueueInfo * ginfo, uint32 BgTypeId, uint32 side, uint32 MaxPlayers, uint8 ArenaType, bool IsRated, uint32 excludeTeam) const;
+
+            std::vector<uint32> m_RemainingPlayers;
         };
 
         EligibleGroups m_EligibleGroups;
@@ -105,10 +129,10 @@ class BattleGroundQueue
 
             bool HasSoloQueueHealer() { return hasSoloQueueHealer; }
             void SetSoloQueueHealer(bool on) { hasSoloQueueHealer = on; }
-            bool HasSoloQueueClass(uint8 playerClass);
+            bool HasSoloQueueClass(uint8 playerClass) const { return SoloQueueClassMask & (1 << playerClass); }
         public:
             std::list<GroupQueueInfo *> SelectedGroups;
-            std::vector<uint8> SoloQueueClass;
+            uint32 SoloQueueClassMask;
         private:
             uint32 PlayerCount;
             EligibleGroups * m_CurrEligGroups;
@@ -132,6 +156,9 @@ class BattleGroundQueue
 
         bool BuildSelectionPool(uint32 bgTypeId, uint32 queue_id, uint32 MinPlayers, uint32 MaxPlayers, SelectionPoolBuildMode mode, uint8 ArenaType = 0, bool isRated = false, uint32 MinRating = 0, uint32 MaxRating = 0, uint32 DisregardTime = 0, uint32 excludeTeam = 0);
 
+        // fills a scratch queue with synthetic arena teams and times the selection pool building, used by .debug bgqueuebench
+        void BenchmarkMatching(uint32 groupCount, uint8 arenaType, uint32& attempts, uint32& matches, uint64& elapsedUs);
+
     private:
 
         bool InviteGroupToBG(GroupQueueInfo * ginfo, BattleGround * bg, uint32 side);
@@ -230,6 +257,10 @@ class BattleGroundMgr
 
         BGFreeSlotQueueType BGFreeSlotQueue[MAX_BATTLEGROUND_TYPES];
 
+        // battlegrounds are updated by their map, so the queues, free slot lists and arena
+        // teams they change when players leave or the match ends are shared between map threads
+        ACE_Recursive_Thread_Mutex& GetSharedStateLock() { return m_SharedStateLock; }
+
         void SendAreaSpiritHealerQueryOpcode(Player *pl, BattleGround *bg, uint64 guid);
 
         bool IsArenaType(uint32 bgTypeId) const;
@@ -243,6 +274,7 @@ class BattleGroundMgr
 
         void InitAutomaticArenaPointDistribution();
         void DistributeArenaPoints();
+        void FinishArenaSeason();
         void CancelAutomaticArenaPointDistribution();
         uint32 GetPrematureFinishTime() const {return m_PrematureFinishTimer;}
         void ToggleArenaTesting();
@@ -266,6 +298,7 @@ class BattleGroundMgr
         uint32 m_PrematureFinishTimer;
         bool   m_ArenaTesting;
         bool   m_Testing;
+        ACE_Recursive_Thread_Mutex m_SharedStateLock;
 };
 
 #define sBattleGroundMgr ACE_Singleton<BattleGroundMgr, ACE_Null_Mutex>::instance()
@@ -105,12 +105,15 @@ ChatCommand * ChatHandler::getCommandTable()
         { "idlerestart",    SEC_ADMINISTRATOR,  true,  NULL,                                                     "", serverIdleRestartCommandTable },
         { "idleshutdown",   SEC_ADMINISTRATOR,  true,  NULL,                                                     "", serverShutdownCommandTable },
         { "info",           SEC_PLAYER,         true,  &ChatHandler::HandleServerInfoCommand,        "", NULL },
+        { "los",            SEC_GAMEMASTER,     true,  &ChatHandler::HandleServerLosCommand,         "", NULL },
         { "motd",           SEC_PLAYER,         true,  &ChatHandler::HandleServerMotdCommand,        "", NULL },
+        { "opcodes",        SEC_GAMEMASTER,     true,  &ChatHandler::HandleServerOpcodesCommand,     "", NULL },
         { "plimit",         SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleServerPLimitCommand,      "", NULL },
         { "restart",        SEC_ADMINISTRATOR,  true,  NULL,                                                     "", serverRestartCommandTable },
         { "shutdown",       SEC_ADMINISTRATOR,  true,  NULL,                                                     "", serverShutdownCommandTable },
         { "set",            SEC_ADMINISTRATOR,  true,  NULL,                                                     "", serverSetCommandTable },
         { "togglequerylog", SEC_CONSOLE,        true,  &ChatHandler::HandleServerToggleQueryLogging, "", NULL },
+        { "trace",          SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleServerTraceCommand,       "", NULL },
         { NULL,             0,                  false, NULL,                                                     "", NULL }
     };
 
@@ -241,6 +244,9 @@ ChatCommand * ChatHandler::getCommandTable()
         { "threatlist",    SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugThreatList,            "", NULL },
         { "setinstdata",   SEC_ADMINISTRATOR,  false, &ChatHandler::HandleSetInstanceDataCommand,     "", NULL },
         { "getinstdata",   SEC_ADMINISTRATOR,  false, &ChatHandler::HandleGetInstanceDataCommand,     "", NULL },
+        { "replay",        SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugReplayCommand,         "", NULL },
+        { "bgqueuebench",  SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugBGQueueBenchCommand,   "", NULL },
+        { "updatemaskbench", SEC_ADMINISTRATOR, true, &ChatHandler::HandleDebugUpdateMaskBenchCommand, "", NULL },
         { NULL,             0,                  false, NULL,                                           "", NULL }
     };
 
@@ -696,6 +702,7 @@ ChatCommand * ChatHandler::getCommandTable()
         { "combatstop",    SEC_GAMEMASTER,     false, &ChatHandler::HandleCombatStopCommand,          "", NULL },
         { "flusharenapoints", SEC_ADMINISTRATOR, true,  &ChatHandler::HandleFlushArenaPointsCommand,    "", NULL },
         { "cancelflush",   SEC_ADMINISTRATOR, true,  &ChatHandler::HandleCancelFlushCommand,          "", NULL },
+        { "flusharenaseason", SEC_ADMINISTRATOR, true,  &ChatHandler::HandleFlushArenaSeasonCommand,    "", NULL },
         { "sendmessage",   SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleSendMessageCommand,         "", NULL },
         { "playall",       SEC_ADMINISTRATOR,  false, &ChatHandler::HandlePlayAllCommand,             "", NULL },
         { "repairitems",   SEC_GAMEMASTER,     false, &ChatHandler::HandleRepairitemsCommand,         "", NULL },
@@ -313,6 +313,9 @@ class ChatHandler
         bool HandleInstanceSaveDataCommand(const char * args);
 
         bool HandleServerCorpsesCommand(const char* args);
+        bool HandleServerOpcodesCommand(const char* args);
+        bool HandleServerLosCommand(const char* args);
+        bool HandleServerTraceCommand(const char* args);
         bool HandleServerExitCommand(const char* args);
         bool HandleServerIdleRestartCommand(const char* args);
         bool HandleServerIdleShutDownCommand(const char* args);
@@ -498,6 +501,7 @@ class ChatHandler
         bool HandleSendMessageCommand(const char * args);
         bool HandleFlushArenaPointsCommand(const char *args);
         bool HandleCancelFlushCommand(const char *args);
+        bool HandleFlushArenaSeasonCommand(const char *args);
         bool HandlePlayAllCommand(const char* args);
         bool HandleRepairitemsCommand(const char* args);
 
@@ -526,6 +530,9 @@ class ChatHandler
         bool HandleUnbindSightCommand(const char* args);
         bool HandleSetInstanceDataCommand(const char* args);
         bool HandleGetInstanceDataCommand(const char* args);
+        bool HandleDebugReplayCommand(const char* args);
+        bool HandleDebugBGQueueBenchCommand(const char* args);
+        bool HandleDebugUpdateMaskBenchCommand(const char* args);
 
         // Arena spectator Commands
         bool HandleArenaSpecResetCommand(const char* args);
@@ -36,6 +36,8 @@
 #include <fstream>
 #include "ObjectMgr.h"
 #include "InstanceScript.h"
+#include "PacketCapture.h"
+#include "UpdateMask.h"
 
 bool ChatHandler::HandleDebugInArcCommand(const char* /*args*/)
 {
@@ -702,3 +704,200 @@ bool ChatHandler::HandleGetInstanceDataCommand(const char *args)
     return true;
 }
 
+// .debug replay <capture file> [account id]
+// replays the captured packets of the account (the first one in the file if not given) into the session of the selected player
+bool ChatHandler::HandleDebugReplayCommand(const char *args)
+{
+    if (!*args)
+        return false;
+
+    char *file = strtok((char*)args, " ");
+    char *account = strtok(NULL, " ");
+
+    if (!file)
+        return false;
+
+    Player* target = getSelectedPlayer();
+    if (!target)
+    {
+        SendSysMessage(LANG_NO_CHAR_SELECTED);
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    std::string path = PacketCapture::GetPath(file);
+    if (path.empty())
+    {
+        PSendSysMessage("%s is not a file name, captures are read from LogsDir.", file);
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    uint32 accountId = account ? uint32(atoi(account)) : 0;
+    PacketCaptureRecordList records;
+    uint32 skipped;
+    if (!PacketCapture::Load(path, accountId, records, skipped))
+    {
+        PSendSysMessage("%s is not a packet capture.", path.c_str());
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    if (records.empty())
+    {
+        PSendSysMessage("No packets of account %u in %s.", accountId, file);
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    target->GetSession()->StartReplay(records);
+    PSendSysMessage("Replaying %u packets over %u ms into the session of %s, %u packets that are not movement or queries skipped.",
+        uint32(records.size()), records.back().time, target->GetName(), skipped);
+    return true;
+}
+
+bool ChatHandler::HandleDebugBGQueueBenchCommand(const char *args)
+{
+    char *count = strtok((char*)args, " ");
+    char *type = strtok(NULL, " ");
+
+    uint32 groupCount = count ? uint32(atoi(count)) : 10000;
+    uint8 arenaType = type ? uint8(atoi(type)) : ARENA_TYPE_2v2;
+
+    if (!groupCount || (arenaType != ARENA_TYPE_2v2 && arenaType != ARENA_TYPE_SOLO_3v3 && arenaType != ARENA_TYPE_3v3 && arenaType != ARENA_TYPE_5v5))
+        return false;
+
+    // the benchmark runs in the world thread
+    groupCount = std::min(groupCount, uint32(100000));
+
+    // a scratch queue, the live queues are not touched
+    BattleGroundQueue queue;
+    uint32 attempts, matches;
+    uint64 elapsedUs;
+    queue.BenchmarkMatching(groupCount, arenaType, attempts, matches, elapsedUs);
+
+    PSendSysMessage("%u synthetic groups of arena type %u: %u matches in %u queue updates, %u us total, %u us per update, %u us per match.",
+        groupCount, arenaType, matches, attempts, uint32(elapsedUs), attempts ? uint32(elapsedUs / attempts) : 0, matches ? uint32(elapsedUs / matches) : 0);
+    return true;
+}
+
+// the heap allocated mask UpdateMask replaced, only kept for .debug updatemaskbench
+struct HeapUpdateMask
+{
+    HeapUpdateMask() : mCount(0), mBlocks(0), mUpdateMask(NULL) { }
+    ~HeapUpdateMask() { delete [] mUpdateMask; }
+
+    void SetCount(uint32 valuesCount)
+    {
+        delete [] mUpdateMask;
+        mCount = valuesCount;
+        mBlocks = (valuesCount + 31) / 32;
+        mUpdateMask = new uint32[mBlocks];
+        memset(mUpdateMask, 0, mBlocks << 2);
+    }
+
+    void SetBit(uint32 index) { ((uint8*)mUpdateMask)[index >> 3] |= 1 << (index & 0x7); }
+    bool GetBit(uint32 index) const { return (((uint8*)mUpdateMask)[index >> 3] & (1 << (index & 0x7))) != 0; }
+
+    // operator & of the old mask, which copied into a freshly allocated mask
+    void And(HeapUpdateMask const& a, HeapUpdateMask const& b)
+    {
+        SetCount(a.mCount);
+        for (uint32 i = 0; i < mBlocks; ++i)
+            mUpdateMask[i] = a.mUpdateMask[i] & b.mUpdateMask[i];
+    }
+
+    uint32 mCount;
+    uint32 mBlocks;
+    uint32* mUpdateMask;
+};
+
+// same work as _BuildValuesUpdate of an object with fieldCount fields for one observer: build the
+// changed fields mask, and it with the visibility mask of the observer, then walk the set bits
+static bool BenchUpdateMask(ChatHandler* handler, char const* type, uint32 fieldCount, uint32 iterations, uint32 changedFields)
+{
+    changedFields = std::min(changedFields, fieldCount);
+
+    std::vector<uint32> fields(changedFields);
+    HeapUpdateMask heapVisible;
+    UpdateMask visible;
+    heapVisible.SetCount(fieldCount);
+    visible.SetCount(fieldCount);
+    for (uint32 i = 0; i < fieldCount; ++i)
+    {
+        if (urand(0, 3))
+        {
+            heapVisible.SetBit(i);
+            visible.SetBit(i);
+        }
+    }
+    for (uint32 i = 0; i < changedFields; ++i)
+        fields[i] = urand(0, fieldCount - 1);
+
+    uint64 heapSum = 0;
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+    for (uint32 n = 0; n < iterations; ++n)
+    {
+        HeapUpdateMask changedMask, mask;
+        changedMask.SetCount(fieldCount);
+        for (uint32 i = 0; i < changedFields; ++i)
+            changedMask.SetBit(fields[i]);
+        mask.And(changedMask, heapVisible);
+        for (uint32 index = 0; index < mask.mCount; ++index)
+            if (mask.GetBit(index))
+                heapSum += index;
+    }
+    ACE_Time_Value heapElapsed = ACE_OS::gettimeofday() - start;
+
+    uint64 sum = 0;
+    start = ACE_OS::gettimeofday();
+    for (uint32 n = 0; n < iterations; ++n)
+    {
+        UpdateMask changedMask;
+        changedMask.SetCount(fieldCount);
+        for (uint32 i = 0; i < changedFields; ++i)
+            changedMask.SetBit(fields[i]);
+        UpdateMask mask = changedMask & visible;
+        for (uint32 index = mask.FindNextBit(0); index < mask.GetCount(); index = mask.FindNextBit(index + 1))
+            sum += index;
+    }
+    ACE_Time_Value elapsed = ACE_OS::gettimeofday() - start;
+
+    // both walks have to visit the same fields
+    if (sum != heapSum)
+    {
+        handler->PSendSysMessage("%s masks disagree: %u vs %u.", type, uint32(sum), uint32(heapSum));
+        return false;
+    }
+
+    uint64 heapUs = uint64(heapElapsed.sec()) * 1000000 + heapElapsed.usec();
+    uint64 us = uint64(elapsed.sec()) * 1000000 + elapsed.usec();
+    handler->PSendSysMessage("%s: %u mask builds of %u changed fields out of %u: heap mask %u us (%u ns each), fixed mask %u us (%u ns each).",
+        type, iterations, changedFields, fieldCount, uint32(heapUs), uint32(heapUs * 1000 / iterations), uint32(us), uint32(us * 1000 / iterations));
+    return true;
+}
+
+bool ChatHandler::HandleDebugUpdateMaskBenchCommand(const char *args)
+{
+    char *count = strtok((char*)args, " ");
+    char *changed = strtok(NULL, " ");
+
+    uint32 iterations = count ? uint32(atoi(count)) : 100000;
+    uint32 changedFields = changed ? uint32(atoi(changed)) : 20;
+
+    if (!iterations || !changedFields || changedFields > PLAYER_END)
+        return false;
+
+    // the benchmark runs in the world thread
+    iterations = std::min(iterations, uint32(1000000));
+
+    // creatures and pets send UNIT_END fields, players PLAYER_END
+    if (!BenchUpdateMask(this, "Unit", UNIT_END, iterations, changedFields) ||
+        !BenchUpdateMask(this, "Player", PLAYER_END, iterations, changedFields))
+    {
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    return true;
+}
@@ -36,6 +36,7 @@
 #include "BattlegroundMgr.h"
 #include "TempEventMgr.h"
 #include "Titles.h"
+#include "WorldSocketMgr.h"
 
 bool ChatHandler::HandleHelpCommand(const char* args)
 {
@@ -112,6 +113,38 @@ bool ChatHandler::HandleServerInfoCommand(const char* /*args*/)
     PSendSysMessage(LANG_CONNECTED_USERS, activeClientsNum, maxActiveClientsNum, queuedClientsNum, maxQueuedClientsNum);
     PSendSysMessage(LANG_UPTIME, str.c_str());
     PSendSysMessage("Update time diff: %u.", updateTime);
+    if (!m_session || m_session->GetSecurity() >= SEC_GAMEMASTER)
+    {
+        uint64 hits = sObjectAccessor->GetUpdateBlockCacheHits();
+        uint64 misses = sObjectAccessor->GetUpdateBlockCacheMisses();
+        PSendSysMessage("Update block cache: " UI64FMTD " hits, " UI64FMTD " misses (%.1f%% hit rate).", hits, misses,
+            hits + misses ? float(hits) * 100.0f / float(hits + misses) : 0.0f);
+
+        PSendSysMessage("Logins: %u, average %u ms (%u ms waiting for the database).", sWorld->GetLoginCount(),
+            sWorld->GetAverageLoginTime(), sWorld->GetAverageLoginQueryTime());
+        if (sWorld->GetLoginCount())
+        {
+            std::ostringstream ss;
+            for (uint8 i = 0; i < LOGIN_LATENCY_BUCKETS; ++i)
+            {
+                if (i < LOGIN_LATENCY_BUCKETS - 1)
+                    ss << "<" << LoginLatencyBucketLimits[i] << "ms: ";
+                else
+                    ss << ">=" << LoginLatencyBucketLimits[i - 1] << "ms: ";
+                ss << sWorld->GetLoginLatencyCount(i) << (i < LOGIN_LATENCY_BUCKETS - 1 ? ", " : "");
+            }
+            PSendSysMessage("Login latency: %s", ss.str().c_str());
+        }
+
+        uint64 saves = sWorld->GetCharacterSaveCount();
+        PSendSysMessage("Character saves: " UI64FMTD ", average " UI64FMTD " rows / " UI64FMTD " bytes written.", saves,
+            saves ? sWorld->GetCharacterSaveRows() / saves : 0, saves ? sWorld->GetCharacterSaveBytes() / saves : 0);
+
+        uint64 sends = sWorldSocketMgr->GetSendCalls();
+        PSendSysMessage("Network: " UI64FMTD " packets in " UI64FMTD " sends (%.1f per send), " UI64FMTD " queued, peak queue " UI64FMTD " bytes, " UI64FMTD " clients dropped.",
+            sWorldSocketMgr->GetSentPackets(), sends, sends ? float(sWorldSocketMgr->GetSentPackets()) / float(sends) : 0.0f,
+            sWorldSocketMgr->GetQueuedPackets(), sWorldSocketMgr->GetPeakQueueBytes(), sWorldSocketMgr->GetQueueOverflows());
+    }
     if (sWorld->getConfig(CONFIG_ARENA_AUTO_DISTRIBUTE_POINTS))
         PSendSysMessage("Next arena flush: %s", nextFlushStr.c_str());
 
@@ -42,6 +42,9 @@
 #include "TicketMgr.h"
 #include "TargetedMovementGenerator.h"                      // for HandleNpcUnFollowCommand
 #include "TempEventMgr.h"
+#include "OpcodeStats.h"
+#include "LineOfSightCache.h"
+#include "TickTracer.h"
 
 #include <cctype>
 #include <iostream>
@@ -3748,6 +3751,59 @@ bool ChatHandler::HandleServerCorpsesCommand(const char* /*args*/)
     return true;
 }
 
+// .server opcodes [count] - the opcode handlers with the most time spent
+bool ChatHandler::HandleServerOpcodesCommand(const char* args)
+{
+    uint32 limit = *args ? uint32(atoi(args)) : 10;
+    if (!limit)
+        limit = 10;
+
+    sOpcodeStats->Merge();
+
+    std::vector<std::pair<uint64, uint16> > byTime;
+    for (uint16 i = 0; i < NUM_MSG_TYPES; ++i)
+        if (uint64 total = sOpcodeStats->GetMerged(i).totalTime)
+            byTime.push_back(std::make_pair(total, i));
+
+    std::sort(byTime.rbegin(), byTime.rend());
+
+    for (uint32 i = 0; i < byTime.size() && i < limit; ++i)
+    {
+        OpcodeStatsEntry const& entry = sOpcodeStats->GetMerged(byTime[i].second);
+        PSendSysMessage("%s: " UI64FMTD " calls, " UI64FMTD " ms total, avg " UI64FMTD " us, p99 " UI64FMTD " us, max " UI64FMTD " us, " UI64FMTD " bytes",
+            LookupOpcodeName(byTime[i].second), entry.count, entry.totalTime / 1000, entry.totalTime / entry.count,
+            entry.GetPercentile(0.99f), entry.maxTime, entry.bytes);
+    }
+
+    return true;
+}
+
+// .server trace on|off - tick phase tracing, dumped when a world update goes over Trace.TickBudget
+bool ChatHandler::HandleServerTraceCommand(const char* args)
+{
+    std::string argstr = (char*)args;
+    if (argstr == "on")
+        sTickTracer->SetEnabled(true);
+    else if (argstr == "off")
+        sTickTracer->SetEnabled(false);
+    else if (!argstr.empty())
+        return false;
+
+    PSendSysMessage("Tick tracing is %s, traces are written for world updates over %u ms.",
+        sTickTracer->IsEnabled() ? "on" : "off", sWorld->getConfig(CONFIG_TICK_TRACE_BUDGET));
+    return true;
+}
+
+// .server los - hit rate of the line of sight caches of all maps
+bool ChatHandler::HandleServerLosCommand(const char* /*args*/)
+{
+    uint64 hits = LineOfSightCache::GetHits();
+    uint64 checks = hits + LineOfSightCache::GetMisses();
+    PSendSysMessage("Line of sight: " UI64FMTD " checks, " UI64FMTD " cache hits (%.1f%%), " UI64FMTD " rays traced in batches",
+        checks, hits, checks ? float(hits) * 100.0f / float(checks) : 0.0f, LineOfSightCache::GetBatchedRays());
+    return true;
+}
+
 bool ChatHandler::HandleRepairitemsCommand(const char* /*args*/)
 {
     Player *target = getSelectedPlayer();
@@ -6807,6 +6807,12 @@ bool ChatHandler::HandleFlushArenaPointsCommand(const char * /*args*/)
     return true;
 }
 
+bool ChatHandler::HandleFlushArenaSeasonCommand(const char * /*args*/)
+{
+    sBattleGroundMgr->FinishArenaSeason();
+    return true;
+}
+
 bool ChatHandler::HandleCancelFlushCommand(const char * /*args*/)
 {
     sBattleGroundMgr->CancelAutomaticArenaPointDistribution();
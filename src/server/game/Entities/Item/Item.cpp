@@ -23,6 +23,7 @@
 #include "ObjectMgr.h"
 #include "WorldPacket.h"
 #include "DatabaseEnv.h"
+#include "PreparedStatements.h"
 #include "ItemEnchantmentMgr.h"
 
 void AddItemsSetItem(Player*player, Item *item)
@@ -295,21 +296,26 @@ void Item::SaveToDB()
         case ITEM_NEW:
         {
             std::ostringstream ss;
-            ss << "REPLACE INTO item_instance (guid, owner_guid, data) VALUES (" << guid << ", " << GUID_LOPART(GetOwnerGUID()) << ", '";
             for (uint16 i = 0; i < m_valuesCount; ++i)
                 ss << GetUInt32Value(i) << " ";
-            ss << "')";
-            CharacterDatabase.Execute(ss.str().c_str());
+
+            PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_REP_ITEM_INSTANCE);
+            stmt->SetUInt32(0, guid);
+            stmt->SetUInt32(1, GUID_LOPART(GetOwnerGUID()));
+            stmt->SetString(2, ss.str());
+            CharacterDatabase.Execute(stmt);
         } break;
         case ITEM_CHANGED:
         {
             std::ostringstream ss;
-            ss << "UPDATE item_instance SET data = '";
             for (uint16 i = 0; i < m_valuesCount; ++i)
                 ss << GetUInt32Value(i) << " ";
-            ss << "', owner_guid = '" << GUID_LOPART(GetOwnerGUID()) << "' WHERE guid = '" << guid << "'";
 
-            CharacterDatabase.Execute(ss.str().c_str());
+            PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_UPD_ITEM_INSTANCE);
+            stmt->SetString(0, ss.str());
+            stmt->SetUInt32(1, GUID_LOPART(GetOwnerGUID()));
+            stmt->SetUInt32(2, guid);
+            CharacterDatabase.Execute(stmt);
 
             if (HasFlag(ITEM_FIELD_FLAGS, ITEM_FLAGS_WRAPPED))
                 CharacterDatabase.PExecute("UPDATE character_gifts SET guid = '%u' WHERE item_guid = '%u'", GUID_LOPART(GetOwnerGUID()), GetGUIDLow());
@@ -318,7 +324,9 @@ void Item::SaveToDB()
         {
             if (GetUInt32Value(ITEM_FIELD_ITEM_TEXT_ID) > 0)
                 CharacterDatabase.PExecute("DELETE FROM item_text WHERE id = '%u'", GetUInt32Value(ITEM_FIELD_ITEM_TEXT_ID));
-            CharacterDatabase.PExecute("DELETE FROM item_instance WHERE guid = '%u'", guid);
+            PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_ITEM_INSTANCE);
+            stmt->SetUInt32(0, guid);
+            CharacterDatabase.Execute(stmt);
             if (HasFlag(ITEM_FIELD_FLAGS, ITEM_FLAGS_WRAPPED))
                 CharacterDatabase.PExecute("DELETE FROM character_gifts WHERE item_guid = '%u'", GetGUIDLow());
             delete this;
@@ -216,19 +216,22 @@ void Object::SendUpdateToPlayer(Player* player)
 void Object::BuildValuesUpdateBlockForPlayer(UpdateData *data, Player *target) const
 {
     ByteBuffer buf(500);
+    _BuildValuesUpdateBlock(&buf, target);
+    data->AddUpdateBlock(buf);
+}
 
-    buf << (uint8) UPDATETYPE_VALUES;
-    //buf << GetPackGUID();                                 //client crashes when using this. but not have crash in debug mode
-    buf << (uint8)0xFF;
-    buf << GetGUID();
+void Object::_BuildValuesUpdateBlock(ByteBuffer *data, Player *target) const
+{
+    *data << (uint8) UPDATETYPE_VALUES;
+    //*data << GetPackGUID();                               //client crashes when using this. but not have crash in debug mode
+    *data << (uint8)0xFF;
+    *data << GetGUID();
 
     UpdateMask updateMask;
     updateMask.SetCount(m_valuesCount);
 
     _SetUpdateBits(&updateMask, target);
-    _BuildValuesUpdate(UPDATETYPE_VALUES, &buf, &updateMask, target);
-
-    data->AddUpdateBlock(buf);
+    _BuildValuesUpdate(UPDATETYPE_VALUES, data, &updateMask, target);
 }
 
 void Object::BuildOutOfRangeUpdateBlock(UpdateData * data) const
@@ -544,177 +547,173 @@ void Object::_BuildValuesUpdate(uint8 updatetype, ByteBuffer * data, UpdateMask
     ASSERT(updateMask && updateMask->GetCount() == m_valuesCount);
 
     *data << (uint8)updateMask->GetBlockCount();
+#if TRINITY_ENDIAN == TRINITY_BIGENDIAN
+    for (uint32 i = 0; i < updateMask->GetBlockCount(); ++i)
+        *data << updateMask->GetBlock(i);
+#else
     data->append(updateMask->GetMask(), updateMask->GetLength());
+#endif
 
     // 2 specialized loops for speed optimization in non-unit case
     if (isType(TYPEMASK_UNIT))                               // unit (creature/player) case
     {
-        for (uint16 index = 0; index < m_valuesCount; index ++)
+        for (uint32 index = updateMask->FindNextBit(0); index < m_valuesCount; index = updateMask->FindNextBit(index + 1))
         {
-            if (updateMask->GetBit(index))
+            // remove custom flag before send
+            if (index == UNIT_NPC_FLAGS)
+                *data << uint32(m_uint32Values[ index ] & ~(UNIT_NPC_FLAG_GUARD + UNIT_NPC_FLAG_OUTDOORPVP));
+            // FIXME: Some values at server stored in float format but must be sent to client in uint32 format
+            else if (index >= UNIT_FIELD_BASEATTACKTIME && index <= UNIT_FIELD_RANGEDATTACKTIME)
             {
-                // remove custom flag before send
-                if (index == UNIT_NPC_FLAGS)
-                    *data << uint32(m_uint32Values[ index ] & ~(UNIT_NPC_FLAG_GUARD + UNIT_NPC_FLAG_OUTDOORPVP));
-                // FIXME: Some values at server stored in float format but must be sent to client in uint32 format
-                else if (index >= UNIT_FIELD_BASEATTACKTIME && index <= UNIT_FIELD_RANGEDATTACKTIME)
-                {
-                    // convert from float to uint32 and send
-                    *data << uint32(m_floatValues[ index ] < 0 ? 0 : m_floatValues[ index ]);
-                }
-                // there are some float values which may be negative or can't get negative due to other checks
-                else if ((index >= UNIT_FIELD_NEGSTAT0   && index <= UNIT_FIELD_NEGSTAT4) ||
-                    (index >= UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE  && index <= (UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE + 6)) ||
-                    (index >= UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE  && index <= (UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE + 6)) ||
-                    (index >= UNIT_FIELD_POSSTAT0   && index <= UNIT_FIELD_POSSTAT4))
-                {
-                    *data << uint32(m_floatValues[ index ]);
-                }
-                // Gamemasters should be always able to select units - remove not selectable flag
-                else if (index == UNIT_FIELD_FLAGS && target->isGameMaster())
-                {
-                    *data << (m_uint32Values[ index ] & ~UNIT_FLAG_NOT_SELECTABLE);
-                }
-                // use modelid_a if not gm, _h if gm for CREATURE_FLAG_EXTRA_TRIGGER creatures
-                else if (index == UNIT_FIELD_DISPLAYID && GetTypeId() == TYPEID_UNIT)
+                // convert from float to uint32 and send
+                *data << uint32(m_floatValues[ index ] < 0 ? 0 : m_floatValues[ index ]);
+            }
+            // there are some float values which may be negative or can't get negative due to other checks
+            else if ((index >= UNIT_FIELD_NEGSTAT0   && index <= UNIT_FIELD_NEGSTAT4) ||
+                (index >= UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE  && index <= (UNIT_FIELD_RESISTANCEBUFFMODSPOSITIVE + 6)) ||
+                (index >= UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE  && index <= (UNIT_FIELD_RESISTANCEBUFFMODSNEGATIVE + 6)) ||
+                (index >= UNIT_FIELD_POSSTAT0   && index <= UNIT_FIELD_POSSTAT4))
+            {
+                *data << uint32(m_floatValues[ index ]);
+            }
+            // Gamemasters should be always able to select units - remove not selectable flag
+            else if (index == UNIT_FIELD_FLAGS && target->isGameMaster())
+            {
+                *data << (m_uint32Values[ index ] & ~UNIT_FLAG_NOT_SELECTABLE);
+            }
+            // use modelid_a if not gm, _h if gm for CREATURE_FLAG_EXTRA_TRIGGER creatures
+            else if (index == UNIT_FIELD_DISPLAYID && GetTypeId() == TYPEID_UNIT)
+            {
+                const CreatureTemplate* cinfo = ToCreature()->GetCreatureTemplate();
+                if (cinfo->flags_extra & CREATURE_FLAG_EXTRA_TRIGGER)
                 {
-                    const CreatureTemplate* cinfo = ToCreature()->GetCreatureTemplate();
-                    if (cinfo->flags_extra & CREATURE_FLAG_EXTRA_TRIGGER)
+                    if (target->isGameMaster())
                     {
-                        if (target->isGameMaster())
-                        {
-                            if (cinfo->Modelid1)
-                                *data << cinfo->Modelid1; // Modelid1 is a visible model for gm's
-                            else
-                                *data << 17519; // world invisible trigger's model
-                        }
+                        if (cinfo->Modelid1)
+                            *data << cinfo->Modelid1; // Modelid1 is a visible model for gm's
                         else
-                        {
-                            if (cinfo->Modelid2)
-                                *data << cinfo->Modelid2; // Modelid2 is an invisible model for players
-                            else
-                                *data << 11686; // world invisible trigger's model
-                        }
+                            *data << 17519; // world invisible trigger's model
                     }
                     else
-                        *data << m_uint32Values[ index ];
+                    {
+                        if (cinfo->Modelid2)
+                            *data << cinfo->Modelid2; // Modelid2 is an invisible model for players
+                        else
+                            *data << 11686; // world invisible trigger's model
+                    }
                 }
-                // hide lootable animation for players not allowed
-                else if (index == UNIT_DYNAMIC_FLAGS && GetTypeId() == TYPEID_UNIT)
+                else
+                    *data << m_uint32Values[ index ];
+            }
+            // hide lootable animation for players not allowed
+            else if (index == UNIT_DYNAMIC_FLAGS && GetTypeId() == TYPEID_UNIT)
+            {
+                if (!target->isAllowedToLoot(ToCreature()))
+                    *data << (m_uint32Values[ index ] & ~UNIT_DYNFLAG_LOOTABLE);
+                else
+                    *data << (m_uint32Values[ index ] & ~UNIT_DYNFLAG_OTHER_TAGGER);
+            }
+            // FG: pretend that OTHER players in own group are friendly ("blue")
+            else if (index == UNIT_FIELD_BYTES_2 || index == UNIT_FIELD_FACTIONTEMPLATE)
+            {
+            bool ch = false;
+                if (target->GetTypeId() == TYPEID_PLAYER && GetTypeId() == TYPEID_PLAYER && target != this)
                 {
-                    if (!target->isAllowedToLoot(ToCreature()))
-                        *data << (m_uint32Values[ index ] & ~UNIT_DYNFLAG_LOOTABLE);
-                    else
-                        *data << (m_uint32Values[ index ] & ~UNIT_DYNFLAG_OTHER_TAGGER);
-                }
-                // FG: pretend that OTHER players in own group are friendly ("blue")
-                else if (index == UNIT_FIELD_BYTES_2 || index == UNIT_FIELD_FACTIONTEMPLATE)
+                if (target->IsInSameGroupWith(ToPlayer()) || target->IsInSameRaidWith(ToPlayer()))
                 {
-                bool ch = false;
-                    if (target->GetTypeId() == TYPEID_PLAYER && GetTypeId() == TYPEID_PLAYER && target != this)
+                    if (index == UNIT_FIELD_BYTES_2)
                     {
-                    if (target->IsInSameGroupWith(ToPlayer()) || target->IsInSameRaidWith(ToPlayer()))
+                        sLog->outDebug("-- VALUES_UPDATE: Sending '%s' the blue-group-fix from '%s' (flag)", target->GetName(), ToPlayer()->GetName());
+                        *data << (m_uint32Values[ index ] & ((UNIT_BYTE2_FLAG_SANCTUARY | UNIT_BYTE2_FLAG_AURAS | UNIT_BYTE2_FLAG_UNK5) << 8)); // this flag is at uint8 offset 1 !!
+
+                        ch = true;
+                    }
+                    else if (index == UNIT_FIELD_FACTIONTEMPLATE)
                     {
-                        if (index == UNIT_FIELD_BYTES_2)
+                        FactionTemplateEntry const *ft1, *ft2;
+                        ft1 = ToPlayer()->getFactionTemplateEntry();
+                        ft2 = target->ToPlayer()->getFactionTemplateEntry();
+                        if (ft1 && ft2 && !ft1->IsFriendlyTo(*ft2))
                         {
-                            sLog->outDebug("-- VALUES_UPDATE: Sending '%s' the blue-group-fix from '%s' (flag)", target->GetName(), ToPlayer()->GetName());
-                            *data << (m_uint32Values[ index ] & ((UNIT_BYTE2_FLAG_SANCTUARY | UNIT_BYTE2_FLAG_AURAS | UNIT_BYTE2_FLAG_UNK5) << 8)); // this flag is at uint8 offset 1 !!
-
+                            uint32 faction = target->ToPlayer()->getFaction(); // pretend that all other HOSTILE players have own faction, to allow follow, heal, rezz (trade wont work)
+                            sLog->outDebug("-- VALUES_UPDATE: Sending '%s' the blue-group-fix from '%s' (faction %u)", target->GetName(), ToPlayer()->GetName(), faction);
+                            *data << uint32(faction);
                             ch = true;
                         }
-                        else if (index == UNIT_FIELD_FACTIONTEMPLATE)
-                        {
-                            FactionTemplateEntry const *ft1, *ft2;
-                            ft1 = ToPlayer()->getFactionTemplateEntry();
-                            ft2 = target->ToPlayer()->getFactionTemplateEntry();
-                            if (ft1 && ft2 && !ft1->IsFriendlyTo(*ft2))
-                            {
-                                uint32 faction = target->ToPlayer()->getFaction(); // pretend that all other HOSTILE players have own faction, to allow follow, heal, rezz (trade wont work)
-                                sLog->outDebug("-- VALUES_UPDATE: Sending '%s' the blue-group-fix from '%s' (faction %u)", target->GetName(), ToPlayer()->GetName(), faction);
-                                *data << uint32(faction);
-                                ch = true;
-                            }
-                        }
-                    }
                     }
-                    if (!ch)
-                        *data << m_uint32Values[ index ];
                 }
-                // Health should show up as pct value for non-friendly player case and general creature case
-                else if (index == UNIT_FIELD_HEALTH)
-                {
-                    if (GetTypeId() == TYPEID_UNIT || GetTypeId() == TYPEID_PLAYER)
-                    {
-                        const Unit* me = reinterpret_cast<const Unit*>(this);
-                        if (me->ShouldRevealHealthTo(target))
-                            *data << m_uint32Values[index];
-                        else
-                            *data << uint32(std::ceil(me->GetHealth() * 100.0f / me->GetMaxHealth()));
-                    }
-                    else
-                        *data << m_uint32Values[index];
                 }
-                else if (index == UNIT_FIELD_MAXHEALTH)
+                if (!ch)
+                    *data << m_uint32Values[ index ];
+            }
+            // Health should show up as pct value for non-friendly player case and general creature case
+            else if (index == UNIT_FIELD_HEALTH)
+            {
+                if (GetTypeId() == TYPEID_UNIT || GetTypeId() == TYPEID_PLAYER)
                 {
-                    if (GetTypeId() == TYPEID_UNIT || GetTypeId() == TYPEID_PLAYER)
-                    {
-                        const Unit* me = reinterpret_cast<const Unit*>(this);
-                        if (me->ShouldRevealHealthTo(target))
-                            *data << m_uint32Values[index];
-                        else
-                            *data << uint32(100);
-                    }
-                    else
+                    const Unit* me = reinterpret_cast<const Unit*>(this);
+                    if (me->ShouldRevealHealthTo(target))
                         *data << m_uint32Values[index];
+                    else
+                        *data << uint32(std::ceil(me->GetHealth() * 100.0f / me->GetMaxHealth()));
                 }
                 else
+                    *data << m_uint32Values[index];
+            }
+            else if (index == UNIT_FIELD_MAXHEALTH)
+            {
+                if (GetTypeId() == TYPEID_UNIT || GetTypeId() == TYPEID_PLAYER)
                 {
-                    // send in current format (float as float, uint32 as uint32)
-                    *data << m_uint32Values[ index ];
+                    const Unit* me = reinterpret_cast<const Unit*>(this);
+                    if (me->ShouldRevealHealthTo(target))
+                        *data << m_uint32Values[index];
+                    else
+                        *data << uint32(100);
                 }
+                else
+                    *data << m_uint32Values[index];
+            }
+            else
+            {
+                // send in current format (float as float, uint32 as uint32)
+                *data << m_uint32Values[ index ];
             }
         }
     }
     else if (isType(TYPEMASK_GAMEOBJECT))                    // gameobject case
     {
-        for (uint16 index = 0; index < m_valuesCount; ++index)
+        for (uint32 index = updateMask->FindNextBit(0); index < m_valuesCount; index = updateMask->FindNextBit(index + 1))
         {
-            if (updateMask->GetBit(index))
+            // send in current format (float as float, uint32 as uint32)
+            if (index == GAMEOBJECT_DYN_FLAGS)
             {
-                // send in current format (float as float, uint32 as uint32)
-                if (index == GAMEOBJECT_DYN_FLAGS)
+                if (IsActivateToQuest)
                 {
-                    if (IsActivateToQuest)
+                    switch (((GameObject*)this)->GetGoType())
                     {
-                        switch (((GameObject*)this)->GetGoType())
-                        {
-                            case GAMEOBJECT_TYPE_CHEST:
-                            case GAMEOBJECT_TYPE_GOOBER:
-                                *data << uint16(GO_DYNFLAG_LO_ACTIVATE | GO_DYNFLAG_LO_SPARKLE);
-                                *data << uint16(-1);
-                                break;
-                            default:
-                                *data << uint32(0);         // unknown, not happen.
-                                break;
-                        }
+                        case GAMEOBJECT_TYPE_CHEST:
+                        case GAMEOBJECT_TYPE_GOOBER:
+                            *data << uint16(GO_DYNFLAG_LO_ACTIVATE | GO_DYNFLAG_LO_SPARKLE);
+                            *data << uint16(-1);
+                            break;
+                        default:
+                            *data << uint32(0);         // unknown, not happen.
+                            break;
                     }
-                    else
-                        *data << uint32(0);                 // disable quest object
                 }
                 else
-                    *data << m_uint32Values[ index ];       // other cases
+                    *data << uint32(0);                 // disable quest object
             }
+            else
+                *data << m_uint32Values[ index ];       // other cases
         }
     }
     else                                                    // other objects case (no special index checks)
     {
-        for (uint16 index = 0; index < m_valuesCount; ++index)
+        for (uint32 index = updateMask->FindNextBit(0); index < m_valuesCount; index = updateMask->FindNextBit(index + 1))
         {
-            if (updateMask->GetBit(index))
-            {
-                // send in current format (float as float, uint32 as uint32)
-                *data << m_uint32Values[ index ];
-            }
+            // send in current format (float as float, uint32 as uint32)
+            *data << m_uint32Values[ index ];
         }
     }
 }
@@ -731,7 +730,7 @@ void Object::ClearUpdateMask(bool remove)
     }
 }
 
-void Object::BuildFieldsUpdate(Player *pl, UpdateDataMapType &data_map) const
+void Object::BuildFieldsUpdate(Player *pl, UpdateDataMapType &data_map, UpdateBlockCache* cache) const
 {
     UpdateDataMapType::iterator iter = data_map.find(pl);
 
@@ -742,9 +741,67 @@ void Object::BuildFieldsUpdate(Player *pl, UpdateDataMapType &data_map) const
         iter = p.first;
     }
 
+    if (cache)
+    {
+        UpdateVisibilityClass visibility = GetUpdateVisibilityClass(pl);
+        if (visibility != UPDATE_VISIBILITY_UNCACHED)
+        {
+            ByteBuffer*& block = cache->blocks[visibility];
+            if (block)
+                ++cache->hits;
+            else
+            {
+                ++cache->misses;
+                block = new ByteBuffer(500);
+                _BuildValuesUpdateBlock(block, pl);
+            }
+
+            iter->second.AddUpdateBlock(*block);
+            return;
+        }
+    }
+
     BuildValuesUpdateBlockForPlayer(&iter->second, iter->first);
 }
 
+// The values block only differs between observers for the fields special cased in
+// _BuildValuesUpdate. Observers which get the same output share a class, observers
+// for which a per target field is about to be sent are built one by one.
+UpdateVisibilityClass Object::GetUpdateVisibilityClass(Player *target) const
+{
+    if (target == this)
+        return UPDATE_VISIBILITY_OWNER;
+
+    // not selectable flag, trigger models, health and quest objects differ for gamemasters
+    if (target->isGameMaster())
+        return UPDATE_VISIBILITY_UNCACHED;
+
+    if (isType(TYPEMASK_GAMEOBJECT))
+        return ((GameObject*)this)->IsTransport() ? UPDATE_VISIBILITY_OTHERS : UPDATE_VISIBILITY_UNCACHED;
+
+    if (!isType(TYPEMASK_UNIT))
+        return UPDATE_VISIBILITY_OTHERS;
+
+    // lootable flag depends on the loot recipient
+    if (GetTypeId() == TYPEID_UNIT && m_uint32Values[UNIT_DYNAMIC_FLAGS] != m_uint32Values_mirror[UNIT_DYNAMIC_FLAGS])
+        return UPDATE_VISIBILITY_UNCACHED;
+
+    bool group = ((Unit*)this)->ShouldRevealHealthTo(target);
+
+    if (GetTypeId() == TYPEID_PLAYER)
+    {
+        // the blue group fix has to agree with the health reveal and sends the observer's own faction
+        bool sameGroup = target->IsInSameGroupWith(ToPlayer()) || target->IsInSameRaidWith(ToPlayer());
+        if (sameGroup != group)
+            return UPDATE_VISIBILITY_UNCACHED;
+
+        if (sameGroup && m_uint32Values[UNIT_FIELD_FACTIONTEMPLATE] != m_uint32Values_mirror[UNIT_FIELD_FACTIONTEMPLATE])
+            return UPDATE_VISIBILITY_UNCACHED;
+    }
+
+    return group ? UPDATE_VISIBILITY_GROUP : UPDATE_VISIBILITY_OTHERS;
+}
+
 bool Object::LoadValues(const char* data)
 {
     if (!m_uint32Values) _InitValues();
@@ -1042,6 +1099,7 @@ WorldObject::WorldObject()
     : WorldLocation(), m_InstanceId(0), m_currMap(NULL)
     , m_zoneScript(NULL)
     , m_isActive(false), m_isWorldObject(false)
+    , m_positionIndexCell(CELL_POSITION_INDEX_NONE), m_positionIndexSlot(0)
     , m_name("")
     , m_notifyflags(0), m_executed_notifies(0)
 {
@@ -1167,7 +1225,11 @@ bool WorldObject::IsWithinLOS(float ox, float oy, float oz) const
 {
     float x, y, z;
     GetPosition(x, y, z);
+    if (Map* map = FindMap())
+        return map->IsInLineOfSight(x, y, z+2.0f, ox, oy, oz+2.0f);
+
     VMAP::IVMapManager *vMapManager = VMAP::VMapFactory::createOrGetVMapManager();
+    vMapManager->recordLineOfSight(GetMapId(), x, y, z+2.0f, ox, oy, oz+2.0f);
     return vMapManager->isInLineOfSight(GetMapId(), x, y, z+2.0f, ox, oy, oz+2.0f);
 }
 
@@ -2089,6 +2151,7 @@ struct WorldObjectChangeAccumulator
     UpdateDataMapType &i_updateDatas;
     WorldObject &i_object;
     std::set<uint64> plr_list;
+    UpdateBlockCache i_cache;
     WorldObjectChangeAccumulator(WorldObject &obj, UpdateDataMapType &d) : i_updateDatas(d), i_object(obj) {}
     void Visit(PlayerMapType &m)
     {
@@ -2135,7 +2198,7 @@ struct WorldObjectChangeAccumulator
         // Only send update once to a player
         if (plr_list.find(plr->GetGUID()) == plr_list.end() && plr->HaveAtClient(&i_object))
         {
-            i_object.BuildFieldsUpdate(plr, i_updateDatas);
+            i_object.BuildFieldsUpdate(plr, i_updateDatas, &i_cache);
             plr_list.insert(plr->GetGUID());
         }
     }
@@ -2155,6 +2218,9 @@ void WorldObject::BuildUpdate(UpdateDataMapType& data_map)
     //we must build packets for all visible players
     cell.Visit(p, player_notifier, map, *this, map.GetVisibilityDistance());
 
+    if (notifier.i_cache.hits || notifier.i_cache.misses)
+        sObjectAccessor->AddUpdateBlockCacheStats(notifier.i_cache.hits, notifier.i_cache.misses);
+
     ClearUpdateMask(false);
 }
 
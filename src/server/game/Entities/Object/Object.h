@@ -138,6 +138,35 @@ class Unit;
 
 typedef UNORDERED_MAP<Player*, UpdateData> UpdateDataMapType;
 
+// observers which get byte-identical values update blocks of an object
+enum UpdateVisibilityClass
+{
+    UPDATE_VISIBILITY_OWNER     = 0,
+    UPDATE_VISIBILITY_GROUP     = 1,
+    UPDATE_VISIBILITY_OTHERS    = 2,
+    MAX_UPDATE_VISIBILITY       = 3,
+    UPDATE_VISIBILITY_UNCACHED  = MAX_UPDATE_VISIBILITY     // block depends on the observer itself
+};
+
+// values update blocks of one object, built once per visibility class during one BuildUpdate
+struct UpdateBlockCache
+{
+    UpdateBlockCache() : hits(0), misses(0)
+    {
+        for (uint8 i = 0; i < MAX_UPDATE_VISIBILITY; ++i)
+            blocks[i] = NULL;
+    }
+    ~UpdateBlockCache()
+    {
+        for (uint8 i = 0; i < MAX_UPDATE_VISIBILITY; ++i)
+            delete blocks[i];
+    }
+
+    ByteBuffer* blocks[MAX_UPDATE_VISIBILITY];
+    uint32 hits;
+    uint32 misses;
+};
+
 class Object
 {
     public:
@@ -332,7 +361,8 @@ class Object
         virtual bool hasQuest(uint32 /* quest_id */) const { return false; }
         virtual bool hasInvolvedQuest(uint32 /* quest_id */) const { return false; }
         virtual void BuildUpdate(UpdateDataMapType&) {}
-        void BuildFieldsUpdate(Player *, UpdateDataMapType &) const;
+        void BuildFieldsUpdate(Player *, UpdateDataMapType &, UpdateBlockCache* cache = NULL) const;
+        UpdateVisibilityClass GetUpdateVisibilityClass(Player *target) const;
 
         void MarkForClientUpdate();
 
@@ -361,6 +391,7 @@ class Object
         virtual void _SetCreateBits(UpdateMask *updateMask, Player *target) const;
         void _BuildMovementUpdate(ByteBuffer * data, uint8 updateFlags) const;
         void _BuildValuesUpdate(uint8 updatetype, ByteBuffer *data, UpdateMask *updateMask, Player *target) const;
+        void _BuildValuesUpdateBlock(ByteBuffer *data, Player *target) const;
 
         uint16 m_objectType;
 
@@ -790,6 +821,10 @@ class WorldObject : public Object, public WorldLocation
 
         bool m_isWorldObject;
 
+        // cell id and slot of the last cell position index this object was packed into, see Map::FindInPositionIndex
+        uint32 m_positionIndexCell;
+        uint32 m_positionIndexSlot;
+
         MovementInfo m_movementInfo;
 
     protected:
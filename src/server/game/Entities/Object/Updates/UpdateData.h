@@ -56,6 +56,7 @@ class UpdateData
         void AddUpdateBlock(const ByteBuffer &block);
         bool BuildPacket(WorldPacket *packet, bool hasTransport = false);
         bool HasData() { return m_blockCount > 0 || !m_outOfRangeGUIDs.empty(); }
+        size_t GetBufferSize() const { return m_data.size(); }
         void Clear();
 
         std::set<uint64> const& GetOutOfRangeGUIDs() const { return m_outOfRangeGUIDs; }
@@ -23,60 +23,83 @@
 
 #include "UpdateFields.h"
 #include "Errors.h"
+#include "Define.h"
 
+#if COMPILER == COMPILER_MICROSOFT
+#  include <intrin.h>
+#endif
+
+// players have the most update fields of all object types
+#define UPDATE_MASK_MAX_BLOCKS ((PLAYER_END + 31) / 32)
+
+// Fixed capacity values mask, lives on the stack and is never heap allocated.
+// Bits are kept in 32 bit blocks (client format), set bits are walked a block
+// at a time with FindNextBit instead of testing every field.
 class UpdateMask
 {
     public:
-        UpdateMask() : mCount(0), mBlocks(0), mUpdateMask(0) { }
-        UpdateMask(const UpdateMask& mask) : mUpdateMask(0) { *this = mask; }
+        UpdateMask() : mCount(0), mBlocks(0) { }
+        UpdateMask(const UpdateMask& mask) { *this = mask; }
 
-        ~UpdateMask()
+        void SetBit (uint32 index)
         {
-            if (mUpdateMask)
-                delete [] mUpdateMask;
+            mUpdateMask[ index >> 5 ] |= 1u << (index & 0x1F);
         }
 
-        void SetBit (uint32 index)
+        void UnsetBit (uint32 index)
         {
-            ((uint8 *)mUpdateMask)[ index >> 3 ] |= 1 << (index & 0x7);
+            mUpdateMask[ index >> 5 ] &= ~(1u << (index & 0x1F));
         }
 
-        void UnsetBit (uint32 index)
+        bool GetBit (uint32 index) const
         {
-            ((uint8 *)mUpdateMask)[ index >> 3 ] &= (0xff ^ (1 <<  (index & 0x7)));
+            return (mUpdateMask[ index >> 5 ] & (1u << (index & 0x1F))) != 0;
         }
 
-        bool GetBit (uint32 index)
+        // first set bit at or after index, GetCount() if there is none
+        uint32 FindNextBit(uint32 index) const
         {
-            return (((uint8 *)mUpdateMask)[ index >> 3 ] & (1 << (index & 0x7))) != 0;
+            uint32 block = index >> 5;
+            if (block >= mBlocks)
+                return mCount;
+
+            uint32 bits = mUpdateMask[block] & (~0u << (index & 0x1F));
+            while (!bits)
+            {
+                if (++block >= mBlocks)
+                    return mCount;
+                bits = mUpdateMask[block];
+            }
+
+            uint32 next = (block << 5) + CountTrailingZeros(bits);
+            return next < mCount ? next : mCount;
         }
 
-        uint32 GetBlockCount() { return mBlocks; }
-        uint32 GetLength() { return mBlocks << 2; }
-        uint32 GetCount() { return mCount; }
+        uint32 GetBlockCount() const { return mBlocks; }
+        uint32 GetLength() const { return mBlocks << 2; }
+        uint32 GetCount() const { return mCount; }
+        uint32 GetBlock(uint32 block) const { return mUpdateMask[block]; }
         uint8* GetMask() { return (uint8*)mUpdateMask; }
 
         void SetCount (uint32 valuesCount)
         {
-            if (mUpdateMask)
-                delete [] mUpdateMask;
+            ASSERT(valuesCount <= UPDATE_MASK_MAX_BLOCKS * 32);
 
             mCount = valuesCount;
             mBlocks = (valuesCount + 31) / 32;
 
-            mUpdateMask = new uint32[mBlocks];
             memset(mUpdateMask, 0, mBlocks << 2);
         }
 
         void Clear()
         {
-            if (mUpdateMask)
-                memset(mUpdateMask, 0, mBlocks << 2);
+            memset(mUpdateMask, 0, mBlocks << 2);
         }
 
         UpdateMask& operator = (const UpdateMask& mask)
         {
-            SetCount(mask.mCount);
+            mCount = mask.mCount;
+            mBlocks = mask.mBlocks;
             memcpy(mUpdateMask, mask.mUpdateMask, mBlocks << 2);
 
             return *this;
@@ -85,23 +108,22 @@ class UpdateMask
         void operator &= (const UpdateMask& mask)
         {
             ASSERT(mask.mCount <= mCount);
-            for (uint32 i = 0; i < mBlocks; i++)
+            for (uint32 i = 0; i < mask.mBlocks; i++)
                 mUpdateMask[i] &= mask.mUpdateMask[i];
+            for (uint32 i = mask.mBlocks; i < mBlocks; i++)
+                mUpdateMask[i] = 0;
         }
 
         void operator |= (const UpdateMask& mask)
         {
             ASSERT(mask.mCount <= mCount);
-            for (uint32 i = 0; i < mBlocks; i++)
+            for (uint32 i = 0; i < mask.mBlocks; i++)
                 mUpdateMask[i] |= mask.mUpdateMask[i];
         }
 
         UpdateMask operator & (const UpdateMask& mask) const
         {
-            ASSERT(mask.mCount <= mCount);
-
-            UpdateMask newmask;
-            newmask = *this;
+            UpdateMask newmask(*this);
             newmask &= mask;
 
             return newmask;
@@ -109,19 +131,26 @@ class UpdateMask
 
         UpdateMask operator | (const UpdateMask& mask) const
         {
-            ASSERT(mask.mCount <= mCount);
-
-            UpdateMask newmask;
-            newmask = *this;
+            UpdateMask newmask(*this);
             newmask |= mask;
 
             return newmask;
         }
 
     private:
+        static uint32 CountTrailingZeros(uint32 bits)
+        {
+#if COMPILER == COMPILER_MICROSOFT
+            unsigned long index;
+            _BitScanForward(&index, bits);
+            return uint32(index);
+#else
+            return uint32(__builtin_ctz(bits));
+#endif
+        }
+
         uint32 mCount;
         uint32 mBlocks;
-        uint32 *mUpdateMask;
+        uint32 mUpdateMask[UPDATE_MASK_MAX_BLOCKS];
 };
 #endif
-
@@ -20,6 +20,7 @@
 
 #include "Common.h"
 #include "DatabaseEnv.h"
+#include "SqlOperations.h"
 #include "Log.h"
 #include "WorldSession.h"
 #include "WorldPacket.h"
@@ -149,7 +150,7 @@ void Pet::RemoveFromWorld()
     }
 }
 
-bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool current)
+bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool current, SqlQueryHolder* holder)
 {
     uint32 ownerid = owner->GetGUIDLow();
 
@@ -157,7 +158,10 @@ bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool c
 
     if (owner->getClass() == CLASS_HUNTER || owner->getClass() == CLASS_WARLOCK) // remove unnecessary use of PQuery
     {
-        if (petnumber)
+        if (holder)
+            // current pet at login, same columns as below, loaded with the LoginQueryHolder
+            result = holder->GetResult(PLAYER_LOGIN_QUERY_LOADPET);
+        else if (petnumber)
             // known petnumber entry                  0   1      2      3        4      5    6           7              8        9           10    11    12       13         14       15            16      17              18        19                 20                 21              22
             result = CharacterDatabase.PQuery("SELECT id, entry, owner, modelid, level, exp, Reactstate, loyaltypoints, loyalty, trainpoint, slot, name, renamed, curhealth, curmana, curhappiness, abdata, TeachSpelldata, savetime, resettalents_cost, resettalents_time, CreatedBySpell, PetType FROM character_pet WHERE owner = '%u' AND id = '%u'", ownerid, petnumber);
         else if (current)
@@ -335,12 +339,23 @@ bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool c
     map->Add(ToCreature());
 
     uint32 timediff = (time(NULL) - fields[18].GetUInt32());
-    _LoadAuras(timediff);
+    if (holder)
+        _LoadAuras(holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETAURAS), timediff);
+    else
+        _LoadAuras(CharacterDatabase.PQuery("SELECT caster_guid, spell, effect_index, stackcount, amount, maxduration, remaintime, remaincharges FROM pet_aura WHERE guid = '%u'", m_charmInfo->GetPetNumber()), timediff);
 
     if (!is_temporary_summoned)
     {
-        _LoadSpells();
-        _LoadSpellCooldowns();
+        if (holder)
+        {
+            _LoadSpells(holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETSPELLS));
+            _LoadSpellCooldowns(holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETSPELLCOOLDOWNS));
+        }
+        else
+        {
+            _LoadSpells(CharacterDatabase.PQuery("SELECT spell, active FROM pet_spell WHERE guid = '%u'", m_charmInfo->GetPetNumber()));
+            _LoadSpellCooldowns(CharacterDatabase.PQuery("SELECT spell, time FROM pet_spell_cooldown WHERE guid = '%u'", m_charmInfo->GetPetNumber()));
+        }
         LearnPetPassives();
         CastPetAuras(current);
     }
@@ -359,7 +374,10 @@ bool Pet::LoadPetFromDB(Player* owner, uint32 petentry, uint32 petnumber, bool c
 
     if (getPetType() == HUNTER_PET)
     {
-        result = CharacterDatabase.PQuery("SELECT genitive, dative, accusative, instrumental, prepositional FROM character_pet_declinedname WHERE owner = '%u' AND id = '%u'", owner->GetGUIDLow(), GetCharmInfo()->GetPetNumber());
+        if (holder)
+            result = holder->GetResult(PLAYER_LOGIN_QUERY_LOADPETDECLINEDNAMES);
+        else
+            result = CharacterDatabase.PQuery("SELECT genitive, dative, accusative, instrumental, prepositional FROM character_pet_declinedname WHERE owner = '%u' AND id = '%u'", owner->GetGUIDLow(), GetCharmInfo()->GetPetNumber());
 
         if (result)
         {
@@ -1347,13 +1365,11 @@ uint32 Pet::GetCurrentFoodBenefitLevel(uint32 itemlevel)
         return 0;                                           //food too low level
 }
 
-void Pet::_LoadSpellCooldowns()
+void Pet::_LoadSpellCooldowns(QueryResult_AutoPtr result)
 {
     m_CreatureSpellCooldowns.clear();
     m_CreatureCategoryCooldowns.clear();
 
-    QueryResult_AutoPtr result = CharacterDatabase.PQuery("SELECT spell, time FROM pet_spell_cooldown WHERE guid = '%u'", m_charmInfo->GetPetNumber());
-
     if (result)
     {
         time_t curTime = time(NULL);
@@ -1415,10 +1431,8 @@ void Pet::_SaveSpellCooldowns()
     }
 }
 
-void Pet::_LoadSpells()
+void Pet::_LoadSpells(QueryResult_AutoPtr result)
 {
-    QueryResult_AutoPtr result = CharacterDatabase.PQuery("SELECT spell, active FROM pet_spell WHERE guid = '%u'", m_charmInfo->GetPetNumber());
-
     if (result)
     {
         do
@@ -1462,7 +1476,7 @@ void Pet::_SaveSpells()
     }
 }
 
-void Pet::_LoadAuras(uint32 timediff)
+void Pet::_LoadAuras(QueryResult_AutoPtr result, uint32 timediff)
 {
     m_Auras.clear();
     for (int i = 0; i < TOTAL_AURAS; i++)
@@ -1472,8 +1486,6 @@ void Pet::_LoadAuras(uint32 timediff)
     for (int i = UNIT_FIELD_AURA; i <= UNIT_FIELD_AURASTATE; ++i)
         SetUInt32Value(i, 0);
 
-    QueryResult_AutoPtr result = CharacterDatabase.PQuery("SELECT caster_guid, spell, effect_index, stackcount, amount, maxduration, remaintime, remaincharges FROM pet_aura WHERE guid = '%u'", m_charmInfo->GetPetNumber());
-
     if (result)
     {
         do
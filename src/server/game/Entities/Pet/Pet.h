@@ -25,6 +25,8 @@
 #include "Unit.h"
 #include "TemporarySummon.h"
 
+class SqlQueryHolder;
+
 enum PetType
 {
     SUMMON_PET              = 0,
@@ -147,7 +149,7 @@ class Pet : public Guardian
 
         bool Create (uint32 guidlow, Map *map, uint32 Entry, uint32 pet_number);
         bool CreateBaseAtCreature(Creature* creature);
-        bool LoadPetFromDB(Player* owner, uint32 petentry = 0, uint32 petnumber = 0, bool current = false);
+        bool LoadPetFromDB(Player* owner, uint32 petentry = 0, uint32 petnumber = 0, bool current = false, SqlQueryHolder* holder = NULL);
         void SavePetToDB(PetSaveMode mode);
         void Remove(PetSaveMode mode, bool returnreagent = false);
         static void DeleteFromDB(uint32 guidlow);
@@ -193,11 +195,11 @@ class Pet : public Guardian
         void CastPetAuras(bool current);
         void CastPetAura(PetAura const* aura);
 
-        void _LoadSpellCooldowns();
+        void _LoadSpellCooldowns(QueryResult_AutoPtr result);
         void _SaveSpellCooldowns();
-        void _LoadAuras(uint32 timediff);
+        void _LoadAuras(QueryResult_AutoPtr result, uint32 timediff);
         void _SaveAuras();
-        void _LoadSpells();
+        void _LoadSpells(QueryResult_AutoPtr result);
         void _SaveSpells();
 
         bool addSpell(uint16 spell_id, uint16 active = ACT_DECIDE, PetSpellState state = PETSPELL_NEW, PetSpellType type = PETSPELL_NORMAL);
@@ -21,6 +21,8 @@
 #include "Common.h"
 #include "Language.h"
 #include "DatabaseEnv.h"
+#include "PreparedStatements.h"
+#include "SqlBatch.h"
 #include "Log.h"
 #include "Opcodes.h"
 #include "ObjectMgr.h"
@@ -791,6 +793,10 @@ Player::Player (WorldSession *session): Unit()
     for (int aX = 0 ; aX < 8 ; aX++)
         m_Tutorials[ aX ] = 0x00;
     m_TutorialsChanged = false;
+    m_saveRows = 0;
+    m_saveBytes = 0;
+    m_interestUnitCount = 0;
+    m_interestBacklog = false;
 
     m_DailyQuestChanged = false;
     m_lastDailyQuestTime = 0;
@@ -1548,6 +1554,12 @@ void Player::Update(uint32 p_time)
         }
     }
 
+    if (m_interestBacklog)
+    {
+        m_interestBacklog = false;
+        AddToNotify(NOTIFY_VISIBILITY_CHANGED);
+    }
+
     //used to implement delayed far teleports
     SetCanDelayTeleport(true);
     Unit::Update(p_time);
@@ -3978,6 +3990,8 @@ void Player::_SaveSpellCooldowns()
 
     time_t curTime = time(NULL);
 
+    SqlBatch insert(CharacterDatabase, "INSERT INTO character_spell_cooldown (guid, spell, item, time) VALUES ");
+
     // remove outdated and save active
     for (SpellCooldowns::iterator itr = m_spellCooldowns.begin();itr != m_spellCooldowns.end();)
     {
@@ -3985,10 +3999,13 @@ void Player::_SaveSpellCooldowns()
             m_spellCooldowns.erase(itr++);
         else
         {
-            CharacterDatabase.PExecute("INSERT INTO character_spell_cooldown (guid, spell, item, time) VALUES ('%u', '%u', '%u', '" UI64FMTD "')", GetGUIDLow(), itr->first, itr->second.itemid, uint64(itr->second.end));
+            insert.AddRow("(%u, %u, %u, " UI64FMTD ")", GetGUIDLow(), itr->first, itr->second.itemid, uint64(itr->second.end));
             ++itr;
         }
     }
+
+    insert.Flush();
+    _CountSave(insert);
 }
 
 uint32 Player::resetTalentsCost() const
@@ -16049,8 +16066,7 @@ bool Player::LoadFromDB(uint32 guid, SqlQueryHolder *holder)
     // update items with duration and realtime
     UpdateItemDuration(time_diff, true);
 
-    QueryResult_AutoPtr actionResult = CharacterDatabase.PQuery("SELECT button, action, type, misc FROM character_action WHERE guid = '%u' AND spec = '%u' ORDER BY button", GetGUIDLow(), m_activeSpec);
-    _LoadActions(actionResult);
+    _LoadActions(holder->GetResult(PLAYER_LOGIN_QUERY_LOADACTIONS));
 
     // unread mails and next delivery time, actual mails not loaded
     _LoadMailInit(holder->GetResult(PLAYER_LOGIN_QUERY_LOADMAILCOUNT), holder->GetResult(PLAYER_LOGIN_QUERY_LOADMAILDATE));
@@ -16174,7 +16190,7 @@ void Player::_LoadActions(QueryResult_AutoPtr result)
 {
     m_actionButtons.clear();
 
-    //QueryResult_AutoPtr result = CharacterDatabase.PQuery("SELECT button, action, type, misc FROM character_action WHERE guid = '%u' ORDER BY button", GetGUIDLow());
+    //QueryResult_AutoPtr result = CharacterDatabase.PQuery("SELECT button, action, type, misc, spec FROM character_action WHERE guid = '%u' ORDER BY button", GetGUIDLow());
 
     if (result)
     {
@@ -16182,6 +16198,10 @@ void Player::_LoadActions(QueryResult_AutoPtr result)
         {
             Field *fields = result->Fetch();
 
+            // buttons of the inactive spec are loaded at the next login after ActivateSpec
+            if (fields[4].GetUInt8() != m_activeSpec)
+                continue;
+
             uint8 button = fields[0].GetUInt8();
 
             addActionButton(button, fields[1].GetUInt16(), fields[2].GetUInt8(), fields[3].GetUInt8());
@@ -16554,14 +16574,14 @@ void Player::_LoadMail()
     m_mailsLoaded = true;
 }
 
-void Player::LoadPet()
+void Player::LoadPet(SqlQueryHolder* holder)
 {
     //fixme: the pet should still be loaded if the player is not in world
     // just not added to the map
     if (IsInWorld())
     {
         Pet *pet = new Pet(this);
-        if (!pet->LoadPetFromDB(this, 0, 0, true))
+        if (!pet->LoadPetFromDB(this, 0, 0, true, holder))
             delete pet;
     }
 }
@@ -17308,136 +17328,99 @@ void Player::SaveToDB()
 
     bool inworld = IsInWorld();
 
-    std::string sql_name = m_name;
-    CharacterDatabase.EscapeString(sql_name);
-
-    std::ostringstream ss;
-    ss << "REPLACE INTO characters (guid, account, name, race, class, gender, level, xp, money, playerBytes, playerBytes2, playerFlags, "
-        "map, instance_id, dungeon_difficulty, position_x, position_y, position_z, orientation, data, "
-        "taximask, online, cinematic, "
-        "totaltime, leveltime, rest_bonus, logout_time, is_logout_resting, resettalents_cost, resettalents_time, "
-        "trans_x, trans_y, trans_z, trans_o, transguid, extra_flags, stable_slots, at_login, zone, "
-        "death_expire_time, taxi_path, arenaPoints, totalHonorPoints, todayHonorPoints, yesterdayHonorPoints, "
-        "totalKills, todayKills, yesterdayKills, chosenTitle, watchedFaction, drunk, health, "
-        "powerMana, powerRage, powerFocus, powerEnergy, powerHappiness, latency, specCount, activeSpec, characterMode) VALUES ("
-        << GetGUIDLow() << ", "
-        << GetSession()->GetAccountId() << ", '"
-        << sql_name << "', "
-        << uint32(getRace()) << ", "
-        << uint32(getClass()) << ", "
-        << uint32(getGender()) << ", "
-        << uint32(getLevel()) << ", "
-        << GetUInt32Value(PLAYER_XP) << ", "
-        << GetMoney() << ", "
-        << GetUInt32Value(PLAYER_BYTES) << ", "
-        << GetUInt32Value(PLAYER_BYTES_2) << ", "
-        << GetUInt32Value(PLAYER_FLAGS) << ", ";
+    PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_REP_CHARACTER);
+    uint8 index = 0;
+    stmt->SetUInt32(index++, GetGUIDLow());
+    stmt->SetUInt32(index++, GetSession()->GetAccountId());
+    stmt->SetString(index++, m_name);
+    stmt->SetUInt8(index++, getRace());
+    stmt->SetUInt8(index++, getClass());
+    stmt->SetUInt8(index++, getGender());
+    stmt->SetUInt8(index++, getLevel());
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_XP));
+    stmt->SetUInt32(index++, GetMoney());
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_BYTES));
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_BYTES_2));
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_FLAGS));
 
     if (!IsBeingTeleported())
     {
-        ss << GetMapId() << ", "
-        << (uint32)GetInstanceId() << ", "
-        << (uint32)GetDifficulty() << ", "
-        << finiteAlways(GetPositionX()) << ", "
-        << finiteAlways(GetPositionY()) << ", "
-        << finiteAlways(GetPositionZ()) << ", "
-        << finiteAlways(GetOrientation()) << ", '";
+        stmt->SetUInt32(index++, GetMapId());
+        stmt->SetUInt32(index++, GetInstanceId());
+        stmt->SetUInt8(index++, GetDifficulty());
+        stmt->SetFloat(index++, finiteAlways(GetPositionX()));
+        stmt->SetFloat(index++, finiteAlways(GetPositionY()));
+        stmt->SetFloat(index++, finiteAlways(GetPositionZ()));
+        stmt->SetFloat(index++, finiteAlways(GetOrientation()));
     }
     else
     {
-        ss << GetTeleportDest().GetMapId() << ", "
-        << (uint32)0 << ", "
-        << (uint32)GetDifficulty() << ", "
-        << finiteAlways(GetTeleportDest().GetPositionX()) << ", "
-        << finiteAlways(GetTeleportDest().GetPositionY()) << ", "
-        << finiteAlways(GetTeleportDest().GetPositionZ()) << ", "
-        << finiteAlways(GetTeleportDest().GetOrientation()) << ", '";
+        stmt->SetUInt32(index++, GetTeleportDest().GetMapId());
+        stmt->SetUInt32(index++, 0);
+        stmt->SetUInt8(index++, GetDifficulty());
+        stmt->SetFloat(index++, finiteAlways(GetTeleportDest().GetPositionX()));
+        stmt->SetFloat(index++, finiteAlways(GetTeleportDest().GetPositionY()));
+        stmt->SetFloat(index++, finiteAlways(GetTeleportDest().GetPositionZ()));
+        stmt->SetFloat(index++, finiteAlways(GetTeleportDest().GetOrientation()));
     }
 
-    uint16 i;
-    for (i = 0; i < m_valuesCount; ++i)
+    std::ostringstream ss;
+    for (uint16 i = 0; i < m_valuesCount; ++i)
         ss << GetUInt32Value(i) << " ";
+    stmt->SetString(index++, ss.str());
 
-    ss << "', '";
-
-    for (i = 0; i < 8; i++)
+    ss.str("");
+    for (uint8 i = 0; i < 8; ++i)
         ss << m_taxi.GetTaximask(i) << " ";
+    stmt->SetString(index++, ss.str());
+
+    stmt->SetUInt8(index++, IsInWorld() ? 1 : 0);
+    stmt->SetUInt32(index++, m_cinematic);
+    stmt->SetUInt32(index++, m_Played_time[PLAYED_TIME_TOTAL]);
+    stmt->SetUInt32(index++, m_Played_time[PLAYED_TIME_LEVEL]);
+    stmt->SetFloat(index++, finiteAlways(m_rest_bonus));
+    stmt->SetUInt64(index++, uint64(time(NULL)));
+    stmt->SetUInt8(index++, is_save_resting);
+    stmt->SetUInt32(index++, m_resetTalentsCost);
+    stmt->SetUInt64(index++, uint64(m_resetTalentsTime));
+    stmt->SetFloat(index++, finiteAlways(m_movementInfo.GetTransportPos()->GetPositionX()));
+    stmt->SetFloat(index++, finiteAlways(m_movementInfo.GetTransportPos()->GetPositionY()));
+    stmt->SetFloat(index++, finiteAlways(m_movementInfo.GetTransportPos()->GetPositionZ()));
+    stmt->SetFloat(index++, finiteAlways(m_movementInfo.GetTransportPos()->GetOrientation()));
+    stmt->SetUInt32(index++, m_transport ? m_transport->GetGUIDLow() : 0);
+    stmt->SetUInt32(index++, m_ExtraFlags);
+    stmt->SetUInt8(index++, m_stableSlots);
+    stmt->SetUInt32(index++, m_atLoginFlags);
+    stmt->SetUInt32(index++, GetZoneId());
+    stmt->SetUInt64(index++, uint64(m_deathExpireTime));
+    stmt->SetString(index++, m_taxi.SaveTaxiDestinationsToString());
+    stmt->SetUInt32(index++, GetArenaPoints());
+    stmt->SetUInt32(index++, GetHonorPoints());
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_FIELD_TODAY_CONTRIBUTION));
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_FIELD_YESTERDAY_CONTRIBUTION));
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_FIELD_LIFETIME_HONORABLE_KILLS));
+    stmt->SetUInt16(index++, GetUInt16Value(PLAYER_FIELD_KILLS, 0));
+    stmt->SetUInt16(index++, GetUInt16Value(PLAYER_FIELD_KILLS, 1));
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_CHOSEN_TITLE));
+    stmt->SetUInt32(index++, GetUInt32Value(PLAYER_FIELD_WATCHED_FACTION_INDEX));
+    stmt->SetUInt16(index++, uint16(GetUInt32Value(PLAYER_BYTES_3) & 0xFFFE));
+    stmt->SetUInt32(index++, GetHealth());
 
-    ss << "', ";
-    ss << (IsInWorld() ? 1 : 0) << ", ";
-
-    ss << m_cinematic << ", ";
-
-    ss << m_Played_time[PLAYED_TIME_TOTAL] << ", ";
-    ss << m_Played_time[PLAYED_TIME_LEVEL] << ", ";
-
-    ss << finiteAlways(m_rest_bonus) << ", ";
-    ss << (uint64)time(NULL) << ", ";
-    ss << is_save_resting << ", ";
-    ss << m_resetTalentsCost << ", ";
-    ss << (uint64)m_resetTalentsTime << ", ";
-
-    ss << finiteAlways(m_movementInfo.GetTransportPos()->GetPositionX()) << ", ";
-    ss << finiteAlways(m_movementInfo.GetTransportPos()->GetPositionY()) << ", ";
-    ss << finiteAlways(m_movementInfo.GetTransportPos()->GetPositionZ()) << ", ";
-    ss << finiteAlways(m_movementInfo.GetTransportPos()->GetOrientation()) << ", ";
-    if (m_transport)
-        ss << m_transport->GetGUIDLow();
-    else
-        ss << "0";
-
-    ss << ", ";
-
-    ss << m_ExtraFlags << ", ";
-
-    ss << uint32(m_stableSlots) << ", ";                    // to prevent save uint8 as char
-
-    ss << uint32(m_atLoginFlags) << ", ";
-
-    ss << GetZoneId() << ", ";
-
-    ss << (uint64)m_deathExpireTime << ", '";
-
-    ss << m_taxi.SaveTaxiDestinationsToString() << "', ";
-
-    ss << GetArenaPoints() << ", ";
-
-    ss << GetHonorPoints() << ", ";
-
-    ss << GetUInt32Value(PLAYER_FIELD_TODAY_CONTRIBUTION) << ", ";
-
-    ss << GetUInt32Value(PLAYER_FIELD_YESTERDAY_CONTRIBUTION) << ", ";
-
-    ss << GetUInt32Value(PLAYER_FIELD_LIFETIME_HONORABLE_KILLS) << ", ";
-
-    ss << GetUInt16Value(PLAYER_FIELD_KILLS, 0) << ", ";
-
-    ss << GetUInt16Value(PLAYER_FIELD_KILLS, 1) << ", ";
-
-    ss << GetUInt32Value(PLAYER_CHOSEN_TITLE) << ", ";
-
-    ss << GetUInt32Value(PLAYER_FIELD_WATCHED_FACTION_INDEX) << ", ";
-
-    ss << (uint16)(GetUInt32Value(PLAYER_BYTES_3) & 0xFFFE) << ", ";
+    for (uint32 i = 0; i < MAX_POWERS; ++i)
+        stmt->SetUInt32(index++, GetPower(Powers(i)));
 
-    ss << GetHealth();
+    stmt->SetUInt32(index++, GetSession()->GetLatency());
+    stmt->SetUInt8(index++, m_specsCount);
+    stmt->SetUInt8(index++, m_activeSpec);
+    stmt->SetUInt32(index++, m_characterMode);
 
-    for (uint32 i = 0; i < MAX_POWERS; ++i)
-        ss << ", " << GetPower(Powers(i));
-    ss << ", '";
-
-    ss << GetSession()->GetLatency();
-    ss << "', ";
-    ss << uint32(m_specsCount);
-    ss << ", ";
-    ss << uint32(m_activeSpec);
-    ss << ", ";
-    ss << uint32(m_characterMode);
-    ss << ")";
+    m_saveRows = 0;
+    m_saveBytes = 0;
+    _CountSave(stmt);
 
     CharacterDatabase.BeginTransaction();
 
-    CharacterDatabase.Execute(ss.str().c_str());
+    CharacterDatabase.Execute(stmt);
 
     if (m_mailsUpdated)                                     //save mails only when needed
         _SaveMail();
@@ -17457,6 +17440,8 @@ void Player::SaveToDB()
 
     CharacterDatabase.CommitTransaction();
 
+    sWorld->RecordCharacterSave(m_saveRows, m_saveBytes);
+
     // restore state (before aura apply, if aura remove flag then aura must set it ack by self)
     SetDisplayId(tmp_displayid);
     SetUInt32Value(UNIT_FIELD_BYTES_1, tmp_bytes);
@@ -17483,24 +17468,25 @@ void Player::SaveGoldToDB()
 
 void Player::_SaveActions()
 {
+    std::ostringstream ss;
+    ss << "DELETE FROM character_action WHERE guid = " << GetGUIDLow() << " AND spec = " << uint32(m_activeSpec) << " AND button IN (";
+    SqlBatch remove(CharacterDatabase, ss.str(), ")");
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_action (guid, spec, button, action, type, misc) VALUES ",
+        " ON DUPLICATE KEY UPDATE action = VALUES(action), type = VALUES(type), misc = VALUES(misc)");
+
     for (ActionButtonList::iterator itr = m_actionButtons.begin(); itr != m_actionButtons.end();)
     {
         switch (itr->second.uState)
         {
             case ACTIONBUTTON_NEW:
-                CharacterDatabase.PExecute("INSERT INTO character_action (guid, spec, button, action, type, misc) VALUES ('%u', '%u', '%u', '%u', '%u', '%u')",
-                    GetGUIDLow(), (uint32)m_activeSpec, (uint32)itr->first, (uint32)itr->second.action, (uint32)itr->second.type, (uint32)itr->second.misc);
-                itr->second.uState = ACTIONBUTTON_UNCHANGED;
-                ++itr;
-                break;
             case ACTIONBUTTON_CHANGED:
-                CharacterDatabase.PExecute("UPDATE character_action  SET action = '%u', type = '%u', misc= '%u' WHERE guid= '%u' AND button= '%u' AND spec= '%u'",
-                    (uint32)itr->second.action, (uint32)itr->second.type, (uint32)itr->second.misc, GetGUIDLow(), (uint32)itr->first, (uint32)m_activeSpec);
+                upsert.AddRow("(%u, %u, %u, %u, %u, %u)", GetGUIDLow(), uint32(m_activeSpec), uint32(itr->first),
+                    uint32(itr->second.action), uint32(itr->second.type), uint32(itr->second.misc));
                 itr->second.uState = ACTIONBUTTON_UNCHANGED;
                 ++itr;
                 break;
             case ACTIONBUTTON_DELETED:
-                CharacterDatabase.PExecute("DELETE FROM character_action WHERE guid = '%u' AND button = '%u' AND spec = '%u'", GetGUIDLow(), (uint32)itr->first, (uint32)m_activeSpec);
+                remove.AddRow("%u", uint32(itr->first));
                 m_actionButtons.erase(itr++);
                 break;
             default:
@@ -17508,17 +17494,28 @@ void Player::_SaveActions()
                 break;
         }
     }
+
+    remove.Flush();
+    upsert.Flush();
+    _CountSave(remove);
+    _CountSave(upsert);
 }
 
 void Player::_SaveAuras()
 {
-    CharacterDatabase.PExecute("DELETE FROM character_aura WHERE guid = '%u'", GetGUIDLow());
+    // durations change all the time, so auras are always rewritten, but with a single insert
+    PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHARACTER_AURAS);
+    stmt->SetUInt32(0, GetGUIDLow());
+    _CountSave(stmt);
+    CharacterDatabase.Execute(stmt);
 
     AuraMap const& auras = GetAuras();
 
     if (auras.empty())
         return;
 
+    SqlBatch insert(CharacterDatabase, "INSERT INTO character_aura (guid, caster_guid, spell, effect_index, stackcount, amount, maxduration, remaintime, remaincharges) VALUES ");
+
     spellEffectPair lastEffectPair = auras.begin()->first;
     uint32 stackCounter = 1;
 
@@ -17546,8 +17543,7 @@ void Player::_SaveAuras()
 
                     if (i == 3)
                     {
-                        CharacterDatabase.PExecute("INSERT INTO character_aura (guid, caster_guid, spell, effect_index, stackcount, amount, maxduration, remaintime, remaincharges) "
-                            "VALUES ('%u', '" UI64FMTD "' , '%u', '%u', '%u', '%d', '%d', '%d', '%d')",
+                        insert.AddRow("(%u, " UI64FMTD ", %u, %u, %u, %d, %d, %d, %d)",
                             GetGUIDLow(), itr2->second->GetCasterGUID(), (uint32)itr2->second->GetId(), (uint32)itr2->second->GetEffIndex(), (uint32)itr2->second->GetStackAmount(), itr2->second->GetModifier()->m_amount, int(itr2->second->GetAuraMaxDuration()), int(itr2->second->GetAuraDuration()), int(itr2->second->m_procCharges));
                     }
                 }
@@ -17566,6 +17562,9 @@ void Player::_SaveAuras()
             stackCounter = 1;
         }
     }
+
+    insert.Flush();
+    _CountSave(insert);
 }
 
 void Player::_SaveInventory()
@@ -17577,8 +17576,13 @@ void Player::_SaveInventory()
         Item *item = m_items[i];
         if (!item || item->GetState() == ITEM_NEW)
             continue;
-        CharacterDatabase.PExecute("DELETE FROM character_inventory WHERE item = '%u'", item->GetGUIDLow());
-        CharacterDatabase.PExecute("DELETE FROM item_instance WHERE guid = '%u'", item->GetGUIDLow());
+        PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHARACTER_INVENTORY_BY_ITEM);
+        stmt->SetUInt32(0, item->GetGUIDLow());
+        CharacterDatabase.Execute(stmt);
+
+        stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_ITEM_INSTANCE);
+        stmt->SetUInt32(0, item->GetGUIDLow());
+        CharacterDatabase.Execute(stmt);
         m_items[i]->FSetState(ITEM_NEW);
     }
 
@@ -17611,7 +17615,10 @@ void Player::_SaveInventory()
                     bagTestGUID = test2->GetGUIDLow();
                 sLog->outError("Player(GUID: %u Name: %s)::_SaveInventory - the bag(%u) and slot(%u) values for the item with guid %u (state %d) are incorrect, the player doesn't have an item at that position!", lowGuid, GetName(), item->GetBagSlot(), item->GetSlot(), item->GetGUIDLow(), (int32)item->GetState());
                 // according to the test that was just performed nothing should be in this slot, delete
-                CharacterDatabase.PExecute("DELETE FROM character_inventory WHERE bag=%u AND slot=%u", bagTestGUID, item->GetSlot());
+                PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHARACTER_INVENTORY_BY_BAG_SLOT);
+                stmt->SetUInt32(0, bagTestGUID);
+                stmt->SetUInt8(1, item->GetSlot());
+                CharacterDatabase.Execute(stmt);
                 // also THIS item should be somewhere else, cheat attempt
                 item->FSetState(ITEM_REMOVED); // we are IN updateQueue right now, can't use SetState which modifies the queue
                 // don't skip, let the switch delete it
@@ -17628,16 +17635,34 @@ void Player::_SaveInventory()
             }
         }
 
+        PreparedStatement* stmt = NULL;
         switch (item->GetState())
         {
             case ITEM_NEW:
-                CharacterDatabase.PExecute("INSERT INTO character_inventory (guid, bag, slot, item, item_template) VALUES ('%u', '%u', '%u', '%u', '%u')", lowGuid, bag_guid, item->GetSlot(), item->GetGUIDLow(), item->GetEntry());
+                stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHARACTER_INVENTORY);
+                stmt->SetUInt32(0, lowGuid);
+                stmt->SetUInt32(1, bag_guid);
+                stmt->SetUInt8(2, item->GetSlot());
+                stmt->SetUInt32(3, item->GetGUIDLow());
+                stmt->SetUInt32(4, item->GetEntry());
+                _CountSave(stmt);
+                CharacterDatabase.Execute(stmt);
                 break;
             case ITEM_CHANGED:
-                CharacterDatabase.PExecute("UPDATE character_inventory SET guid='%u', bag='%u', slot='%u', item_template='%u' WHERE item='%u'", lowGuid, bag_guid, item->GetSlot(), item->GetEntry(), item->GetGUIDLow());
+                stmt = CharacterDatabase.GetPreparedStatement(CHAR_UPD_CHARACTER_INVENTORY);
+                stmt->SetUInt32(0, lowGuid);
+                stmt->SetUInt32(1, bag_guid);
+                stmt->SetUInt8(2, item->GetSlot());
+                stmt->SetUInt32(3, item->GetEntry());
+                stmt->SetUInt32(4, item->GetGUIDLow());
+                _CountSave(stmt);
+                CharacterDatabase.Execute(stmt);
                 break;
             case ITEM_REMOVED:
-                CharacterDatabase.PExecute("DELETE FROM character_inventory WHERE item = '%u'", item->GetGUIDLow());
+                stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHARACTER_INVENTORY_BY_ITEM);
+                stmt->SetUInt32(0, item->GetGUIDLow());
+                _CountSave(stmt);
+                CharacterDatabase.Execute(stmt);
                 break;
             case ITEM_UNCHANGED:
                 break;
@@ -17699,25 +17724,24 @@ void Player::_SaveMail()
 
 void Player::_SaveQuestStatus()
 {
-    // we don't need transactions here.
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_queststatus (guid, quest, status, rewarded, explored, timer, mobcount1, mobcount2, mobcount3, mobcount4, itemcount1, itemcount2, itemcount3, itemcount4) VALUES ",
+        " ON DUPLICATE KEY UPDATE status = VALUES(status), rewarded = VALUES(rewarded), explored = VALUES(explored), timer = VALUES(timer), "
+        "mobcount1 = VALUES(mobcount1), mobcount2 = VALUES(mobcount2), mobcount3 = VALUES(mobcount3), mobcount4 = VALUES(mobcount4), "
+        "itemcount1 = VALUES(itemcount1), itemcount2 = VALUES(itemcount2), itemcount3 = VALUES(itemcount3), itemcount4 = VALUES(itemcount4)");
+
     for (QuestStatusMap::iterator i = mQuestStatus.begin(); i != mQuestStatus.end(); ++i)
     {
-        switch (i->second.uState)
-        {
-            case QUEST_NEW:
-                CharacterDatabase.PExecute("INSERT INTO character_queststatus (guid, quest, status, rewarded, explored, timer, mobcount1, mobcount2, mobcount3, mobcount4, itemcount1, itemcount2, itemcount3, itemcount4) "
-                    "VALUES ('%u', '%u', '%u', '%u', '%u', '" UI64FMTD "', '%u', '%u', '%u', '%u', '%u', '%u', '%u', '%u')",
-                    GetGUIDLow(), i->first, i->second.m_status, i->second.m_rewarded, i->second.m_explored, uint64(i->second.m_timer / IN_MILLISECONDS + sWorld->GetGameTime()), i->second.m_creatureOrGOcount[0], i->second.m_creatureOrGOcount[1], i->second.m_creatureOrGOcount[2], i->second.m_creatureOrGOcount[3], i->second.m_itemcount[0], i->second.m_itemcount[1], i->second.m_itemcount[2], i->second.m_itemcount[3]);
-                break;
-            case QUEST_CHANGED:
-                CharacterDatabase.PExecute("UPDATE character_queststatus SET status = '%u', rewarded = '%u', explored = '%u', timer = '" UI64FMTD "', mobcount1 = '%u', mobcount2 = '%u', mobcount3 = '%u', mobcount4 = '%u', itemcount1 = '%u', itemcount2 = '%u', itemcount3 = '%u', itemcount4 = '%u'  WHERE guid = '%u' AND quest = '%u' ",
-                    i->second.m_status, i->second.m_rewarded, i->second.m_explored, uint64(i->second.m_timer / IN_MILLISECONDS + sWorld->GetGameTime()), i->second.m_creatureOrGOcount[0], i->second.m_creatureOrGOcount[1], i->second.m_creatureOrGOcount[2], i->second.m_creatureOrGOcount[3], i->second.m_itemcount[0], i->second.m_itemcount[1], i->second.m_itemcount[2], i->second.m_itemcount[3], GetGUIDLow(), i->first);
-                break;
-            case QUEST_UNCHANGED:
-                break;
-        };
+        if (i->second.uState == QUEST_UNCHANGED)
+            continue;
+
+        // QUEST_NEW and QUEST_CHANGED
+        upsert.AddRow("(%u, %u, %u, %u, %u, " UI64FMTD ", %u, %u, %u, %u, %u, %u, %u, %u)",
+            GetGUIDLow(), i->first, i->second.m_status, i->second.m_rewarded, i->second.m_explored, uint64(i->second.m_timer / IN_MILLISECONDS + sWorld->GetGameTime()), i->second.m_creatureOrGOcount[0], i->second.m_creatureOrGOcount[1], i->second.m_creatureOrGOcount[2], i->second.m_creatureOrGOcount[3], i->second.m_itemcount[0], i->second.m_itemcount[1], i->second.m_itemcount[2], i->second.m_itemcount[3]);
         i->second.uState = QUEST_UNCHANGED;
     }
+
+    upsert.Flush();
+    _CountSave(upsert);
 }
 
 void Player::_SaveDailyQuestStatus()
@@ -17729,17 +17753,25 @@ void Player::_SaveDailyQuestStatus()
 
     // save last daily quest time for all quests: we need only mostly reset time for reset check anyway
 
-    // we don't need transactions here.
     CharacterDatabase.PExecute("DELETE FROM character_queststatus_daily WHERE guid = '%u'", GetGUIDLow());
+
+    SqlBatch insert(CharacterDatabase, "INSERT INTO character_queststatus_daily (guid, quest, time) VALUES ");
     for (uint32 quest_daily_idx = 0; quest_daily_idx < PLAYER_MAX_DAILY_QUESTS; ++quest_daily_idx)
         if (GetUInt32Value(PLAYER_FIELD_DAILY_QUESTS_1+quest_daily_idx))
-            CharacterDatabase.PExecute("INSERT INTO character_queststatus_daily (guid, quest, time) VALUES ('%u', '%u', '" UI64FMTD "')",
-                GetGUIDLow(), GetUInt32Value(PLAYER_FIELD_DAILY_QUESTS_1+quest_daily_idx), uint64(m_lastDailyQuestTime));
+            insert.AddRow("(%u, %u, " UI64FMTD ")", GetGUIDLow(), GetUInt32Value(PLAYER_FIELD_DAILY_QUESTS_1+quest_daily_idx), uint64(m_lastDailyQuestTime));
+
+    insert.Flush();
+    _CountSave(insert);
 }
 
 void Player::_SaveSkills()
 {
-    // we don't need transactions here.
+    std::ostringstream ss;
+    ss << "DELETE FROM character_skills WHERE guid = " << GetGUIDLow() << " AND skill IN (";
+    SqlBatch remove(CharacterDatabase, ss.str(), ")");
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_skills (guid, skill, value, max) VALUES ",
+        " ON DUPLICATE KEY UPDATE value = VALUES(value), max = VALUES(max)");
+
     for (SkillStatusMap::iterator itr = mSkillStatus.begin(); itr != mSkillStatus.end();)
     {
         if (itr->second.uState == SKILL_UNCHANGED)
@@ -17750,43 +17782,41 @@ void Player::_SaveSkills()
 
         if (itr->second.uState == SKILL_DELETED)
         {
-            CharacterDatabase.PExecute("DELETE FROM character_skills WHERE guid = '%u' AND skill = '%u'", GetGUIDLow(), itr->first);
+            remove.AddRow("%u", itr->first);
             mSkillStatus.erase(itr++);
             continue;
         }
 
+        // SKILL_NEW and SKILL_CHANGED
         uint32 valueData = GetUInt32Value(PLAYER_SKILL_VALUE_INDEX(itr->second.pos));
-        uint16 value = SKILL_VALUE(valueData);
-        uint16 max = SKILL_MAX(valueData);
-
-        switch (itr->second.uState)
-        {
-            case SKILL_NEW:
-                CharacterDatabase.PExecute("INSERT INTO character_skills (guid, skill, value, max) VALUES ('%u', '%u', '%u', '%u')",
-                    GetGUIDLow(), itr->first, value, max);
-                break;
-            case SKILL_CHANGED:
-                CharacterDatabase.PExecute("UPDATE character_skills SET value = '%u', max = '%u'WHERE guid = '%u' AND skill = '%u' ",
-                    value, max, GetGUIDLow(), itr->first );
-                break;
-        };
+        upsert.AddRow("(%u, %u, %u, %u)", GetGUIDLow(), itr->first, uint32(SKILL_VALUE(valueData)), uint32(SKILL_MAX(valueData)));
         itr->second.uState = SKILL_UNCHANGED;
 
         ++itr;
     }
+
+    remove.Flush();
+    upsert.Flush();
+    _CountSave(remove);
+    _CountSave(upsert);
 }
 
 void Player::_SaveReputation()
 {
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_reputation (guid, faction, standing, flags) VALUES ",
+        " ON DUPLICATE KEY UPDATE standing = VALUES(standing), flags = VALUES(flags)");
+
     for (FactionStateList::iterator itr = m_factions.begin(); itr != m_factions.end(); ++itr)
     {
         if (itr->second.Changed)
         {
-            CharacterDatabase.PExecute("DELETE FROM character_reputation WHERE guid = '%u' AND faction='%u'", GetGUIDLow(), itr->second.ID);
-            CharacterDatabase.PExecute("INSERT INTO character_reputation (guid, faction, standing, flags) VALUES ('%u', '%u', '%i', '%u')", GetGUIDLow(), itr->second.ID, itr->second.Standing, itr->second.Flags);
+            upsert.AddRow("(%u, %u, %i, %u)", GetGUIDLow(), itr->second.ID, itr->second.Standing, itr->second.Flags);
             itr->second.Changed = false;
         }
     }
+
+    upsert.Flush();
+    _CountSave(upsert);
 }
 
 void Player::_ResetTalentMap(uint8 specEntry)
@@ -17802,14 +17832,22 @@ void Player::_ResetTalentMap(uint8 specEntry)
 
 void Player::_SaveTalents()
 {
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_talent (guid, spell, spec) VALUES ",
+        " ON DUPLICATE KEY UPDATE spec = VALUES(spec)");
+
     for (uint8 i = 0; i < MAX_TALENT_SPECS; ++i)
     {
+        std::ostringstream ss;
+        ss << "DELETE FROM character_talent WHERE guid = " << GetGUIDLow() << " AND spec = " << uint32(i) << " AND spell IN (";
+        SqlBatch remove(CharacterDatabase, ss.str(), ")");
+
         for (PlayerTalentMap::const_iterator itr = m_talents[i].begin(); itr != m_talents[i].end();)
         {
-            if (itr->second->state == PLAYERSPELL_REMOVED || itr->second->state == PLAYERSPELL_CHANGED)
-                CharacterDatabase.PExecute("DELETE FROM character_talent WHERE guid = '%u' and spell = '%u' and spec = '%u'", GetGUIDLow(), itr->first, itr->second->spec);
-            if (itr->second->state == PLAYERSPELL_NEW || itr->second->state == PLAYERSPELL_CHANGED)
-                CharacterDatabase.PExecute("INSERT INTO character_talent (guid,spell,spec) VALUES ('%u', '%u', '%u')", GetGUIDLow(), itr->first, itr->second->spec);
+            // new and changed talents are upserted, a changed row that is already stored doesn't fail the batch
+            if (itr->second->state == PLAYERSPELL_REMOVED)
+                remove.AddRow("%u", itr->first);
+            else if (itr->second->state == PLAYERSPELL_NEW || itr->second->state == PLAYERSPELL_CHANGED)
+                upsert.AddRow("(%u, %u, %u)", GetGUIDLow(), itr->first, uint32(itr->second->spec));
 
             if (itr->second->state == PLAYERSPELL_REMOVED)
             {
@@ -17822,24 +17860,41 @@ void Player::_SaveTalents()
                 ++itr;
             }
         }
+
+        remove.Flush();
+        _CountSave(remove);
     }
+
+    upsert.Flush();
+    _CountSave(upsert);
 }
 
 void Player::_SaveSpells()
 {
+    std::ostringstream ss;
+    ss << "DELETE FROM character_spell WHERE guid = " << GetGUIDLow() << " AND spell IN (";
+    SqlBatch remove(CharacterDatabase, ss.str(), ")");
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_spell (guid, spell, active, disabled) VALUES ",
+        " ON DUPLICATE KEY UPDATE active = VALUES(active), disabled = VALUES(disabled)");
+
     for (PlayerSpellMap::const_iterator itr = m_spells.begin(), next = m_spells.begin(); itr != m_spells.end(); itr = next)
     {
         ++next;
-        if (itr->second->state == PLAYERSPELL_REMOVED || itr->second->state == PLAYERSPELL_CHANGED)
-            CharacterDatabase.PExecute("DELETE FROM character_spell WHERE guid = '%u' and spell = '%u'", GetGUIDLow(), itr->first);
-        if (itr->second->state == PLAYERSPELL_NEW || itr->second->state == PLAYERSPELL_CHANGED)
-            CharacterDatabase.PExecute("INSERT INTO character_spell (guid, spell, active, disabled) VALUES ('%u', '%u', '%u', '%u')", GetGUIDLow(), itr->first, itr->second->active ? 1 : 0, itr->second->disabled ? 1 : 0);
+        if (itr->second->state == PLAYERSPELL_REMOVED)
+            remove.AddRow("%u", itr->first);
+        else if (itr->second->state == PLAYERSPELL_NEW || itr->second->state == PLAYERSPELL_CHANGED)
+            upsert.AddRow("(%u, %u, %u, %u)", GetGUIDLow(), itr->first, itr->second->active ? 1 : 0, itr->second->disabled ? 1 : 0);
 
         if (itr->second->state == PLAYERSPELL_REMOVED)
             _removeSpell(itr->first);
         else
             itr->second->state = PLAYERSPELL_UNCHANGED;
     }
+
+    remove.Flush();
+    upsert.Flush();
+    _CountSave(remove);
+    _CountSave(upsert);
 }
 
 void Player::_SaveTutorials()
@@ -17847,25 +17902,29 @@ void Player::_SaveTutorials()
     if (!m_TutorialsChanged)
         return;
 
-    uint32 Rows=0;
-    // it's better than rebuilding indexes multiple times
-    QueryResult_AutoPtr result = CharacterDatabase.PQuery("SELECT count(*) AS r FROM character_tutorial WHERE account = '%u' AND realmid = '%u'", GetSession()->GetAccountId(), realmID);
-    if (result)
-        Rows = result->Fetch()[0].GetUInt32();
-
-    if (Rows)
-    {
-        CharacterDatabase.PExecute("UPDATE character_tutorial SET tut0='%u', tut1='%u', tut2='%u', tut3='%u', tut4='%u', tut5='%u', tut6='%u', tut7='%u' WHERE account = '%u' AND realmid = '%u'",
-            m_Tutorials[0], m_Tutorials[1], m_Tutorials[2], m_Tutorials[3], m_Tutorials[4], m_Tutorials[5], m_Tutorials[6], m_Tutorials[7], GetSession()->GetAccountId(), realmID);
-    }
-    else
-    {
-        CharacterDatabase.PExecute("INSERT INTO character_tutorial (account, realmid, tut0, tut1, tut2, tut3, tut4, tut5, tut6, tut7) VALUES ('%u', '%u', '%u', '%u', '%u', '%u', '%u', '%u', '%u', '%u')", GetSession()->GetAccountId(), realmID, m_Tutorials[0], m_Tutorials[1], m_Tutorials[2], m_Tutorials[3], m_Tutorials[4], m_Tutorials[5], m_Tutorials[6], m_Tutorials[7]);
-    };
+    SqlBatch upsert(CharacterDatabase, "INSERT INTO character_tutorial (account, realmid, tut0, tut1, tut2, tut3, tut4, tut5, tut6, tut7) VALUES ",
+        " ON DUPLICATE KEY UPDATE tut0 = VALUES(tut0), tut1 = VALUES(tut1), tut2 = VALUES(tut2), tut3 = VALUES(tut3), "
+        "tut4 = VALUES(tut4), tut5 = VALUES(tut5), tut6 = VALUES(tut6), tut7 = VALUES(tut7)");
+    upsert.AddRow("(%u, %u, %u, %u, %u, %u, %u, %u, %u, %u)", GetSession()->GetAccountId(), realmID,
+        m_Tutorials[0], m_Tutorials[1], m_Tutorials[2], m_Tutorials[3], m_Tutorials[4], m_Tutorials[5], m_Tutorials[6], m_Tutorials[7]);
+    upsert.Flush();
+    _CountSave(upsert);
 
     m_TutorialsChanged = false;
 }
 
+void Player::_CountSave(SqlBatch const& batch)
+{
+    m_saveRows += batch.GetWrittenRows();
+    m_saveBytes += batch.GetWrittenBytes();
+}
+
+void Player::_CountSave(PreparedStatement const* stmt)
+{
+    ++m_saveRows;
+    m_saveBytes += stmt->GetDataSize();
+}
+
 void Player::outDebugValues() const
 {
     #ifdef TRINITY_DEBUG
@@ -20161,17 +20220,40 @@ inline void BeforeVisibilityDestroy<Creature>(Creature* t, Player* p)
         ((Pet*)t)->Remove(PET_SAVE_NOT_IN_SLOT, true);
 }
 
+uint8 Player::GetInterestPriority(Unit const* u) const
+{
+    if (u->getVictim() == this || getVictim() == u || u->GetGUID() == GetSelection())
+        return INTEREST_PRIORITY_HIGH;
+
+    if (Player const* owner = u->GetCharmerOrOwnerPlayerOrPlayerItself())
+    {
+        if (IsInSameRaidWith(owner))
+            return INTEREST_PRIORITY_HIGH;
+        if (u->GetTypeId() == TYPEID_PLAYER && IsHostileTo(u))
+            return INTEREST_PRIORITY_HOSTILE_PLAYER;
+    }
+
+    return INTEREST_PRIORITY_NORMAL;
+}
+
 void Player::UpdateVisibilityOf(WorldObject* target)
 {
+    // on crowded maps units follow the enter/leave distances and the unit cap of VisibleNotifier
+    bool interest = target != this && target->isType(TYPEMASK_UNIT) && GetMap()->IsInterestManaged()
+        && GetInterestPriority((Unit*)target) != INTEREST_PRIORITY_HIGH;
+
     if (HaveAtClient(target))
     {
-        if (!target->isVisibleForInState(this, true))
+        bool leave = interest && !m_seer->IsWithinDist2d(target, World::GetInterestLeaveDistance());
+        if (leave || !target->isVisibleForInState(this, true))
         {
             if (target->GetTypeId() == TYPEID_UNIT)
                 BeforeVisibilityDestroy<Creature>(target->ToCreature(), this);
 
             target->DestroyForPlayer(this);
             m_clientGUIDs.erase(target->GetGUID());
+            if (interest && m_interestUnitCount)
+                --m_interestUnitCount;
 
             #ifdef TRINITY_DEBUG
             if ((sLog->getLogFilter() & LOG_FILTER_VISIBILITY_CHANGES) == 0)
@@ -20181,11 +20263,17 @@ void Player::UpdateVisibilityOf(WorldObject* target)
     }
     else
     {
+        if (interest && (m_interestUnitCount >= sWorld->getConfig(CONFIG_INTEREST_MANAGEMENT_MAX_UNITS)
+            || !m_seer->IsWithinDist2d(target, World::GetInterestEnterDistance())))
+            return;
+
         if (target->isVisibleForInState(this, false))
         {
             target->SendUpdateToPlayer(this);
             if (target->GetTypeId() != TYPEID_GAMEOBJECT||!((GameObject*)target)->IsTransport())
                 m_clientGUIDs.insert(target->GetGUID());
+            if (interest)
+                ++m_interestUnitCount;
 
             #ifdef TRINITY_DEBUG
             if ((sLog->getLogFilter() & LOG_FILTER_VISIBILITY_CHANGES) == 0)
@@ -20261,16 +20349,18 @@ void Player::UpdateObjectVisibility(bool forced)
     {
         Unit::UpdateObjectVisibility(true);
         // updates visibility of all objects around point of view for current player
-        Trinity::VisibleNotifier notifier(*this);
-        m_seer->VisitNearbyObject(GetMap()->GetVisibilityDistance(), notifier);
-        notifier.SendToSelf();   // send gathered data
+        UpdateVisibilityForPlayer();
     }
 }
 
 void Player::UpdateVisibilityForPlayer()
 {
+    CellPair p(Trinity::ComputeCellPair(m_seer->GetPositionX(), m_seer->GetPositionY()));
+    Cell cell(p);
+    cell.SetNoCreate();
+
     Trinity::VisibleNotifier notifier(*this);
-    m_seer->VisitNearbyObject(GetMap()->GetVisibilityDistance(), notifier);
+    cell.VisitIndexed(p, notifier, *GetMap(), *m_seer, Trinity::VisibilityNotifyRange(GetMap()->GetVisibilityDistance()), CELL_INDEX_ALL);
     notifier.SendToSelf();   // send gathered data
 }
 
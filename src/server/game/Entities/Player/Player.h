@@ -52,6 +52,8 @@ class Transport;
 class UpdateMask;
 class PlayerSocial;
 class OutdoorPvP;
+class SqlBatch;
+class PreparedStatement;
 
 typedef std::deque<Mail*> PlayerMails;
 
@@ -755,6 +757,11 @@ enum PlayerLoginQueryIndex
     PLAYER_LOGIN_QUERY_LOADBGDATA               = 19,
     PLAYER_LOGIN_QUERY_LOADSKILLS               = 20,
     PLAYER_LOGIN_QUERY_LOADTALENTS              = 21,
+    PLAYER_LOGIN_QUERY_LOADPET                  = 22,       // current pet, see Pet::LoadPetFromDB
+    PLAYER_LOGIN_QUERY_LOADPETAURAS             = 23,
+    PLAYER_LOGIN_QUERY_LOADPETSPELLS            = 24,
+    PLAYER_LOGIN_QUERY_LOADPETSPELLCOOLDOWNS    = 25,
+    PLAYER_LOGIN_QUERY_LOADPETDECLINEDNAMES     = 26,
 
     MAX_PLAYER_LOGIN_QUERY
 };
@@ -826,6 +833,14 @@ enum PlayerRestState
     REST_STATE_RAF_LINKED   = 0x04               // Exact use unknown
 };
 
+// order in which units enter the visibility of a player on interest managed maps
+enum InterestPriority
+{
+    INTEREST_PRIORITY_HIGH           = 0,        // attackers, target, selection, own raid: always visible
+    INTEREST_PRIORITY_HOSTILE_PLAYER = 1,
+    INTEREST_PRIORITY_NORMAL         = 2
+};
+
 class PlayerTaxi
 {
     public:
@@ -1240,7 +1255,7 @@ class Player : public Unit, public GridObject<Player>
         void RemoveItemDurations(Item *item);
         void SendItemDurations();
         void LoadCorpse();
-        void LoadPet();
+        void LoadPet(SqlQueryHolder* holder = NULL);
 
         uint32 m_stableSlots;
 
@@ -2202,6 +2217,12 @@ class Player : public Unit, public GridObject<Player>
         template<class T>
             void UpdateVisibilityOf(T* target, UpdateData& data, std::set<Unit*>& visibleNow);
 
+        // interest management, see Map::IsInterestManaged
+        uint8 GetInterestPriority(Unit const* u) const;
+        void SetInterestUnitCount(uint32 count) { m_interestUnitCount = count; }
+        // creates left over by the bandwidth budget, visibility is updated again next tick
+        void SetInterestBacklog() { m_interestBacklog = true; }
+
         // Stealth detection system
         void HandleStealthedUnitsDetection();
 
@@ -2375,6 +2396,15 @@ class Player : public Unit, public GridObject<Player>
         void _SaveTutorials();
         void _SaveBGData();
 
+        // rows and bytes written by the current SaveToDB, see World::RecordCharacterSave
+        void _CountSave(SqlBatch const& batch);
+        void _CountSave(PreparedStatement const* stmt);
+        uint32 m_saveRows;
+        uint32 m_saveBytes;
+
+        uint32 m_interestUnitCount;
+        bool m_interestBacklog;
+
         void _SetCreateBits(UpdateMask *updateMask, Player *target) const;
         void _SetUpdateBits(UpdateMask *updateMask, Player *target) const;
 
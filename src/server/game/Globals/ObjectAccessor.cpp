@@ -38,10 +38,11 @@
 #include "ObjectGuid.h"
 #include "MapInstanced.h"
 #include "World.h"
+#include "TickTracer.h"
 
 #include <cmath>
 
-ObjectAccessor::ObjectAccessor()
+ObjectAccessor::ObjectAccessor() : i_updateBlockCacheHits(0), i_updateBlockCacheMisses(0)
 {
 }
 
@@ -333,9 +334,39 @@ void ObjectAccessor::RemoveOldCorpses()
     }
 }
 
+// Builds and sends the object updates of one map. Objects are only ever seen
+// by players on their own map, so the per player update data of different
+// maps never overlap and the requests can run on the map update threads.
+class MapObjectUpdateRequest : public ACE_Method_Request
+{
+    public:
+        MapObjectUpdateRequest() {}
+
+        virtual int call()
+        {
+            UpdateDataMapType update_players;
+
+            for (std::vector<Object*>::const_iterator itr = m_objects.begin(); itr != m_objects.end(); ++itr)
+                (*itr)->BuildUpdate(update_players);
+
+            WorldPacket packet;                             // here we allocate a std::vector with a size of 0x10000
+            for (UpdateDataMapType::iterator iter = update_players.begin(); iter != update_players.end(); ++iter)
+            {
+                iter->second.BuildPacket(&packet);
+                iter->first->GetSession()->SendPacket(&packet);
+                packet.clear();                             // clean the string
+            }
+            return 0;
+        }
+
+        std::vector<Object*> m_objects;
+};
+
 void ObjectAccessor::Update(uint32 /*diff*/)
 {
-    UpdateDataMapType update_players;
+    TRACE_SPAN("ObjectAccessor::Update");
+
+    UNORDERED_MAP<Map*, MapObjectUpdateRequest*> requests;
 
     // Critical section
     {
@@ -346,17 +377,35 @@ void ObjectAccessor::Update(uint32 /*diff*/)
             Object* obj = *i_objects.begin();
             ASSERT(obj && obj->IsInWorld());
             i_objects.erase(i_objects.begin());
-            obj->BuildUpdate(update_players);
+
+            // items are sent to their owner only, group them with the owner's map
+            Map* map = NULL;
+            if (obj->isType(TYPEMASK_ITEM))
+            {
+                if (Player* owner = ((Item*)obj)->GetOwner())
+                    if (owner->IsInWorld())
+                        map = owner->GetMap();
+            }
+            else
+                map = ((WorldObject*)obj)->GetMap();
+
+            MapObjectUpdateRequest*& request = requests[map];
+            if (!request)
+                request = new MapObjectUpdateRequest();
+            request->m_objects.push_back(obj);
         }
     }
 
-    WorldPacket packet;                                     // here we allocate a std::vector with a size of 0x10000
-    for (UpdateDataMapType::iterator iter = update_players.begin(); iter != update_players.end(); ++iter)
-    {
-        iter->second.BuildPacket(&packet);
-        iter->first->GetSession()->SendPacket(&packet);
-        packet.clear();                                     // clean the string
-    }
+    std::vector<ACE_Method_Request*> chunks;
+    chunks.reserve(requests.size());
+    for (UNORDERED_MAP<Map*, MapObjectUpdateRequest*>::const_iterator itr = requests.begin(); itr != requests.end(); ++itr)
+        chunks.push_back(itr->second);
+
+    // maps are idle at this point of the world update, the map threads build the packets
+    sMapMgr->GetMapUpdater()->execute_chunks(chunks);
+
+    for (std::vector<ACE_Method_Request*>::const_iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+        delete *itr;
 }
 
 // Define the static members of HashMapHolder
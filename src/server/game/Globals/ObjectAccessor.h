@@ -33,6 +33,7 @@
 
 #include <ace/Singleton.h>
 #include <ace/Thread_Mutex.h>
+#include <ace/Atomic_Op.h>
 #include <set>
 
 class Creature;
@@ -216,6 +217,15 @@ class ObjectAccessor
 
         void Update(uint32 diff);
 
+        // values update blocks shared between observers of the same visibility class
+        void AddUpdateBlockCacheStats(uint32 hits, uint32 misses)
+        {
+            i_updateBlockCacheHits += hits;
+            i_updateBlockCacheMisses += misses;
+        }
+        uint64 GetUpdateBlockCacheHits() const { return i_updateBlockCacheHits.value(); }
+        uint64 GetUpdateBlockCacheMisses() const { return i_updateBlockCacheMisses.value(); }
+
         Corpse* GetCorpseForPlayerGUID(uint64 guid);
         void RemoveCorpse(Corpse* corpse);
         void AddCorpse(Corpse* corpse);
@@ -237,6 +247,9 @@ class ObjectAccessor
 
         LockType i_updateGuard;
         LockType i_corpseGuard;
+
+        ACE_Atomic_Op<ACE_Thread_Mutex, uint64> i_updateBlockCacheHits;
+        ACE_Atomic_Op<ACE_Thread_Mutex, uint64> i_updateBlockCacheMisses;
 };
 
 #define sObjectAccessor ACE_Singleton<ObjectAccessor, ACE_Thread_Mutex>::instance()
@@ -164,6 +164,8 @@ struct Cell
     template<class T, class CONTAINER> void Visit(const CellPair&, TypeContainerVisitor<T, CONTAINER> &visitor, Map &) const;
     template<class T, class CONTAINER> void Visit(const CellPair&, TypeContainerVisitor<T, CONTAINER> &visitor, Map &, const WorldObject&, float) const;
     template<class T, class CONTAINER> void Visit(const CellPair&, TypeContainerVisitor<T, CONTAINER> &visitor, Map &, float, float, float) const;
+    // visits only the objects of typeMask within radius, found through the cell position indexes
+    template<class NOTIFIER> void VisitIndexed(const CellPair&, NOTIFIER &notifier, Map &, const WorldObject&, float radius, uint8 typeMask) const;
 
     static CellArea CalculateCellArea(const WorldObject &obj, float radius);
     static CellArea CalculateCellArea(float x, float y, float radius);
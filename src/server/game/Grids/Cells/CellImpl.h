@@ -240,6 +240,41 @@ Cell::Visit(const CellPair& l, TypeContainerVisitor<T, CONTAINER> &visitor, Map
     Visit(l, visitor, m, radius + obj.GetObjectSize(), obj.GetPositionX(), obj.GetPositionY());
 }
 
+template<class NOTIFIER>
+inline void
+Cell::VisitIndexed(const CellPair& standing_cell, NOTIFIER &notifier, Map &m, const WorldObject &obj, float radius, uint8 typeMask) const
+{
+    if (standing_cell.x_coord >= TOTAL_NUMBER_OF_CELLS_PER_MAP || standing_cell.y_coord >= TOTAL_NUMBER_OF_CELLS_PER_MAP)
+        return;
+
+    const float x = obj.GetPositionX();
+    const float y = obj.GetPositionY();
+
+    // same cell area as Visit(), but only the objects inside the circle are visited
+    CellPair begin_cell = standing_cell;
+    CellPair end_cell = standing_cell;
+    float range = MAP_SIZE;
+    if (radius > 0.0f)
+    {
+        range = radius + obj.GetObjectSize();
+        Cell::CalculateCellArea(x, y, range > 333.0f ? 333.0f : range).ResizeBorders(begin_cell, end_cell);
+    }
+
+    CellPositionIndexResultList objects;
+    for (uint32 cell_x = begin_cell.x_coord; cell_x <= end_cell.x_coord; ++cell_x)
+    {
+        for (uint32 cell_y = begin_cell.y_coord; cell_y <= end_cell.y_coord; ++cell_y)
+        {
+            Cell r_zone(CellPair(cell_x, cell_y));
+            m.FindInPositionIndex(r_zone, data.Part.nocreate, x, y, range, typeMask, objects);
+        }
+    }
+
+    // notifiers may add or remove objects of these cells, so nothing is called while the indexes are read
+    for (CellPositionIndexResultList::const_iterator itr = objects.begin(); itr != objects.end(); ++itr)
+        Trinity::VisitIndexedObject(notifier, *itr);
+}
+
 template<class T, class CONTAINER>
 inline void
 Cell::VisitCircle(TypeContainerVisitor<T, CONTAINER> &visitor, Map &m, const CellPair& begin_cell, const CellPair& end_cell) const
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CellPositionIndex.h"
+#include "Object.h"
+#include "Creature.h"
+#include "GameObject.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define CELL_POSITION_INDEX_SSE2
+#endif
+
+// coordinate of the padding entries, far enough to never be in range
+#define CELL_POSITION_INDEX_FAR     1.0e18f
+
+void CellPositionIndex::Clear()
+{
+    i_x.clear();
+    i_y.clear();
+    i_guid.clear();
+    i_typeMask.clear();
+    i_objects.clear();
+    i_size = 0;
+    i_valid = false;
+}
+
+uint32 CellPositionIndex::Add(WorldObject* obj, uint8 typeMask)
+{
+    // only active creatures that are not pets or charmed and transports can be visible beyond the
+    // visibility distance (Player::canSeeOrDetect, GameObject::isVisibleForInState), everything else is culled
+    if (typeMask == CELL_INDEX_CREATURE && obj->isActiveObject() && !((Creature*)obj)->GetCharmerOrOwnerGUID())
+        typeMask |= CELL_INDEX_ACTIVE;
+    else if (typeMask == CELL_INDEX_GAMEOBJECT && ((GameObject*)obj)->IsTransport())
+        typeMask |= CELL_INDEX_ACTIVE;
+
+    i_x.push_back(obj->GetPositionX());
+    i_y.push_back(obj->GetPositionY());
+    i_guid.push_back(obj->GetGUID());
+    i_typeMask.push_back(typeMask);
+    i_objects.push_back(obj);
+    return i_size++;
+}
+
+void CellPositionIndex::SetValid()
+{
+    uint32 padded = (i_size + 3) & ~3;
+    i_x.resize(padded, CELL_POSITION_INDEX_FAR);
+    i_y.resize(padded, CELL_POSITION_INDEX_FAR);
+    i_valid = true;
+}
+
+void CellPositionIndex::FindInRange(float x, float y, float radius, uint8 typeMask, CellPositionIndexResultList& result) const
+{
+    float radiusSq = radius * radius;
+
+#ifdef CELL_POSITION_INDEX_SSE2
+    __m128 const cx = _mm_set1_ps(x);
+    __m128 const cy = _mm_set1_ps(y);
+    __m128 const r2 = _mm_set1_ps(radiusSq);
+
+    for (uint32 i = 0; i < i_size; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&i_x[i]), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&i_y[i]), cy);
+        __m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        int inRange = _mm_movemask_ps(_mm_cmple_ps(distSq, r2));
+
+        uint32 count = i_size - i < 4 ? i_size - i : 4;
+        for (uint32 j = 0; j < count; ++j)
+        {
+            uint8 mask = i_typeMask[i + j];
+            if ((mask & typeMask) && ((inRange & (1 << j)) || (mask & CELL_INDEX_ACTIVE)))
+                result.push_back(CellPositionIndexResult(i_objects[i + j], i_guid[i + j], mask));
+        }
+    }
+#else
+    for (uint32 i = 0; i < i_size; ++i)
+    {
+        uint8 mask = i_typeMask[i];
+        if (!(mask & typeMask))
+            continue;
+
+        float dx = i_x[i] - x;
+        float dy = i_y[i] - y;
+        if (dx * dx + dy * dy <= radiusSq || (mask & CELL_INDEX_ACTIVE))
+            result.push_back(CellPositionIndexResult(i_objects[i], i_guid[i], mask));
+    }
+#endif
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_CELLPOSITIONINDEX_H
+#define TRINITY_CELLPOSITIONINDEX_H
+
+#include "Define.h"
+
+#include <vector>
+
+class WorldObject;
+
+// slot of an object that is not in any cell position index
+#define CELL_POSITION_INDEX_NONE    0xFFFFFFFF
+
+enum CellPositionIndexTypeMask
+{
+    CELL_INDEX_PLAYER        = 0x01,
+    CELL_INDEX_CREATURE      = 0x02,
+    CELL_INDEX_GAMEOBJECT    = 0x04,
+    CELL_INDEX_DYNAMICOBJECT = 0x08,
+    CELL_INDEX_CORPSE        = 0x10,
+    CELL_INDEX_ACTIVE        = 0x80,                        // objects that may be visible beyond the range are returned regardless of it
+
+    CELL_INDEX_UNIT          = CELL_INDEX_PLAYER | CELL_INDEX_CREATURE,
+    CELL_INDEX_ALL           = CELL_INDEX_UNIT | CELL_INDEX_GAMEOBJECT | CELL_INDEX_DYNAMICOBJECT | CELL_INDEX_CORPSE
+};
+
+struct CellPositionIndexResult
+{
+    CellPositionIndexResult(WorldObject* obj, uint64 guid, uint8 typeMask) : object(obj), guid(guid), typeMask(typeMask) {}
+
+    WorldObject* object;
+    uint64 guid;
+    uint8 typeMask;
+};
+
+typedef std::vector<CellPositionIndexResult> CellPositionIndexResultList;
+
+namespace Trinity
+{
+    // calls notifier.VisitObject with the real type of the object, defined in GridNotifiers.h
+    template<class NOTIFIER> void VisitIndexedObject(NOTIFIER &notifier, CellPositionIndexResult const& result);
+}
+
+/*
+  Structure of arrays copy of the objects of one cell, so the range checks of the
+  visibility and relocation notifiers run over packed coordinates instead of chasing
+  the GridRefManager lists. The index is packed by Map::FindInPositionIndex on first use,
+  dropped whenever an object enters or leaves the cell and kept up to date by the map
+  relocation functions while the objects move inside the cell. The index does no locking
+  of its own, all access goes through the map under Map::m_positionIndexLock.
+*/
+class CellPositionIndex
+{
+    public:
+        CellPositionIndex() : i_size(0), i_valid(false) {}
+
+        bool IsValid() const { return i_valid; }
+        void Invalidate() { i_valid = false; }
+
+        // starts packing, Add() every object of the cell and then call SetValid()
+        void Clear();
+        // returns the slot of the object
+        uint32 Add(WorldObject* obj, uint8 typeMask);
+        void SetValid();
+
+        uint32 GetSize() const { return i_size; }
+        WorldObject* GetObject(uint32 slot) const { return slot < i_size ? i_objects[slot] : NULL; }
+        void Relocate(uint32 slot, float x, float y) { i_x[slot] = x; i_y[slot] = y; }
+
+        // appends the objects of typeMask within radius (2d) of x, y
+        void FindInRange(float x, float y, float radius, uint8 typeMask, CellPositionIndexResultList& result) const;
+
+    private:
+        // coordinates are padded with far away entries to a multiple of 4 for the SSE2 range test
+        std::vector<float> i_x;
+        std::vector<float> i_y;
+        std::vector<uint64> i_guid;
+        std::vector<uint8> i_typeMask;
+        std::vector<WorldObject*> i_objects;
+        uint32 i_size;
+        bool i_valid;
+};
+#endif
@@ -25,6 +25,7 @@
 
 #include "Grid.h"
 #include "GridReference.h"
+#include "CellPositionIndex.h"
 #include "Timer.h"
 #include "Util.h"
 
@@ -124,6 +125,20 @@ class NGrid
         void ResetTimeTracker(time_t interval) { i_GridInfo.ResetTimeTracker(interval); }
         void UpdateTimeTracker(time_t diff) { i_GridInfo.UpdateTimeTracker(diff); }
 
+        CellPositionIndex& getPositionIndex(const uint32 x, const uint32 y)
+        {
+            ASSERT(x < N);
+            ASSERT(y < N);
+            return i_positionIndex[x][y];
+        }
+
+        void InvalidatePositionIndex()
+        {
+            for (unsigned int x=0; x < N; ++x)
+                for (unsigned int y=0; y < N; ++y)
+                    i_positionIndex[x][y].Invalidate();
+        }
+
         template<class SPECIFIC_OBJECT> void AddWorldObject(const uint32 x, const uint32 y, SPECIFIC_OBJECT *obj)
         {
             getGridType(x, y).AddWorldObject(obj);
@@ -181,6 +196,7 @@ class NGrid
         int32 i_y;
         grid_state_t i_cellstate;
         GridType i_cells[N][N];
+        CellPositionIndex i_positionIndex[N][N];
         bool i_GridObjectDataLoaded;
 };
 #endif
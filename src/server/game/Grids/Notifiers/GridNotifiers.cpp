@@ -34,9 +34,55 @@
 
 using namespace Trinity;
 
+void
+VisibleNotifier::ProcessInterestUnits()
+{
+    if (i_interestUnits.empty())
+        return;
+
+    std::sort(i_interestUnits.begin(), i_interestUnits.end());
+
+    float enterDistSq = World::GetInterestEnterDistance() * World::GetInterestEnterDistance();
+    float leaveDistSq = World::GetInterestLeaveDistance() * World::GetInterestLeaveDistance();
+    uint32 maxUnits = sWorld->getConfig(CONFIG_INTEREST_MANAGEMENT_MAX_UNITS);
+    uint32 createBytes = sWorld->getConfig(CONFIG_INTEREST_MANAGEMENT_CREATE_BYTES);
+    uint32 shown = 0;
+
+    for (std::vector<InterestCandidate>::const_iterator itr = i_interestUnits.begin(); itr != i_interestUnits.end(); ++itr)
+    {
+        if (itr->priority != INTEREST_PRIORITY_HIGH)
+        {
+            // units skipped while at client stay in vis_guids and are removed by SendToSelf
+            bool atClient = i_player.HaveAtClient(itr->unit);
+            if (itr->distSq > (atClient ? leaveDistSq : enterDistSq) || shown >= maxUnits)
+                continue;
+
+            if (!atClient && i_data.GetBufferSize() >= createBytes)
+            {
+                i_player.SetInterestBacklog();
+                continue;
+            }
+        }
+
+        vis_guids.erase(itr->guid);
+        if (itr->unit->GetTypeId() == TYPEID_PLAYER)
+            i_player.UpdateVisibilityOf(itr->unit->ToPlayer(), i_data, i_visibleNow);
+        else
+            i_player.UpdateVisibilityOf(itr->unit->ToCreature(), i_data, i_visibleNow);
+
+        if (itr->priority != INTEREST_PRIORITY_HIGH && i_player.HaveAtClient(itr->unit))
+            ++shown;
+    }
+
+    i_player.SetInterestUnitCount(shown);
+    i_interestUnits.clear();
+}
+
 void
 VisibleNotifier::SendToSelf()
 {
+    ProcessInterestUnits();
+
     // at this moment i_clientGUIDs have guids that not iterate at grid level checks
     // but exist one case when this possible and object not out of range: transports
     if (Transport* transport = i_player.GetTransport())
@@ -129,63 +175,64 @@ inline void CreatureUnitRelocationWorker(Creature* c, Unit* u)
 void PlayerRelocationNotifier::Visit(PlayerMapType &m)
 {
     for (PlayerMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
-    {
-        Player* plr = iter->getSource();
-
-        vis_guids.erase(plr->GetGUID());
+        VisitObject(iter->getSource(), iter->getSource()->GetGUID());
+}
 
-        i_player.UpdateVisibilityOf(plr, i_data, i_visibleNow);
+void PlayerRelocationNotifier::VisitObject(Player* plr, uint64 guid)
+{
+    VisitUnit(plr, guid);
 
-        if (plr->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
-            continue;
+    if (plr->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+        return;
 
-        plr->UpdateVisibilityOf(&i_player);
-    }
+    plr->UpdateVisibilityOf(&i_player);
 }
 
 void PlayerRelocationNotifier::Visit(CreatureMapType &m)
 {
-    bool relocated_for_ai = (&i_player == i_player.m_seer);
-
     for (CreatureMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
-    {
-        Creature * c = iter->getSource();
+        VisitObject(iter->getSource(), iter->getSource()->GetGUID());
+}
 
-        vis_guids.erase(c->GetGUID());
+void PlayerRelocationNotifier::VisitObject(Creature* c, uint64 guid)
+{
+    bool relocated_for_ai = (&i_player == i_player.m_seer);
 
-        i_player.UpdateVisibilityOf(c, i_data, i_visibleNow);
+    VisitUnit(c, guid);
 
-        if (relocated_for_ai && !c->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
-            CreatureUnitRelocationWorker(c, &i_player);
-    }
+    if (relocated_for_ai && !c->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+        CreatureUnitRelocationWorker(c, &i_player);
 }
 
 void CreatureRelocationNotifier::Visit(PlayerMapType &m)
 {
     for (PlayerMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
-    {
-        Player * pl = iter->getSource();
+        VisitObject(iter->getSource(), iter->getSource()->GetGUID());
+}
 
-        if (!pl->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
-            pl->UpdateVisibilityOf(&i_creature);
+void CreatureRelocationNotifier::VisitObject(Player* pl, uint64 /*guid*/)
+{
+    if (!pl->m_seer->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+        pl->UpdateVisibilityOf(&i_creature);
 
-        CreatureUnitRelocationWorker(&i_creature, pl);
-    }
+    CreatureUnitRelocationWorker(&i_creature, pl);
 }
 
 void CreatureRelocationNotifier::Visit(CreatureMapType &m)
+{
+    for (CreatureMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
+        VisitObject(iter->getSource(), iter->getSource()->GetGUID());
+}
+
+void CreatureRelocationNotifier::VisitObject(Creature* c, uint64 /*guid*/)
 {
     if (!i_creature.isAlive())
         return;
 
-    for (CreatureMapType::iterator iter=m.begin(); iter != m.end(); ++iter)
-    {
-        Creature* c = iter->getSource();
-        CreatureUnitRelocationWorker(&i_creature, c);
+    CreatureUnitRelocationWorker(&i_creature, c);
 
-        if (!c->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
-            CreatureUnitRelocationWorker(c, &i_creature);
-    }
+    if (!c->isNeedNotify(NOTIFY_VISIBILITY_CHANGED))
+        CreatureUnitRelocationWorker(c, &i_creature);
 }
 
 void DelayedUnitRelocation::Visit(CreatureMapType &m)
@@ -197,12 +244,7 @@ void DelayedUnitRelocation::Visit(CreatureMapType &m)
             continue;
 
         CreatureRelocationNotifier relocate(*unit);
-
-        TypeContainerVisitor<CreatureRelocationNotifier, WorldTypeMapContainer > c2world_relocation(relocate);
-        TypeContainerVisitor<CreatureRelocationNotifier, GridTypeMapContainer >  c2grid_relocation(relocate);
-
-        cell.Visit(p, c2world_relocation, i_map, *unit, i_radius);
-        cell.Visit(p, c2grid_relocation, i_map, *unit, i_radius);
+        cell.VisitIndexed(p, relocate, i_map, *unit, i_radius + World::GetVisibleUnitGreyDistance(), CELL_INDEX_UNIT);
     }
 }
 
@@ -224,11 +266,7 @@ void DelayedUnitRelocation::Visit(PlayerMapType &m)
         //cell.SetNoCreate(); need load cells around viewPoint or player, that's why its commented
 
         PlayerRelocationNotifier relocate(*player);
-        TypeContainerVisitor<PlayerRelocationNotifier, WorldTypeMapContainer > c2world_relocation(relocate);
-        TypeContainerVisitor<PlayerRelocationNotifier, GridTypeMapContainer >  c2grid_relocation(relocate);
-
-        cell2.Visit(pair2, c2world_relocation, i_map, *viewPoint, i_radius);
-        cell2.Visit(pair2, c2grid_relocation, i_map, *viewPoint, i_radius);
+        cell2.VisitIndexed(pair2, relocate, i_map, *viewPoint, VisibilityNotifyRange(i_radius), CELL_INDEX_ALL);
 
         relocate.SendToSelf();
     }
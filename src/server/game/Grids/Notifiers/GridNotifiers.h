@@ -33,6 +33,7 @@
 #include "Player.h"
 #include "Unit.h"
 #include "CreatureAI.h"
+#include "World.h"
 
 class Player;
 //class Map;
@@ -46,8 +47,31 @@ namespace Trinity
         std::set<Unit*> i_visibleNow;
         Player::ClientUnorderedGUIDs vis_guids;
 
-        VisibleNotifier(Player &player) : i_player(player), vis_guids(player.m_clientGUIDs) {}
+        // units seen on an interest managed map, ordered by priority and distance before they are shown
+        struct InterestCandidate
+        {
+            InterestCandidate(Unit* u, uint64 guid, uint8 priority, float distSq) : unit(u), guid(guid), priority(priority), distSq(distSq) {}
+            bool operator<(InterestCandidate const& other) const
+            {
+                return priority != other.priority ? priority < other.priority : distSq < other.distSq;
+            }
+
+            Unit* unit;
+            uint64 guid;
+            uint8 priority;
+            float distSq;
+        };
+        bool i_interestManaged;
+        std::vector<InterestCandidate> i_interestUnits;
+
+        VisibleNotifier(Player &player) : i_player(player), vis_guids(player.m_clientGUIDs),
+            i_interestManaged(player.GetMap()->IsInterestManaged()) {}
         template<class T> void Visit(GridRefManager<T> &m);
+        template<class T> void VisitObject(T* obj, uint64 guid);
+        void VisitObject(Creature* c, uint64 guid) { VisitUnit(c, guid); }
+        void VisitObject(Player* plr, uint64 guid) { VisitUnit(plr, guid); }
+        template<class T> void VisitUnit(T* u, uint64 guid);
+        void ProcessInterestUnits();
         void SendToSelf(void);
     };
 
@@ -69,6 +93,9 @@ namespace Trinity
         template<class T> void Visit(GridRefManager<T> &m) { VisibleNotifier::Visit(m); }
         void Visit(CreatureMapType &);
         void Visit(PlayerMapType &);
+        template<class T> void VisitObject(T* obj, uint64 guid) { VisibleNotifier::VisitObject(obj, guid); }
+        void VisitObject(Creature* c, uint64 guid);
+        void VisitObject(Player* plr, uint64 guid);
     };
 
     struct CreatureRelocationNotifier
@@ -78,8 +105,30 @@ namespace Trinity
         template<class T> void Visit(GridRefManager<T> &) {}
         void Visit(CreatureMapType &);
         void Visit(PlayerMapType &);
+        template<class T> void VisitObject(T*, uint64) {}
+        void VisitObject(Creature* c, uint64 guid);
+        void VisitObject(Player* pl, uint64 guid);
     };
 
+    // the visibility notifiers also have to reach the objects in the grey zone, which stay visible a bit beyond the visibility distance
+    inline float VisibilityNotifyRange(float visibilityDistance)
+    {
+        return visibilityDistance + std::max(World::GetVisibleUnitGreyDistance(), World::GetVisibleObjectGreyDistance());
+    }
+
+    template<class NOTIFIER>
+    void VisitIndexedObject(NOTIFIER &notifier, CellPositionIndexResult const& result)
+    {
+        switch (result.typeMask & CELL_INDEX_ALL)
+        {
+            case CELL_INDEX_PLAYER:        notifier.VisitObject((Player*)result.object, result.guid); break;
+            case CELL_INDEX_CREATURE:      notifier.VisitObject((Creature*)result.object, result.guid); break;
+            case CELL_INDEX_GAMEOBJECT:    notifier.VisitObject((GameObject*)result.object, result.guid); break;
+            case CELL_INDEX_DYNAMICOBJECT: notifier.VisitObject((DynamicObject*)result.object, result.guid); break;
+            case CELL_INDEX_CORPSE:        notifier.VisitObject((Corpse*)result.object, result.guid); break;
+        }
+    }
+
     struct DelayedUnitRelocation
     {
         Map &i_map;
@@ -125,6 +174,8 @@ namespace Trinity
     {
         WorldObject *i_source;
         WorldPacket *i_message;
+        // copy of i_message queued by the recipients whose socket buffer is full
+        WorldPacketPtr i_shared;
         float i_distSq;
         uint32 team;
         uint32 i_phaseMask;
@@ -145,7 +196,7 @@ namespace Trinity
                 return;
 
             if (WorldSession* session = plr->GetSession())
-                session->SendPacket(i_message);
+                session->SendPacket(i_message, &i_shared);
         }
     };
 
@@ -34,10 +34,29 @@ inline void
 Trinity::VisibleNotifier::Visit(GridRefManager<T> &m)
 {
     for (typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
+        VisitObject(iter->getSource(), iter->getSource()->GetGUID());
+}
+
+template<class T>
+inline void
+Trinity::VisibleNotifier::VisitObject(T* obj, uint64 guid)
+{
+    vis_guids.erase(guid);
+    i_player.UpdateVisibilityOf(obj, i_data, i_visibleNow);
+}
+
+template<class T>
+inline void
+Trinity::VisibleNotifier::VisitUnit(T* u, uint64 guid)
+{
+    if (i_interestManaged && (Unit*)u != &i_player)
     {
-        vis_guids.erase(iter->getSource()->GetGUID());
-        i_player.UpdateVisibilityOf(iter->getSource(), i_data, i_visibleNow);
+        i_interestUnits.push_back(InterestCandidate(u, guid, i_player.GetInterestPriority(u), i_player.m_seer->GetExactDist2dSq(u)));
+        return;
     }
+
+    vis_guids.erase(guid);
+    i_player.UpdateVisibilityOf(u, i_data, i_visibleNow);
 }
 
 inline void
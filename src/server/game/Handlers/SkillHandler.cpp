@@ -29,6 +29,7 @@
 #include "ObjectAccessor.h"
 #include "UpdateMask.h"
 #include "SpellAuras.h"
+#include "BattlegroundMgr.h"
 
 void WorldSession::HandleLearnTalentOpcode(WorldPacket & recv_data)
 {
@@ -137,6 +138,10 @@ void WorldSession::HandleLearnTalentOpcode(WorldPacket & recv_data)
 
     // update free talent points
     GetPlayer()->SetFreeTalentPoints(CurTalentPoints - 1);
+
+    // the talent can change the role the player is queued with (talent resets are refused while queued)
+    if (GetPlayer()->InBattleGroundQueueForBattleGroundQueueType(BATTLEGROUND_QUEUE_SOLO_3v3))
+        sBattleGroundMgr->m_BattleGroundQueues[BATTLEGROUND_QUEUE_SOLO_3v3].UpdateSoloQueueRole(GetPlayer());
 }
 
 void WorldSession::HandleTalentWipeOpcode(WorldPacket & recv_data)
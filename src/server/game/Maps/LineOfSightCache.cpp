@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LineOfSightCache.h"
+#include "Timer.h"
+#include "World.h"
+
+#include <ace/Guard_T.h>
+#include <algorithm>
+#include <cmath>
+
+ACE_Atomic_Op<ACE_Thread_Mutex, uint64> LineOfSightCache::s_hits(0);
+ACE_Atomic_Op<ACE_Thread_Mutex, uint64> LineOfSightCache::s_misses(0);
+ACE_Atomic_Op<ACE_Thread_Mutex, uint64> LineOfSightCache::s_batchedRays(0);
+
+LineOfSightCache::Key::Key(float x1, float y1, float z1, float x2, float y2, float z2)
+{
+    // half yard grid
+    int32 a[3] = { int32(floor(x1 * 2.0f)), int32(floor(y1 * 2.0f)), int32(floor(z1 * 2.0f)) };
+    int32 b[3] = { int32(floor(x2 * 2.0f)), int32(floor(y2 * 2.0f)), int32(floor(z2 * 2.0f)) };
+
+    bool swap = std::lexicographical_compare(b, b + 3, a, a + 3);
+    std::copy(swap ? b : a, (swap ? b : a) + 3, pos);
+    std::copy(swap ? a : b, (swap ? a : b) + 3, pos + 3);
+}
+
+bool LineOfSightCache::Lookup(Key const& key, bool& inLineOfSight)
+{
+    ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, m_lock, false);
+
+    EntryMap::iterator itr = m_entries.find(key);
+    if (itr == m_entries.end())
+        return false;
+
+    if (getMSTimeDiff(itr->second.storeTime, getMSTime()) <= sWorld->getConfig(CONFIG_LOS_CACHE_TIME))
+    {
+        inLineOfSight = itr->second.inLineOfSight;
+        return true;
+    }
+
+    m_entries.erase(itr);
+    return false;
+}
+
+bool LineOfSightCache::Find(float x1, float y1, float z1, float x2, float y2, float z2, bool& inLineOfSight)
+{
+    if (Lookup(Key(x1, y1, z1, x2, y2, z2), inLineOfSight))
+    {
+        ++s_hits;
+        return true;
+    }
+
+    ++s_misses;
+    return false;
+}
+
+bool LineOfSightCache::IsCached(float x1, float y1, float z1, float x2, float y2, float z2)
+{
+    bool inLineOfSight;
+    return Lookup(Key(x1, y1, z1, x2, y2, z2), inLineOfSight);
+}
+
+void LineOfSightCache::Store(float x1, float y1, float z1, float x2, float y2, float z2, bool inLineOfSight)
+{
+    uint32 maxEntries = sWorld->getConfig(CONFIG_LOS_CACHE_SIZE);
+    if (!maxEntries)
+        return;
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, m_lock);
+
+    if (m_entries.size() >= maxEntries)
+    {
+        uint32 now = getMSTime();
+        uint32 cacheTime = sWorld->getConfig(CONFIG_LOS_CACHE_TIME);
+        for (EntryMap::iterator itr = m_entries.begin(); itr != m_entries.end();)
+        {
+            if (getMSTimeDiff(itr->second.storeTime, now) > cacheTime)
+                m_entries.erase(itr++);
+            else
+                ++itr;
+        }
+
+        // everything is fresh, the map checks more pairs than the cache holds
+        if (m_entries.size() >= maxEntries)
+            m_entries.clear();
+    }
+
+    Entry& entry = m_entries[Key(x1, y1, z1, x2, y2, z2)];
+    entry.inLineOfSight = inLineOfSight;
+    entry.storeTime = getMSTime();
+}
+
+void LineOfSightCache::Clear()
+{
+    ACE_GUARD(ACE_Thread_Mutex, guard, m_lock);
+
+    m_entries.clear();
+}
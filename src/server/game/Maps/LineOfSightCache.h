@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_LINEOFSIGHTCACHE_H
+#define TRINITY_LINEOFSIGHTCACHE_H
+
+#include "Define.h"
+
+#include <ace/Atomic_Op.h>
+#include <ace/Thread_Mutex.h>
+#include <map>
+
+/*
+  Recent line of sight results of one map. The end points are rounded to a half yard
+  grid and ordered, so A to B and B to A share an entry, and units that stand still
+  or barely move keep hitting the same entry while they fight. Results expire after
+  vmap.losCacheTime and the expired entries are dropped once vmap.losCacheSize
+  is reached. Lookups and stores hold m_lock only for the map access, the vmap
+  query of a miss runs unlocked, so two threads may compute the same ray once each.
+*/
+class LineOfSightCache
+{
+    public:
+        LineOfSightCache() {}
+
+        // true and the cached result in inLineOfSight if there is a fresh one
+        bool Find(float x1, float y1, float z1, float x2, float y2, float z2, bool& inLineOfSight);
+        // same lookup without touching the hit and miss counters, for batched prefetches
+        bool IsCached(float x1, float y1, float z1, float x2, float y2, float z2);
+        void Store(float x1, float y1, float z1, float x2, float y2, float z2, bool inLineOfSight);
+        void Clear();
+
+        // counters of all maps since the start, for .server los
+        static uint64 GetHits() { return s_hits.value(); }
+        static uint64 GetMisses() { return s_misses.value(); }
+        static uint64 GetBatchedRays() { return s_batchedRays.value(); }
+        static void CountBatchedRays(uint32 count) { s_batchedRays += count; }
+
+    private:
+        struct Key
+        {
+            Key(float x1, float y1, float z1, float x2, float y2, float z2);
+
+            bool operator<(Key const& other) const
+            {
+                for (int i = 0; i < 6; ++i)
+                    if (pos[i] != other.pos[i])
+                        return pos[i] < other.pos[i];
+                return false;
+            }
+
+            int32 pos[6];
+        };
+
+        struct Entry
+        {
+            bool inLineOfSight;
+            uint32 storeTime;
+        };
+
+        typedef std::map<Key, Entry> EntryMap;
+
+        bool Lookup(Key const& key, bool& inLineOfSight);
+
+        EntryMap m_entries;
+        ACE_Thread_Mutex m_lock;
+
+        static ACE_Atomic_Op<ACE_Thread_Mutex, uint64> s_hits;
+        static ACE_Atomic_Op<ACE_Thread_Mutex, uint64> s_misses;
+        static ACE_Atomic_Op<ACE_Thread_Mutex, uint64> s_batchedRays;
+};
+#endif
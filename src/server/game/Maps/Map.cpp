@@ -32,6 +32,10 @@
 #include "MapManager.h"
 #include "ObjectMgr.h"
 #include "MoveMap.h"
+#include "Battleground.h"
+#include "TickTracer.h"
+
+#include <ace/TSS_T.h>
 
 #define DEFAULT_GRID_EXPIRY     300
 #define MAX_GRID_LOAD_TIME      50
@@ -72,7 +76,8 @@ bool Map::ExistMap(uint32 mapid, int gx, int gy)
         map_fileheader header;
         if (fread(&header, sizeof(header), 1, pf) == 1)
         {
-            if (header.mapMagic != *((uint32 const*)(MAP_MAGIC)) || header.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC)))
+            if (header.mapMagic != *((uint32 const*)(MAP_MAGIC)) || (header.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC)) &&
+                header.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC_UNALIGNED))))
                 sLog->outError("Map file '%s' is from an incompatible clientversion. Please recreate using the mapextractor.", tmp);
             else
                 ret = true;
@@ -127,6 +132,9 @@ void Map::LoadMap(int gx, int gy, bool reload)
         if (GridMaps[gx][gy])
             return;
 
+        // sibling instances are updated on different map threads
+        ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, ((MapInstanced*)m_parentMap)->GetGridMapReferenceLock());
+
         // load grid map for base map
         if (!m_parentMap->GridMaps[gx][gy])
             m_parentMap->EnsureGridCreated(GridPair(63-gx, 63-gy));
@@ -169,6 +177,7 @@ void Map::LoadMapAndVMap(int gx, int gy)
     {
         // Only load the data for the base map
         LoadVMap(gx, gy);
+        m_losCache.Clear();
 
         // Load navmesh
         MMAP::MMapFactory::createOrGetMMapManager()->loadMap(GetId(), gx, gy);
@@ -194,12 +203,17 @@ void Map::DeleteStateMachine()
 Map::Map(uint32 id, time_t expiry, uint32 InstanceId, uint8 SpawnMode, Map* _parent):
 i_mapEntry (sMapStore.LookupEntry(id)), i_spawnMode(SpawnMode), i_InstanceId(InstanceId),
 m_unloadTimer(0), m_VisibleDistance(DEFAULT_VISIBILITY_DISTANCE),
-m_VisibilityNotifyPeriod(DEFAULT_VISIBILITY_NOTIFY_PERIOD),
+m_VisibilityNotifyPeriod(DEFAULT_VISIBILITY_NOTIFY_PERIOD), m_updateCost(0),
 m_activeNonPlayersIter(m_activeNonPlayers.end()), i_gridExpiry(expiry),
-i_scriptLock(false)
+i_scriptLock(false), m_cellRegionsRunning(false), m_cellRegionBlockSize(0), m_cellRegionBlocksPerRow(0)
 {
     m_parentMap = (_parent ? _parent : this);
 
+    // only continents, instances are small and already updated in parallel with each other
+    m_parallelCellUpdate = !Instanceable() && sWorld->IsParallelCellUpdateMap(id);
+    m_interestManaged = false;
+    m_pathfindingTime = 0;
+
     for (unsigned int idx=0; idx < MAX_NUMBER_OF_GRIDS; ++idx)
     {
         for (unsigned int j=0; j < MAX_NUMBER_OF_GRIDS; ++j)
@@ -229,6 +243,9 @@ void Map::AddToGrid(T* obj, NGridType *grid, Cell const& cell)
         (*grid)(cell.CellX(), cell.CellY()).template AddWorldObject<T>(obj);
     else
         (*grid)(cell.CellX(), cell.CellY()).template AddGridObject<T>(obj);
+
+    InvalidatePositionIndex(obj);
+    InvalidatePositionIndex(grid, cell);
 }
 
 template<>
@@ -240,6 +257,9 @@ void Map::AddToGrid(Creature* obj, NGridType *grid, Cell const& cell)
         (*grid)(cell.CellX(), cell.CellY()).AddGridObject(obj);
 
     obj->SetCurrentCell(cell);
+
+    InvalidatePositionIndex(obj);
+    InvalidatePositionIndex(grid, cell);
 }
 
 template<class T>
@@ -249,6 +269,9 @@ void Map::RemoveFromGrid(T* obj, NGridType *grid, Cell const& cell)
         (*grid)(cell.CellX(), cell.CellY()).template RemoveWorldObject<T>(obj);
     else
         (*grid)(cell.CellX(), cell.CellY()).template RemoveGridObject<T>(obj);
+
+    InvalidatePositionIndex(obj);
+    InvalidatePositionIndex(grid, cell);
 }
 
 template<class T>
@@ -361,6 +384,14 @@ bool Map::EnsureGridLoaded(const Cell &cell)
     ASSERT(grid != NULL);
     if (!isGridObjectDataLoaded(cell.GridX(), cell.GridY()))
     {
+        // the loader links objects into every cell of the grid, some of them may be updated by another region
+        if (m_cellRegionsRunning)
+        {
+            ACE_GUARD_RETURN(ACE_Recursive_Thread_Mutex, deferredGuard, m_deferredLock, false);
+            m_deferredGridLoads.push_back(cell);
+            return false;
+        }
+
         sLog->outDebug("Loading grid[%u, %u] for map %u instance %u", cell.GridX(), cell.GridY(), GetId(), i_InstanceId);
 
         setGridObjectDataLoaded(true, cell.GridX(), cell.GridY());
@@ -370,6 +401,12 @@ bool Map::EnsureGridLoaded(const Cell &cell)
 
         // Add resurrectable corpses to world object list in grid
         sObjectAccessor->AddCorpsesToGrid(GridPair(cell.GridX(), cell.GridY()), (*grid)(cell.CellX(), cell.CellY()), this);
+
+        // the loaders link the objects directly into the cells
+        {
+            TRINITY_WRITE_GUARD(ACE_RW_Thread_Mutex, m_positionIndexLock);
+            grid->InvalidatePositionIndex();
+        }
         return true;
     }
 
@@ -396,6 +433,8 @@ bool Map::Add(Player* player)
 
     player->SetMap(this);
 
+    ACE_GUARD_RETURN(ACE_Recursive_Thread_Mutex, deferredGuard, m_deferredLock, false);
+
     Cell cell(p);
     EnsureGridLoadedAtEnter(cell, player);
     NGridType *grid = getNGrid(cell.GridX(), cell.GridY());
@@ -424,6 +463,8 @@ Map::Add(T *obj)
         return;
     }
 
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, deferredGuard, m_deferredLock);
+
     Cell cell(p);
     if (obj->IsInWorld()) // need some clean up later
     {
@@ -431,6 +472,13 @@ Map::Add(T *obj)
         return;
     }
 
+    // objects of another region could see it, it enters the world after the join
+    if (IsNextToOtherCellRegion(p))
+    {
+        m_deferredAdds.push_back(obj);
+        return;
+    }
+
     if (obj->isActiveObject())
         EnsureGridLoadedAtEnter(cell);
     else
@@ -548,6 +596,26 @@ bool Map::loaded(const GridPair &p) const
 
 void Map::Update(const uint32 &t_diff)
 {
+    TRACE_SPAN(i_mapEntry && *i_mapEntry->name[0] ? i_mapEntry->name[0] : "Map::Update");
+
+    uint32 interestPlayers = sWorld->getConfig(CONFIG_INTEREST_MANAGEMENT_PLAYERS);
+    m_interestManaged = interestPlayers && GetPlayersCountExceptGMs() >= interestPlayers;
+
+    // the path searches deferred by the last update are served first, see PathInfo::BuildPolyPath
+    m_pathfindingTime = 0;
+
+    // handle the map local packets of the players in this map
+    for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
+    {
+        Player* plr = m_mapRefIter->getSource();
+        if (plr && plr->IsInWorld())
+        {
+            WorldSession* pSession = plr->GetSession();
+            MapSessionFilter updater(pSession);
+            pSession->Update(t_diff, updater);
+        }
+    }
+
     // update players at tick
     for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
     {
@@ -559,6 +627,10 @@ void Map::Update(const uint32 &t_diff)
     // update active cells around players and active objects
     resetMarkedCells();
 
+    // in parallel mode the cells are only collected here and updated by region afterwards
+    bool parallel = m_parallelCellUpdate && sMapMgr->GetMapUpdater()->activated();
+    std::vector<uint32> activeCells;
+
     Trinity::ObjectUpdater updater(t_diff);
     // for creature
     TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
@@ -599,6 +671,13 @@ void Map::Update(const uint32 &t_diff)
                     markCell(cell_id);
                     CellPair pair(x, y);
                     Cell cell(pair);
+                    if (parallel)
+                    {
+                        // grids are loaded before the regions start, never from inside one
+                        EnsureGridLoaded(cell);
+                        activeCells.push_back(cell_id);
+                        continue;
+                    }
                     cell.data.Part.reserved = CENTER_DISTRICT;
                     //cell.SetNoCreate();
                     cell.Visit(pair, grid_object_update,  *this);
@@ -645,6 +724,12 @@ void Map::Update(const uint32 &t_diff)
                 markCell(cell_id);
                 CellPair pair(x, y);
                 Cell cell(pair);
+                if (parallel)
+                {
+                    if (loaded(GridPair(cell.GridX(), cell.GridY())))
+                        activeCells.push_back(cell_id);
+                    continue;
+                }
                 cell.data.Part.reserved = CENTER_DISTRICT;
                 cell.SetNoCreate();
                 cell.Visit(pair, grid_object_update, *this);
@@ -653,6 +738,9 @@ void Map::Update(const uint32 &t_diff)
         }
     }
 
+    if (parallel)
+        UpdateCellRegions(activeCells, t_diff);
+
     // Process necessary scripts
     if (!m_scriptSchedule.empty())
     {
@@ -667,6 +755,203 @@ void Map::Update(const uint32 &t_diff)
         ProcessRelocationNotifies(t_diff);
 }
 
+// the region the current map thread is updating
+struct MapCellRegionContext
+{
+    MapCellRegionContext() : map(NULL), region(0) {}
+
+    Map const* map;
+    uint32 region;
+};
+
+static ACE_TSS<MapCellRegionContext> s_cellRegion;
+
+class MapCellRegionUpdateRequest : public ACE_Method_Request
+{
+    public:
+        MapCellRegionUpdateRequest(Map& map, uint32 diff, uint32 region) : m_map(map), m_diff(diff), m_region(region) {}
+
+        virtual int call()
+        {
+            s_cellRegion->map = &m_map;
+            s_cellRegion->region = m_region;
+
+            Trinity::ObjectUpdater updater(m_diff);
+            TypeContainerVisitor<Trinity::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
+            TypeContainerVisitor<Trinity::ObjectUpdater, WorldTypeMapContainer > world_object_update(updater);
+
+            for (std::vector<uint32>::const_iterator itr = m_cells.begin(); itr != m_cells.end(); ++itr)
+            {
+                CellPair pair(*itr % TOTAL_NUMBER_OF_CELLS_PER_MAP, *itr / TOTAL_NUMBER_OF_CELLS_PER_MAP);
+                Cell cell(pair);
+                cell.data.Part.reserved = CENTER_DISTRICT;
+                cell.SetNoCreate();
+                cell.Visit(pair, grid_object_update,  m_map);
+                cell.Visit(pair, world_object_update, m_map);
+            }
+
+            s_cellRegion->map = NULL;
+            return 0;
+        }
+
+        std::vector<uint32> m_cells;
+
+    private:
+        Map& m_map;
+        uint32 m_diff;
+        uint32 m_region;
+};
+
+static uint32 FindCellRegion(std::vector<uint32>& parents, uint32 block)
+{
+    while (parents[block] != block)
+        block = parents[block] = parents[parents[block]];
+    return block;
+}
+
+void Map::UpdateCellRegions(std::vector<uint32> const& cells, const uint32 &t_diff)
+{
+    if (cells.empty())
+        return;
+
+    TRACE_SPAN("Map::UpdateCellRegions");
+
+    // Cells are bucketed into blocks twice the visibility range wide. Occupied
+    // blocks that touch are joined into one region, so objects of different
+    // regions are always further apart than anything can see, aggro or cast.
+    uint32 blockSize = 2 * uint32(ceil(GetVisibilityDistance() / SIZE_OF_GRID_CELL)) + 1;
+    uint32 blocksPerRow = (TOTAL_NUMBER_OF_CELLS_PER_MAP + blockSize - 1) / blockSize;
+    uint32 const noRegion = uint32(-1);
+
+    std::vector<uint32> parents(blocksPerRow * blocksPerRow, noRegion);
+    for (std::vector<uint32>::const_iterator itr = cells.begin(); itr != cells.end(); ++itr)
+    {
+        uint32 block = (*itr / TOTAL_NUMBER_OF_CELLS_PER_MAP / blockSize) * blocksPerRow + (*itr % TOTAL_NUMBER_OF_CELLS_PER_MAP / blockSize);
+        parents[block] = block;
+    }
+
+    for (uint32 by = 0; by < blocksPerRow; ++by)
+    {
+        for (uint32 bx = 0; bx < blocksPerRow; ++bx)
+        {
+            uint32 block = by * blocksPerRow + bx;
+            if (parents[block] == noRegion)
+                continue;
+
+            // right, lower left, lower and lower right neighbours, the others were joined already
+            int32 const offsets[4][2] = { {1, 0}, {-1, 1}, {0, 1}, {1, 1} };
+            for (uint8 i = 0; i < 4; ++i)
+            {
+                int32 nx = int32(bx) + offsets[i][0];
+                int32 ny = int32(by) + offsets[i][1];
+                if (nx < 0 || nx >= int32(blocksPerRow) || ny >= int32(blocksPerRow))
+                    continue;
+
+                uint32 neighbour = uint32(ny) * blocksPerRow + uint32(nx);
+                if (parents[neighbour] == noRegion)
+                    continue;
+
+                uint32 a = FindCellRegion(parents, block);
+                uint32 b = FindCellRegion(parents, neighbour);
+                if (a != b)
+                    parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    // kept for IsNextToOtherCellRegion while the regions run
+    m_cellRegionBlockSize = blockSize;
+    m_cellRegionBlocksPerRow = blocksPerRow;
+    m_cellRegionOfBlock.assign(parents.size(), noRegion);
+    for (uint32 block = 0; block < parents.size(); ++block)
+        if (parents[block] != noRegion)
+            m_cellRegionOfBlock[block] = FindCellRegion(parents, block);
+
+    // cells are handed out in ascending id order per region, so every region updates deterministically
+    std::vector<uint32> sortedCells(cells);
+    std::sort(sortedCells.begin(), sortedCells.end());
+
+    std::map<uint32, MapCellRegionUpdateRequest*> regions;
+    for (std::vector<uint32>::const_iterator itr = sortedCells.begin(); itr != sortedCells.end(); ++itr)
+    {
+        uint32 block = (*itr / TOTAL_NUMBER_OF_CELLS_PER_MAP / blockSize) * blocksPerRow + (*itr % TOTAL_NUMBER_OF_CELLS_PER_MAP / blockSize);
+        uint32 root = m_cellRegionOfBlock[block];
+
+        MapCellRegionUpdateRequest*& region = regions[root];
+        if (!region)
+            region = new MapCellRegionUpdateRequest(*this, t_diff, root);
+        region->m_cells.push_back(*itr);
+    }
+
+    std::vector<ACE_Method_Request*> chunks;
+    chunks.reserve(regions.size());
+    for (std::map<uint32, MapCellRegionUpdateRequest*>::const_iterator itr = regions.begin(); itr != regions.end(); ++itr)
+        chunks.push_back(itr->second);
+
+    // scripts started from inside a region are run in the merge phase below
+    bool scriptLock = i_scriptLock;
+    i_scriptLock = true;
+    m_cellRegionsRunning = true;
+    sMapMgr->GetMapUpdater()->execute_chunks(chunks);
+    m_cellRegionsRunning = false;
+    i_scriptLock = scriptLock;
+
+    for (std::vector<ACE_Method_Request*>::const_iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+        delete *itr;
+
+    // grid loads and adds the regions held back, in the order they were asked for
+    std::vector<Cell> gridLoads;
+    std::vector<WorldObject*> adds;
+    {
+        ACE_GUARD(ACE_Recursive_Thread_Mutex, deferredGuard, m_deferredLock);
+        gridLoads.swap(m_deferredGridLoads);
+        adds.swap(m_deferredAdds);
+    }
+
+    for (std::vector<Cell>::const_iterator itr = gridLoads.begin(); itr != gridLoads.end(); ++itr)
+        EnsureGridLoaded(*itr);
+
+    for (std::vector<WorldObject*>::const_iterator itr = adds.begin(); itr != adds.end(); ++itr)
+    {
+        switch ((*itr)->GetTypeId())
+        {
+            case TYPEID_UNIT:          Add((*itr)->ToCreature());        break;
+            case TYPEID_GAMEOBJECT:    Add((*itr)->ToGameObject());      break;
+            case TYPEID_DYNAMICOBJECT: Add((DynamicObject*)(*itr));      break;
+            case TYPEID_CORPSE:        Add((Corpse*)(*itr));             break;
+            default: break;
+        }
+    }
+}
+
+bool Map::IsNextToOtherCellRegion(CellPair const& p) const
+{
+    if (!m_cellRegionsRunning)
+        return false;
+
+    // threads outside the regions, like the map thread waiting on them, never own a cell
+    uint32 const noRegion = uint32(-1);
+    uint32 ownRegion = s_cellRegion->map == this ? s_cellRegion->region : noRegion;
+
+    // blocks are wider than anything can see, so only objects in the surrounding blocks can see the cell
+    int32 bx = int32(p.x_coord / m_cellRegionBlockSize);
+    int32 by = int32(p.y_coord / m_cellRegionBlockSize);
+    for (int32 ny = by - 1; ny <= by + 1; ++ny)
+    {
+        for (int32 nx = bx - 1; nx <= bx + 1; ++nx)
+        {
+            if (nx < 0 || ny < 0 || nx >= int32(m_cellRegionBlocksPerRow) || ny >= int32(m_cellRegionBlocksPerRow))
+                continue;
+
+            uint32 region = m_cellRegionOfBlock[uint32(ny) * m_cellRegionBlocksPerRow + uint32(nx)];
+            if (region != noRegion && region != ownRegion)
+                return true;
+        }
+    }
+
+    return false;
+}
+
 struct ResetNotifier
 {
     template<class T>inline void resetNotify(GridRefManager<T> &m)
@@ -681,6 +966,8 @@ struct ResetNotifier
 
 void Map::ProcessRelocationNotifies(const uint32 & diff)
 {
+    TRACE_SPAN("Map::ProcessRelocationNotifies");
+
     for (GridRefManager<NGridType>::iterator i = GridRefManager<NGridType>::begin(); i != GridRefManager<NGridType>::end(); ++i)
     {
         NGridType *grid = i->getSource();
@@ -850,6 +1137,8 @@ Map::PlayerRelocation(Player* player, float x, float y, float z, float orientati
         NGridType* newGrid = getNGrid(new_cell.GridX(), new_cell.GridY());
         AddToGrid(player, newGrid, new_cell);
     }
+    else
+        UpdatePositionIndex(player);
 
     player->UpdateObjectVisibility(false);
 }
@@ -880,6 +1169,7 @@ Map::CreatureRelocation(Creature* creature, float x, float y, float z, float ang
     else
     {
         creature->Relocate(x, y, z, ang);
+        UpdatePositionIndex(creature);
         creature->UpdateObjectVisibility(false);
     }
 
@@ -891,6 +1181,7 @@ void Map::AddCreatureToMoveList(Creature *c, float x, float y, float z, float an
     if (!c)
         return;
 
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     i_creaturesToMove[c] = CreatureMover(x, y, z, ang);
 }
 
@@ -913,6 +1204,7 @@ void Map::MoveAllCreaturesInMoveList()
         {
             // update pos
             c->Relocate(cm.x, cm.y, cm.z, cm.ang);
+            UpdatePositionIndex(c);
             //CreatureRelocationNotify(c, new_cell, new_cell.cellPair());
             c->UpdateObjectVisibility(false);
         }
@@ -1019,6 +1311,7 @@ bool Map::CreatureRespawnRelocation(Creature *c)
     if (CreatureCellRelocation(c, resp_cell))
     {
         c->Relocate(resp_x, resp_y, resp_z, resp_o);
+        UpdatePositionIndex(c);
         c->GetMotionMaster()->Initialize();                 // prevent possible problems with default move generators
         //CreatureRelocationNotify(c, resp_cell, resp_cell.cellPair());
         c->UpdateObjectVisibility(false);
@@ -1028,6 +1321,165 @@ bool Map::CreatureRespawnRelocation(Creature *c)
         return false;
 }
 
+struct CellPositionIndexPacker
+{
+    CellPositionIndex& i_index;
+    uint32 i_cellId;
+
+    CellPositionIndexPacker(CellPositionIndex& index, uint32 cellId) : i_index(index), i_cellId(cellId) {}
+
+    template<class T> void Pack(GridRefManager<T> &m, uint8 typeMask)
+    {
+        for (typename GridRefManager<T>::iterator iter = m.begin(); iter != m.end(); ++iter)
+        {
+            T* obj = iter->getSource();
+            obj->m_positionIndexCell = i_cellId;
+            obj->m_positionIndexSlot = i_index.Add(obj, typeMask);
+        }
+    }
+
+    void Visit(PlayerMapType &m) { Pack(m, CELL_INDEX_PLAYER); }
+    void Visit(CreatureMapType &m) { Pack(m, CELL_INDEX_CREATURE); }
+    void Visit(GameObjectMapType &m) { Pack(m, CELL_INDEX_GAMEOBJECT); }
+    void Visit(DynamicObjectMapType &m) { Pack(m, CELL_INDEX_DYNAMICOBJECT); }
+    void Visit(CorpseMapType &m) { Pack(m, CELL_INDEX_CORPSE); }
+};
+
+bool Map::HasPathfindingBudget() const
+{
+    uint32 budget = sWorld->getConfig(CONFIG_PATHFINDING_TICK_BUDGET);
+    return !budget || m_pathfindingTime.value() < long(budget);
+}
+
+bool Map::IsInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2)
+{
+    VMAP::IVMapManager* vMapManager = VMAP::VMapFactory::createOrGetVMapManager();
+    // recorded before the cache, so a replay sees every query the map is asked
+    vMapManager->recordLineOfSight(GetId(), x1, y1, z1, x2, y2, z2);
+    if (!sWorld->getConfig(CONFIG_LOS_CACHE_TIME))
+        return vMapManager->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2);
+
+    bool inLineOfSight;
+    if (m_losCache.Find(x1, y1, z1, x2, y2, z2, inLineOfSight))
+        return inLineOfSight;
+
+    inLineOfSight = vMapManager->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2);
+    m_losCache.Store(x1, y1, z1, x2, y2, z2, inLineOfSight);
+    return inLineOfSight;
+}
+
+void Map::PrefetchLineOfSight(WorldObject const* obj, std::list<Unit*> const& units)
+{
+    if (!sWorld->getConfig(CONFIG_LOS_CACHE_TIME))
+        return;
+
+    // same points as WorldObject::IsWithinLOSInMap called on each unit, skip what is already cached
+    std::vector<VMAP::LineOfSightRay> rays;
+    rays.reserve(units.size());
+    for (std::list<Unit*>::const_iterator itr = units.begin(); itr != units.end(); ++itr)
+    {
+        if (*itr == obj)
+            continue;
+
+        VMAP::LineOfSightRay ray;
+        ray.x1 = (*itr)->GetPositionX();
+        ray.y1 = (*itr)->GetPositionY();
+        ray.z1 = (*itr)->GetPositionZ() + 2.0f;
+        ray.x2 = obj->GetPositionX();
+        ray.y2 = obj->GetPositionY();
+        ray.z2 = obj->GetPositionZ() + 2.0f;
+        if (!m_losCache.IsCached(ray.x1, ray.y1, ray.z1, ray.x2, ray.y2, ray.z2))
+            rays.push_back(ray);
+    }
+
+    if (rays.size() < 2)
+        return;
+
+    VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), &rays[0], rays.size());
+    LineOfSightCache::CountBatchedRays(rays.size());
+
+    for (std::vector<VMAP::LineOfSightRay>::const_iterator itr = rays.begin(); itr != rays.end(); ++itr)
+        m_losCache.Store(itr->x1, itr->y1, itr->z1, itr->x2, itr->y2, itr->z2, itr->result);
+}
+
+void Map::FindInPositionIndex(Cell const& cell, bool noCreate, float x, float y, float radius, uint8 typeMask, CellPositionIndexResultList& result)
+{
+    if (!loaded(GridPair(cell.GridX(), cell.GridY())))
+    {
+        if (noCreate)
+            return;
+
+        EnsureGridLoaded(cell);
+    }
+
+    NGridType* grid = getNGrid(cell.GridX(), cell.GridY());
+    CellPositionIndex& index = grid->getPositionIndex(cell.CellX(), cell.CellY());
+
+    {
+        TRINITY_READ_GUARD(ACE_RW_Thread_Mutex, m_positionIndexLock);
+        if (index.IsValid())
+        {
+            index.FindInRange(x, y, radius, typeMask, result);
+            return;
+        }
+    }
+
+    TRINITY_WRITE_GUARD(ACE_RW_Thread_Mutex, m_positionIndexLock);
+    if (!index.IsValid())
+    {
+        CellPair pair = cell.cellPair();
+        CellPositionIndexPacker packer(index, pair.y_coord * TOTAL_NUMBER_OF_CELLS_PER_MAP + pair.x_coord);
+        TypeContainerVisitor<CellPositionIndexPacker, GridTypeMapContainer > grid_packer(packer);
+        TypeContainerVisitor<CellPositionIndexPacker, WorldTypeMapContainer > world_packer(packer);
+
+        index.Clear();
+        grid->Visit(cell.CellX(), cell.CellY(), grid_packer);
+        grid->Visit(cell.CellX(), cell.CellY(), world_packer);
+        index.SetValid();
+    }
+
+    index.FindInRange(x, y, radius, typeMask, result);
+}
+
+void Map::UpdatePositionIndex(WorldObject* obj)
+{
+    if (obj->m_positionIndexCell == CELL_POSITION_INDEX_NONE)
+        return;
+
+    Cell cell(CellPair(obj->m_positionIndexCell % TOTAL_NUMBER_OF_CELLS_PER_MAP, obj->m_positionIndexCell / TOTAL_NUMBER_OF_CELLS_PER_MAP));
+    NGridType* grid = getNGrid(cell.GridX(), cell.GridY());
+    if (!grid)
+        return;
+
+    CellPositionIndex& index = grid->getPositionIndex(cell.CellX(), cell.CellY());
+    TRINITY_WRITE_GUARD(ACE_RW_Thread_Mutex, m_positionIndexLock);
+    if (index.IsValid() && index.GetObject(obj->m_positionIndexSlot) == obj)
+        index.Relocate(obj->m_positionIndexSlot, obj->GetPositionX(), obj->GetPositionY());
+}
+
+void Map::InvalidatePositionIndex(WorldObject* obj)
+{
+    if (obj->m_positionIndexCell == CELL_POSITION_INDEX_NONE)
+        return;
+
+    Cell cell(CellPair(obj->m_positionIndexCell % TOTAL_NUMBER_OF_CELLS_PER_MAP, obj->m_positionIndexCell / TOTAL_NUMBER_OF_CELLS_PER_MAP));
+    obj->m_positionIndexCell = CELL_POSITION_INDEX_NONE;
+    NGridType* grid = getNGrid(cell.GridX(), cell.GridY());
+    if (!grid)
+        return;
+
+    CellPositionIndex& index = grid->getPositionIndex(cell.CellX(), cell.CellY());
+    TRINITY_WRITE_GUARD(ACE_RW_Thread_Mutex, m_positionIndexLock);
+    if (index.GetObject(obj->m_positionIndexSlot) == obj)
+        index.Invalidate();
+}
+
+void Map::InvalidatePositionIndex(NGridType* grid, Cell const& cell)
+{
+    TRINITY_WRITE_GUARD(ACE_RW_Thread_Mutex, m_positionIndexLock);
+    grid->getPositionIndex(cell.CellX(), cell.CellY()).Invalidate();
+}
+
 bool Map::UnloadGrid(const uint32 &x, const uint32 &y, bool unloadAll)
 {
     NGridType *grid = getNGrid(x, y);
@@ -1082,6 +1534,8 @@ bool Map::UnloadGrid(const uint32 &x, const uint32 &y, bool unloadAll)
             }
             VMAP::VMapFactory::createOrGetVMapManager()->unloadMap(GetId(), gx, gy);
             MMAP::MMapFactory::createOrGetMMapManager()->unloadMap(GetId(), gx, gy);
+            m_pathCache.Clear();
+            m_losCache.Clear();
         }
         else
             ((MapInstanced*)m_parentMap)->RemoveGridMapReference(GridPair(gx, gy));
@@ -1157,56 +1611,54 @@ bool GridMap::loadData(char *filename)
     // Unload old data if exist
     unloadData();
 
-    map_fileheader header;
     // Not return error if file not found
-    FILE *in = fopen(filename, "rb");
-    if (!in)
+    if (!m_file.Open(filename))
         return true;
 
-    if (fread(&header, sizeof(header), 1, in) != 1)
+    map_fileheader header;
+    if (!readFileHeader(0, header))
     {
-        fclose(in);
+        m_file.Close();
         return false;
     }
 
-    if (header.mapMagic == *((uint32 const*)(MAP_MAGIC)) && header.versionMagic == *((uint32 const*)(MAP_VERSION_MAGIC)))
+    if (header.mapMagic == *((uint32 const*)(MAP_MAGIC)) && (header.versionMagic == *((uint32 const*)(MAP_VERSION_MAGIC)) ||
+        header.versionMagic == *((uint32 const*)(MAP_VERSION_MAGIC_UNALIGNED))))
     {
         // loadup area data
-        if (header.areaMapOffset && !loadAreaData(in, header.areaMapOffset, header.areaMapSize))
+        if (header.areaMapOffset && !loadAreaData(header.areaMapOffset, header.areaMapSize))
         {
             sLog->outError("Error loading map area data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
         // loadup height data
-        if (header.heightMapOffset && !loadHeightData(in, header.heightMapOffset, header.heightMapSize))
+        if (header.heightMapOffset && !loadHeightData(header.heightMapOffset, header.heightMapSize))
         {
             sLog->outError("Error loading map height data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
         // loadup liquid data
-        if (header.liquidMapOffset && !loadLiquidData(in, header.liquidMapOffset, header.liquidMapSize))
+        if (header.liquidMapOffset && !loadLiquidData(header.liquidMapOffset, header.liquidMapSize))
         {
             sLog->outError("Error loading map liquids data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
-        fclose(in);
         return true;
     }
     sLog->outError("Map file '%s' is from an incompatible clientversion. Please recreate using the mapextractor.", filename);
-    fclose(in);
+    m_file.Close();
     return false;
 }
 
 void GridMap::unloadData()
 {
-    delete[] m_area_map;
-    delete[] m_V9;
-    delete[] m_V8;
-    delete[] m_liquid_type;
-    delete[] m_liquid_map;
+    for (std::vector<uint8*>::const_iterator itr = m_copies.begin(); itr != m_copies.end(); ++itr)
+        delete[] *itr;
+    m_copies.clear();
+    m_file.Close();
     m_area_map = NULL;
     m_V9 = NULL;
     m_V8 = NULL;
@@ -1215,13 +1667,34 @@ void GridMap::unloadData()
     m_gridGetHeight = &GridMap::getHeightFromFlat;
 }
 
-bool GridMap::loadAreaData(FILE *in, uint32 offset, uint32 /*size*/)
+template<class T> bool GridMap::readFileHeader(uint32 offset, T& header) const
 {
-    map_areaHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
+    // copied, the headers of older map files are not aligned
+    uint8 const* data = m_file.GetData(offset, sizeof(T));
+    if (!data)
+        return false;
+    memcpy(&header, data, sizeof(T));
+    return true;
+}
+
+template<class T> T const* GridMap::getFileArray(uint32 offset, uint32 count)
+{
+    uint8 const* data = m_file.GetData(offset, count * sizeof(T));
+    if (!data)
+        return NULL;
+    if (!(size_t(data) % sizeof(T)))
+        return (T const*)data;
 
-    if (header.fourcc != *((uint32 const*)(MAP_AREA_MAGIC)))
+    uint8* copy = new uint8[count * sizeof(T)];
+    memcpy(copy, data, count * sizeof(T));
+    m_copies.push_back(copy);
+    return (T const*)copy;
+}
+
+bool GridMap::loadAreaData(uint32 offset, uint32 /*size*/)
+{
+    map_areaHeader header;
+    if (!readFileHeader(offset, header) || header.fourcc != *((uint32 const*)(MAP_AREA_MAGIC)))
     {
         sLog->outError("Error reading header. offset: %u\n", offset);
         return false;
@@ -1230,51 +1703,46 @@ bool GridMap::loadAreaData(FILE *in, uint32 offset, uint32 /*size*/)
     m_gridArea = header.gridArea;
     if (!(header.flags & MAP_AREA_NO_AREA))
     {
-        m_area_map = new uint16 [16*16];
-        if (fread(m_area_map, sizeof(uint16), 16*16, in) != 16*16)
+        m_area_map = getFileArray<uint16>(offset + sizeof(header), 16*16);
+        if (!m_area_map)
             return false;
     }
     return true;
 }
 
-bool GridMap::loadHeightData(FILE *in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHeightData(uint32 offset, uint32 /*size*/)
 {
     map_heightHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
-
-    if (header.fourcc != *((uint32 const*)(MAP_HEIGHT_MAGIC)))
+    if (!readFileHeader(offset, header) || header.fourcc != *((uint32 const*)(MAP_HEIGHT_MAGIC)))
         return false;
 
+    offset += sizeof(header);
     m_gridHeight = header.gridHeight;
     if (!(header.flags & MAP_HEIGHT_NO_HEIGHT))
     {
         if ((header.flags & MAP_HEIGHT_AS_INT16))
         {
-            m_uint16_V9 = new uint16 [129*129];
-            m_uint16_V8 = new uint16 [128*128];
-            if (fread(m_uint16_V9, sizeof(uint16), 129*129, in) != 129*129 ||
-                fread(m_uint16_V8, sizeof(uint16), 128*128, in) != 128*128)
+            m_uint16_V9 = getFileArray<uint16>(offset, 129*129);
+            m_uint16_V8 = getFileArray<uint16>(offset + 129*129*sizeof(uint16), 128*128);
+            if (!m_uint16_V9 || !m_uint16_V8)
                 return false;
             m_gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
             m_gridGetHeight = &GridMap::getHeightFromUint16;
         }
         else if ((header.flags & MAP_HEIGHT_AS_INT8))
         {
-            m_uint8_V9 = new uint8 [129*129];
-            m_uint8_V8 = new uint8 [128*128];
-            if (fread(m_uint8_V9, sizeof(uint8), 129*129, in) != 129*129 ||
-                fread(m_uint8_V8, sizeof(uint8), 128*128, in) != 128*128)
+            m_uint8_V9 = getFileArray<uint8>(offset, 129*129);
+            m_uint8_V8 = getFileArray<uint8>(offset + 129*129*sizeof(uint8), 128*128);
+            if (!m_uint8_V9 || !m_uint8_V8)
                 return false;
             m_gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 255;
             m_gridGetHeight = &GridMap::getHeightFromUint8;
         }
         else
         {
-            m_V9 = new float [129*129];
-            m_V8 = new float [128*128];
-            if (fread(m_V9, sizeof(float), 129*129, in) != 129*129 ||
-                fread(m_V8, sizeof(float), 128*128, in) != 128*128)
+            m_V9 = getFileArray<float>(offset, 129*129);
+            m_V8 = getFileArray<float>(offset + 129*129*sizeof(float), 128*128);
+            if (!m_V9 || !m_V8)
                 return false;
             m_gridGetHeight = &GridMap::getHeightFromFloat;
         }
@@ -1284,15 +1752,13 @@ bool GridMap::loadHeightData(FILE *in, uint32 offset, uint32 /*size*/)
     return true;
 }
 
-bool  GridMap::loadLiquidData(FILE *in, uint32 offset, uint32 /*size*/)
+bool  GridMap::loadLiquidData(uint32 offset, uint32 /*size*/)
 {
     map_liquidHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
-
-    if (header.fourcc != *((uint32 const*)(MAP_LIQUID_MAGIC)))
+    if (!readFileHeader(offset, header) || header.fourcc != *((uint32 const*)(MAP_LIQUID_MAGIC)))
         return false;
 
+    offset += sizeof(header);
     m_liquidType   = header.liquidType;
     m_liquid_offX  = header.offsetX;
     m_liquid_offY  = header.offsetY;
@@ -1302,14 +1768,15 @@ bool  GridMap::loadLiquidData(FILE *in, uint32 offset, uint32 /*size*/)
 
     if (!(header.flags & MAP_LIQUID_NO_TYPE))
     {
-        m_liquid_type = new uint8 [16*16];
-        if (fread(m_liquid_type, sizeof(uint8), 16*16, in) != 16*16)
+        m_liquid_type = getFileArray<uint8>(offset, 16*16);
+        if (!m_liquid_type)
             return false;
+        offset += 16*16*sizeof(uint8);
     }
     if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
     {
-        m_liquid_map = new float [m_liquid_width*m_liquid_height];
-        if (fread(m_liquid_map, sizeof(float), m_liquid_width*m_liquid_height, in) != m_liquid_width*m_liquid_height)
+        m_liquid_map = getFileArray<float>(offset, m_liquid_width*m_liquid_height);
+        if (!m_liquid_map)
             return false;
     }
     return true;
@@ -1430,7 +1897,7 @@ float  GridMap::getHeightFromUint8(float x, float y) const
     y_int&=(MAP_RESOLUTION - 1);
 
     int32 a, b, c;
-    uint8 *V9_h1_ptr = &m_uint8_V9[x_int*128 + x_int + y_int];
+    uint8 const* V9_h1_ptr = &m_uint8_V9[x_int*128 + x_int + y_int];
     if (x+y < 1)
     {
         if (x > y)
@@ -1497,7 +1964,7 @@ float  GridMap::getHeightFromUint16(float x, float y) const
     y_int&=(MAP_RESOLUTION - 1);
 
     int32 a, b, c;
-    uint16 *V9_h1_ptr = &m_uint16_V9[x_int*128 + x_int + y_int];
+    uint16 const* V9_h1_ptr = &m_uint16_V9[x_int*128 + x_int + y_int];
     if (x+y < 1)
     {
         if (x > y)
@@ -1944,12 +2411,8 @@ void Map::UpdateObjectsVisibilityFor(Player* player, Cell cell, CellPair cellpai
 {
     Trinity::VisibleNotifier notifier(*player);
 
-    cell.data.Part.reserved = ALL_DISTRICT;
     cell.SetNoCreate();
-    TypeContainerVisitor<Trinity::VisibleNotifier, WorldTypeMapContainer > world_notifier(notifier);
-    TypeContainerVisitor<Trinity::VisibleNotifier, GridTypeMapContainer  > grid_notifier(notifier);
-    cell.Visit(cellpair, world_notifier, *this, *player, GetVisibilityDistance());
-    cell.Visit(cellpair, grid_notifier,  *this, *player, GetVisibilityDistance());
+    cell.VisitIndexed(cellpair, notifier, *this, *player, Trinity::VisibilityNotifyRange(GetVisibilityDistance()), CELL_INDEX_ALL);
 
     // send data
     notifier.SendToSelf();
@@ -2056,6 +2519,8 @@ inline void Map::setNGrid(NGridType *grid, uint32 x, uint32 y)
 
 void Map::DelayedUpdate(const uint32 t_diff)
 {
+    TRACE_SPAN("Map::DelayedUpdate");
+
     RemoveAllObjectsInRemoveList();
 
     // Don't unload grids if it's battleground, since we may have manually added GOs, creatures, those doesn't load from DB at grid re-load !
@@ -2079,6 +2544,7 @@ void Map::AddObjectToRemoveList(WorldObject *obj)
 
     obj->CleanupsBeforeDelete();                            // remove or simplify at least cross referenced links
 
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     i_objectsToRemove.insert(obj);
     //sLog->outDebug("Object (GUID: %u TypeId: %u) added to removing list.", obj->GetGUIDLow(), obj->GetTypeId());
 }
@@ -2087,6 +2553,7 @@ void Map::AddObjectToSwitchList(WorldObject *obj, bool on)
 {
     ASSERT(obj->GetMapId() == GetId() && obj->GetInstanceId() == GetInstanceId());
 
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     std::map<WorldObject*, bool>::iterator itr = i_objectsToSwitch.find(obj);
     if (itr == i_objectsToSwitch.end())
         i_objectsToSwitch.insert(itr, std::make_pair(obj, on));
@@ -2167,8 +2634,9 @@ uint32 Map::GetPlayersCountExceptGMs() const
 
 void Map::SendToPlayers(WorldPacket const* data) const
 {
+    WorldPacketPtr shared;
     for (MapRefManager::const_iterator itr = m_mapRefManager.begin(); itr != m_mapRefManager.end(); ++itr)
-        itr->getSource()->GetSession()->SendPacket(data);
+        itr->getSource()->GetSession()->SendPacket(data, &shared);
 }
 
 bool Map::ActiveObjectsNearGrid(uint32 x, uint32 y) const
@@ -2213,6 +2681,7 @@ bool Map::ActiveObjectsNearGrid(uint32 x, uint32 y) const
 
 void Map::AddToActive(Creature* c)
 {
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     AddToActiveHelper(c);
 
     // also not allow unloading spawn grid to prevent creating creature clone at load
@@ -2234,6 +2703,7 @@ void Map::AddToActive(Creature* c)
 
 void Map::RemoveFromActive(Creature* c)
 {
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     RemoveFromActiveHelper(c);
 
     // also allow unloading spawn grid
@@ -2601,7 +3071,7 @@ void InstanceMap::SetResetSchedule(bool on)
 /* ******* Battleground Instance Maps ******* */
 
 BattleGroundMap::BattleGroundMap(uint32 id, time_t expiry, uint32 InstanceId, Map* _parent)
-  : Map(id, expiry, InstanceId, DIFFICULTY_NORMAL, _parent)
+  : Map(id, expiry, InstanceId, DIFFICULTY_NORMAL, _parent), m_bg(NULL)
 {
     //lets initialize visibility distance for BG/Arenas
     BattleGroundMap::InitVisibilityDistance();
@@ -2609,6 +3079,21 @@ BattleGroundMap::BattleGroundMap(uint32 id, time_t expiry, uint32 InstanceId, Ma
 
 BattleGroundMap::~BattleGroundMap()
 {
+    if (m_bg)
+        m_bg->SetBgMap(NULL);
+}
+
+void BattleGroundMap::Update(const uint32& t_diff)
+{
+    Map::Update(t_diff);
+
+    // the battleground timers, scores and world states only touch this map, so they are
+    // driven from its map thread; the shared queues are guarded by the BattleGroundMgr lock
+    if (m_bg && !m_bg->IsSetForDelete())
+    {
+        TRACE_SPAN("BattleGround::Update");
+        m_bg->Update(t_diff);
+    }
 }
 
 void BattleGroundMap::InitVisibilityDistance()
@@ -30,12 +30,18 @@
 #include "SharedDefines.h"
 #include "GridRefManager.h"
 #include "MapRefManager.h"
+#include "PathCache.h"
+#include "LineOfSightCache.h"
+#include "MappedFile.h"
 
+#include <ace/Atomic_Op.h>
 #include <ace/RW_Thread_Mutex.h>
 #include <ace/Thread_Mutex.h>
+#include <ace/Recursive_Thread_Mutex.h>
 #include <bitset>
 #include <list>
 #include <set>
+#include <vector>
 #include "UnorderedSet.h"
 
 class Unit;
@@ -66,11 +72,14 @@ struct ScriptAction
 // Map file format defines
 //******************************************
 static char const* MAP_MAGIC         = "MAPS";
-static char const* MAP_VERSION_MAGIC = "w0.6";
+static char const* MAP_VERSION_MAGIC = "w0.7";           // sections aligned to MAP_SECTION_ALIGN
+static char const* MAP_VERSION_MAGIC_UNALIGNED = "w0.6"; // still loaded, misaligned arrays are copied
 static char const* MAP_AREA_MAGIC    = "AREA";
 static char const* MAP_HEIGHT_MAGIC  = "MHGT";
 static char const* MAP_LIQUID_MAGIC  = "MLIQ";
 
+#define MAP_SECTION_ALIGN     16
+
 struct map_fileheader
 {
     uint32 mapMagic;
@@ -153,19 +162,19 @@ class GridMap
     uint32  m_flags;
     // Area data
     uint16  m_gridArea;
-    uint16 *m_area_map;
+    uint16 const* m_area_map;
     // Height level data
     float   m_gridHeight;
     float   m_gridIntHeightMultiplier;
     union{
-        float  *m_V9;
-        uint16 *m_uint16_V9;
-        uint8  *m_uint8_V9;
+        float  const* m_V9;
+        uint16 const* m_uint16_V9;
+        uint8  const* m_uint8_V9;
     };
     union{
-        float  *m_V8;
-        uint16 *m_uint16_V8;
-        uint8  *m_uint8_V8;
+        float  const* m_V8;
+        uint16 const* m_uint16_V8;
+        uint8  const* m_uint8_V8;
     };
     // Liquid data
     uint16  m_liquidType;
@@ -174,12 +183,20 @@ class GridMap
     uint8   m_liquid_width;
     uint8   m_liquid_height;
     float   m_liquidLevel;
-    uint8  *m_liquid_type;
-    float  *m_liquid_map;
+    uint8  const* m_liquid_type;
+    float  const* m_liquid_map;
+
+    // the whole .map file, the arrays above point into it
+    MappedFile m_file;
+    // arrays of older map files that are not aligned in the file
+    std::vector<uint8*> m_copies;
+
+    bool  loadAreaData(uint32 offset, uint32 size);
+    bool  loadHeightData(uint32 offset, uint32 size);
+    bool  loadLiquidData(uint32 offset, uint32 size);
 
-    bool  loadAreaData(FILE *in, uint32 offset, uint32 size);
-    bool  loadHeightData(FILE *in, uint32 offset, uint32 size);
-    bool  loadLiquidData(FILE *in, uint32 offset, uint32 size);
+    template<class T> bool readFileHeader(uint32 offset, T& header) const;
+    template<class T> T const* getFileArray(uint32 offset, uint32 count);
 
     // Get height functions and pointers
     typedef float (GridMap::*pGetHeightPtr) (float x, float y) const;
@@ -276,6 +293,10 @@ class Map : public GridRefManager<NGridType>
 
         virtual void Update(const uint32&);
 
+        // smoothed wall time of the last updates in microseconds, used to order the map update queue
+        uint32 GetUpdateCost() const { return m_updateCost; }
+        void SetUpdateCost(uint32 cost) { m_updateCost = (m_updateCost * 3 + cost) / 4; }
+
         /*
         void MessageBroadcast(Player *, WorldPacket *, bool to_self);
         void MessageBroadcast(WorldObject *, WorldPacket *);
@@ -284,6 +305,20 @@ class Map : public GridRefManager<NGridType>
         */
 
         float GetVisibilityDistance() const { return m_VisibleDistance; }
+        // crowded map, visibility of units is limited by distance, count and bandwidth (see VisibleNotifier)
+        bool IsInterestManaged() const { return m_interestManaged; }
+
+        // poly paths recently searched by the units of this map (see PathInfo::BuildPolyPath)
+        PathCache& GetPathCache() { return m_pathCache; }
+        // false once the path searches of this update used up Pathfinding.TickBudget
+        bool HasPathfindingBudget() const;
+        void ChargePathfindingTime(uint32 us) { m_pathfindingTime += long(us); }
+
+        // vmap line of sight between two points, answered from the cache of recent checks if possible
+        bool IsInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2);
+        // checks the line of sight from all units to obj in one batch and caches the results, so the
+        // IsWithinLOSInMap checks of the single targets of an area spell are cache hits
+        void PrefetchLineOfSight(WorldObject const* obj, std::list<Unit*> const& units);
         //function for setting up visibility distance for maps on per-type/per-Id basis
         virtual void InitVisibilityDistance();
 
@@ -386,6 +421,14 @@ class Map : public GridRefManager<NGridType>
         void UpdateObjectsVisibilityFor(Player* player, Cell cell, CellPair cellpair);
 
         void resetMarkedCells() { marked_cells.reset(); }
+
+        // appends the objects of typeMask of a cell within radius of x, y, packing the cell position index on first use
+        // nothing is appended if the grid is not loaded and noCreate is set
+        void FindInPositionIndex(Cell const& cell, bool noCreate, float x, float y, float radius, uint8 typeMask, CellPositionIndexResultList& result);
+        // keep the cell position index in sync with object moves inside a cell and with grid changes
+        void UpdatePositionIndex(WorldObject* obj);
+        void InvalidatePositionIndex(WorldObject* obj);
+        void InvalidatePositionIndex(NGridType* grid, Cell const& cell);
         bool isCellMarked(uint32 pCellId) { return marked_cells.test(pCellId); }
         void markCell(uint32 pCellId) { marked_cells.set(pCellId); }
 
@@ -393,8 +436,17 @@ class Map : public GridRefManager<NGridType>
         uint32 GetPlayersCountExceptGMs() const;
         bool ActiveObjectsNearGrid(uint32 x, uint32 y) const;
 
-        void AddWorldObject(WorldObject *obj) { i_worldObjects.insert(obj); }
-        void RemoveWorldObject(WorldObject *obj) { i_worldObjects.erase(obj); }
+        void AddWorldObject(WorldObject *obj)
+        {
+            ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
+            i_worldObjects.insert(obj);
+        }
+
+        void RemoveWorldObject(WorldObject *obj)
+        {
+            ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
+            i_worldObjects.erase(obj);
+        }
 
         void SendToPlayers(WorldPacket const* data) const;
 
@@ -473,11 +525,40 @@ class Map : public GridRefManager<NGridType>
         void ScriptsProcess();
 
         void UpdateActiveCells(const float &x, const float &y, const uint32 &t_diff);
+
+        // splits the given active cells into independent regions and updates them on the map threads
+        void UpdateCellRegions(std::vector<uint32> const& cells, const uint32 &t_diff);
     protected:
         void SetUnloadReferenceLock(const GridPair &p, bool on) { getNGrid(p.x_coord, p.y_coord)->setUnloadReferenceLock(on); }
 
         ACE_Thread_Mutex Lock;
 
+        // guards the lists that collect cross-cell changes (creature moves, removals, active objects,
+        // scripts) while the regions of a parallel cell update run, they are applied after all regions are done
+        ACE_Recursive_Thread_Mutex m_deferredLock;
+        bool m_parallelCellUpdate;
+
+        // set while the regions of a parallel cell update run, the regions never load grids then and objects
+        // they add next to another region are held back, both are applied under m_deferredLock after the join
+        bool m_cellRegionsRunning;
+        uint32 m_cellRegionBlockSize;
+        uint32 m_cellRegionBlocksPerRow;
+        std::vector<uint32> m_cellRegionOfBlock;
+        std::vector<Cell> m_deferredGridLoads;
+        std::vector<WorldObject*> m_deferredAdds;
+
+        bool IsNextToOtherCellRegion(CellPair const& p) const;
+
+        // cell position indexes are read under the read lock, packed, relocated and invalidated under the write lock,
+        // so the regions of a parallel cell update never see an index another region is changing
+        ACE_RW_Thread_Mutex m_positionIndexLock;
+
+        bool m_interestManaged;
+
+        PathCache m_pathCache;
+        LineOfSightCache m_losCache;
+        ACE_Atomic_Op<ACE_Thread_Mutex, long> m_pathfindingTime;   // microseconds of path searches in this update
+
         MapEntry const* i_mapEntry;
         uint8 i_spawnMode;
         uint32 i_InstanceId;
@@ -488,6 +569,7 @@ class Map : public GridRefManager<NGridType>
         MapRefManager::iterator m_mapRefIter;
 
         int32 m_VisibilityNotifyPeriod;
+        uint32 m_updateCost;
 
         typedef UNORDERED_SET<WorldObject*> ActiveNonPlayers;
         ActiveNonPlayers m_activeNonPlayers;
@@ -536,12 +618,19 @@ class Map : public GridRefManager<NGridType>
         template<class T>
         void AddToActiveHelper(T* obj)
         {
+            InvalidatePositionIndex(obj);
+
+            ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
             m_activeNonPlayers.insert(obj);
         }
 
         template<class T>
         void RemoveFromActiveHelper(T* obj)
         {
+            InvalidatePositionIndex(obj);
+
+            ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
+
             // Map::Update for active object in proccess
             if (m_activeNonPlayersIter != m_activeNonPlayers.end())
             {
@@ -606,6 +695,8 @@ class BattleGroundMap : public Map
         void SetUnload();
         void RemoveAllPlayers();
 
+        void Update(const uint32&);
+
         virtual void InitVisibilityDistance();
         BattleGround* GetBG() { return m_bg; }
         void SetBG(BattleGround* bg) { m_bg = bg; }
@@ -21,6 +21,7 @@
 #include "MapInstanced.h"
 #include "ObjectMgr.h"
 #include "MapManager.h"
+#include "MapUpdater.h"
 #include "Battleground.h"
 #include "VMapFactory.h"
 #include "MoveMap.h"
@@ -67,6 +68,29 @@ void MapInstanced::Update(const uint32& t)
     }
 }
 
+void MapInstanced::ScheduleUpdate(MapUpdater& updater, const uint32 t)
+{
+    // the base map only holds the shared grid maps, it is cheap enough to keep
+    // it and the instance destruction on the scheduling thread
+    Map::Update(t);
+
+    // every instance is an update request of its own
+    InstancedMaps::iterator i = m_InstancedMaps.begin();
+
+    while (i != m_InstancedMaps.end())
+    {
+        if (i->second->CanUnload(t))
+        {
+            DestroyInstance(i);                             // iterator incremented
+        }
+        else
+        {
+            updater.schedule_update(*i->second, t);
+            ++i;
+        }
+    }
+}
+
 void MapInstanced::DelayedUpdate(const uint32 diff)
 {
     for (InstancedMaps::iterator i = m_InstancedMaps.begin(); i != m_InstancedMaps.end(); ++i)
@@ -24,6 +24,10 @@
 #include "Map.h"
 #include "InstanceSaveMgr.h"
 
+#include <ace/Recursive_Thread_Mutex.h>
+
+class MapUpdater;
+
 class MapInstanced : public Map
 {
     friend class MapManager;
@@ -35,6 +39,7 @@ class MapInstanced : public Map
 
         // functions overwrite Map versions
         void Update(const uint32&);
+        void ScheduleUpdate(MapUpdater& updater, const uint32 t);
         void DelayedUpdate(const uint32 diff);
         //void RelocationNotify();
         void UnloadAll();
@@ -46,17 +51,21 @@ class MapInstanced : public Map
 
         void AddGridMapReference(const GridPair &p)
         {
+            ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_gridMapReferenceLock);
             ++GridMapReference[p.x_coord][p.y_coord];
             SetUnloadReferenceLock(GridPair(63-p.x_coord, 63-p.y_coord), true);
         }
 
         void RemoveGridMapReference(const GridPair &p)
         {
+            ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_gridMapReferenceLock);
             --GridMapReference[p.x_coord][p.y_coord];
             if (!GridMapReference[p.x_coord][p.y_coord])
                 SetUnloadReferenceLock(GridPair(63-p.x_coord, 63-p.y_coord), false);
         }
 
+        ACE_Recursive_Thread_Mutex& GetGridMapReferenceLock() { return m_gridMapReferenceLock; }
+
         InstancedMaps &GetInstancedMaps() { return m_InstancedMaps; }
         virtual void InitVisibilityDistance();
 
@@ -74,6 +83,7 @@ class MapInstanced : public Map
         }
 
         uint16 GridMapReference[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];
+        ACE_Recursive_Thread_Mutex m_gridMapReferenceLock;
 };
 #endif
 
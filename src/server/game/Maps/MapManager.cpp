@@ -32,6 +32,7 @@
 #include "CellImpl.h"
 #include "Corpse.h"
 #include "ObjectMgr.h"
+#include "TickTracer.h"
 
 extern GridState* si_GridStates[];                          // debugging code, should be deleted some day
 
@@ -240,13 +241,17 @@ void MapManager::Update(uint32 diff)
     if (!i_timer.Passed())
         return;
 
+    TRACE_SPAN("MapManager::Update");
+
     MapMapType::iterator iter = i_maps.begin();
     for (; iter != i_maps.end(); ++iter)
     {
-        if (m_updater.activated())
-            m_updater.schedule_update(*iter->second, uint32(i_timer.GetCurrent()));
-        else
+        if (!m_updater.activated())
             iter->second->Update(uint32(i_timer.GetCurrent()));
+        else if (iter->second->Instanceable())
+            ((MapInstanced*)iter->second)->ScheduleUpdate(m_updater, uint32(i_timer.GetCurrent()));
+        else
+            m_updater.schedule_update(*iter->second, uint32(i_timer.GetCurrent()));
     }
     if (m_updater.activated())
         m_updater.wait();
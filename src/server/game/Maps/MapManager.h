@@ -55,6 +55,8 @@ class MapManager
         void Initialize(void);
         void Update(uint32);
 
+        MapUpdater* GetMapUpdater() { return &m_updater; }
+
         void SetGridCleanUpDelay(uint32 t)
         {
             if (t < MIN_GRID_DELAY)
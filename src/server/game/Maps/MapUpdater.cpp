@@ -19,41 +19,13 @@
  */
 
 #include "MapUpdater.h"
-#include "DelayExecutor.h"
 #include "Map.h"
 #include "DatabaseEnv.h"
 
 #include <ace/Guard_T.h>
-#include <ace/Method_Request.h>
+#include <ace/OS_NS_sys_time.h>
 
-//the reason this things are here is that i want to make
-//the netcode patch and the multithreaded maps independant
-//once they are merged 1 class should be used
-class WDBThreadStartReq1 : public ACE_Method_Request
-{
-    public:
-        WDBThreadStartReq1(){}
-        virtual int
-
-    call (void)
-    {
-        WorldDatabase.ThreadStart();
-        return 0;
-    }
-};
-
-class WDBThreadEndReq1 : public ACE_Method_Request
-{
-    public:
-        WDBThreadEndReq1(){}
-        virtual int
-
-    call (void)
-    {
-        WorldDatabase.ThreadEnd();
-        return 0;
-    }
-};
+#include <algorithm>
 
 class MapUpdateRequest : public ACE_Method_Request
 {
@@ -66,17 +38,33 @@ class MapUpdateRequest : public ACE_Method_Request
 
     call (void)
     {
+        ACE_Time_Value start = ACE_OS::gettimeofday();
         m_map.Update (m_diff);
+        ACE_UINT64 cost;
+        (ACE_OS::gettimeofday() - start).to_usec(cost);
+        m_map.SetUpdateCost(uint32(cost));
         m_updater.update_finished ();
         return 0;
     }
 };
 
+struct MapUpdateRequestCostGreater
+{
+    bool operator()(MapUpdateRequest const* a, MapUpdateRequest const* b) const
+    {
+        return a->m_map.GetUpdateCost() > b->m_map.GetUpdateCost();
+    }
+};
+
 MapUpdater::MapUpdater() :
 m_mutex(),
 m_condition(m_mutex),
-m_executor(),
-pedning_requests(0)
+m_work(m_mutex),
+pedning_requests(0),
+m_queued(0),
+m_nextWorker(0),
+m_activated(false),
+m_shutdown(false)
 {
     return;
 }
@@ -88,18 +76,49 @@ MapUpdater::~MapUpdater()
 
 int MapUpdater::activate(size_t num_threads)
 {
-    return this->m_executor.activate(static_cast<int> (num_threads), new WDBThreadStartReq1, new WDBThreadEndReq1);
+    if (m_activated || num_threads < 1)
+        return -1;
+
+    for (size_t i = 0; i < num_threads; ++i)
+        m_queues.push_back(new WorkerQueue());
+
+    m_shutdown = false;
+    m_nextWorker = 0;
+
+    if (ACE_Task_Base::activate(THR_NEW_LWP | THR_JOINABLE | THR_INHERIT_SCHED, static_cast<int>(num_threads)) == -1)
+        return -1;
+
+    m_activated = true;
+    return 0;
 }
 
 int MapUpdater::deactivate(void)
 {
+    if (!m_activated)
+        return -1;
+
     this->wait();
 
-    return this->m_executor.deactivate();
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
+        m_shutdown = true;
+        m_work.broadcast();
+    }
+
+    ACE_Task_Base::wait();
+    m_activated = false;
+
+    for (size_t i = 0; i < m_queues.size(); ++i)
+        delete m_queues[i];
+    m_queues.clear();
+
+    return 0;
 }
 
 int MapUpdater::wait()
 {
+    dispatch();
+
     ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
 
     while(this->pedning_requests > 0)
@@ -110,24 +129,204 @@ int MapUpdater::wait()
 
 int MapUpdater::schedule_update(Map& map, ACE_UINT32 diff)
 {
+    if (!m_activated)
+    {
+        ACE_DEBUG((LM_ERROR, ACE_TEXT("(%t) \n"), ACE_TEXT("Failed to schedule Map Update")));
+        return -1;
+    }
+
+    m_scheduled.push_back(new MapUpdateRequest(map, *this, diff));
+    return 0;
+}
+
+void MapUpdater::dispatch()
+{
+    if (m_scheduled.empty())
+        return;
+
+    // longest processing time first, always to the worker with the least projected load
+    std::stable_sort(m_scheduled.begin(), m_scheduled.end(), MapUpdateRequestCostGreater());
+
+    for (size_t i = 0; i < m_queues.size(); ++i)
+        m_queues[i]->load = 0;
+
+    for (std::vector<MapUpdateRequest*>::const_iterator itr = m_scheduled.begin(); itr != m_scheduled.end(); ++itr)
+    {
+        WorkerQueue* target = m_queues[0];
+        for (size_t i = 1; i < m_queues.size(); ++i)
+            if (m_queues[i]->load < target->load)
+                target = m_queues[i];
+
+        // maps that never ran yet still count, otherwise all of them pile up on one worker
+        target->load += std::max<uint32>((*itr)->m_map.GetUpdateCost(), 1);
+
+        ACE_GUARD(ACE_Thread_Mutex, guard, target->lock);
+        target->requests.push_back(*itr);
+    }
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, this->m_mutex);
+
+    this->pedning_requests += m_scheduled.size();
+    m_queued += m_scheduled.size();
+    m_scheduled.clear();
+
+    m_work.broadcast();
+}
+
+ACE_Method_Request* MapUpdater::next_request(size_t index)
+{
+    ACE_Method_Request* request = NULL;
+
+    // own queue from the front (most expensive first)
+    {
+        WorkerQueue* own = m_queues[index];
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, own->lock, NULL);
+        if (!own->requests.empty())
+        {
+            request = own->requests.front();
+            own->requests.pop_front();
+        }
+    }
+
+    // otherwise steal from the back of the other queues
+    for (size_t i = 1; !request && i < m_queues.size(); ++i)
+    {
+        WorkerQueue* victim = m_queues[(index + i) % m_queues.size()];
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, victim->lock, NULL);
+        if (!victim->requests.empty())
+        {
+            request = victim->requests.back();
+            victim->requests.pop_back();
+        }
+    }
+
+    if (request)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, request);
+        --m_queued;
+    }
+
+    return request;
+}
+
+bool MapUpdater::claim_chunk(ChunkGroup* group, size_t& index)
+{
+    if (group->next >= group->chunks.size())
+        return false;
+
+    index = group->next++;
+    return true;
+}
+
+void MapUpdater::run_chunk(ChunkGroup* group, size_t index)
+{
+    group->chunks[index]->call();
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, this->m_mutex);
+    if (++group->done == group->chunks.size())
+        this->m_condition.broadcast();
+}
+
+bool MapUpdater::help_chunks()
+{
+    ChunkGroup* group = NULL;
+    size_t index = 0;
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, false);
+
+        // claimed under the lock, the owner can not return before this chunk is reported done
+        for (std::list<ChunkGroup*>::const_iterator itr = m_chunkGroups.begin(); itr != m_chunkGroups.end() && !group; ++itr)
+            if (claim_chunk(*itr, index))
+                group = *itr;
+    }
+
+    if (!group)
+        return false;
+
+    run_chunk(group, index);
+    return true;
+}
+
+int MapUpdater::execute_chunks(std::vector<ACE_Method_Request*> const& chunks)
+{
+    if (!m_activated || chunks.size() < 2)
+    {
+        for (std::vector<ACE_Method_Request*>::const_iterator itr = chunks.begin(); itr != chunks.end(); ++itr)
+            (*itr)->call();
+        return 0;
+    }
+
+    ChunkGroup group(chunks);
+
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
+        m_chunkGroups.push_back(&group);
+        m_work.broadcast();
+    }
+
+    // the calling thread works on its own group until nothing is left to claim
+    for (;;)
+    {
+        size_t index;
+        {
+            ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
+            if (!claim_chunk(&group, index))
+                break;
+        }
+
+        run_chunk(&group, index);
+    }
+
     ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
 
-    ++this->pedning_requests;
+    m_chunkGroups.remove(&group);
+
+    while (group.done < group.chunks.size())
+        this->m_condition.wait();
 
-    if (this->m_executor.execute(new MapUpdateRequest(map, *this, diff)) == -1)
+    return 0;
+}
+
+int MapUpdater::svc()
+{
+    size_t index;
     {
-        ACE_DEBUG((LM_ERROR, ACE_TEXT("(%t) \n"), ACE_TEXT("Failed to schedule Map Update")));
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
+        index = m_nextWorker++;
+    }
 
-        --this->pedning_requests;
-        return -1;
+    WorldDatabase.ThreadStart();
+
+    for (;;)
+    {
+        // chunks first, they belong to a map update that is already running
+        if (help_chunks())
+            continue;
+
+        if (ACE_Method_Request* request = next_request(index))
+        {
+            request->call();
+            delete request;
+            continue;
+        }
+
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, this->m_mutex, -1);
+
+        while (!m_shutdown && !m_queued && m_chunkGroups.empty())
+            m_work.wait();
+
+        if (m_shutdown && !m_queued)
+            break;
     }
 
+    WorldDatabase.ThreadEnd();
+
     return 0;
 }
 
 bool MapUpdater::activated()
 {
-    return m_executor.activated();
+    return m_activated;
 }
 
 void MapUpdater::update_finished()
@@ -142,6 +341,6 @@ void MapUpdater::update_finished()
 
     --this->pedning_requests;
 
-    this->m_condition.broadcast();
+    if (this->pedning_requests == 0)
+        this->m_condition.broadcast();
 }
-
@@ -21,14 +21,33 @@
 #ifndef _MAP_UPDATER_H_INCLUDED
 #define _MAP_UPDATER_H_INCLUDED
 
+#include <ace/Task.h>
 #include <ace/Thread_Mutex.h>
 #include <ace/Condition_Thread_Mutex.h>
+#include <ace/Method_Request.h>
 
-#include "DelayExecutor.h"
+#include <deque>
+#include <list>
+#include <vector>
+
+#include "Define.h"
 
 class Map;
+class MapUpdateRequest;
 
-class MapUpdater
+/*
+ * Work-stealing map update scheduler.
+ *
+ * schedule_update() only collects the maps of the current tick, wait() hands
+ * them out to the workers ordered by their measured cost (longest first, each
+ * to the least loaded worker) and blocks until all of them are done. A worker
+ * whose own queue runs dry steals from the tail of the other queues, so one
+ * busy continent does not leave the other threads idle.
+ *
+ * A map can also split its own update into chunks with execute_chunks(), idle
+ * workers then pick up chunks of that map while the calling thread helps.
+ */
+class MapUpdater : protected ACE_Task_Base
 {
     public:
         MapUpdater();
@@ -45,13 +64,50 @@ class MapUpdater
         int deactivate(void);
 
         bool activated();
+
+        // runs all chunks (owned by the caller) in parallel and returns when every chunk is done
+        int execute_chunks(std::vector<ACE_Method_Request*> const& chunks);
+
+        virtual int svc();
+
     private:
+        struct WorkerQueue
+        {
+            WorkerQueue() : load(0) {}
+
+            ACE_Thread_Mutex lock;
+            std::deque<ACE_Method_Request*> requests;
+            uint64 load;                                    // projected cost, only used while dispatching
+        };
+
+        struct ChunkGroup
+        {
+            ChunkGroup(std::vector<ACE_Method_Request*> const& c) : chunks(c), next(0), done(0) {}
+
+            std::vector<ACE_Method_Request*> const& chunks;
+            size_t next;
+            size_t done;
+        };
+
+        void dispatch();
+        ACE_Method_Request* next_request(size_t index);
+        bool claim_chunk(ChunkGroup* group, size_t& index);   // m_mutex must be held
+        void run_chunk(ChunkGroup* group, size_t index);
+        bool help_chunks();
         void update_finished();
 
-        DelayExecutor m_executor;
-        ACE_Condition_Thread_Mutex m_condition;
+        std::vector<WorkerQueue*> m_queues;
+        std::vector<MapUpdateRequest*> m_scheduled;         // collected by schedule_update, dispatched by wait
+        std::list<ChunkGroup*> m_chunkGroups;
+
         ACE_Thread_Mutex m_mutex;
+        ACE_Condition_Thread_Mutex m_condition;             // signaled when pedning_requests reaches 0 or a chunk group is done
+        ACE_Condition_Thread_Mutex m_work;                  // signaled when new requests or chunks are available
         size_t pedning_requests;
+        size_t m_queued;                                    // dispatched but not yet picked up by a worker
+        size_t m_nextWorker;
+        bool m_activated;
+        bool m_shutdown;
 };
 #endif //_MAP_UPDATER_H_INCLUDED
 
@@ -198,7 +198,7 @@ bool TargetedMovementGenerator<T>::_setTargetLocation(T &owner)
 
         bool newPathCalculated = true;
         if (!i_path)
-            i_path = new PathInfo(&owner, x, y, z, forceDest);
+            i_path = new PathInfo(&owner, x, y, z, forceDest, true);
         else
         newPathCalculated = i_path->Update(x, y, z, forceDest);
 
@@ -209,7 +209,7 @@ bool TargetedMovementGenerator<T>::_setTargetLocation(T &owner)
             newPathCalculated = true;
 
             if (!i_path)
-            i_path = new PathInfo(&owner, x, y, z, forceDest);
+            i_path = new PathInfo(&owner, x, y, z, forceDest, true);
             else
             newPathCalculated = i_path->Update(x, y, z, forceDest);
         }
@@ -376,7 +376,10 @@ bool TargetedMovementGenerator<T>::Update(T &owner, const uint32 & time_diff)
             }
 
             // target moved
-            if (!i_path || targetMoved || needNewDest || forceRecalc)
+            // the map was out of pathfinding budget, the path is searched now
+            bool deferred = i_path && (i_path->getPathType() & PATHFIND_DEFERRED);
+
+            if (!i_path || targetMoved || needNewDest || forceRecalc || deferred)
             {
                 // (re)calculate path
                 _setTargetLocation(owner);
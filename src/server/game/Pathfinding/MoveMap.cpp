@@ -154,10 +154,12 @@ namespace MMAP
         char *fileName = new char[pathLen];
         snprintf(fileName, pathLen, (sWorld->GetDataPath()+"mmaps/%03i%02i%02i.mmtile").c_str(), mapId, x, y);
 
-        FILE *file = fopen(fileName, "rb");
-        if (!file)
+        // private copy on write mapping, detour links the polygons in place and only those pages get copied
+        MappedFile* file = new MappedFile();
+        if (!file->Open(fileName, true))
         {
             sLog->outDebug("MMAP:loadMap: Could not open mmtile file '%s'", fileName);
+            delete file;
             delete [] fileName;
             return false;
         }
@@ -165,11 +167,14 @@ namespace MMAP
 
         // read header
         MmapTileHeader fileHeader;
-        fread(&fileHeader, sizeof(MmapTileHeader), 1, file);
+        uint8 const* headerData = file->GetData(0, sizeof(MmapTileHeader));
+        if (headerData)
+            memcpy(&fileHeader, headerData, sizeof(MmapTileHeader));
 
-        if (fileHeader.mmapMagic != MMAP_MAGIC)
+        if (!headerData || fileHeader.mmapMagic != MMAP_MAGIC)
         {
             sLog->outError("MMAP:loadMap: Bad header in mmap %03u%02i%02i.mmtile", mapId, x, y);
+            delete file;
             return false;
         }
 
@@ -177,29 +182,27 @@ namespace MMAP
         {
             sLog->outError("MMAP:loadMap: %03u%02i%02i.mmtile was built with generator v%i, expected v%i",
                                                 mapId, x, y, fileHeader.mmapVersion, MMAP_VERSION);
+            delete file;
             return false;
         }
 
-        unsigned char* data = (unsigned char*)dtAlloc(fileHeader.size, DT_ALLOC_PERM);
-        ASSERT(data);
-
-        size_t result = fread(data, fileHeader.size, 1, file);
-        if(!result)
+        // detour needs the tile data 4 byte aligned, the header keeps it so
+        unsigned char* data = file->GetWritableData() + sizeof(MmapTileHeader);
+        if (!file->GetData(sizeof(MmapTileHeader), fileHeader.size) || (size_t(data) % 4))
         {
             sLog->outError("MMAP:loadMap: Bad header or data in mmap %03u%02i%02i.mmtile", mapId, x, y);
-            fclose(file);
+            delete file;
             return false;
         }
 
-        fclose(file);
-
         dtMeshHeader* header = (dtMeshHeader*)data;
         dtTileRef tileRef = 0;
 
-        // memory allocated for data is now managed by detour, and will be deallocated when the tile is removed
-        if(DT_SUCCESS == mmap->navMesh->addTile(data, fileHeader.size, DT_TILE_FREE_DATA, 0, &tileRef))
+        // the tile data stays owned by the mapped file, it is released after the tile is removed
+        if(DT_SUCCESS == mmap->navMesh->addTile(data, fileHeader.size, 0, 0, &tileRef))
         {
             mmap->mmapLoadedTiles.insert(std::pair<uint32, dtTileRef>(packedGridPos, tileRef));
+            mmap->mmapTileFiles.insert(std::pair<uint32, MappedFile*>(packedGridPos, file));
             ++loadedTiles;
             sLog->outDetail("MMAP:loadMap: Loaded mmtile %03i[%02i,%02i] into %03i[%02i,%02i]", mapId, x, y, mapId, header->x, header->y);
             return true;
@@ -207,7 +210,7 @@ namespace MMAP
         else
         {
             sLog->outError("MMAP:loadMap: Could not load %03u%02i%02i.mmtile into navmesh", mapId, x, y);
-            dtFree(data);
+            delete file;
             return false;
         }
 
@@ -249,6 +252,12 @@ namespace MMAP
         else
         {
             mmap->mmapLoadedTiles.erase(packedGridPos);
+            MMapTileFileSet::iterator file = mmap->mmapTileFiles.find(packedGridPos);
+            if (file != mmap->mmapTileFiles.end())
+            {
+                delete file->second;
+                mmap->mmapTileFiles.erase(file);
+            }
             --loadedTiles;
             sLog->outDetail("MMAP:unloadMap: Unloaded mmtile %03i[%02i,%02i] from %03i", mapId, x, y, mapId);
             return true;
@@ -288,32 +297,6 @@ namespace MMAP
         return true;
     }
 
-    bool MMapManager::unloadMapInstance(uint32 mapId, uint32 instanceId)
-    {
-        // check if we have this map loaded
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
-        {
-            // file may not exist, therefore not loaded
-            sLog->outDebug("MMAP:unloadMapInstance: Asked to unload not loaded navmesh map %03u", mapId);
-            return false;
-        }
-
-        MMapData* mmap = loadedMMaps[mapId];
-        if (mmap->navMeshQueries.find(instanceId) == mmap->navMeshQueries.end())
-        {
-            sLog->outDebug("MMAP:unloadMapInstance: Asked to unload not loaded dtNavMeshQuery mapId %03u instanceId %u", mapId, instanceId);
-            return false;
-        }
-
-        dtNavMeshQuery* query = mmap->navMeshQueries[instanceId];
-
-        dtFreeNavMeshQuery(query);
-        mmap->navMeshQueries.erase(instanceId);
-        sLog->outDetail("MMAP:unloadMapInstance: Unloaded mapId %03u instanceId %u", mapId, instanceId);
-
-        return true;
-    }
-
     dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
     {
         if (loadedMMaps.find(mapId) == loadedMMaps.end())
@@ -322,28 +305,50 @@ namespace MMAP
         return loadedMMaps[mapId]->navMesh;
     }
 
-    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId, uint32 instanceId)
+    dtNavMeshQuery* MMapManager::AcquireNavMeshQuery(uint32 mapId)
     {
-        if (loadedMMaps.find(mapId) == loadedMMaps.end())
+        MMapDataSet::const_iterator itr = loadedMMaps.find(mapId);
+        if (itr == loadedMMaps.end())
             return NULL;
 
-        MMapData* mmap = loadedMMaps[mapId];
-        if (mmap->navMeshQueries.find(instanceId) == mmap->navMeshQueries.end())
+        MMapData* mmap = itr->second;
         {
-             // allocate mesh query
-            dtNavMeshQuery* query = dtAllocNavMeshQuery();
-            ASSERT(query);
-            if(DT_SUCCESS != query->init(mmap->navMesh, 1024))
+            ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, mmap->queryLock, NULL);
+            if (!mmap->navMeshQueries.empty())
             {
-                dtFreeNavMeshQuery(query);
-                sLog->outError("MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u instanceId %u", mapId, instanceId);
-                return NULL;
+                dtNavMeshQuery* query = mmap->navMeshQueries.back();
+                mmap->navMeshQueries.pop_back();
+                return query;
             }
+        }
 
-            sLog->outDetail("MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId %03u instanceId %u", mapId, instanceId);
-            mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(instanceId, query));
+        // all pooled queries are in use, allocate mesh query
+        dtNavMeshQuery* query = dtAllocNavMeshQuery();
+        ASSERT(query);
+        if (DT_SUCCESS != query->init(mmap->navMesh, 1024))
+        {
+            dtFreeNavMeshQuery(query);
+            sLog->outError("MMAP:AcquireNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u", mapId);
+            return NULL;
+        }
+
+        sLog->outDetail("MMAP:AcquireNavMeshQuery: created dtNavMeshQuery for mapId %03u", mapId);
+        return query;
+    }
+
+    void MMapManager::ReleaseNavMeshQuery(uint32 mapId, dtNavMeshQuery* query)
+    {
+        if (!query)
+            return;
+
+        MMapDataSet::const_iterator itr = loadedMMaps.find(mapId);
+        if (itr == loadedMMaps.end())
+        {
+            dtFreeNavMeshQuery(query);
+            return;
         }
 
-        return mmap->navMeshQueries[instanceId];
+        ACE_GUARD(ACE_Thread_Mutex, guard, itr->second->queryLock);
+        itr->second->navMeshQueries.push_back(query);
     }
 }
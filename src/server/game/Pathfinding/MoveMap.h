@@ -20,6 +20,10 @@
 #define _MOVE_MAP_H
 
 #include "UnorderedMap.h"
+#include "MappedFile.h"
+
+#include <ace/Thread_Mutex.h>
+#include <vector>
 
 #include "DetourAlloc.h"
 #include "DetourNavMesh.h"
@@ -40,7 +44,8 @@ inline void dtCustomFree(void* ptr)
 namespace MMAP
 {
     typedef UNORDERED_MAP<uint32, dtTileRef> MMapTileSet;
-    typedef UNORDERED_MAP<uint32, dtNavMeshQuery*> NavMeshQuerySet;
+    typedef UNORDERED_MAP<uint32, MappedFile*> MMapTileFileSet;
+    typedef std::vector<dtNavMeshQuery*> NavMeshQueryPool;
 
     // dummy struct to hold map's mmap data
     struct MMapData
@@ -48,18 +53,25 @@ namespace MMAP
         MMapData(dtNavMesh* mesh) : navMesh(mesh) {}
         ~MMapData()
         {
-            for (NavMeshQuerySet::iterator i = navMeshQueries.begin(); i != navMeshQueries.end(); ++i)
-                dtFreeNavMeshQuery(i->second);
+            for (NavMeshQueryPool::iterator i = navMeshQueries.begin(); i != navMeshQueries.end(); ++i)
+                dtFreeNavMeshQuery(*i);
 
             if (navMesh)
                 dtFreeNavMesh(navMesh);
+
+            // detour does not free the tile data, it is used in place
+            for (MMapTileFileSet::iterator i = mmapTileFiles.begin(); i != mmapTileFiles.end(); ++i)
+                delete i->second;
         }
 
         dtNavMesh* navMesh;
 
-        // we have to use single dtNavMeshQuery for every instance, since those are not thread safe
-        NavMeshQuerySet navMeshQueries;     // instanceId to query
+        // dtNavMeshQuery is not thread safe, every path build takes one out of the pool and returns it
+        // so the map threads and the cell regions of one map never share a query
+        NavMeshQueryPool navMeshQueries;    // idle queries
+        ACE_Thread_Mutex queryLock;         // guards navMeshQueries
         MMapTileSet mmapLoadedTiles;        // maps [map grid coords] to [dtTile]
+        MMapTileFileSet mmapTileFiles;      // maps [map grid coords] to the mapped .mmtile holding the tile data
     };
 
 
@@ -76,10 +88,10 @@ namespace MMAP
             bool loadMap(uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId);
-            bool unloadMapInstance(uint32 mapId, uint32 instanceId);
 
-            // the returned [dtNavMeshQuery const*] is NOT threadsafe
-            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId, uint32 instanceId);
+            // the returned query is owned by the caller until it is given back with ReleaseNavMeshQuery
+            dtNavMeshQuery* AcquireNavMeshQuery(uint32 mapId);
+            void ReleaseNavMeshQuery(uint32 mapId, dtNavMeshQuery* query);
             dtNavMesh const* GetNavMesh(uint32 mapId);
 
             uint32 getLoadedTilesCount() const { return loadedTiles; }
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PathCache.h"
+#include "Timer.h"
+#include "World.h"
+
+#include <ace/Guard_T.h>
+#include <algorithm>
+
+uint32 PathCache::Find(dtPolyRef startPoly, dtPolyRef endPoly, uint16 includeFlags, uint16 excludeFlags,
+                       dtPolyRef* path, uint32 maxLength)
+{
+    ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, m_lock, 0);
+
+    EntryMap::iterator itr = m_entries.find(Key(startPoly, endPoly, includeFlags, excludeFlags));
+    if (itr == m_entries.end())
+        return 0;
+
+    Entry& entry = itr->second;
+    if (getMSTimeDiff(entry.storeTime, getMSTime()) > sWorld->getConfig(CONFIG_PATHFINDING_CACHE_TIME) ||
+        entry.polys.size() > maxLength)
+    {
+        Erase(itr);
+        return 0;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, entry.lruPos);
+    std::copy(entry.polys.begin(), entry.polys.end(), path);
+    return entry.polys.size();
+}
+
+void PathCache::Store(dtPolyRef startPoly, dtPolyRef endPoly, uint16 includeFlags, uint16 excludeFlags,
+                      dtPolyRef const* path, uint32 length)
+{
+    uint32 maxEntries = sWorld->getConfig(CONFIG_PATHFINDING_CACHE_SIZE);
+    if (!maxEntries || !length)
+        return;
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, m_lock);
+
+    Key key(startPoly, endPoly, includeFlags, excludeFlags);
+    EntryMap::iterator itr = m_entries.find(key);
+    if (itr == m_entries.end())
+    {
+        while (m_entries.size() >= maxEntries)
+            Erase(m_entries.find(m_lru.back()));
+
+        m_lru.push_front(key);
+        itr = m_entries.insert(EntryMap::value_type(key, Entry())).first;
+        itr->second.lruPos = m_lru.begin();
+    }
+    else
+        m_lru.splice(m_lru.begin(), m_lru, itr->second.lruPos);
+
+    itr->second.polys.assign(path, path + length);
+    itr->second.storeTime = getMSTime();
+}
+
+void PathCache::Clear()
+{
+    ACE_GUARD(ACE_Thread_Mutex, guard, m_lock);
+
+    m_entries.clear();
+    m_lru.clear();
+}
+
+void PathCache::Erase(EntryMap::iterator itr)
+{
+    m_lru.erase(itr->second.lruPos);
+    m_entries.erase(itr);
+}
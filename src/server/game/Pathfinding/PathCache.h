@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_PATHCACHE_H
+#define TRINITY_PATHCACHE_H
+
+#include "Define.h"
+#include "DetourNavMesh.h"
+
+#include <ace/Thread_Mutex.h>
+#include <list>
+#include <map>
+#include <vector>
+
+/*
+  Recently searched poly paths of one map, keyed by start poly, end poly and the
+  filter flags of the search. A pack of creatures chasing the same target starts
+  and ends on the same few polys, so most of their searches are answered from here
+  instead of running findPath again. Entries expire after Pathfinding.CacheTime and
+  the least recently used entry is dropped once Pathfinding.CacheSize is reached.
+  The map threads and the cell regions of a parallel update share the cache.
+*/
+class PathCache
+{
+    public:
+        PathCache() {}
+
+        // copies the cached path into path and returns its length, 0 if there is none
+        uint32 Find(dtPolyRef startPoly, dtPolyRef endPoly, uint16 includeFlags, uint16 excludeFlags,
+                    dtPolyRef* path, uint32 maxLength);
+        void Store(dtPolyRef startPoly, dtPolyRef endPoly, uint16 includeFlags, uint16 excludeFlags,
+                   dtPolyRef const* path, uint32 length);
+        void Clear();
+
+    private:
+        struct Key
+        {
+            Key(dtPolyRef start, dtPolyRef end, uint16 include, uint16 exclude)
+                : startPoly(start), endPoly(end), flags((uint32(include) << 16) | exclude) {}
+
+            bool operator<(Key const& other) const
+            {
+                if (startPoly != other.startPoly)
+                    return startPoly < other.startPoly;
+                if (endPoly != other.endPoly)
+                    return endPoly < other.endPoly;
+                return flags < other.flags;
+            }
+
+            dtPolyRef startPoly;
+            dtPolyRef endPoly;
+            uint32 flags;
+        };
+
+        typedef std::list<Key> KeyList;
+
+        struct Entry
+        {
+            std::vector<dtPolyRef> polys;
+            uint32 storeTime;
+            KeyList::iterator lruPos;
+        };
+
+        typedef std::map<Key, Entry> EntryMap;
+
+        void Erase(EntryMap::iterator itr);
+
+        EntryMap m_entries;
+        KeyList m_lru;                                      // most recently used first
+        ACE_Thread_Mutex m_lock;
+};
+#endif
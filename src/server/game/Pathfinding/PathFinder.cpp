@@ -26,9 +26,9 @@
 #include "DetourCommon.h"
 
 ////////////////// PathInfo //////////////////
-PathInfo::PathInfo(const Unit* owner, float destX, float destY, float destZ, bool forceDest) :
+PathInfo::PathInfo(const Unit* owner, float destX, float destY, float destZ, bool forceDest, bool deferrable) :
     m_polyLength(0), m_type(PATHFIND_BLANK),
-    m_forceDestination(forceDest), m_pointPathLimit(MAX_POINT_PATH_LENGTH),
+    m_forceDestination(forceDest), m_deferrable(deferrable), m_deferred(false), m_pointPathLimit(MAX_POINT_PATH_LENGTH),
     m_sourceUnit(owner), m_navMesh(NULL), m_navMeshQuery(NULL)
 {
     PathNode endPoint(destX, destY, destZ);
@@ -43,18 +43,14 @@ PathInfo::PathInfo(const Unit* owner, float destX, float destY, float destZ, boo
 
     uint32 mapId = m_sourceUnit->GetMapId();
     if (MMAP::MMapFactory::IsPathfindingEnabled())
-    {
-        MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
-        m_navMesh = mmap->GetNavMesh(mapId);
-        m_navMeshQuery = mmap->GetNavMeshQuery(mapId, m_sourceUnit->GetInstanceId());
-    }
+        m_navMesh = MMAP::MMapFactory::createOrGetMMapManager()->GetNavMesh(mapId);
 
     createFilter();
 
-    if (m_navMesh && m_navMeshQuery && HaveTile(endPoint) &&
+    if (m_navMesh && HaveTile(endPoint) &&
             !m_sourceUnit->hasUnitState(UNIT_STAT_IGNORE_PATHFINDING))
     {
-        BuildPolyPath(startPoint, endPoint);
+        BuildPath(startPoint, endPoint);
     }
     else
     {
@@ -86,7 +82,7 @@ bool PathInfo::Update(float destX, float destY, float destZ, bool forceDest)
 
     // make sure navMesh works - we can run on map w/o mmap
     // check if the start and end point have a .mmtile loaded (can we pass via not loaded tile on the way?)
-    if (!m_navMesh || !m_navMeshQuery || m_sourceUnit->hasUnitState(UNIT_STAT_IGNORE_PATHFINDING) ||
+    if (!m_navMesh || m_sourceUnit->hasUnitState(UNIT_STAT_IGNORE_PATHFINDING) ||
         !HaveTile(newStart) || !HaveTile(newDest))
     {
         BuildShortcut();
@@ -113,7 +109,7 @@ bool PathInfo::Update(float destX, float destY, float destZ, bool forceDest)
     else
     {
         // target moved, so we need to update the poly path
-        BuildPolyPath(newStart, newDest);
+        BuildPath(newStart, newDest);
         return true;
     }
 }
@@ -185,6 +181,78 @@ dtPolyRef PathInfo::getPolyByLocation(const float* point, float *distance) const
     return INVALID_POLYREF;
 }
 
+void PathInfo::BuildPath(const PathNode &startPos, const PathNode &endPos)
+{
+    // take a query out of the pool, the units of a map may build their paths in parallel
+    MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+    m_navMeshQuery = mmap->AcquireNavMeshQuery(m_sourceUnit->GetMapId());
+    if (!m_navMeshQuery)
+    {
+        BuildShortcut();
+        m_type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH);
+        return;
+    }
+
+    BuildPolyPath(startPos, endPos);
+
+    mmap->ReleaseNavMeshQuery(m_sourceUnit->GetMapId(), m_navMeshQuery);
+    m_navMeshQuery = NULL;
+}
+
+dtStatus PathInfo::FindPolyPath(dtPolyRef startPoly, dtPolyRef endPoly, const float* startPoint, const float* endPoint,
+                                dtPolyRef* path, uint32* pathSize, uint32 maxPathSize, bool cached)
+{
+    Map* map = m_sourceUnit->GetMap();
+    uint16 includeFlags = m_filter.getIncludeFlags();
+    uint16 excludeFlags = m_filter.getExcludeFlags();
+
+    if (cached)
+    {
+        // tiles may have been reloaded since the path was stored, all of its polys must still exist
+        *pathSize = map->GetPathCache().Find(startPoly, endPoly, includeFlags, excludeFlags, path, maxPathSize);
+        bool valid = *pathSize != 0;
+        for (uint32 i = 0; valid && i < *pathSize; ++i)
+            valid = m_navMesh->isValidPolyRef(path[i]);
+
+        if (valid)
+        {
+            m_deferred = false;
+            return DT_SUCCESS;
+        }
+
+        // the map is out of budget for this update, a search is never put off twice in a row
+        if (m_deferrable && !m_deferred && !map->HasPathfindingBudget())
+        {
+            *pathSize = 0;
+            m_deferred = true;
+            return DT_IN_PROGRESS;
+        }
+    }
+
+    m_deferred = false;
+
+    ACE_Time_Value start = ACE_OS::gettimeofday();
+
+    dtStatus dtResult = m_navMeshQuery->findPath(
+            startPoly,          // start polygon
+            endPoly,            // end polygon
+            startPoint,         // start position
+            endPoint,           // end position
+            &m_filter,          // polygon search filter
+            path,               // [out] path
+            (int*)pathSize,
+            maxPathSize);       // max number of polygons in output path
+
+    uint64 searchTime;
+    (ACE_OS::gettimeofday() - start).to_usec(searchTime);
+    map->ChargePathfindingTime(uint32(searchTime));
+
+    if (cached && *pathSize && dtResult == DT_SUCCESS)
+        map->GetPathCache().Store(startPoly, endPoly, includeFlags, excludeFlags, path, *pathSize);
+
+    return dtResult;
+}
+
 void PathInfo::BuildPolyPath(const PathNode &startPos, const PathNode &endPos)
 {
     // *** getting start/end poly logic ***
@@ -351,15 +419,9 @@ void PathInfo::BuildPolyPath(const PathNode &startPos, const PathNode &endPos)
 
         // generate suffix
         uint32 suffixPolyLength = 0;
-        dtStatus dtResult = m_navMeshQuery->findPath(
-                                suffixStartPoly,    // start polygon
-                                endPoly,            // end polygon
-                                suffixEndPoint,     // start position
-                                endPoint,           // end position
-                                &m_filter,            // polygon search filter
-                                m_pathPolyRefs + prefixPolyLength - 1,    // [out] path
-                                (int*)&suffixPolyLength,
-                                MAX_PATH_LENGTH-prefixPolyLength);   // max number of polygons in output path
+        dtStatus dtResult = FindPolyPath(suffixStartPoly, endPoly, suffixEndPoint, endPoint,
+                                m_pathPolyRefs + prefixPolyLength - 1, &suffixPolyLength,
+                                MAX_PATH_LENGTH-prefixPolyLength, false);
 
         if (!suffixPolyLength || dtResult != DT_SUCCESS)
         {
@@ -385,15 +447,16 @@ void PathInfo::BuildPolyPath(const PathNode &startPos, const PathNode &endPos)
         // free and invalidate old path data
         clear();
 
-        dtStatus dtResult = m_navMeshQuery->findPath(
-                startPoly,          // start polygon
-                endPoly,            // end polygon
-                startPoint,         // start position
-                endPoint,           // end position
-                &m_filter,           // polygon search filter
-                m_pathPolyRefs,     // [out] path
-                (int*)&m_polyLength,
-                MAX_PATH_LENGTH);   // max number of polygons in output path
+        dtStatus dtResult = FindPolyPath(startPoly, endPoly, startPoint, endPoint,
+                m_pathPolyRefs, &m_polyLength, MAX_PATH_LENGTH, true);
+
+        if (dtResult == DT_IN_PROGRESS)
+        {
+            // move straight at the target, the caller asks again on its next update
+            BuildShortcut();
+            m_type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH | PATHFIND_DEFERRED);
+            return;
+        }
 
         if (!m_polyLength || dtResult != DT_SUCCESS)
         {
@@ -45,13 +45,16 @@ enum PathType
     PATHFIND_SHORTCUT       = 0x0002,   // travel through obstacles, terrain, air, etc (old behavior)
     PATHFIND_INCOMPLETE     = 0x0004,   // we have partial path to follow - getting closer to target
     PATHFIND_NOPATH         = 0x0008,   // no valid path at all or error in generating one
-    PATHFIND_NOT_USING_PATH = 0x0010    // used when we are either flying/swiming or on map w/o mmaps
+    PATHFIND_NOT_USING_PATH = 0x0010,   // used when we are either flying/swiming or on map w/o mmaps
+    PATHFIND_DEFERRED       = 0x0020    // map ran out of pathfinding budget, shortcut until the next Update
 };
 
 class PathInfo
 {
     public:
-        PathInfo(Unit const* owner, float destX, float destY, float destZ, bool forceDest = false);
+        // deferrable paths may be built as shortcut (PATHFIND_DEFERRED) when the map is out of
+        // Pathfinding.TickBudget, the caller has to Update them again on its next update
+        PathInfo(Unit const* owner, float destX, float destY, float destZ, bool forceDest = false, bool deferrable = false);
         ~PathInfo();
 
         // Calculate the path from owner to given destination
@@ -88,6 +91,8 @@ class PathInfo
 
         bool            m_useStraightPath;  // type of path will be generated
         bool            m_forceDestination; // when set, we will always arrive at given point
+        bool            m_deferrable;       // path search may be put off to the next map update
+        bool            m_deferred;         // last path search was put off, do not put it off again
         uint32          m_pointPathLimit;   // limit point path size; min(this, MAX_POINT_PATH_LENGTH)
 
         PathNode        m_startPosition;    // {x, y, z} of current location
@@ -97,7 +102,7 @@ class PathInfo
 
         const Unit* const       m_sourceUnit;       // the unit that is moving
         const dtNavMesh*        m_navMesh;          // the nav mesh
-        const dtNavMeshQuery*   m_navMeshQuery;     // the nav mesh query used to find the path
+        dtNavMeshQuery*         m_navMeshQuery;     // pooled query, only held while the path is built
 
         dtQueryFilter m_filter;                     // use single filter for all movements, update it when needed
 
@@ -118,7 +123,10 @@ class PathInfo
         dtPolyRef getPolyByLocation(const float* point, float *distance) const;
         bool HaveTile(const PathNode &p) const;
 
+        void BuildPath(const PathNode &startPos, const PathNode &endPos);
         void BuildPolyPath(const PathNode &startPos, const PathNode &endPos);
+        dtStatus FindPolyPath(dtPolyRef startPoly, dtPolyRef endPoly, const float* startPoint, const float* endPoint,
+                              dtPolyRef* path, uint32* pathSize, uint32 maxPathSize, bool cached);
         void BuildPointPath(const float *startPoint, const float *endPoint);
         void BuildShortcut();
 
@@ -47,6 +47,7 @@ void Map::ScriptsStart(ScriptMapMap const& scripts, uint32 id, Object* source, O
     // Schedule script execution for all scripts in the script map
     ScriptMap const *s2 = &(s->second);
     bool immedScript = false;
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     for (ScriptMap::const_iterator iter = s2->begin(); iter != s2->end(); ++iter)
     {
         ScriptAction sa;
@@ -85,6 +86,8 @@ void Map::ScriptCommandStart(ScriptInfo const& script, uint32 delay, Object* sou
     sa.ownerGUID  = ownerGUID;
 
     sa.script = &script;
+
+    ACE_GUARD(ACE_Recursive_Thread_Mutex, guard, m_deferredLock);
     m_scriptSchedule.insert(std::pair<time_t, ScriptAction>(time_t(sWorld->GetGameTime() + delay), sa));
 
     sWorld->IncreaseScheduledScriptsCount();
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OpcodeStats.h"
+#include "Config.h"
+#include "Log.h"
+
+void OpcodeStatsEntry::Add(OpcodeStatsEntry const& other)
+{
+    count += other.count;
+    totalTime += other.totalTime;
+    maxTime = std::max(maxTime, other.maxTime);
+    bytes += other.bytes;
+    for (uint8 i = 0; i < OPCODE_LATENCY_BUCKETS; ++i)
+        latency[i] += other.latency[i];
+}
+
+uint64 OpcodeStatsEntry::GetPercentile(float fraction) const
+{
+    uint64 needed = uint64(ceil(double(count) * fraction));
+    uint64 seen = 0;
+    for (uint8 i = 0; i < OPCODE_LATENCY_BUCKETS; ++i)
+    {
+        seen += latency[i];
+        if (seen >= needed)
+            return std::min(uint64(1) << i, maxTime);
+    }
+
+    return maxTime;
+}
+
+OpcodeStatsSlot::OpcodeStatsSlot()
+{
+    memset(entries, 0, sizeof(entries));
+
+    OpcodeStats* stats = sOpcodeStats;
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, stats->i_lock);
+    stats->i_slots.insert(this);
+}
+
+OpcodeStatsSlot::~OpcodeStatsSlot()
+{
+    OpcodeStats* stats = sOpcodeStats;
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, stats->i_lock);
+    stats->i_slots.erase(this);
+    for (uint32 i = 0; i < NUM_MSG_TYPES; ++i)
+        stats->i_retired[i].Add(entries[i]);
+}
+
+OpcodeStats::OpcodeStats()
+{
+    memset(i_retired, 0, sizeof(i_retired));
+    memset(i_merged, 0, sizeof(i_merged));
+}
+
+void OpcodeStats::Record(uint16 opcode, uint64 time, uint32 bytes)
+{
+    if (opcode >= NUM_MSG_TYPES)
+        return;
+
+    OpcodeStatsEntry& entry = i_slot->entries[opcode];
+    ++entry.count;
+    entry.totalTime += time;
+    if (time > entry.maxTime)
+        entry.maxTime = time;
+    entry.bytes += bytes;
+
+    uint8 bucket = 0;
+    while (bucket < OPCODE_LATENCY_BUCKETS - 1 && (uint64(1) << bucket) <= time)
+        ++bucket;
+    ++entry.latency[bucket];
+}
+
+void OpcodeStats::Merge()
+{
+    ACE_GUARD(ACE_Thread_Mutex, guard, i_lock);
+
+    // the slots are read while their threads keep counting, the sums may be off by the calls in progress
+    memcpy(i_merged, i_retired, sizeof(i_merged));
+    for (std::set<OpcodeStatsSlot*>::const_iterator itr = i_slots.begin(); itr != i_slots.end(); ++itr)
+        for (uint32 i = 0; i < NUM_MSG_TYPES; ++i)
+            i_merged[i].Add((*itr)->entries[i]);
+}
+
+void OpcodeStats::WriteFile()
+{
+    std::string fileName = ConfigMgr::GetStringDefault("OpcodeStatsFile", "");
+    if (fileName.empty())
+        return;
+
+    std::string logsDir = ConfigMgr::GetStringDefault("LogsDir", "");
+    if (!logsDir.empty() && logsDir.at(logsDir.length()-1) != '/' && logsDir.at(logsDir.length()-1) != '\\')
+        logsDir.append("/");
+
+    FILE* file = fopen((logsDir + fileName).c_str(), "w");
+    if (!file)
+    {
+        sLog->outError("OpcodeStats: can't open %s for writing", (logsDir + fileName).c_str());
+        return;
+    }
+
+    fprintf(file, "opcode,name,count,total_us,avg_us,p99_us,max_us,bytes\n");
+    for (uint32 i = 0; i < NUM_MSG_TYPES; ++i)
+    {
+        OpcodeStatsEntry const& entry = i_merged[i];
+        if (!entry.count)
+            continue;
+
+        fprintf(file, "%u,%s," UI64FMTD "," UI64FMTD "," UI64FMTD "," UI64FMTD "," UI64FMTD "," UI64FMTD "\n",
+            i, LookupOpcodeName(i), entry.count, entry.totalTime, entry.totalTime / entry.count,
+            entry.GetPercentile(0.99f), entry.maxTime, entry.bytes);
+    }
+
+    fclose(file);
+}
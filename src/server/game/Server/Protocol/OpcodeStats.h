@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_OPCODESTATS_H
+#define TRINITY_OPCODESTATS_H
+
+#include "Common.h"
+#include "Opcodes.h"
+
+#include <ace/Singleton.h>
+#include <ace/TSS_T.h>
+
+// bucket i counts handler calls that took less than 2^i microseconds, the last one everything slower
+#define OPCODE_LATENCY_BUCKETS  24
+
+struct OpcodeStatsEntry
+{
+    uint64 count;
+    uint64 totalTime;                                       // microseconds
+    uint64 maxTime;
+    uint64 bytes;
+    uint32 latency[OPCODE_LATENCY_BUCKETS];
+
+    void Add(OpcodeStatsEntry const& other);
+    // upper bound of the bucket that holds the given fraction of the calls, in microseconds
+    uint64 GetPercentile(float fraction) const;
+};
+
+// counters of the handlers run by one thread, written only by that thread
+struct OpcodeStatsSlot
+{
+    OpcodeStatsSlot();
+    ~OpcodeStatsSlot();
+
+    OpcodeStatsEntry entries[NUM_MSG_TYPES];
+};
+
+/*
+  Always on counters of the opcode handlers run by WorldSession::ExecuteOpcode. Every
+  thread that runs handlers (world and map update threads) records into its own slot
+  without locking, Merge() sums the slots for .server opcodes and the periodic dump.
+*/
+class OpcodeStats
+{
+    friend class ACE_Singleton<OpcodeStats, ACE_Thread_Mutex>;
+    friend struct OpcodeStatsSlot;
+    OpcodeStats();
+
+    public:
+        void Record(uint16 opcode, uint64 time, uint32 bytes);
+
+        // sums all slots, call from the world thread
+        void Merge();
+        OpcodeStatsEntry const& GetMerged(uint16 opcode) const { return i_merged[opcode]; }
+
+        // writes the merged counters as csv to OpcodeStatsFile, if set
+        void WriteFile();
+
+    private:
+        ACE_TSS<OpcodeStatsSlot> i_slot;
+
+        ACE_Thread_Mutex i_lock;
+        std::set<OpcodeStatsSlot*> i_slots;
+        OpcodeStatsEntry i_retired[NUM_MSG_TYPES];          // slots of finished threads
+        OpcodeStatsEntry i_merged[NUM_MSG_TYPES];
+};
+
+#define sOpcodeStats ACE_Singleton<OpcodeStats, ACE_Thread_Mutex>::instance()
+#endif
@@ -110,17 +110,17 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x053*/ { "SMSG_PET_NAME_QUERY_RESPONSE",    STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x054*/ { "CMSG_GUILD_QUERY",                STATUS_AUTHED,   &WorldSession::HandleGuildQueryOpcode          },
     /*0x055*/ { "SMSG_GUILD_QUERY_RESPONSE",       STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x056*/ { "CMSG_ITEM_QUERY_SINGLE",          STATUS_LOGGEDIN, &WorldSession::HandleItemQuerySingleOpcode     },
+    /*0x056*/ { "CMSG_ITEM_QUERY_SINGLE",          STATUS_LOGGEDIN, &WorldSession::HandleItemQuerySingleOpcode, PROCESS_THREADSAFE },
     /*0x057*/ { "CMSG_ITEM_QUERY_MULTIPLE",        STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x058*/ { "SMSG_ITEM_QUERY_SINGLE_RESPONSE", STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x059*/ { "SMSG_ITEM_QUERY_MULTIPLE_RESPONSE", STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x05A*/ { "CMSG_PAGE_TEXT_QUERY",            STATUS_LOGGEDIN, &WorldSession::HandlePageQueryOpcode           },
+    /*0x05A*/ { "CMSG_PAGE_TEXT_QUERY",            STATUS_LOGGEDIN, &WorldSession::HandlePageQueryOpcode, PROCESS_THREADSAFE },
     /*0x05B*/ { "SMSG_PAGE_TEXT_QUERY_RESPONSE",   STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x05C*/ { "CMSG_QUEST_QUERY",                STATUS_LOGGEDIN, &WorldSession::HandleQuestQueryOpcode          },
+    /*0x05C*/ { "CMSG_QUEST_QUERY",                STATUS_LOGGEDIN, &WorldSession::HandleQuestQueryOpcode, PROCESS_THREADSAFE },
     /*0x05D*/ { "SMSG_QUEST_QUERY_RESPONSE",       STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x05E*/ { "CMSG_GAMEOBJECT_QUERY",           STATUS_LOGGEDIN, &WorldSession::HandleGameObjectQueryOpcode     },
+    /*0x05E*/ { "CMSG_GAMEOBJECT_QUERY",           STATUS_LOGGEDIN, &WorldSession::HandleGameObjectQueryOpcode, PROCESS_THREADSAFE },
     /*0x05F*/ { "SMSG_GAMEOBJECT_QUERY_RESPONSE",  STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x060*/ { "CMSG_CREATURE_QUERY",             STATUS_LOGGEDIN, &WorldSession::HandleCreatureQueryOpcode       },
+    /*0x060*/ { "CMSG_CREATURE_QUERY",             STATUS_LOGGEDIN, &WorldSession::HandleCreatureQueryOpcode, PROCESS_THREADSAFE },
     /*0x061*/ { "SMSG_CREATURE_QUERY_RESPONSE",    STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x062*/ { "CMSG_WHO",                        STATUS_LOGGEDIN, &WorldSession::HandleWhoOpcode                 },
     /*0x063*/ { "SMSG_WHO",                        STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -205,29 +205,29 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x0B2*/ { "CMSG_GAMEOBJ_CHAIR_USE_OBSOLETE", STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0B3*/ { "SMSG_GAMEOBJECT_CUSTOM_ANIM",     STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x0B4*/ { "CMSG_AREATRIGGER",                STATUS_LOGGEDIN, &WorldSession::HandleAreaTriggerOpcode         },
-    /*0x0B5*/ { "MSG_MOVE_START_FORWARD",          STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0B6*/ { "MSG_MOVE_START_BACKWARD",         STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0B7*/ { "MSG_MOVE_STOP",                   STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0B8*/ { "MSG_MOVE_START_STRAFE_LEFT",      STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0B9*/ { "MSG_MOVE_START_STRAFE_RIGHT",     STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0BA*/ { "MSG_MOVE_STOP_STRAFE",            STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0BB*/ { "MSG_MOVE_JUMP",                   STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0BC*/ { "MSG_MOVE_START_TURN_LEFT",        STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0BD*/ { "MSG_MOVE_START_TURN_RIGHT",       STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0BE*/ { "MSG_MOVE_STOP_TURN",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0BF*/ { "MSG_MOVE_START_PITCH_UP",         STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0C0*/ { "MSG_MOVE_START_PITCH_DOWN",       STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0C1*/ { "MSG_MOVE_STOP_PITCH",             STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0C2*/ { "MSG_MOVE_SET_RUN_MODE",           STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0C3*/ { "MSG_MOVE_SET_WALK_MODE",          STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x0B5*/ { "MSG_MOVE_START_FORWARD",          STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0B6*/ { "MSG_MOVE_START_BACKWARD",         STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0B7*/ { "MSG_MOVE_STOP",                   STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0B8*/ { "MSG_MOVE_START_STRAFE_LEFT",      STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0B9*/ { "MSG_MOVE_START_STRAFE_RIGHT",     STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0BA*/ { "MSG_MOVE_STOP_STRAFE",            STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0BB*/ { "MSG_MOVE_JUMP",                   STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0BC*/ { "MSG_MOVE_START_TURN_LEFT",        STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0BD*/ { "MSG_MOVE_START_TURN_RIGHT",       STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0BE*/ { "MSG_MOVE_STOP_TURN",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0BF*/ { "MSG_MOVE_START_PITCH_UP",         STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0C0*/ { "MSG_MOVE_START_PITCH_DOWN",       STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0C1*/ { "MSG_MOVE_STOP_PITCH",             STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0C2*/ { "MSG_MOVE_SET_RUN_MODE",           STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0C3*/ { "MSG_MOVE_SET_WALK_MODE",          STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x0C4*/ { "MSG_MOVE_TOGGLE_LOGGING",         STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0C5*/ { "MSG_MOVE_TELEPORT",               STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0C6*/ { "MSG_MOVE_TELEPORT_CHEAT",         STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x0C7*/ { "MSG_MOVE_TELEPORT_ACK",           STATUS_LOGGEDIN, &WorldSession::HandleMoveTeleportAck           },
+    /*0x0C7*/ { "MSG_MOVE_TELEPORT_ACK",           STATUS_LOGGEDIN, &WorldSession::HandleMoveTeleportAck, PROCESS_MAPLOCAL },
     /*0x0C8*/ { "MSG_MOVE_TOGGLE_FALL_LOGGING",    STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x0C9*/ { "MSG_MOVE_FALL_LAND",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0CA*/ { "MSG_MOVE_START_SWIM",             STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0CB*/ { "MSG_MOVE_STOP_SWIM",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x0C9*/ { "MSG_MOVE_FALL_LAND",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0CA*/ { "MSG_MOVE_START_SWIM",             STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0CB*/ { "MSG_MOVE_STOP_SWIM",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x0CC*/ { "MSG_MOVE_SET_RUN_SPEED_CHEAT",    STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0CD*/ { "MSG_MOVE_SET_RUN_SPEED",          STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0CE*/ { "MSG_MOVE_SET_RUN_BACK_SPEED_CHEAT", STATUS_NEVER,    &WorldSession::Handle_NULL                     },
@@ -242,8 +242,8 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x0D7*/ { "MSG_MOVE_SET_TURN_RATE_CHEAT",    STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0D8*/ { "MSG_MOVE_SET_TURN_RATE",          STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0D9*/ { "MSG_MOVE_TOGGLE_COLLISION_CHEAT", STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x0DA*/ { "MSG_MOVE_SET_FACING",             STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x0DB*/ { "MSG_MOVE_SET_PITCH",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x0DA*/ { "MSG_MOVE_SET_FACING",             STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x0DB*/ { "MSG_MOVE_SET_PITCH",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x0DC*/ { "MSG_MOVE_WORLDPORT_ACK",          STATUS_TRANSFER_PENDING, &WorldSession::HandleMoveWorldportAckOpcode},
     /*0x0DD*/ { "SMSG_MONSTER_MOVE",               STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x0DE*/ { "SMSG_MOVE_WATER_WALK",            STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -251,26 +251,26 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x0E0*/ { "MSG_MOVE_SET_RAW_POSITION_ACK",   STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0E1*/ { "CMSG_MOVE_SET_RAW_POSITION",      STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0E2*/ { "SMSG_FORCE_RUN_SPEED_CHANGE",     STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0E3*/ { "CMSG_FORCE_RUN_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck       },
+    /*0x0E3*/ { "CMSG_FORCE_RUN_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x0E4*/ { "SMSG_FORCE_RUN_BACK_SPEED_CHANGE", STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0E5*/ { "CMSG_FORCE_RUN_BACK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck     },
+    /*0x0E5*/ { "CMSG_FORCE_RUN_BACK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x0E6*/ { "SMSG_FORCE_SWIM_SPEED_CHANGE",    STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0E7*/ { "CMSG_FORCE_SWIM_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck       },
+    /*0x0E7*/ { "CMSG_FORCE_SWIM_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x0E8*/ { "SMSG_FORCE_MOVE_ROOT",            STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0E9*/ { "CMSG_FORCE_MOVE_ROOT_ACK",        STATUS_LOGGEDIN, &WorldSession::HandleMoveRootAck               },
+    /*0x0E9*/ { "CMSG_FORCE_MOVE_ROOT_ACK",        STATUS_LOGGEDIN, &WorldSession::HandleMoveRootAck, PROCESS_MAPLOCAL },
     /*0x0EA*/ { "SMSG_FORCE_MOVE_UNROOT",          STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0EB*/ { "CMSG_FORCE_MOVE_UNROOT_ACK",      STATUS_LOGGEDIN, &WorldSession::HandleMoveUnRootAck             },
+    /*0x0EB*/ { "CMSG_FORCE_MOVE_UNROOT_ACK",      STATUS_LOGGEDIN, &WorldSession::HandleMoveUnRootAck, PROCESS_MAPLOCAL },
     /*0x0EC*/ { "MSG_MOVE_ROOT",                   STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0ED*/ { "MSG_MOVE_UNROOT",                 STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x0EE*/ { "MSG_MOVE_HEARTBEAT",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x0EE*/ { "MSG_MOVE_HEARTBEAT",              STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x0EF*/ { "SMSG_MOVE_KNOCK_BACK",            STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0F0*/ { "CMSG_MOVE_KNOCK_BACK_ACK",        STATUS_LOGGEDIN, &WorldSession::HandleMoveKnockBackAck          },
+    /*0x0F0*/ { "CMSG_MOVE_KNOCK_BACK_ACK",        STATUS_LOGGEDIN, &WorldSession::HandleMoveKnockBackAck, PROCESS_MAPLOCAL },
     /*0x0F1*/ { "MSG_MOVE_KNOCK_BACK",             STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0F2*/ { "SMSG_MOVE_FEATHER_FALL",          STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x0F3*/ { "SMSG_MOVE_NORMAL_FALL",           STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x0F4*/ { "SMSG_MOVE_SET_HOVER",             STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x0F5*/ { "SMSG_MOVE_UNSET_HOVER",           STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x0F6*/ { "CMSG_MOVE_HOVER_ACK",             STATUS_LOGGEDIN, &WorldSession::HandleMoveHoverAck              },
+    /*0x0F6*/ { "CMSG_MOVE_HOVER_ACK",             STATUS_LOGGEDIN, &WorldSession::HandleMoveHoverAck, PROCESS_MAPLOCAL },
     /*0x0F7*/ { "MSG_MOVE_HOVER",                  STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0F8*/ { "CMSG_TRIGGER_CINEMATIC_CHEAT",    STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x0F9*/ { "CMSG_OPENING_CINEMATIC",          STATUS_NEVER,    &WorldSession::Handle_NULL                     },
@@ -281,10 +281,10 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x0FE*/ { "CMSG_TUTORIAL_FLAG",              STATUS_LOGGEDIN, &WorldSession::HandleTutorialFlag              },
     /*0x0FF*/ { "CMSG_TUTORIAL_CLEAR",             STATUS_LOGGEDIN, &WorldSession::HandleTutorialClear             },
     /*0x100*/ { "CMSG_TUTORIAL_RESET",             STATUS_LOGGEDIN, &WorldSession::HandleTutorialReset             },
-    /*0x101*/ { "CMSG_STANDSTATECHANGE",           STATUS_LOGGEDIN, &WorldSession::HandleStandStateChangeOpcode    },
-    /*0x102*/ { "CMSG_EMOTE",                      STATUS_LOGGEDIN, &WorldSession::HandleEmoteOpcode               },
+    /*0x101*/ { "CMSG_STANDSTATECHANGE",           STATUS_LOGGEDIN, &WorldSession::HandleStandStateChangeOpcode, PROCESS_MAPLOCAL },
+    /*0x102*/ { "CMSG_EMOTE",                      STATUS_LOGGEDIN, &WorldSession::HandleEmoteOpcode, PROCESS_MAPLOCAL },
     /*0x103*/ { "SMSG_EMOTE",                      STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x104*/ { "CMSG_TEXT_EMOTE",                 STATUS_LOGGEDIN, &WorldSession::HandleTextEmoteOpcode           },
+    /*0x104*/ { "CMSG_TEXT_EMOTE",                 STATUS_LOGGEDIN, &WorldSession::HandleTextEmoteOpcode, PROCESS_MAPLOCAL },
     /*0x105*/ { "SMSG_TEXT_EMOTE",                 STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x106*/ { "CMSG_AUTOEQUIP_GROUND_ITEM",      STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x107*/ { "CMSG_AUTOSTORE_GROUND_ITEM",      STATUS_NEVER,    &WorldSession::Handle_NULL                     },
@@ -326,27 +326,27 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x12B*/ { "SMSG_LEARNED_SPELL",              STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x12C*/ { "SMSG_SUPERCEDED_SPELL",           STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x12D*/ { "CMSG_NEW_SPELL_SLOT",             STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x12E*/ { "CMSG_CAST_SPELL",                 STATUS_LOGGEDIN, &WorldSession::HandleCastSpellOpcode           },
-    /*0x12F*/ { "CMSG_CANCEL_CAST",                STATUS_LOGGEDIN, &WorldSession::HandleCancelCastOpcode          },
+    /*0x12E*/ { "CMSG_CAST_SPELL",                 STATUS_LOGGEDIN, &WorldSession::HandleCastSpellOpcode, PROCESS_MAPLOCAL },
+    /*0x12F*/ { "CMSG_CANCEL_CAST",                STATUS_LOGGEDIN, &WorldSession::HandleCancelCastOpcode, PROCESS_MAPLOCAL },
     /*0x130*/ { "SMSG_CAST_FAILED",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x131*/ { "SMSG_SPELL_START",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x132*/ { "SMSG_SPELL_GO",                   STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x133*/ { "SMSG_SPELL_FAILURE",              STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x134*/ { "SMSG_SPELL_COOLDOWN",             STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x135*/ { "SMSG_COOLDOWN_EVENT",             STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x136*/ { "CMSG_CANCEL_AURA",                STATUS_LOGGEDIN, &WorldSession::HandleCancelAuraOpcode          },
+    /*0x136*/ { "CMSG_CANCEL_AURA",                STATUS_LOGGEDIN, &WorldSession::HandleCancelAuraOpcode, PROCESS_MAPLOCAL },
     /*0x137*/ { "SMSG_UPDATE_AURA_DURATION",       STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x138*/ { "SMSG_PET_CAST_FAILED",            STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x139*/ { "MSG_CHANNEL_START",               STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x13A*/ { "MSG_CHANNEL_UPDATE",              STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x13B*/ { "CMSG_CANCEL_CHANNELLING",         STATUS_LOGGEDIN, &WorldSession::HandleCancelChanneling          },
+    /*0x13B*/ { "CMSG_CANCEL_CHANNELLING",         STATUS_LOGGEDIN, &WorldSession::HandleCancelChanneling, PROCESS_MAPLOCAL },
     /*0x13C*/ { "SMSG_AI_REACTION",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x13D*/ { "CMSG_SET_SELECTION",              STATUS_LOGGEDIN, &WorldSession::HandleSetSelectionOpcode        },
-    /*0x13E*/ { "CMSG_SET_TARGET_OBSOLETE",        STATUS_LOGGEDIN, &WorldSession::HandleSetTargetOpcode           },
+    /*0x13D*/ { "CMSG_SET_SELECTION",              STATUS_LOGGEDIN, &WorldSession::HandleSetSelectionOpcode, PROCESS_MAPLOCAL },
+    /*0x13E*/ { "CMSG_SET_TARGET_OBSOLETE",        STATUS_LOGGEDIN, &WorldSession::HandleSetTargetOpcode, PROCESS_MAPLOCAL },
     /*0x13F*/ { "CMSG_UNUSED",                     STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x140*/ { "CMSG_UNUSED2",                    STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x141*/ { "CMSG_ATTACKSWING",                STATUS_LOGGEDIN, &WorldSession::HandleAttackSwingOpcode         },
-    /*0x142*/ { "CMSG_ATTACKSTOP",                 STATUS_LOGGEDIN, &WorldSession::HandleAttackStopOpcode          },
+    /*0x141*/ { "CMSG_ATTACKSWING",                STATUS_LOGGEDIN, &WorldSession::HandleAttackSwingOpcode, PROCESS_MAPLOCAL },
+    /*0x142*/ { "CMSG_ATTACKSTOP",                 STATUS_LOGGEDIN, &WorldSession::HandleAttackStopOpcode, PROCESS_MAPLOCAL },
     /*0x143*/ { "SMSG_ATTACKSTART",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x144*/ { "SMSG_ATTACKSTOP",                 STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x145*/ { "SMSG_ATTACKSWING_NOTINRANGE",     STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -407,7 +407,7 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x17C*/ { "CMSG_GOSSIP_SELECT_OPTION",       STATUS_LOGGEDIN, &WorldSession::HandleGossipSelectOptionOpcode  },
     /*0x17D*/ { "SMSG_GOSSIP_MESSAGE",             STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x17E*/ { "SMSG_GOSSIP_COMPLETE",            STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x17F*/ { "CMSG_NPC_TEXT_QUERY",             STATUS_LOGGEDIN, &WorldSession::HandleNpcTextQueryOpcode        },
+    /*0x17F*/ { "CMSG_NPC_TEXT_QUERY",             STATUS_LOGGEDIN, &WorldSession::HandleNpcTextQueryOpcode, PROCESS_THREADSAFE },
     /*0x180*/ { "SMSG_NPC_TEXT_UPDATE",            STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x181*/ { "SMSG_NPC_WONT_TALK",              STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x182*/ { "CMSG_QUESTGIVER_STATUS_QUERY",    STATUS_LOGGEDIN, &WorldSession::HandleQuestgiverStatusQueryOpcode},
@@ -486,7 +486,7 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x1CB*/ { "SMSG_NOTIFICATION",               STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1CC*/ { "CMSG_PLAYED_TIME",                STATUS_LOGGEDIN, &WorldSession::HandlePlayedTime                },
     /*0x1CD*/ { "SMSG_PLAYED_TIME",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x1CE*/ { "CMSG_QUERY_TIME",                 STATUS_LOGGEDIN, &WorldSession::HandleQueryTimeOpcode           },
+    /*0x1CE*/ { "CMSG_QUERY_TIME",                 STATUS_LOGGEDIN, &WorldSession::HandleQueryTimeOpcode, PROCESS_THREADSAFE },
     /*0x1CF*/ { "SMSG_QUERY_TIME_RESPONSE",        STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1D0*/ { "SMSG_LOG_XPGAIN",                 STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1D1*/ { "SMSG_AURACASTLOG",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -504,7 +504,7 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x1DD*/ { "SMSG_PONG",                       STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1DE*/ { "SMSG_CLEAR_COOLDOWN",             STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1DF*/ { "SMSG_GAMEOBJECT_PAGETEXT",        STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x1E0*/ { "CMSG_SETSHEATHED",                STATUS_LOGGEDIN, &WorldSession::HandleSetSheathedOpcode         },
+    /*0x1E0*/ { "CMSG_SETSHEATHED",                STATUS_LOGGEDIN, &WorldSession::HandleSetSheathedOpcode, PROCESS_MAPLOCAL },
     /*0x1E1*/ { "SMSG_COOLDOWN_CHEAT",             STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1E2*/ { "SMSG_SPELL_DELAYED",              STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1E3*/ { "CMSG_PLAYER_MACRO_OBSOLETE",      STATUS_NEVER,    &WorldSession::Handle_NULL                     },
@@ -520,7 +520,7 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x1ED*/ { "CMSG_AUTH_SESSION",               STATUS_NEVER,    &WorldSession::Handle_EarlyProccess            },
     /*0x1EE*/ { "SMSG_AUTH_RESPONSE",              STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x1EF*/ { "MSG_GM_SHOWLABEL",                STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x1F0*/ { "CMSG_PET_CAST_SPELL",             STATUS_LOGGEDIN, &WorldSession::HandlePetCastSpellOpcode        },
+    /*0x1F0*/ { "CMSG_PET_CAST_SPELL",             STATUS_LOGGEDIN, &WorldSession::HandlePetCastSpellOpcode, PROCESS_MAPLOCAL },
     /*0x1F1*/ { "MSG_SAVE_GUILD_EMBLEM",           STATUS_LOGGEDIN, &WorldSession::HandleGuildSaveEmblemOpcode     },
     /*0x1F2*/ { "MSG_TABARDVENDOR_ACTIVATE",       STATUS_LOGGEDIN, &WorldSession::HandleTabardVendorActivateOpcode},
     /*0x1F3*/ { "SMSG_PLAY_SPELL_VISUAL",          STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -642,10 +642,10 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x267*/ { "SMSG_SET_PCT_SPELL_MODIFIER",     STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x268*/ { "CMSG_SET_AMMO",                   STATUS_LOGGEDIN, &WorldSession::HandleSetAmmoOpcode             },
     /*0x269*/ { "SMSG_CORPSE_RECLAIM_DELAY",       STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x26A*/ { "CMSG_SET_ACTIVE_MOVER",           STATUS_LOGGEDIN, &WorldSession::HandleSetActiveMoverOpcode      },
+    /*0x26A*/ { "CMSG_SET_ACTIVE_MOVER",           STATUS_LOGGEDIN, &WorldSession::HandleSetActiveMoverOpcode, PROCESS_MAPLOCAL },
     /*0x26B*/ { "CMSG_PET_CANCEL_AURA",            STATUS_LOGGEDIN, &WorldSession::HandlePetCancelAuraOpcode       },
     /*0x26C*/ { "CMSG_PLAYER_AI_CHEAT",            STATUS_NEVER,    &WorldSession::Handle_NULL                     },
-    /*0x26D*/ { "CMSG_CANCEL_AUTO_REPEAT_SPELL",   STATUS_LOGGEDIN, &WorldSession::HandleCancelAutoRepeatSpellOpcode},
+    /*0x26D*/ { "CMSG_CANCEL_AUTO_REPEAT_SPELL",   STATUS_LOGGEDIN, &WorldSession::HandleCancelAutoRepeatSpellOpcode, PROCESS_MAPLOCAL},
     /*0x26E*/ { "MSG_GM_ACCOUNT_ONLINE",           STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x26F*/ { "MSG_LIST_STABLED_PETS",           STATUS_LOGGEDIN, &WorldSession::HandleListStabledPetsOpcode     },
     /*0x270*/ { "CMSG_STABLE_PET",                 STATUS_LOGGEDIN, &WorldSession::HandleStablePet                 },
@@ -738,14 +738,14 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x2C7*/ { "CMSG_CHAR_RENAME",                STATUS_AUTHED,   &WorldSession::HandleChangePlayerNameOpcode    },
     /*0x2C8*/ { "SMSG_CHAR_RENAME",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x2C9*/ { "CMSG_MOVE_SPLINE_DONE",           STATUS_LOGGEDIN, &WorldSession::HandleTaxiNextDestinationOpcode },
-    /*0x2CA*/ { "CMSG_MOVE_FALL_RESET",            STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x2CA*/ { "CMSG_MOVE_FALL_RESET",            STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x2CB*/ { "SMSG_INSTANCE_SAVE_CREATED",      STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x2CC*/ { "SMSG_RAID_INSTANCE_INFO",         STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x2CD*/ { "CMSG_REQUEST_RAID_INFO",          STATUS_LOGGEDIN, &WorldSession::HandleRequestRaidInfoOpcode     },
-    /*0x2CE*/ { "CMSG_MOVE_TIME_SKIPPED",          STATUS_LOGGEDIN, &WorldSession::HandleMoveTimeSkippedOpcode     },
-    /*0x2CF*/ { "CMSG_MOVE_FEATHER_FALL_ACK",      STATUS_LOGGEDIN, &WorldSession::HandleFeatherFallAck            },
-    /*0x2D0*/ { "CMSG_MOVE_WATER_WALK_ACK",        STATUS_LOGGEDIN, &WorldSession::HandleMoveWaterWalkAck          },
-    /*0x2D1*/ { "CMSG_MOVE_NOT_ACTIVE_MOVER",      STATUS_LOGGEDIN, &WorldSession::HandleMoveNotActiveMoverOpcode  },
+    /*0x2CE*/ { "CMSG_MOVE_TIME_SKIPPED",          STATUS_LOGGEDIN, &WorldSession::HandleMoveTimeSkippedOpcode, PROCESS_MAPLOCAL },
+    /*0x2CF*/ { "CMSG_MOVE_FEATHER_FALL_ACK",      STATUS_LOGGEDIN, &WorldSession::HandleFeatherFallAck, PROCESS_MAPLOCAL },
+    /*0x2D0*/ { "CMSG_MOVE_WATER_WALK_ACK",        STATUS_LOGGEDIN, &WorldSession::HandleMoveWaterWalkAck, PROCESS_MAPLOCAL },
+    /*0x2D1*/ { "CMSG_MOVE_NOT_ACTIVE_MOVER",      STATUS_LOGGEDIN, &WorldSession::HandleMoveNotActiveMoverOpcode, PROCESS_MAPLOCAL },
     /*0x2D2*/ { "SMSG_PLAY_SOUND",                 STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x2D3*/ { "CMSG_BATTLEFIELD_STATUS",         STATUS_LOGGEDIN, &WorldSession::HandleBattlefieldStatusOpcode   },
     /*0x2D4*/ { "SMSG_BATTLEFIELD_STATUS",         STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -755,11 +755,11 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x2D8*/ { "CMSG_MOVE_START_SWIM_CHEAT",      STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x2D9*/ { "CMSG_MOVE_STOP_SWIM_CHEAT",       STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x2DA*/ { "SMSG_FORCE_WALK_SPEED_CHANGE",    STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x2DB*/ { "CMSG_FORCE_WALK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck       },
+    /*0x2DB*/ { "CMSG_FORCE_WALK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x2DC*/ { "SMSG_FORCE_SWIM_BACK_SPEED_CHANGE", STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x2DD*/ { "CMSG_FORCE_SWIM_BACK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck    },
+    /*0x2DD*/ { "CMSG_FORCE_SWIM_BACK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x2DE*/ { "SMSG_FORCE_TURN_RATE_CHANGE",     STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x2DF*/ { "CMSG_FORCE_TURN_RATE_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck       },
+    /*0x2DF*/ { "CMSG_FORCE_TURN_RATE_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x2E0*/ { "MSG_PVP_LOG_DATA",                STATUS_LOGGEDIN, &WorldSession::HandleBattleGroundPVPlogdataOpcode},
     /*0x2E1*/ { "CMSG_LEAVE_BATTLEFIELD",          STATUS_LOGGEDIN, &WorldSession::HandleBattleGroundLeaveOpcode   },
     /*0x2E2*/ { "CMSG_AREA_SPIRIT_HEALER_QUERY",   STATUS_LOGGEDIN, &WorldSession::HandleAreaSpiritHealerQueryOpcode},
@@ -861,8 +861,8 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x342*/ { "MSG_MOVE_STOP_SWIM_CHEAT",        STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x343*/ { "SMSG_MOVE_SET_CAN_FLY",           STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x344*/ { "SMSG_MOVE_UNSET_CAN_FLY",         STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x345*/ { "CMSG_MOVE_SET_CAN_FLY_ACK",       STATUS_LOGGEDIN, &WorldSession::HandleMoveFlyModeChangeAckOpcode},
-    /*0x346*/ { "CMSG_MOVE_SET_FLY",               STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x345*/ { "CMSG_MOVE_SET_CAN_FLY_ACK",       STATUS_LOGGEDIN, &WorldSession::HandleMoveFlyModeChangeAckOpcode, PROCESS_MAPLOCAL},
+    /*0x346*/ { "CMSG_MOVE_SET_FLY",               STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x347*/ { "CMSG_SOCKET_GEMS",                STATUS_LOGGEDIN, &WorldSession::HandleSocketOpcode              },
     /*0x348*/ { "CMSG_ARENA_TEAM_CREATE",          STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x349*/ { "SMSG_ARENA_TEAM_COMMAND_RESULT",  STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
@@ -881,8 +881,8 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x356*/ { "CMSG_ARENA_TEAM_LEADER",          STATUS_LOGGEDIN, &WorldSession::HandleArenaTeamPromoteToCaptainOpcode},
     /*0x357*/ { "SMSG_ARENA_TEAM_EVENT",           STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x358*/ { "CMSG_BATTLEMASTER_JOIN_ARENA",    STATUS_LOGGEDIN, &WorldSession::HandleBattleGroundArenaJoin     },
-    /*0x359*/ { "MSG_MOVE_START_ASCEND",           STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
-    /*0x35A*/ { "MSG_MOVE_STOP_ASCEND",            STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x359*/ { "MSG_MOVE_START_ASCEND",           STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
+    /*0x35A*/ { "MSG_MOVE_STOP_ASCEND",            STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x35B*/ { "SMSG_ARENA_TEAM_STATS",           STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x35C*/ { "CMSG_LFG_SET_AUTOJOIN",           STATUS_AUTHED,   &WorldSession::HandleLfgSetAutoJoinOpcode      },
     /*0x35D*/ { "CMSG_LFG_CLEAR_AUTOJOIN",         STATUS_LOGGEDIN, &WorldSession::HandleLfgClearAutoJoinOpcode    },
@@ -922,9 +922,9 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x37F*/ { "MSG_MOVE_SET_FLIGHT_BACK_SPEED_CHEAT", STATUS_NEVER, &WorldSession::Handle_NULL                     },
     /*0x380*/ { "MSG_MOVE_SET_FLIGHT_BACK_SPEED",  STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x381*/ { "SMSG_FORCE_FLIGHT_SPEED_CHANGE",  STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x382*/ { "CMSG_FORCE_FLIGHT_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck       },
+    /*0x382*/ { "CMSG_FORCE_FLIGHT_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x383*/ { "SMSG_FORCE_FLIGHT_BACK_SPEED_CHANGE", STATUS_NEVER,  &WorldSession::Handle_ServerSide               },
-    /*0x384*/ { "CMSG_FORCE_FLIGHT_BACK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck  },
+    /*0x384*/ { "CMSG_FORCE_FLIGHT_BACK_SPEED_CHANGE_ACK", STATUS_LOGGEDIN, &WorldSession::HandleForceSpeedChangeAck, PROCESS_MAPLOCAL },
     /*0x385*/ { "SMSG_SPLINE_SET_FLIGHT_SPEED",    STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x386*/ { "SMSG_SPLINE_SET_FLIGHT_BACK_SPEED", STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x387*/ { "CMSG_MAELSTROM_INVALIDATE_CACHE", STATUS_NEVER,    &WorldSession::Handle_NULL                     },
@@ -933,11 +933,11 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x38A*/ { "SMSG_JOINED_BATTLEGROUND_QUEUE",  STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x38B*/ { "SMSG_REALM_SPLIT",                STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x38C*/ { "CMSG_REALM_SPLIT",                STATUS_AUTHED,   &WorldSession::HandleRealmStateRequestOpcode   },
-    /*0x38D*/ { "CMSG_MOVE_CHNG_TRANSPORT",        STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x38D*/ { "CMSG_MOVE_CHNG_TRANSPORT",        STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x38E*/ { "MSG_PARTY_ASSIGNMENT",            STATUS_LOGGEDIN, &WorldSession::HandleGroupPromoteOpcode        },
     /*0x38F*/ { "SMSG_OFFER_PETITION_ERROR",       STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x390*/ { "SMSG_TIME_SYNC_REQ",              STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x391*/ { "CMSG_TIME_SYNC_RESP",             STATUS_LOGGEDIN, &WorldSession::HandleTimeSyncResp              },
+    /*0x391*/ { "CMSG_TIME_SYNC_RESP",             STATUS_LOGGEDIN, &WorldSession::HandleTimeSyncResp, PROCESS_MAPLOCAL },
     /*0x392*/ { "CMSG_SEND_LOCAL_EVENT",           STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x393*/ { "CMSG_SEND_GENERAL_TRIGGER",       STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x394*/ { "CMSG_SEND_COMBAT_TRIGGER",        STATUS_NEVER,    &WorldSession::Handle_NULL                     },
@@ -959,7 +959,7 @@ OpcodeHandler opcodeTable[NUM_MSG_TYPES] =
     /*0x3A4*/ { "SMSG_SET_EXTRA_AURA_INFO",        STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x3A5*/ { "SMSG_SET_EXTRA_AURA_INFO_NEED_UPDATE", STATUS_NEVER, &WorldSession::Handle_ServerSide               },
     /*0x3A6*/ { "SMSG_CLEAR_EXTRA_AURA_INFO",      STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
-    /*0x3A7*/ { "MSG_MOVE_START_DESCEND",          STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes           },
+    /*0x3A7*/ { "MSG_MOVE_START_DESCEND",          STATUS_LOGGEDIN, &WorldSession::HandleMovementOpcodes, PROCESS_MAPLOCAL },
     /*0x3A8*/ { "CMSG_IGNORE_REQUIREMENTS_CHEAT",  STATUS_NEVER,    &WorldSession::Handle_NULL                     },
     /*0x3A9*/ { "SMSG_IGNORE_REQUIREMENTS_CHEAT",  STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
     /*0x3AA*/ { "SMSG_SPELL_CHANCE_PROC_LOG",      STATUS_NEVER,    &WorldSession::Handle_ServerSide               },
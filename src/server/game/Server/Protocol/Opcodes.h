@@ -1106,6 +1106,14 @@ enum SessionStatus
     STATUS_NEVER                                            // Opcode not accepted from client (deprecated or server side only)
 };
 
+// Thread an opcode handler may run on
+enum PacketProcessing
+{
+    PROCESS_THREADUNSAFE = 0,                               // World::UpdateSessions only (default), global state
+    PROCESS_MAPLOCAL,                                       // map thread of the player, touches only the player and its surroundings
+    PROCESS_THREADSAFE                                      // any thread, reads only static data
+};
+
 class WorldPacket;
 
 struct OpcodeHandler
@@ -1113,6 +1121,7 @@ struct OpcodeHandler
     char const* name;
     SessionStatus status;
     void (WorldSession::*handler)(WorldPacket& recvPacket);
+    PacketProcessing packetProcessing;
 };
 
 extern OpcodeHandler opcodeTable[NUM_MSG_TYPES];
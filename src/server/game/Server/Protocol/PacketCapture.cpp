@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PacketCapture.h"
+#include "Opcodes.h"
+#include "WorldSession.h"
+#include "Config.h"
+#include "Log.h"
+#include "Timer.h"
+
+PacketCapture::PacketCapture() : i_file(NULL), i_startTime(0), i_unflushed(0)
+{
+    Initialize();
+}
+
+PacketCapture::~PacketCapture()
+{
+    if (i_file != NULL)
+        fclose(i_file);
+    i_file = NULL;
+}
+
+// Open the capture file (if specified so in the configuration file)
+void PacketCapture::Initialize()
+{
+    std::string capname = ConfigMgr::GetStringDefault("PacketCaptureFile", "");
+    if (capname.empty())
+        return;
+
+    std::string path = GetPath(capname);
+    if (path.empty())
+    {
+        sLog->outError("PacketCapture: %s is not a file name, captures are written to LogsDir", capname.c_str());
+        return;
+    }
+
+    i_file = fopen(path.c_str(), "wb");
+    if (!i_file)
+    {
+        sLog->outError("PacketCapture: can't open %s for writing", path.c_str());
+        return;
+    }
+
+    uint32 version = PACKET_CAPTURE_VERSION;
+    uint64 now = uint64(time(NULL));
+    fwrite(PACKET_CAPTURE_MAGIC, 1, 4, i_file);
+    fwrite(&version, sizeof(version), 1, i_file);
+    fwrite(&now, sizeof(now), 1, i_file);
+
+    i_startTime = getMSTime();
+}
+
+void PacketCapture::Capture(uint32 accountId, WorldPacket const& packet)
+{
+    if (!IsActive())
+        return;
+
+    uint32 time = getMSTimeDiff(i_startTime, getMSTime());
+    uint16 opcode = packet.GetOpcode();
+    uint32 size = uint32(packet.size());
+
+    ACE_GUARD(ACE_Thread_Mutex, Guard, Lock);
+
+    fwrite(&time, sizeof(time), 1, i_file);
+    fwrite(&accountId, sizeof(accountId), 1, i_file);
+    fwrite(&opcode, sizeof(opcode), 1, i_file);
+    fwrite(&size, sizeof(size), 1, i_file);
+    if (size)
+        fwrite(packet.contents(), 1, size, i_file);
+
+    // keep the file usable if the server doesn't shut down cleanly
+    if (++i_unflushed >= PACKET_CAPTURE_FLUSH_INTERVAL)
+    {
+        fflush(i_file);
+        i_unflushed = 0;
+    }
+}
+
+std::string PacketCapture::GetPath(std::string const& fileName)
+{
+    // no directories, the capture files stay in LogsDir
+    if (fileName.empty() || fileName == "." || fileName == ".." || fileName.find_first_of("/\\:") != std::string::npos)
+        return "";
+
+    std::string logsDir = ConfigMgr::GetStringDefault("LogsDir", "");
+    if (!logsDir.empty())
+    {
+        if ((logsDir.at(logsDir.length()-1) != '/') && (logsDir.at(logsDir.length()-1) != '\\'))
+            logsDir.append("/");
+    }
+
+    return logsDir + fileName;
+}
+
+bool PacketCapture::IsReplayable(uint16 opcode)
+{
+    if (opcode >= NUM_MSG_TYPES)
+        return false;
+
+    if (opcodeTable[opcode].handler == &WorldSession::HandleMovementOpcodes)
+        return true;
+
+    switch (opcode)
+    {
+        case CMSG_MOVE_TIME_SKIPPED:
+        case CMSG_SET_SELECTION:
+        case CMSG_STANDSTATECHANGE:
+        case CMSG_NAME_QUERY:
+        case CMSG_CREATURE_QUERY:
+        case CMSG_GAMEOBJECT_QUERY:
+        case CMSG_ITEM_QUERY_SINGLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool PacketCapture::Load(std::string const& fileName, uint32 accountId, PacketCaptureRecordList& records, uint32& skipped)
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file)
+        return false;
+
+    char magic[4];
+    uint32 version;
+    uint64 startTime;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, PACKET_CAPTURE_MAGIC, 4) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != PACKET_CAPTURE_VERSION ||
+        fread(&startTime, sizeof(startTime), 1, file) != 1)
+    {
+        fclose(file);
+        return false;
+    }
+
+    records.clear();
+    skipped = 0;
+
+    uint32 firstTime = 0;
+    std::vector<uint8> payload;
+    while (true)
+    {
+        uint32 time, account, size;
+        uint16 opcode;
+        if (fread(&time, sizeof(time), 1, file) != 1 ||
+            fread(&account, sizeof(account), 1, file) != 1 ||
+            fread(&opcode, sizeof(opcode), 1, file) != 1 ||
+            fread(&size, sizeof(size), 1, file) != 1)
+            break;
+
+        if (size > PACKET_CAPTURE_MAX_SIZE)
+            break;
+
+        payload.resize(size);
+        if (size && fread(&payload[0], 1, size, file) != size)
+            break;
+
+        if (!accountId)
+            accountId = account;
+        else if (account != accountId)
+            continue;
+
+        if (!IsReplayable(opcode))
+        {
+            ++skipped;
+            continue;
+        }
+
+        if (records.empty())
+            firstTime = time;
+
+        PacketCaptureRecord record;
+        record.time = time - firstTime;
+        record.packet.Initialize(opcode, size);
+        if (size)
+            record.packet.append(&payload[0], size);
+        records.push_back(record);
+    }
+
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_PACKETCAPTURE_H
+#define TRINITY_PACKETCAPTURE_H
+
+#include "Common.h"
+#include "WorldPacket.h"
+
+#include <ace/Singleton.h>
+#include <deque>
+
+/*
+  Binary capture of the packets received from the clients, for replaying them later.
+
+  File layout, little endian:
+    header: "WCAP", uint32 version, uint64 unix time of the capture start
+    record: uint32 ms since the capture start, uint32 account id, uint16 opcode,
+            uint32 payload size, payload
+*/
+#define PACKET_CAPTURE_MAGIC    "WCAP"
+#define PACKET_CAPTURE_VERSION  1
+// WorldSocket drops client packets larger than this, a bigger record means a corrupt file
+#define PACKET_CAPTURE_MAX_SIZE 10240
+// records between two flushes of the capture file
+#define PACKET_CAPTURE_FLUSH_INTERVAL 64
+
+struct PacketCaptureRecord
+{
+    uint32 time;                                            // ms since the first record of the replayed account
+    WorldPacket packet;
+};
+
+typedef std::deque<PacketCaptureRecord> PacketCaptureRecordList;
+
+class PacketCapture
+{
+    friend class ACE_Singleton<PacketCapture, ACE_Thread_Mutex>;
+    PacketCapture();
+    PacketCapture(const PacketCapture &);
+    PacketCapture& operator=(const PacketCapture &);
+    ACE_Thread_Mutex Lock;
+
+    // Close the file in destructor
+    ~PacketCapture();
+
+    public:
+        void Initialize();
+        // Is the capture active?
+        bool IsActive() const { return (i_file != NULL); }
+        // Append a received packet of the account
+        void Capture(uint32 accountId, WorldPacket const& packet);
+
+        // Read the packets of one account (the first one of the file if 0) from a capture file, false if the file is not a capture.
+        // Only replayable packets are kept, skipped counts the dropped ones.
+        static bool Load(std::string const& fileName, uint32 accountId, PacketCaptureRecordList& records, uint32& skipped);
+
+        // Movement and in-world queries only. Everything else (login, logout, items, mail, trade, guild ...)
+        // would make persistent changes to the character the capture is replayed into.
+        static bool IsReplayable(uint16 opcode);
+
+        // Path of a capture file in LogsDir, empty if fileName is not a plain file name
+        static std::string GetPath(std::string const& fileName);
+
+    private:
+        FILE *i_file;
+        uint32 i_startTime;
+        uint32 i_unflushed;
+};
+
+#define sPacketCapture ACE_Singleton<PacketCapture, ACE_Thread_Mutex>::instance()
+#endif
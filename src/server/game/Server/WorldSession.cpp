@@ -41,6 +41,9 @@
 #include "WardenMac.h"
 #include "TempEventMgr.h"
 #include "AnticheatMgr.h"
+#include "OpcodeStats.h"
+
+#include <ace/High_Res_Timer.h>
 
 // WorldSession constructor
 WorldSession::WorldSession(uint32 id, WorldSocket *sock, uint32 sec, uint8 expansion, time_t mute_time, LocaleConstant locale) :
@@ -48,7 +51,7 @@ LookingForGroup_auto_join(false), LookingForGroup_auto_add(false), m_muteTime(mu
 _player(NULL), m_Socket(sock), _security(sec), _accountId(id), m_expansion(expansion),
 m_sessionDbcLocale(sWorld->GetAvailableDbcLocale(locale)), m_sessionDbLocaleIndex(sObjectMgr->GetIndexForLocale(locale)),
 _logoutTime(0), m_inQueue(false), m_playerLoading(false), m_playerLogout(false), m_playerRecentlyLogout(false), m_playerSave(false),
-m_latency(0), m_timeOutTime(0), m_Warden(NULL), m_expireTime(60000), m_forceExit(false)
+m_latency(0), m_timeOutTime(0), m_Warden(NULL), m_expireTime(60000), m_forceExit(false), m_replayTime(0)
 {
     if (sock)
     {
@@ -98,7 +101,7 @@ char const* WorldSession::GetPlayerName() const
 }
 
 // Send a packet to the client
-void WorldSession::SendPacket(WorldPacket const* packet)
+void WorldSession::SendPacket(WorldPacket const* packet, WorldPacketPtr* shared)
 {
     if (!m_Socket || m_Socket->IsClosed())
         return;
@@ -139,10 +142,28 @@ void WorldSession::SendPacket(WorldPacket const* packet)
 
     #endif                                                  // !TRINITY_DEBUG
 
-    if (m_Socket->SendPacket(*packet) == -1)
+    if (m_Socket->SendPacket(*packet, shared) == -1)
         m_Socket->CloseSocket();
 }
 
+void WorldSession::StartReplay(PacketCaptureRecordList const& records)
+{
+    m_replayPackets = records;
+    m_replayTime = 0;
+}
+
+void WorldSession::UpdateReplay(uint32 diff)
+{
+    m_replayTime += diff;
+
+    while (!m_replayPackets.empty() && m_replayPackets.front().time <= m_replayTime)
+    {
+        if (PacketCapture::IsReplayable(m_replayPackets.front().packet.GetOpcode()))
+            QueuePacket(new WorldPacket(m_replayPackets.front().packet));
+        m_replayPackets.pop_front();
+    }
+}
+
 // Add an incoming packet to the queue
 void WorldSession::QueuePacket(WorldPacket* new_packet)
 {
@@ -167,21 +188,28 @@ void WorldSession::LogUnprocessedTail(WorldPacket *packet)
         packet->rpos(), packet->wpos());
 }
 
-// Update the WorldSession (triggered by World update)
-bool WorldSession::Update(uint32 diff)
+// Update the WorldSession (triggered by World update and by Map::Update for players in world)
+bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 {
-    /// Update Timeout timer.
-    UpdateTimeOutTime(diff);
+    if (updater.ProcessLogout())
+    {
+        /// Update Timeout timer.
+        UpdateTimeOutTime(diff);
 
-    ///- Before we process anything:
-    /// If necessary, kick the player from the character select screen
-    if (IsConnectionIdle())
-        m_Socket->CloseSocket();
+        ///- Before we process anything:
+        /// If necessary, kick the player from the character select screen
+        if (IsConnectionIdle())
+            m_Socket->CloseSocket();
+
+        if (!m_replayPackets.empty())
+            UpdateReplay(diff);
+    }
 
     // Retrieve packets from the receive queue and call the appropriate handlers
-    // not proccess packets if socket already closed
+    // not proccess packets if socket already closed, stop at the first packet
+    // the filter rejects so the packets of a session keep their order
     WorldPacket* packet;
-    while (m_Socket && !m_Socket->IsClosed() && _recvQueue.next(packet))
+    while (m_Socket && !m_Socket->IsClosed() && _recvQueue.next(packet, updater))
     {
         /*#if 1
         sLog->outError("MOEP: %s (0x%.4X)",
@@ -256,6 +284,10 @@ bool WorldSession::Update(uint32 diff)
         delete packet;
     }
 
+    // the rest is handled by World::UpdateSessions only
+    if (!updater.ProcessLogout())
+        return true;
+
     if (m_Socket && !m_Socket->IsClosed() && m_Warden)
         m_Warden->Update();
 
@@ -281,6 +313,33 @@ bool WorldSession::Update(uint32 diff)
     return true;
 }
 
+bool MapSessionFilter::Process(WorldPacket* packet)
+{
+    if (packet->GetOpcode() >= NUM_MSG_TYPES)
+        return false;
+
+    OpcodeHandler const& opHandle = opcodeTable[packet->GetOpcode()];
+    if (opHandle.packetProcessing == PROCESS_THREADUNSAFE)
+        return false;
+
+    Player* player = m_pSession->GetPlayer();
+    return player && player->IsInWorld();
+}
+
+bool WorldSessionFilter::Process(WorldPacket* packet)
+{
+    if (packet->GetOpcode() >= NUM_MSG_TYPES)
+        return true;
+
+    OpcodeHandler const& opHandle = opcodeTable[packet->GetOpcode()];
+    if (opHandle.packetProcessing == PROCESS_THREADUNSAFE)
+        return true;
+
+    // no map thread will pick it up
+    Player* player = m_pSession->GetPlayer();
+    return !player || !player->IsInWorld();
+}
+
 // Log the player out
 void WorldSession::LogoutPlayer(bool Save)
 {
@@ -603,8 +662,17 @@ void WorldSession::ExecuteOpcode(OpcodeHandler const& opHandle, WorldPacket* pac
     if (_player)
         _player->SetCanDelayTeleport(true);
 
+    // monotonic, a wall clock step would show up as a huge or negative handler time
+    ACE_High_Res_Timer timer;
+    timer.start();
+
     (this->*opHandle.handler)(*packet);
 
+    timer.stop();
+    ACE_hrtime_t handlerTime;
+    timer.elapsed_microseconds(handlerTime);
+    sOpcodeStats->Record(packet->GetOpcode(), uint64(handlerTime), uint32(packet->size()));
+
     if (_player)
     {
         // can be not set in fact for login opcode, but this not create porblems.
@@ -25,6 +25,8 @@
 #include "QueryResult.h"
 #include "World.h"
 #include "WardenBase.h"
+#include "WorldPacket.h"
+#include "PacketCapture.h"
 
 struct ItemPrototype;
 struct AuctionEntry;
@@ -35,7 +37,6 @@ class Item;
 class Object;
 class Player;
 class Unit;
-class WorldPacket;
 class WorldSocket;
 class QueryResult;
 class LoginQueryHolder;
@@ -70,6 +71,42 @@ struct PacketCounter
     uint32 amountCounter;
 };
 
+// Decides which queued packets of a session may be handled by the current WorldSession::Update caller
+class PacketFilter
+{
+    public:
+        explicit PacketFilter(WorldSession* pSession) : m_pSession(pSession) {}
+        virtual ~PacketFilter() {}
+
+        virtual bool Process(WorldPacket* /*packet*/) { return true; }
+        virtual bool ProcessLogout() const { return true; }
+
+    protected:
+        WorldSession* const m_pSession;
+};
+
+// Used in Map::Update, handles map local and thread safe opcodes of players in world
+class MapSessionFilter : public PacketFilter
+{
+    public:
+        explicit MapSessionFilter(WorldSession* pSession) : PacketFilter(pSession) {}
+        ~MapSessionFilter() {}
+
+        virtual bool Process(WorldPacket* packet);
+        // logout and timeouts are handled by World::UpdateSessions only
+        virtual bool ProcessLogout() const { return false; }
+};
+
+// Used in World::UpdateSessions, handles global opcodes and everything of players not in world
+class WorldSessionFilter : public PacketFilter
+{
+    public:
+        explicit WorldSessionFilter(WorldSession* pSession) : PacketFilter(pSession) {}
+        ~WorldSessionFilter() {}
+
+        virtual bool Process(WorldPacket* packet);
+};
+
 // Player session in the World
 class WorldSession
 {
@@ -84,7 +121,7 @@ class WorldSession
 
         void SizeError(WorldPacket const& packet, uint32 size) const;
 
-        void SendPacket(WorldPacket const* packet);
+        void SendPacket(WorldPacket const* packet, WorldPacketPtr* shared = NULL);
         void SendNotification(const char *format, ...) ATTR_PRINTF(2, 3);
         void SendNotification(int32 string_id, ...);
         void SendPetNameInvalid(uint32 error, const std::string& name, DeclinedName *declinedName);
@@ -126,7 +163,11 @@ class WorldSession
         void KickPlayer();
 
         void QueuePacket(WorldPacket* new_packet);
-        bool Update(uint32 diff);
+        bool Update(uint32 diff, PacketFilter& updater);
+
+        // feeds captured client packets to this session with their original timing, see PacketCapture
+        void StartReplay(PacketCaptureRecordList const& records);
+        size_t GetReplayRemaining() const { return m_replayPackets.size(); }
 
         // Handle the authentication waiting queue (to be completed)
         void SendAuthWaitQue(uint32 position);
@@ -685,6 +726,7 @@ class WorldSession
         time_t _logoutTime;
         bool m_inQueue;                                     // session wait in auth.queue
         bool m_playerLoading;                               // code processed in LoginPlayer
+        std::set<uint32> m_petlessCharacters;               // characters of the last char enum the login skips the pet queries for
         bool m_playerLogout;                                // code processed in LogoutPlayer
         bool m_playerRecentlyLogout;
         bool m_playerSave;
@@ -696,6 +738,10 @@ class WorldSession
         bool m_forceExit;
 
         ACE_Based::LockedQueue<WorldPacket*, ACE_Thread_Mutex> _recvQueue;
+
+        void UpdateReplay(uint32 diff);
+        PacketCaptureRecordList m_replayPackets;
+        uint32 m_replayTime;
 };
 #endif
 
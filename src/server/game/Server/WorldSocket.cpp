@@ -79,6 +79,8 @@ m_RecvPct(),
 m_Header(sizeof (ClientPktHeader)),
 m_OutBuffer(0),
 m_OutBufferSize(65536),
+m_PacketQueueSize(0),
+m_PacketQueueLimit(0),
 m_OutActive(false),
 m_Seed(static_cast<uint32> (rand32())),
 m_OverSpeedPings(0),
@@ -98,9 +100,8 @@ WorldSocket::~WorldSocket (void)
 
     peer().close();
 
-    WorldPacket* pct;
-    while (m_PacketQueue.dequeue_head (pct) == 0)
-        delete pct;
+    m_PacketQueue.reset ();
+    m_PacketQueueSize = 0;
 }
 
 bool WorldSocket::IsClosed (void) const
@@ -132,7 +133,7 @@ const std::string& WorldSocket::GetRemoteAddress (void) const
     return m_Address;
 }
 
-int WorldSocket::SendPacket (const WorldPacket& pct)
+int WorldSocket::SendPacket (const WorldPacket& pct, WorldPacketPtr* shared)
 {
     ACE_GUARD_RETURN (LockType, Guard, m_OutBufferLock, -1);
 
@@ -161,18 +162,42 @@ int WorldSocket::SendPacket (const WorldPacket& pct)
 
     if (iSendPacket (pct) == -1)
     {
-        WorldPacket* npct;
+        // client does not read fast enough, drop it instead of letting the queue grow without bound
+        if (m_PacketQueueLimit && m_PacketQueueSize + pct.size () > m_PacketQueueLimit)
+        {
+            ++sWorldSocketMgr->m_QueueOverflows;
+            sLog->outError ("WorldSocket::SendPacket: %s has %u bytes queued, closing connection", m_Address.c_str (), uint32(m_PacketQueueSize));
+            return -1;
+        }
+
+        WorldPacketPtr npct;
 
-        ACE_NEW_RETURN (npct, WorldPacket (pct), -1);
+        if (shared && !shared->null ())
+            npct = *shared;
+        else
+        {
+            WorldPacket* copy;
+
+            ACE_NEW_RETURN (copy, WorldPacket (pct), -1);
+            npct.reset (copy);
+
+            if (shared)
+                *shared = npct;
+        }
 
         // NOTE maybe check of the size of the queue can be good ?
         // to make it bounded instead of unbounded
         if (m_PacketQueue.enqueue_tail (npct) == -1)
         {
-            delete npct;
             sLog->outError ("WorldSocket::SendPacket: m_PacketQueue.enqueue_tail failed");
             return -1;
         }
+
+        m_PacketQueueSize += pct.size ();
+        ++sWorldSocketMgr->m_QueuedPackets;
+
+        if (m_PacketQueueSize > sWorldSocketMgr->m_PeakQueueBytes.value ())
+            sWorldSocketMgr->m_PeakQueueBytes = m_PacketQueueSize;
     }
 
     return 0;
@@ -292,11 +317,20 @@ int WorldSocket::handle_output (ACE_HANDLE)
     if (closing_)
         return -1;
 
+    // move queued packets in behind the pending data, so they leave with the same send
+    if (!m_PacketQueue.is_empty ())
+    {
+        m_OutBuffer->crunch();
+        iFlushPacketQueue ();
+    }
+
     const size_t send_len = m_OutBuffer->length ();
 
     if (send_len == 0)
         return cancel_wakeup_output (Guard);
 
+    ++sWorldSocketMgr->m_SendCalls;
+
 #ifdef MSG_NOSIGNAL
     ssize_t n = peer().send (m_OutBuffer->rd_ptr(), send_len, MSG_NOSIGNAL);
 #else
@@ -432,7 +466,8 @@ int WorldSocket::handle_input_payload (void)
 
 int WorldSocket::handle_input_missing_data (void)
 {
-    char buf [1024];
+    // large enough for a few movement packets, so a busy client is drained with fewer recv calls
+    char buf [4096];
 
     ACE_Data_Block db (sizeof (buf),
                         ACE_Message_Block::MB_DATA,
@@ -618,6 +653,9 @@ int WorldSocket::ProcessIncoming (WorldPacket* new_pct)
                     // Catches people idling on the login screen and any lingering ingame connections.
                     m_Session->ResetTimeOutTime();
 
+                    if (sPacketCapture->IsActive())
+                        sPacketCapture->Capture(m_Session->GetAccountId(), *new_pct);
+
                     // OK , give the packet to WorldSession
                     aptr.release();
                     // WARNINIG here we call it with locks held.
@@ -956,12 +994,14 @@ int WorldSocket::iSendPacket (const WorldPacket& pct)
         if (m_OutBuffer->copy ((char*) pct.contents (), pct.size ()) == -1)
             ACE_ASSERT (false);
 
+    ++sWorldSocketMgr->m_SentPackets;
+
     return 0;
 }
 
 bool WorldSocket::iFlushPacketQueue ()
 {
-    WorldPacket *pct;
+    WorldPacketPtr pct;
     bool haveone = false;
 
     while (m_PacketQueue.dequeue_head (pct) == 0)
@@ -970,7 +1010,6 @@ bool WorldSocket::iFlushPacketQueue ()
         {
             if (m_PacketQueue.enqueue_head (pct) == -1)
             {
-                delete pct;
                 sLog->outError ("WorldSocket::iFlushPacketQueue m_PacketQueue->enqueue_head");
                 return false;
             }
@@ -980,7 +1019,7 @@ bool WorldSocket::iFlushPacketQueue ()
         else
         {
             haveone = true;
-            delete pct;
+            m_PacketQueueSize -= pct->size ();
         }
     }
 
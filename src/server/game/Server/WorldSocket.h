@@ -38,9 +38,9 @@
 
 #include "Common.h"
 #include "AuthCrypt.h"
+#include "WorldPacket.h"
 
 class ACE_Message_Block;
-class WorldPacket;
 class WorldSession;
 
 // Handler that can communicate over stream sockets.
@@ -98,7 +98,7 @@ class WorldSocket : protected WorldHandler
         typedef ACE_Guard<LockType> GuardType;
 
         // Queue for storing packets for which there is no space.
-        typedef ACE_Unbounded_Queue< WorldPacket* > PacketQueueT;
+        typedef ACE_Unbounded_Queue< WorldPacketPtr > PacketQueueT;
 
         // Check if socket is closed.
         bool IsClosed (void) const;
@@ -111,8 +111,10 @@ class WorldSocket : protected WorldHandler
 
         // Send A packet on the socket, this function is reentrant.
         // pct packet to send
+        // shared if not NULL, the copy of pct queued when there is no space on the buffer,
+        // pass the same one for all recipients of a broadcast so they queue one copy
         // return -1 of failure
-        int SendPacket (const WorldPacket& pct);
+        int SendPacket (const WorldPacket& pct, WorldPacketPtr* shared = NULL);
 
         // Add reference to this object.
         long AddReference (void);
@@ -218,6 +220,12 @@ class WorldSocket : protected WorldHandler
         // this allows not-to kick player if its buffer is overflowed.
         PacketQueueT m_PacketQueue;
 
+        // Bytes of the packets in m_PacketQueue.
+        size_t m_PacketQueueSize;
+
+        // Max bytes in m_PacketQueue before the socket is closed, 0 for unlimited.
+        size_t m_PacketQueueLimit;
+
         // True if the socket is registered with the reactor for output
         bool m_OutActive;
 
@@ -207,8 +207,14 @@ WorldSocketMgr::WorldSocketMgr() :
     m_NetThreads(0),
     m_SockOutKBuff(-1),
     m_SockOutUBuff(65536),
+    m_SockOutQueueLimit(0),
     m_UseNoDelay(true),
-    m_Acceptor (0)
+    m_Acceptor (0),
+    m_SendCalls(0),
+    m_SentPackets(0),
+    m_QueuedPackets(0),
+    m_PeakQueueBytes(0),
+    m_QueueOverflows(0)
 {
 }
 
@@ -248,6 +254,15 @@ WorldSocketMgr::StartReactiveIO (ACE_UINT16 port, const char* address)
         return -1;
     }
 
+    // 0 means unlimited
+    m_SockOutQueueLimit = ConfigMgr::GetIntDefault ("Network.OutQueueLimit", 8388608);
+
+    if (m_SockOutQueueLimit < 0)
+    {
+        sLog->outError ("Network.OutQueueLimit is wrong in your config file");
+        return -1;
+    }
+
     WorldSocket::Acceptor *acc = new WorldSocket::Acceptor;
     m_Acceptor = acc;
 
@@ -339,6 +354,7 @@ WorldSocketMgr::OnSocketOpen (WorldSocket* sock)
     }
 
     sock->m_OutBufferSize = static_cast<size_t> (m_SockOutUBuff);
+    sock->m_PacketQueueLimit = static_cast<size_t> (m_SockOutQueueLimit);
 
     // we skip the Acceptor Thread
     size_t min = 1;
@@ -24,6 +24,9 @@
 #include <ace/Basic_Types.h>
 #include <ace/Singleton.h>
 #include <ace/Thread_Mutex.h>
+#include <ace/Atomic_Op.h>
+
+#include "Define.h"
 
 class WorldSocket;
 class ReactorRunnable;
@@ -48,6 +51,13 @@ public:
   // Make this class singleton .
   static WorldSocketMgr* Instance();
 
+  // Output statistics of all sockets, for the packets per send ratio and the send budget.
+  uint64 GetSendCalls() const { return m_SendCalls.value(); }
+  uint64 GetSentPackets() const { return m_SentPackets.value(); }
+  uint64 GetQueuedPackets() const { return m_QueuedPackets.value(); }
+  uint64 GetPeakQueueBytes() const { return m_PeakQueueBytes.value(); }
+  uint64 GetQueueOverflows() const { return m_QueueOverflows.value(); }
+
 private:
   int OnSocketOpen(WorldSocket* sock);
 
@@ -62,8 +72,15 @@ private:
 
   int m_SockOutKBuff;
   int m_SockOutUBuff;
+  int m_SockOutQueueLimit;
   bool m_UseNoDelay;
 
+  ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_SendCalls;
+  ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_SentPackets;
+  ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_QueuedPackets;
+  ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_PeakQueueBytes;
+  ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_QueueOverflows;
+
   ACE_Event_Handler* m_Acceptor;
 };
 
@@ -2155,6 +2155,11 @@ void Spell::SetTargetMap(uint32 i, uint32 cur)
             }else if (m_spellInfo->Id == 27285) // Seed of Corruption proc spell
                 unitList.remove(m_targets.getUnitTarget());
 
+            // trace the line of sight of all targets at once, CheckTarget then finds it in the cache
+            if (unitList.size() > 1 && !m_IsTriggeredSpell && !(m_spellInfo->AttributesEx2 & SPELL_ATTR_EX2_IGNORE_LOS) &&
+                !CanTargetNotInLOS(m_spellInfo, i) && IsAreaOfEffectSpell(m_spellInfo))
+                m_caster->GetMap()->PrefetchLineOfSight(m_caster, unitList);
+
             for (std::list<Unit*>::iterator itr = unitList.begin(); itr != unitList.end(); ++itr)
                 AddUnitTarget(*itr, i);
         }
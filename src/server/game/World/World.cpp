@@ -60,6 +60,9 @@
 #include "CreatureEventAIMgr.h"
 #include "ScriptMgr.h"
 #include "WardenDataStorage.h"
+#include "OpcodeStats.h"
+#include "TickTracer.h"
+#include "MappedFile.h"
 
 volatile bool World::m_stopEvent = false;
 uint8 World::m_ExitCode = SHUTDOWN_EXIT_CODE;
@@ -73,6 +76,8 @@ float World::m_MaxVisibleDistanceForObject    = DEFAULT_VISIBILITY_DISTANCE;
 float World::m_MaxVisibleDistanceInFlight     = DEFAULT_VISIBILITY_DISTANCE;
 float World::m_VisibleUnitGreyDistance        = 0;
 float World::m_VisibleObjectGreyDistance      = 0;
+float World::m_InterestEnterDistance          = 0;
+float World::m_InterestLeaveDistance          = 0;
 
 int32 World::m_visibility_notify_periodOnContinents = DEFAULT_VISIBILITY_NOTIFY_PERIOD;
 int32 World::m_visibility_notify_periodInInstances  = DEFAULT_VISIBILITY_NOTIFY_PERIOD;
@@ -102,6 +107,16 @@ World::World()
 
     m_updateTimeSum = 0;
     m_updateTimeCount = 0;
+    m_lastTickTraceDump = 0;
+
+    memset(m_loginLatency, 0, sizeof(m_loginLatency));
+    m_loginCount = 0;
+    m_loginQueryTimeSum = 0;
+    m_loginTimeSum = 0;
+
+    m_characterSaveCount = 0;
+    m_characterSaveRows = 0;
+    m_characterSaveBytes = 0;
 }
 
 // World destructor
@@ -1031,6 +1046,23 @@ void World::LoadConfigSettings(bool reload)
         m_MaxVisibleDistanceInFlight = MAX_VISIBILITY_DISTANCE - m_VisibleObjectGreyDistance;
     }
 
+    // interest management in crowded maps
+    m_configs[CONFIG_INTEREST_MANAGEMENT_PLAYERS] = ConfigMgr::GetIntDefault("Visibility.InterestManagement.Players", 0);
+    m_configs[CONFIG_INTEREST_MANAGEMENT_MAX_UNITS] = ConfigMgr::GetIntDefault("Visibility.InterestManagement.MaxUnits", 100);
+    m_configs[CONFIG_INTEREST_MANAGEMENT_CREATE_BYTES] = ConfigMgr::GetIntDefault("Visibility.InterestManagement.CreateBytes", 16384);
+    m_InterestEnterDistance = ConfigMgr::GetFloatDefault("Visibility.InterestManagement.EnterDistance", 60.0f);
+    if (m_InterestEnterDistance < 45*sWorld->getRate(RATE_CREATURE_AGGRO))
+    {
+        sLog->outError("Visibility.InterestManagement.EnterDistance can't be less max aggro radius %f", 45*sWorld->getRate(RATE_CREATURE_AGGRO));
+        m_InterestEnterDistance = 45*sWorld->getRate(RATE_CREATURE_AGGRO);
+    }
+    m_InterestLeaveDistance = ConfigMgr::GetFloatDefault("Visibility.InterestManagement.LeaveDistance", 80.0f);
+    if (m_InterestLeaveDistance < m_InterestEnterDistance)
+    {
+        sLog->outError("Visibility.InterestManagement.LeaveDistance can't be less than Visibility.InterestManagement.EnterDistance %f", m_InterestEnterDistance);
+        m_InterestLeaveDistance = m_InterestEnterDistance;
+    }
+
     ///- Load the CharDelete related config options
     m_configs[CONFIG_CHARDELETE_METHOD] = ConfigMgr::GetIntDefault("CharDelete.Method", 0);
     m_configs[CONFIG_CHARDELETE_MIN_LEVEL] = ConfigMgr::GetIntDefault("CharDelete.MinLevel", 0);
@@ -1056,11 +1088,16 @@ void World::LoadConfigSettings(bool reload)
         sLog->outString("Using DataDir %s", m_dataPath.c_str());
     }
 
+    // takes effect for the .map and .mmtile files loaded from now on
+    MappedFile::SetMappingEnabled(ConfigMgr::GetBoolDefault("MemoryMappedDataFiles", true));
+
     bool enableIndoor = ConfigMgr::GetBoolDefault("vmap.enableIndoorCheck", true);
     bool enableLOS = ConfigMgr::GetBoolDefault("vmap.enableLOS", true);
     bool enableHeight = ConfigMgr::GetBoolDefault("vmap.enableHeight", true);
     bool enablePetLOS = ConfigMgr::GetBoolDefault("vmap.petLOS", true);
     std::string ignoreSpellIds = ConfigMgr::GetStringDefault("vmap.ignoreSpellIds", "");
+    bool enableSimd = ConfigMgr::GetBoolDefault("vmap.enableSimd", true);
+    std::string losRecordFile = ConfigMgr::GetStringDefault("vmap.losRecordFile", "");
 
     if (!enableHeight)
         sLog->outError("VMap height checking disabled! Creatures movements and other various things WILL be broken! Expect no support.");
@@ -1068,11 +1105,18 @@ void World::LoadConfigSettings(bool reload)
     VMAP::VMapFactory::createOrGetVMapManager()->setEnableLineOfSightCalc(enableLOS);
     VMAP::VMapFactory::createOrGetVMapManager()->setEnableHeightCalc(enableHeight);
     VMAP::VMapFactory::preventSpellsFromBeingTestedForLoS(ignoreSpellIds.c_str());
+    VMAP::VMapFactory::createOrGetVMapManager()->setEnableRaySimd(enableSimd);
+    if (!VMAP::VMapFactory::createOrGetVMapManager()->setLineOfSightRecordFile(losRecordFile))
+        sLog->outError("VMap line of sight queries can not be recorded to %s", losRecordFile.c_str());
+    else if (!losRecordFile.empty())
+        sLog->outString("WORLD: Recording line of sight queries to %s", losRecordFile.c_str());
     sLog->outString("WORLD: VMap support included. LineOfSight:%i, getHeight:%i, indoorCheck:%i, PetLOS:%i", enableLOS, enableHeight, enableIndoor, enablePetLOS);
     sLog->outString("WORLD: VMap data directory is: %svmaps", m_dataPath.c_str());
 
     m_configs[CONFIG_VMAP_INDOOR_CHECK] = enableIndoor;
     m_configs[CONFIG_PET_LOS] = enablePetLOS;
+    m_configs[CONFIG_LOS_CACHE_SIZE] = ConfigMgr::GetIntDefault("vmap.losCacheSize", 4096);
+    m_configs[CONFIG_LOS_CACHE_TIME] = ConfigMgr::GetIntDefault("vmap.losCacheTime", 500);
     m_configs[CONFIG_VMAP_TOTEM] = ConfigMgr::GetBoolDefault("vmap.totem", false);
     m_configs[CONFIG_MAX_WHO] = ConfigMgr::GetIntDefault("MaxWhoListReturns", 49);
 
@@ -1094,7 +1138,25 @@ void World::LoadConfigSettings(bool reload)
     m_configs[CONFIG_SHOW_KICK_IN_WORLD] = ConfigMgr::GetBoolDefault("ShowKickInWorld", false);
     m_configs[CONFIG_INTERVAL_LOG_UPDATE] = ConfigMgr::GetIntDefault("RecordUpdateTimeDiffInterval", 60000);
     m_configs[CONFIG_MIN_LOG_UPDATE] = ConfigMgr::GetIntDefault("MinRecordUpdateTimeDiff", 100);
+
+    // diagnostics
+    m_configs[CONFIG_OPCODE_STATS_INTERVAL] = ConfigMgr::GetIntDefault("OpcodeStats.Interval", 60);
+    sTickTracer->SetEnabled(ConfigMgr::GetBoolDefault("Trace.Enable", false));
+    m_configs[CONFIG_TICK_TRACE_BUDGET] = ConfigMgr::GetIntDefault("Trace.TickBudget", 150);
+    m_configs[CONFIG_TICK_TRACE_WINDOW] = ConfigMgr::GetIntDefault("Trace.Window", 5);
+
     m_configs[CONFIG_NUMTHREADS] = ConfigMgr::GetIntDefault("MapUpdate.Threads", 1);
+
+    std::string parallelCellMaps = ConfigMgr::GetStringDefault("MapUpdate.ParallelCells.Maps", "");
+    m_parallelCellUpdateMapIds.clear();
+    if (!parallelCellMaps.empty())
+    {
+        unsigned int pos = 0;
+        unsigned int id;
+        VMAP::VMapFactory::chompAndTrim(parallelCellMaps);
+        while (VMAP::VMapFactory::getNextId(parallelCellMaps, pos, id))
+            m_parallelCellUpdateMapIds.insert(id);
+    }
     m_configs[CONFIG_DUEL_MOD] = ConfigMgr::GetBoolDefault("DuelMod.Enable", false);
     m_configs[CONFIG_DUEL_CD_RESET] = ConfigMgr::GetBoolDefault("DuelMod.Cooldowns", false);
     m_configs[CONFIG_AUTOBROADCAST_TIMER] = ConfigMgr::GetIntDefault("AutoBroadcast.Timer", 60000);
@@ -1142,6 +1204,9 @@ void World::LoadConfigSettings(bool reload)
 
     // mmaps
     m_configs[CONFIG_BOOL_MMAP_ENABLED] = ConfigMgr::GetBoolDefault("mmap.enable", true);
+    m_configs[CONFIG_PATHFINDING_TICK_BUDGET] = ConfigMgr::GetIntDefault("Pathfinding.TickBudget", 0);
+    m_configs[CONFIG_PATHFINDING_CACHE_SIZE] = ConfigMgr::GetIntDefault("Pathfinding.CacheSize", 512);
+    m_configs[CONFIG_PATHFINDING_CACHE_TIME] = ConfigMgr::GetIntDefault("Pathfinding.CacheTime", 5000);
 
     // misc
     m_configs[CONFIG_FREE_ALLY_TRANSFER] = ConfigMgr::GetBoolDefault("Transfer.FreeForAlliance", false);
@@ -1512,6 +1577,7 @@ void World::SetInitialWorldSettings()
                                                             //erase corpses every 20 minutes
     m_timers[WUPDATE_CLEANDB].SetInterval(m_configs[CONFIG_LOGDB_CLEARINTERVAL]*MINUTE*IN_MILLISECONDS);
                                                             // clean logs table every 14 days by default
+    m_timers[WUPDATE_OPCODE_STATS].SetInterval(m_configs[CONFIG_OPCODE_STATS_INTERVAL]*IN_MILLISECONDS);
 
     //to set mailtimer to return mails every day between 4 and 5 am
     //mailtimer is increased when updating auctions
@@ -1812,6 +1878,14 @@ void World::Update(time_t diff)
     UpdateResultQueue();
     RecordTimeDiff("UpdateResultQueue");
 
+    // dump the opcode handler counters
+    if (m_configs[CONFIG_OPCODE_STATS_INTERVAL] && m_timers[WUPDATE_OPCODE_STATS].Passed())
+    {
+        m_timers[WUPDATE_OPCODE_STATS].Reset();
+        sOpcodeStats->Merge();
+        sOpcodeStats->WriteFile();
+    }
+
     // Erase corpses once every 20 minutes
     if (m_timers[WUPDATE_CORPSES].Passed())
     {
@@ -1835,6 +1909,30 @@ void World::Update(time_t diff)
     ProcessCliCommands();
 }
 
+void World::CheckTickBudget(uint32 tickTime)
+{
+    if (!sTickTracer->IsEnabled() || tickTime < m_configs[CONFIG_TICK_TRACE_BUDGET])
+        return;
+
+    // one dump per window, it already holds the slow ticks that follow closely
+    uint32 window = m_configs[CONFIG_TICK_TRACE_WINDOW] * IN_MILLISECONDS;
+    if (m_lastTickTraceDump && getMSTimeDiff(m_lastTickTraceDump, getMSTime()) < window)
+        return;
+    m_lastTickTraceDump = getMSTime();
+
+    std::string logsDir = ConfigMgr::GetStringDefault("LogsDir", "");
+    if (!logsDir.empty() && logsDir.at(logsDir.length()-1) != '/' && logsDir.at(logsDir.length()-1) != '\\')
+        logsDir.append("/");
+
+    std::ostringstream fileName;
+    fileName << logsDir << ConfigMgr::GetStringDefault("Trace.File", "tick_trace") << "_" << uint64(time(NULL)) << ".json";
+
+    if (sTickTracer->Dump(fileName.str(), window))
+        sLog->outString("World update took %u ms, trace of the last %u ms written to %s", tickTime, window, fileName.str().c_str());
+    else
+        sLog->outError("World update took %u ms, can't write the trace to %s", tickTime, fileName.str().c_str());
+}
+
 void World::ForceGameEventUpdate()
 {
     m_timers[WUPDATE_EVENTS].Reset();                   // to give time for Update() to be processed
@@ -1846,6 +1944,7 @@ void World::ForceGameEventUpdate()
 // Send a packet to all players (except self if mentioned)
 void World::SendGlobalMessage(WorldPacket *packet, WorldSession *self, uint32 team)
 {
+    WorldPacketPtr shared;
     SessionMap::iterator itr;
     for (itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
     {
@@ -1855,7 +1954,7 @@ void World::SendGlobalMessage(WorldPacket *packet, WorldSession *self, uint32 te
             itr->second != self &&
             (team == 0 || itr->second->GetPlayer()->GetTeam() == team))
         {
-            itr->second->SendPacket(packet);
+            itr->second->SendPacket(packet, &shared);
         }
     }
 }
@@ -2275,6 +2374,8 @@ void World::SendServerMessage(ServerMessageType type, const char *text, Player*
 
 void World::UpdateSessions(time_t diff)
 {
+    TRACE_SPAN("World::UpdateSessions");
+
     // Add new sessions
     WorldSession* sess;
     while (addSessQueue.next(sess))
@@ -2290,7 +2391,10 @@ void World::UpdateSessions(time_t diff)
             continue;
 
         // and remove not active sessions from the list
-        if (!itr->second->Update(diff))                      // As interval = 0
+        WorldSession* pSession = itr->second;
+        WorldSessionFilter updater(pSession);
+
+        if (!pSession->Update(diff, updater))                // As interval = 0
         {
             if (!RemoveQueuedPlayer(itr->second) && itr->second && getConfig(CONFIG_INTERVAL_DISCONNECT_TOLERANCE))
                 m_disconnects[itr->second->GetAccountId()] = time(NULL);
@@ -2364,6 +2468,7 @@ void World::InitResultQueue()
 
 void World::UpdateResultQueue()
 {
+    TRACE_SPAN("World::UpdateResultQueue");
     m_resultQueue->Update();
 }
 
@@ -2458,6 +2563,25 @@ void World::UpdateMaxSessionCounters()
     m_maxQueuedSessionCount = std::max(m_maxQueuedSessionCount, uint32(m_QueuedPlayer.size()));
 }
 
+void World::RecordLoginLatency(uint32 queryTime, uint32 totalTime)
+{
+    uint8 bucket = 0;
+    while (bucket < LOGIN_LATENCY_BUCKETS - 1 && totalTime >= LoginLatencyBucketLimits[bucket])
+        ++bucket;
+
+    ++m_loginLatency[bucket];
+    ++m_loginCount;
+    m_loginQueryTimeSum += queryTime;
+    m_loginTimeSum += totalTime;
+}
+
+void World::RecordCharacterSave(uint32 rows, uint32 bytes)
+{
+    ++m_characterSaveCount;
+    m_characterSaveRows += rows;
+    m_characterSaveBytes += bytes;
+}
+
 void World::LoadDBVersion()
 {
     QueryResult_AutoPtr result = WorldDatabase.Query("SELECT db_version FROM version LIMIT 1");
@@ -42,6 +42,10 @@ class QueryResult;
 class WorldSocket;
 
 // ServerMessages.dbc
+// login latency histogram, upper bounds in ms of all but the last bucket
+#define LOGIN_LATENCY_BUCKETS 8
+static const uint32 LoginLatencyBucketLimits[LOGIN_LATENCY_BUCKETS - 1] = { 50, 100, 250, 500, 1000, 2500, 5000 };
+
 enum ServerMessageType
 {
     SERVER_MSG_SHUTDOWN_TIME      = 1,
@@ -76,7 +80,8 @@ enum WorldTimers
     WUPDATE_EVENTS      = 6,
     WUPDATE_CLEANDB     = 7,
     WUPDATE_AUTOBROADCAST = 8,
-    WUPDATE_COUNT       = 9
+    WUPDATE_OPCODE_STATS = 9,
+    WUPDATE_COUNT       = 10
 };
 
 // Configuration elements
@@ -279,7 +284,18 @@ enum WorldConfigs
     CONFIG_WARDEN_CLIENT_CHECK_HOLDOFF,
     CONFIG_WARDEN_CLIENT_RESPONSE_DELAY,
     CONFIG_BOOL_MMAP_ENABLED,
+    CONFIG_PATHFINDING_TICK_BUDGET,
+    CONFIG_PATHFINDING_CACHE_SIZE,
+    CONFIG_PATHFINDING_CACHE_TIME,
+    CONFIG_LOS_CACHE_SIZE,
+    CONFIG_LOS_CACHE_TIME,
     CONFIG_FREE_ALLY_TRANSFER,
+    CONFIG_INTEREST_MANAGEMENT_PLAYERS,
+    CONFIG_INTEREST_MANAGEMENT_MAX_UNITS,
+    CONFIG_INTEREST_MANAGEMENT_CREATE_BYTES,
+    CONFIG_OPCODE_STATS_INTERVAL,
+    CONFIG_TICK_TRACE_BUDGET,
+    CONFIG_TICK_TRACE_WINDOW,
     CONFIG_VALUE_COUNT
 };
 
@@ -471,6 +487,19 @@ class World
         // Get the maximum number of parallel sessions on the server since last reboot
         uint32 GetMaxQueuedSessionCount() const { return m_maxQueuedSessionCount; }
         uint32 GetMaxActiveSessionCount() const { return m_maxActiveSessionCount; }
+
+        // Time from CMSG_PLAYER_LOGIN until the player is in world, queryTime of it spent waiting for the login queries
+        void RecordLoginLatency(uint32 queryTime, uint32 totalTime);
+        uint32 GetLoginCount() const { return m_loginCount; }
+        uint32 GetLoginLatencyCount(uint8 bucket) const { return m_loginLatency[bucket]; }
+        uint32 GetAverageLoginQueryTime() const { return m_loginCount ? uint32(m_loginQueryTimeSum / m_loginCount) : 0; }
+        uint32 GetAverageLoginTime() const { return m_loginCount ? uint32(m_loginTimeSum / m_loginCount) : 0; }
+
+        // Rows and bytes written by one Player::SaveToDB, called from the map threads
+        void RecordCharacterSave(uint32 rows, uint32 bytes);
+        uint64 GetCharacterSaveCount() const { return m_characterSaveCount.value(); }
+        uint64 GetCharacterSaveRows() const { return m_characterSaveRows.value(); }
+        uint64 GetCharacterSaveBytes() const { return m_characterSaveBytes.value(); }
         Player* FindPlayerInZone(uint32 zone);
 
         Weather* FindWeather(uint32 id) const;
@@ -596,6 +625,9 @@ class World
 
         bool IsAllowedMap(uint32 mapid) { return m_forbiddenMapIds.count(mapid) == 0 ;}
 
+        // Maps whose active cells are split into independent regions and updated in parallel
+        bool IsParallelCellUpdateMap(uint32 mapid) const { return m_parallelCellUpdateMapIds.count(mapid) != 0; }
+
         // for max speed access
         static float GetMaxVisibleDistanceOnContinents()    { return m_MaxVisibleDistanceOnContinents; }
         static float GetMaxVisibleDistanceInInstances()     { return m_MaxVisibleDistanceInInstances;  }
@@ -605,6 +637,8 @@ class World
         static float GetMaxVisibleDistanceInFlight()        { return m_MaxVisibleDistanceInFlight;     }
         static float GetVisibleUnitGreyDistance()           { return m_VisibleUnitGreyDistance;        }
         static float GetVisibleObjectGreyDistance()         { return m_VisibleObjectGreyDistance;      }
+        static float GetInterestEnterDistance()             { return m_InterestEnterDistance;          }
+        static float GetInterestLeaveDistance()             { return m_InterestLeaveDistance;          }
 
         static int32 GetVisibilityNotifyPeriodOnContinents(){ return m_visibility_notify_periodOnContinents; }
         static int32 GetVisibilityNotifyPeriodInInstances() { return m_visibility_notify_periodInInstances;  }
@@ -635,6 +669,8 @@ class World
         char const* GetScriptsVersion() { return m_ScriptsVersion.c_str(); }
 
         void RecordTimeDiff(const char * text, ...);
+        // dumps the tick trace when a world update took longer than Trace.TickBudget
+        void CheckTickBudget(uint32 tickTime);
         void LoadAutobroadcasts();
     protected:
         void _UpdateGameTime();
@@ -661,6 +697,7 @@ class World
         uint32 m_updateTime, m_updateTimeSum;
         uint32 m_updateTimeCount;
         uint32 m_currentTime;
+        uint32 m_lastTickTraceDump;
 
         typedef UNORDERED_MAP<uint32, Weather*> WeatherMap;
         WeatherMap m_weathers;
@@ -673,6 +710,15 @@ class World
         uint32 m_PlayerCount;
         uint32 m_MaxPlayerCount;
 
+        uint32 m_loginLatency[LOGIN_LATENCY_BUCKETS];
+        uint32 m_loginCount;
+        uint64 m_loginQueryTimeSum;
+        uint64 m_loginTimeSum;
+
+        ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_characterSaveCount;
+        ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_characterSaveRows;
+        ACE_Atomic_Op<ACE_Thread_Mutex, uint64> m_characterSaveBytes;
+
         std::string m_newCharString;
 
         float rate_values[MAX_RATES];
@@ -686,6 +732,7 @@ class World
         std::string m_motd;
         std::string m_dataPath;
         std::set<uint32> m_forbiddenMapIds;
+        std::set<uint32> m_parallelCellUpdateMapIds;
 
         // List of Maps that should be force-loaded on startup
         std::set<uint32>* m_configForceLoadMapIds;
@@ -699,6 +746,8 @@ class World
         static float m_MaxVisibleDistanceInFlight;
         static float m_VisibleUnitGreyDistance;
         static float m_VisibleObjectGreyDistance;
+        static float m_InterestEnterDistance;
+        static float m_InterestLeaveDistance;
 
         static int32 m_visibility_notify_periodOnContinents;
         static int32 m_visibility_notify_periodInInstances;
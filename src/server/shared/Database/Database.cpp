@@ -26,15 +26,24 @@
 #include "Threading.h"
 #include "SqlDelayThread.h"
 #include "SqlOperations.h"
+#include "PreparedStatements.h"
 #include "Timer.h"
 
+#ifdef _WIN32
+  #include <errmsg.h>
+  #include <mysqld_error.h>
+#else
+  #include <mysql/errmsg.h>
+  #include <mysql/mysqld_error.h>
+#endif
+
 #include <ctime>
 #include <iostream>
 #include <fstream>
 
 size_t Database::db_count = 0;
 
-Database::Database() : mMysql(NULL)
+Database::Database() : m_threadBody(NULL), m_delayThread(NULL), m_workerConnection(NULL), m_nextConnection(0), mMysql(NULL)
 {
     // before first connection
     if (db_count++ == 0)
@@ -55,15 +64,15 @@ Database::~Database()
     if (m_delayThread)
         HaltDelayThread();
 
-    if (mMysql)
-        mysql_close(mMysql);
+    for (std::vector<SqlConnection*>::iterator itr = m_connections.begin(); itr != m_connections.end(); ++itr)
+        _CloseConnection(*itr);
 
     // Free Mysql library pointers for last ~DB
     if (--db_count == 0)
         mysql_library_end();
 }
 
-bool Database::Initialize(const char* infoString)
+bool Database::Initialize(const char* infoString, uint8 synchThreads)
 {
     // Enable logging of SQL commands (usally only GM commands)
     // (See method: PExecuteLog)
@@ -75,37 +84,54 @@ bool Database::Initialize(const char* infoString)
             m_logsDir.append("/");
     }
 
-    tranThread = NULL;
-    MYSQL* mysqlInit;
-    mysqlInit = mysql_init(NULL);
-    if (!mysqlInit)
-    {
-        sLog->outError("Could not initialize Mysql connection");
-        return false;
-    }
-
-    InitDelayThread();
-
     Tokens tokens = StrSplit(infoString, ";");
 
     Tokens::iterator iter;
 
-    std::string host, port_or_socket, user, password, database;
-    int port;
-    char const* unix_socket;
-
     iter = tokens.begin();
 
     if (iter != tokens.end())
-        host = *iter++;
+        m_host = *iter++;
     if (iter != tokens.end())
-        port_or_socket = *iter++;
+        m_portOrSocket = *iter++;
     if (iter != tokens.end())
-        user = *iter++;
+        m_user = *iter++;
     if (iter != tokens.end())
-        password = *iter++;
+        m_password = *iter++;
     if (iter != tokens.end())
-        database = *iter++;
+        m_database = *iter++;
+
+    for (uint8 i = 0; i < (synchThreads ? synchThreads : 1); ++i)
+    {
+        MYSQL* mysql = _Connect();
+        if (!mysql)
+            return false;
+
+        m_connections.push_back(new SqlConnection(mysql));
+    }
+
+    mMysql = m_connections.front()->mMysql;
+
+    sLog->outString("MySQL client library: %s", mysql_get_client_info());
+    sLog->outString("MySQL server ver: %s ", mysql_get_server_info(mMysql));
+
+    InitDelayThread();
+    return m_delayThread != NULL;
+}
+
+MYSQL* Database::_Connect()
+{
+    MYSQL* mysqlInit;
+    mysqlInit = mysql_init(NULL);
+    if (!mysqlInit)
+    {
+        sLog->outError("Could not initialize Mysql connection");
+        return NULL;
+    }
+
+    std::string host = m_host;
+    int port;
+    char const* unix_socket;
 
     mysql_options(mysqlInit, MYSQL_SET_CHARSET_NAME, "utf8");
     #ifdef _WIN32
@@ -118,7 +144,7 @@ bool Database::Initialize(const char* infoString)
     }
     else     // generic case
     {
-        port = atoi(port_or_socket.c_str());
+        port = atoi(m_portOrSocket.c_str());
         unix_socket = 0;
     }
     #else
@@ -128,51 +154,109 @@ bool Database::Initialize(const char* infoString)
         mysql_options(mysqlInit, MYSQL_OPT_PROTOCOL, (char const*)&opt);
         host = "localhost";
         port = 0;
-        unix_socket = port_or_socket.c_str();
+        unix_socket = m_portOrSocket.c_str();
     }
     else     // generic case
     {
-        port = atoi(port_or_socket.c_str());
+        port = atoi(m_portOrSocket.c_str());
         unix_socket = 0;
     }
     #endif
 
-    mMysql = mysql_real_connect(mysqlInit, host.c_str(), user.c_str(),
-        password.c_str(), database.c_str(), port, unix_socket, 0);
+    MYSQL* mysql = mysql_real_connect(mysqlInit, host.c_str(), m_user.c_str(),
+        m_password.c_str(), m_database.c_str(), port, unix_socket, 0);
 
-    if (mMysql)
+    if (!mysql)
     {
-        sLog->outDetail("Connected to MySQL database at %s", host.c_str());
-        sLog->outString("MySQL client library: %s", mysql_get_client_info());
-        sLog->outString("MySQL server ver: %s ", mysql_get_server_info(mMysql));
+        sLog->outError("Could not connect to MySQL database at %s\n", host.c_str());
+        mysql_close(mysqlInit);
+        return NULL;
+    }
 
-        if (!mysql_autocommit(mMysql, 1))
-            sLog->outDetail("AUTOCOMMIT SUCCESSFULLY SET TO 1");
-        else
-            sLog->outDetail("AUTOCOMMIT NOT SET TO 1");
+    sLog->outDetail("Connected to MySQL database at %s", host.c_str());
 
-        // set connection properties to UTF8 to properly handle locales for different
-        // server configs - core sends data in UTF8, so MySQL must expect UTF8 too
-        PExecute("SET NAMES `utf8`");
-        PExecute("SET CHARACTER SET `utf8`");
+    if (!mysql_autocommit(mysql, 1))
+        sLog->outDetail("AUTOCOMMIT SUCCESSFULLY SET TO 1");
+    else
+        sLog->outDetail("AUTOCOMMIT NOT SET TO 1");
 
-    #if MYSQL_VERSION_ID >= 50003
-        my_bool my_true = (my_bool) 1;
-        if (mysql_options(mMysql, MYSQL_OPT_RECONNECT, &my_true))
-            sLog->outDetail("Failed to turn on MYSQL_OPT_RECONNECT.");
-        else
-           sLog->outDetail("Successfully turned on MYSQL_OPT_RECONNECT.");
-    #else
-        #warning "Your mySQL client lib version does not support reconnecting after a timeout.\nIf this causes you any trouble we advice you to upgrade your mySQL client libs to at least mySQL 6.0 to resolve this problem."
-    #endif
-        return true;
-    }
+    // set connection properties to UTF8 to properly handle locales for different
+    // server configs - core sends data in UTF8, so MySQL must expect UTF8 too
+    mysql_query(mysql, "SET NAMES `utf8`");
+    mysql_query(mysql, "SET CHARACTER SET `utf8`");
+
+#if MYSQL_VERSION_ID >= 50003
+    my_bool my_true = (my_bool) 1;
+    if (mysql_options(mysql, MYSQL_OPT_RECONNECT, &my_true))
+        sLog->outDetail("Failed to turn on MYSQL_OPT_RECONNECT.");
     else
+        sLog->outDetail("Successfully turned on MYSQL_OPT_RECONNECT.");
+#else
+    #warning "Your mySQL client lib version does not support reconnecting after a timeout.\nIf this causes you any trouble we advice you to upgrade your mySQL client libs to at least mySQL 6.0 to resolve this problem."
+#endif
+
+    return mysql;
+}
+
+void Database::_CloseConnection(SqlConnection* conn)
+{
+    for (std::vector<MYSQL_STMT*>::iterator itr = conn->stmts.begin(); itr != conn->stmts.end(); ++itr)
+        if (*itr)
+            mysql_stmt_close(*itr);
+
+    mysql_close(conn->mMysql);
+    delete conn;
+}
+
+SqlConnection* Database::_AcquireConnection()
+{
+    ACE_Based::Thread* thread = ACE_Based::Thread::current();
+
+    size_t count = m_connections.size();
+    size_t start;
     {
-        sLog->outError("Could not connect to MySQL database at %s\n", host.c_str());
-        mysql_close(mysqlInit);
-        return false;
+        ACE_Guard<ACE_Thread_Mutex> guard(m_pinLock);
+
+        // delay threads and threads inside a direct transaction keep their own connection
+        PinnedConnections::const_iterator itr = m_pinnedConnections.find(thread);
+        if (itr != m_pinnedConnections.end())
+            return itr->second;
+
+        start = m_nextConnection++;
+    }
+
+    // take the first idle connection, only wait if all of them are busy
+    for (size_t i = 0; i < count; ++i)
+    {
+        SqlConnection* conn = m_connections[(start + i) % count];
+        if (conn->mutex.tryacquire() != -1)
+            return conn;
     }
+
+    SqlConnection* conn = m_connections[start % count];
+    conn->mutex.acquire();
+    return conn;
+}
+
+void Database::_ReleaseConnection(SqlConnection* conn)
+{
+    // pinned connections stay with their thread
+    if (!conn->owner)
+        conn->mutex.release();
+}
+
+void Database::_PinConnection(SqlConnection* conn)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_pinLock);
+    conn->owner = ACE_Based::Thread::current();
+    m_pinnedConnections[conn->owner] = conn;
+}
+
+void Database::_UnpinConnection(SqlConnection* conn)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_pinLock);
+    m_pinnedConnections.erase(conn->owner);
+    conn->owner = NULL;
 }
 
 void Database::ThreadStart()
@@ -259,15 +343,16 @@ bool Database::_Query(const char *sql, MYSQL_RES **pResult, MYSQL_FIELD **pField
         return 0;
 
     {
-        // guarded block for thread-safe mySQL request
-        ACE_Guard<ACE_Thread_Mutex> query_connection_guard(mMutex);
+        // the connection is ours until released
+        SqlConnection* conn = _AcquireConnection();
         #ifdef TRINITY_DEBUG
         uint32 _s = getMSTime();
         #endif
-        if (mysql_query(mMysql, sql))
+        if (mysql_query(conn->mMysql, sql))
         {
             sLog->outErrorDb("SQL: %s", sql);
-            sLog->outErrorDb("query ERROR: %s", mysql_error(mMysql));
+            sLog->outErrorDb("query ERROR: %s", mysql_error(conn->mMysql));
+            _ReleaseConnection(conn);
             return false;
         }
         else
@@ -277,9 +362,10 @@ bool Database::_Query(const char *sql, MYSQL_RES **pResult, MYSQL_FIELD **pField
             #endif
         }
 
-        *pResult = mysql_store_result(mMysql);
-        *pRowCount = mysql_affected_rows(mMysql);
-        *pFieldCount = mysql_field_count(mMysql);
+        *pResult = mysql_store_result(conn->mMysql);
+        *pRowCount = mysql_affected_rows(conn->mMysql);
+        *pFieldCount = mysql_field_count(conn->mMysql);
+        _ReleaseConnection(conn);
     }
 
     if (!*pResult )
@@ -373,6 +459,204 @@ QueryNamedResult* Database::PQueryNamed(const char* format, ...)
     return QueryNamed(szQuery);
 }
 
+void Database::PrepareStatement(uint32 index, const char* sql)
+{
+    if (m_preparedQueries.size() <= index)
+        m_preparedQueries.resize(index + 1);
+
+    m_preparedQueries[index] = sql;
+}
+
+PreparedStatement* Database::GetPreparedStatement(uint32 index)
+{
+    return new PreparedStatement(index);
+}
+
+MYSQL_STMT* Database::_GetStatement(SqlConnection* conn, uint32 index)
+{
+    if (index >= m_preparedQueries.size() || m_preparedQueries[index].empty())
+    {
+        sLog->outError("SQL: prepared statement %u is not registered", index);
+        return NULL;
+    }
+
+    if (conn->stmts.size() < m_preparedQueries.size())
+        conn->stmts.resize(m_preparedQueries.size(), NULL);
+
+    if (conn->stmts[index])
+        return conn->stmts[index];
+
+    std::string const& sql = m_preparedQueries[index];
+
+    MYSQL_STMT* stmt = mysql_stmt_init(conn->mMysql);
+    if (!stmt)
+    {
+        sLog->outErrorDb("SQL: %s", sql.c_str());
+        sLog->outErrorDb("SQL ERROR: %s", mysql_error(conn->mMysql));
+        return NULL;
+    }
+
+    if (mysql_stmt_prepare(stmt, sql.c_str(), sql.length()))
+    {
+        sLog->outErrorDb("SQL: %s", sql.c_str());
+        sLog->outErrorDb("SQL ERROR: %s", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        return NULL;
+    }
+
+    // needed by PreparedQueryResult to size the string buffers
+    my_bool updateMaxLength = 1;
+    mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+
+    conn->stmts[index] = stmt;
+    return stmt;
+}
+
+MYSQL_STMT* Database::_ExecuteStatement(SqlConnection* conn, PreparedStatement* stmt)
+{
+    std::vector<MYSQL_BIND> binds;
+    stmt->BindParameters(binds);
+
+    for (uint8 attempt = 0; attempt < 2; ++attempt)
+    {
+        MYSQL_STMT* mStmt = _GetStatement(conn, stmt->GetIndex());
+        if (!mStmt)
+            return NULL;
+
+        if (mysql_stmt_param_count(mStmt) != binds.size())
+        {
+            sLog->outErrorDb("SQL: prepared statement %u expects %u parameters, %u given", stmt->GetIndex(),
+                uint32(mysql_stmt_param_count(mStmt)), uint32(binds.size()));
+            return NULL;
+        }
+
+        #ifdef TRINITY_DEBUG
+        uint32 _s = getMSTime();
+        #endif
+        if ((binds.empty() || !mysql_stmt_bind_param(mStmt, &binds[0])) && !mysql_stmt_execute(mStmt))
+        {
+            #ifdef TRINITY_DEBUG
+            sLog->outDebug("[%u ms] SQL prepared statement %u: %s", getMSTimeDiff(_s, getMSTime()), stmt->GetIndex(), m_preparedQueries[stmt->GetIndex()].c_str());
+            #endif
+            return mStmt;
+        }
+
+        uint32 error = mysql_stmt_errno(mStmt);
+
+        // a reconnect drops all statements of the old session, prepare them again once
+        if (attempt == 0 && (error == CR_SERVER_GONE_ERROR || error == CR_SERVER_LOST || error == ER_UNKNOWN_STMT_HANDLER))
+        {
+            for (std::vector<MYSQL_STMT*>::iterator itr = conn->stmts.begin(); itr != conn->stmts.end(); ++itr)
+            {
+                if (*itr)
+                    mysql_stmt_close(*itr);
+                *itr = NULL;
+            }
+
+            mysql_ping(conn->mMysql);
+            continue;
+        }
+
+        sLog->outErrorDb("SQL: %s", m_preparedQueries[stmt->GetIndex()].c_str());
+        sLog->outErrorDb("SQL ERROR: %s", mysql_stmt_error(mStmt));
+        return NULL;
+    }
+
+    return NULL;
+}
+
+QueryResult_AutoPtr Database::Query(PreparedStatement* stmt)
+{
+    if (!mMysql)
+    {
+        delete stmt;
+        return QueryResult_AutoPtr(NULL);
+    }
+
+    QueryResult* queryResult = NULL;
+
+    {
+        // the connection is ours until released
+        SqlConnection* conn = _AcquireConnection();
+
+        MYSQL_STMT* mStmt = _ExecuteStatement(conn, stmt);
+        delete stmt;
+
+        if (!mStmt)
+        {
+            _ReleaseConnection(conn);
+            return QueryResult_AutoPtr(NULL);
+        }
+
+        MYSQL_RES* metadata = mysql_stmt_result_metadata(mStmt);
+        if (metadata && !mysql_stmt_store_result(mStmt))
+        {
+            uint64 rowCount = mysql_stmt_num_rows(mStmt);
+            if (rowCount)
+                queryResult = new PreparedQueryResult(mStmt, metadata, rowCount, mysql_stmt_field_count(mStmt));
+        }
+        else
+            sLog->outErrorDb("SQL ERROR: %s", mysql_stmt_error(mStmt));
+
+        if (metadata)
+            mysql_free_result(metadata);
+        mysql_stmt_free_result(mStmt);
+        _ReleaseConnection(conn);
+    }
+
+    if (!queryResult)
+        return QueryResult_AutoPtr(NULL);
+
+    // an empty result after fetching is no result, like for text queries
+    if (!queryResult->NextRow())
+    {
+        delete queryResult;
+        return QueryResult_AutoPtr(NULL);
+    }
+
+    return QueryResult_AutoPtr(queryResult);
+}
+
+bool Database::Execute(PreparedStatement* stmt)
+{
+    if (!mMysql)
+    {
+        delete stmt;
+        return false;
+    }
+
+    // don't use queued execution if it has not been initialized
+    if (!m_threadBody)
+        return DirectExecute(stmt);
+
+    nMutex.acquire();
+    ACE_Based::Thread* tranThread = ACE_Based::Thread::current();   // owner of this transaction
+    TransactionQueues::iterator i = m_tranQueues.find(tranThread);
+    if (i != m_tranQueues.end() && i->second != NULL)
+        i->second->DelayExecute(stmt);                      // Statement for transaction
+    else
+        m_threadBody->Delay(new SqlPreparedStatement(stmt));
+
+    nMutex.release();
+    return true;
+}
+
+bool Database::DirectExecute(PreparedStatement* stmt)
+{
+    if (!mMysql)
+    {
+        delete stmt;
+        return false;
+    }
+
+    SqlConnection* conn = _AcquireConnection();
+    bool res = _ExecuteStatement(conn, stmt) != NULL;
+    _ReleaseConnection(conn);
+
+    delete stmt;
+    return res;
+}
+
 bool Database::Execute(const char* sql)
 {
     if (!mMysql)
@@ -383,7 +667,7 @@ bool Database::Execute(const char* sql)
         return DirectExecute(sql);
 
     nMutex.acquire();
-    tranThread = ACE_Based::Thread::current();              // owner of this transaction
+    ACE_Based::Thread* tranThread = ACE_Based::Thread::current();   // owner of this transaction
     TransactionQueues::iterator i = m_tranQueues.find(tranThread);
     if (i != m_tranQueues.end() && i->second != NULL)
         i->second->DelayExecute(sql);                       // Statement for transaction
@@ -439,16 +723,17 @@ bool Database::DirectExecute(const char* sql)
         return false;
 
     {
-        // guarded block for thread-safe mySQL request
-        ACE_Guard<ACE_Thread_Mutex> query_connection_guard(mMutex);
+        // the connection is ours until released
+        SqlConnection* conn = _AcquireConnection();
 
         #ifdef TRINITY_DEBUG
         uint32 _s = getMSTime();
         #endif
-        if (mysql_query(mMysql, sql))
+        if (mysql_query(conn->mMysql, sql))
         {
             sLog->outErrorDb("SQL: %s", sql);
-            sLog->outErrorDb("SQL ERROR: %s", mysql_error(mMysql));
+            sLog->outErrorDb("SQL ERROR: %s", mysql_error(conn->mMysql));
+            _ReleaseConnection(conn);
             return false;
         }
         else
@@ -457,6 +742,7 @@ bool Database::DirectExecute(const char* sql)
             sLog->outDebug("[%u ms] SQL: %s", getMSTimeDiff(_s, getMSTime()), sql);
             #endif
         }
+        _ReleaseConnection(conn);
     }
 
     return true;
@@ -519,12 +805,12 @@ bool Database::CheckRequiredField(char const* table_name, char const* required_n
     return false;
 }
 
-bool Database::_TransactionCmd(const char* sql)
+bool Database::_TransactionCmd(SqlConnection* conn, const char* sql)
 {
-    if (mysql_query(mMysql, sql))
+    if (mysql_query(conn->mMysql, sql))
     {
         sLog->outError("SQL: %s", sql);
-        sLog->outError("SQL ERROR: %s", mysql_error(mMysql));
+        sLog->outError("SQL ERROR: %s", mysql_error(conn->mMysql));
         return false;
     }
     else
@@ -538,23 +824,27 @@ bool Database::BeginTransaction()
     if (!mMysql)
         return false;
 
+    ACE_Based::Thread* tranThread = ACE_Based::Thread::current();   // owner of this transaction
+
     // don't use queued execution if it has not been initialized
     if (!m_threadBody)
     {
-        if (tranThread == ACE_Based::Thread::current())
+        SqlConnection* conn = _AcquireConnection();
+        if (conn->owner == tranThread)
             return false;                                   // huh? this thread already started transaction
 
-        mMutex.acquire();
-        if (!_TransactionCmd("START TRANSACTION"))
+        // the connection stays with this thread until commit or rollback
+        _PinConnection(conn);
+        if (!_TransactionCmd(conn, "START TRANSACTION"))
         {
-            mMutex.release();                               // can't start transaction
+            _UnpinConnection(conn);
+            _ReleaseConnection(conn);                       // can't start transaction
             return false;
         }
         return true;                                        // transaction started
     }
 
     nMutex.acquire();
-    tranThread = ACE_Based::Thread::current();              // owner of this transaction
     TransactionQueues::iterator i = m_tranQueues.find(tranThread);
     if (i != m_tranQueues.end() && i->second != NULL)
         // If for thread exists queue and also contains transaction
@@ -572,21 +862,25 @@ bool Database::CommitTransaction()
         return false;
 
     bool _res = false;
+    ACE_Based::Thread* tranThread = ACE_Based::Thread::current();
 
     // don't use queued execution if it has not been initialized
     if (!m_threadBody)
     {
-        if (tranThread != ACE_Based::Thread::current())
+        SqlConnection* conn = _AcquireConnection();
+        if (conn->owner != tranThread)
+        {
+            _ReleaseConnection(conn);
             return false;
+        }
 
-        _res = _TransactionCmd("COMMIT");
-        tranThread = NULL;
-        mMutex.release();
+        _res = _TransactionCmd(conn, "COMMIT");
+        _UnpinConnection(conn);
+        _ReleaseConnection(conn);
         return _res;
     }
 
     nMutex.acquire();
-    tranThread = ACE_Based::Thread::current();
     TransactionQueues::iterator i = m_tranQueues.find(tranThread);
     if (i != m_tranQueues.end() && i->second != NULL)
     {
@@ -603,20 +897,25 @@ bool Database::RollbackTransaction()
     if (!mMysql)
         return false;
 
+    ACE_Based::Thread* tranThread = ACE_Based::Thread::current();
+
     // don't use queued execution if it has not been initialized
     if (!m_threadBody)
     {
-        if (tranThread != ACE_Based::Thread::current())
+        SqlConnection* conn = _AcquireConnection();
+        if (conn->owner != tranThread)
+        {
+            _ReleaseConnection(conn);
             return false;
+        }
 
-        bool _res = _TransactionCmd("ROLLBACK");
-        tranThread = NULL;
-        mMutex.release();
+        bool _res = _TransactionCmd(conn, "ROLLBACK");
+        _UnpinConnection(conn);
+        _ReleaseConnection(conn);
         return _res;
     }
 
     nMutex.acquire();
-    tranThread = ACE_Based::Thread::current();
     TransactionQueues::iterator i = m_tranQueues.find(tranThread);
     if (i != m_tranQueues.end() && i->second != NULL)
     {
@@ -632,8 +931,13 @@ void Database::InitDelayThread()
 {
     assert(!m_delayThread);
 
-    //New delay thread for delay execute
-    m_threadBody = new SqlDelayThread(this);              // will deleted at m_delayThread delete
+    //New delay thread for delay execute, with its own connection
+    MYSQL* mysql = _Connect();
+    if (!mysql)
+        return;
+
+    m_workerConnection = new SqlConnection(mysql);
+    m_threadBody = new SqlDelayThread(this, m_workerConnection);    // will deleted at m_delayThread delete
     m_delayThread = new ACE_Based::Thread(m_threadBody);
 }
 
@@ -647,5 +951,7 @@ void Database::HaltDelayThread()
     delete m_delayThread;                                   //This also deletes m_threadBody
     m_delayThread = NULL;
     m_threadBody = NULL;
-}
 
+    _CloseConnection(m_workerConnection);
+    m_workerConnection = NULL;
+}
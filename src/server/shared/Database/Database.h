@@ -27,6 +27,8 @@
 #include <ace/Thread_Mutex.h>
 #include <ace/Guard_T.h>
 
+#include <vector>
+
 #ifdef _WIN32
   #define FD_SETSIZE 1024
   #include <winsock2.h>
@@ -36,14 +38,29 @@
 class SqlTransaction;
 class SqlResultQueue;
 class SqlQueryHolder;
+class PreparedStatement;
+
+// one MySQL connection, either in the synchronous pool or owned by a delay thread
+struct SqlConnection
+{
+    SqlConnection(MYSQL* mysql) : mMysql(mysql), owner(NULL) {}
+
+    MYSQL* mMysql;
+    ACE_Thread_Mutex mutex;                                 // held while a synchronous query or direct transaction uses the connection
+    ACE_Based::Thread* owner;                               // thread the connection is pinned to, if any
+    std::vector<MYSQL_STMT*> stmts;                         // server side prepared statements, prepared on first use
+};
 
 typedef UNORDERED_MAP<ACE_Based::Thread*, SqlTransaction*> TransactionQueues;
 typedef UNORDERED_MAP<ACE_Based::Thread*, SqlResultQueue*> QueryQueues;
+typedef UNORDERED_MAP<ACE_Based::Thread*, SqlConnection*> PinnedConnections;
 
 #define MAX_QUERY_LEN   32*1024
 
 class Database
 {
+    friend class SqlDelayThread;
+
     protected:
         TransactionQueues m_tranQueues;                     ///< Transaction queues from diff. threads
         QueryQueues m_queryQueues;                          ///< Query queues from diff threads
@@ -55,8 +72,9 @@ class Database
         Database();
         ~Database();
 
-        /*! infoString should be formatted like hostname;username;password;database.*/
-        bool Initialize(const char* infoString);
+        /*! infoString should be formatted like hostname;username;password;database.
+            synchThreads connections serve synchronous queries, delayed statements run in order on one more connection. */
+        bool Initialize(const char* infoString, uint8 synchThreads = 1);
 
         void InitDelayThread();
         void HaltDelayThread();
@@ -66,6 +84,16 @@ class Database
         QueryNamedResult* QueryNamed(const char* sql);
         QueryNamedResult* PQueryNamed(const char* format,...) ATTR_PRINTF(2, 3);
 
+        /// Prepared statements, see PreparedStatements.h. The statement is deleted after execution.
+
+        // registers the sql of statement index, done once at startup before any of them is used
+        void PrepareStatement(uint32 index, const char* sql);
+        PreparedStatement* GetPreparedStatement(uint32 index);
+
+        QueryResult_AutoPtr Query(PreparedStatement* stmt);
+        bool Execute(PreparedStatement* stmt);
+        bool DirectExecute(PreparedStatement* stmt);
+
         /// Async queries and query holders, implemented in DatabaseImpl.h
 
         // Query / member
@@ -136,16 +164,34 @@ class Database
     private:
         bool m_logSQL;
         std::string m_logsDir;
-        ACE_Thread_Mutex mMutex;        // For thread safe operations between core and mySQL server
         ACE_Thread_Mutex nMutex;        // For thread safe operations on m_transQueues
+        ACE_Thread_Mutex m_pinLock;     // For thread safe operations on m_pinnedConnections
 
-        ACE_Based::Thread* tranThread;
+        std::string m_host, m_portOrSocket, m_user, m_password, m_database;
 
-        MYSQL* mMysql;
+        std::vector<SqlConnection*> m_connections;          // synchronous pool
+        SqlConnection* m_workerConnection;                  // used by the delay thread only
+        PinnedConnections m_pinnedConnections;              // delay thread and threads inside a direct transaction
+        size_t m_nextConnection;
+
+        MYSQL* mMysql;                  // first synchronous connection, used for escaping
 
         static size_t db_count;
 
-        bool _TransactionCmd(const char* sql);
+        MYSQL* _Connect();
+        SqlConnection* _AcquireConnection();
+        void _ReleaseConnection(SqlConnection* conn);
+        void _PinConnection(SqlConnection* conn);
+        void _UnpinConnection(SqlConnection* conn);
+
+        void _CloseConnection(SqlConnection* conn);
+
+        std::vector<std::string> m_preparedQueries;         // sql of the registered prepared statements
+
+        MYSQL_STMT* _GetStatement(SqlConnection* conn, uint32 index);
+        MYSQL_STMT* _ExecuteStatement(SqlConnection* conn, PreparedStatement* stmt);
+
+        bool _TransactionCmd(SqlConnection* conn, const char* sql);
         bool _Query(const char *sql, MYSQL_RES **pResult, MYSQL_FIELD **pFields, uint64* pRowCount, uint32* pFieldCount);
 };
 #endif
@@ -20,15 +20,16 @@
 #include "DatabaseEnv.h"
 
 Field::Field() :
-mValue(NULL), mType(DB_TYPE_UNKNOWN)
+mValue(NULL), mType(DB_TYPE_UNKNOWN), mRaw(false)
 {
+    mRawValue.i = 0;
 }
 
 Field::Field(Field &f)
 {
     const char* value;
 
-    value = f.GetString();
+    value = f.mValue;                                       // raw values are copied below, not formatted
 
     if (value)
     {
@@ -40,11 +41,15 @@ Field::Field(Field &f)
         mValue = NULL;
 
     mType = f.GetType();
+    mRaw = f.mRaw;
+    mRawValue = f.mRawValue;
 }
 
 Field::Field(const char* value, enum Field::DataTypes type) :
-mType(type)
+mType(type), mRaw(false)
 {
+    mRawValue.i = 0;
+
     if (value)
     {
         mValue = new char[strlen(value) + 1];
@@ -66,6 +71,8 @@ void Field::SetValue(const char* value)
     if (mValue)
         delete [] mValue;
 
+    mRaw = false;
+
     if (value)
     {
         mValue = new char[strlen(value) + 1];
@@ -74,3 +81,37 @@ void Field::SetValue(const char* value)
     else
         mValue = NULL;
 }
+
+void Field::SetRawInt64(int64 value)
+{
+    if (mValue)
+        delete [] mValue;
+
+    mValue = NULL;
+    mRaw = true;
+    mType = DB_TYPE_INTEGER;
+    mRawValue.i = value;
+}
+
+void Field::SetRawDouble(double value)
+{
+    if (mValue)
+        delete [] mValue;
+
+    mValue = NULL;
+    mRaw = true;
+    mType = DB_TYPE_FLOAT;
+    mRawValue.f = value;
+}
+
+void Field::_FormatRaw() const
+{
+    char buf[32];
+    if (mType == DB_TYPE_FLOAT)
+        snprintf(buf, sizeof(buf), "%g", mRawValue.f);
+    else
+        snprintf(buf, sizeof(buf), SI64FMTD, mRawValue.i);
+
+    mValue = new char[strlen(buf) + 1];
+    strcpy(mValue, buf);
+}
@@ -41,21 +41,29 @@ class Field
 
         enum DataTypes GetType() const { return mType; }
 
-        const char* GetString() const { return mValue; }
+        const char* GetString() const
+        {
+            if (mRaw && !mValue)
+                _FormatRaw();
+            return mValue;
+        }
         std::string GetCppString() const
         {
-            return mValue ? mValue : "";                    // std::string s = 0 have undefine result in C++
+            const char* value = GetString();
+            return value ? value : "";                      // std::string s = 0 have undefine result in C++
         }
-        float GetFloat() const { return mValue ? static_cast<float>(atof(mValue)) : 0.0f; }
-        bool GetBool() const { return mValue ? atoi(mValue) > 0 : false; }
-        int32 GetInt32() const { return mValue ? static_cast<int32>(atol(mValue)) : int32(0); }
-        uint8 GetUInt8() const { return mValue ? static_cast<uint8>(atol(mValue)) : uint8(0); }
-        uint16 GetUInt16() const { return mValue ? static_cast<uint16>(atol(mValue)) : uint16(0); }
-        int16 GetInt16() const { return mValue ? static_cast<int16>(atol(mValue)) : int16(0); }
-        uint32 GetUInt32() const { return mValue ? static_cast<uint32>(atol(mValue)) : uint32(0); }
+        float GetFloat() const { return mRaw ? static_cast<float>(_RawFloat()) : mValue ? static_cast<float>(atof(mValue)) : 0.0f; }
+        bool GetBool() const { return mRaw ? _RawInt() > 0 : mValue ? atoi(mValue) > 0 : false; }
+        int32 GetInt32() const { return mRaw ? static_cast<int32>(_RawInt()) : mValue ? static_cast<int32>(atol(mValue)) : int32(0); }
+        uint8 GetUInt8() const { return mRaw ? static_cast<uint8>(_RawInt()) : mValue ? static_cast<uint8>(atol(mValue)) : uint8(0); }
+        uint16 GetUInt16() const { return mRaw ? static_cast<uint16>(_RawInt()) : mValue ? static_cast<uint16>(atol(mValue)) : uint16(0); }
+        int16 GetInt16() const { return mRaw ? static_cast<int16>(_RawInt()) : mValue ? static_cast<int16>(atol(mValue)) : int16(0); }
+        uint32 GetUInt32() const { return mRaw ? static_cast<uint32>(_RawInt()) : mValue ? static_cast<uint32>(atol(mValue)) : uint32(0); }
         uint64 GetUInt64() const
         {
-            if (mValue)
+            if (mRaw)
+                return static_cast<uint64>(_RawInt());
+            else if (mValue)
             {
                 uint64 value;
                 sscanf(mValue, UI64FMTD, &value);
@@ -66,7 +74,9 @@ class Field
         }
         uint64 GetInt64() const
         {
-            if (mValue)
+            if (mRaw)
+                return static_cast<uint64>(_RawInt());
+            else if (mValue)
             {
                 int64 value;
                 sscanf(mValue, SI64FMTD, &value);
@@ -80,9 +90,23 @@ class Field
 
         void SetValue(const char* value);
 
+        // binary values of prepared statement results, no string conversion unless GetString is used
+        void SetRawInt64(int64 value);
+        void SetRawDouble(double value);
+
     private:
-        char* mValue;
+        int64 _RawInt() const { return mType == DB_TYPE_FLOAT ? static_cast<int64>(mRawValue.f) : mRawValue.i; }
+        double _RawFloat() const { return mType == DB_TYPE_FLOAT ? mRawValue.f : static_cast<double>(mRawValue.i); }
+        void _FormatRaw() const;
+
+        mutable char* mValue;
         enum DataTypes mType;
+        bool mRaw;
+        union
+        {
+            int64 i;
+            double f;
+        } mRawValue;
 };
 #endif
 
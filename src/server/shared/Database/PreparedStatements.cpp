@@ -18,94 +18,128 @@
 
 #include "PreparedStatements.h"
 
-void PreparedStatementHolder::_prepareStatement(const char* name, const char* sql, Database* db, uint32 &count)
+uint32 PreparedStatement::GetDataSize() const
 {
-    const char prefix[] = "PREPARE ";
-    size_t querySize = 8 + strlen(name) + 6 + strlen(sql) + 2 + 1;
-    char* query = new char[querySize];
-    strcpy(query, prefix);
-    strcat(query, name);
-    strcat(query, " FROM ");
-    strcat(query, "'");
-    strcat(query, sql);
-    strcat(query, "'");
-
-    sLog->outDebug("Preparing statement: %s", query);
-    db->Execute(query);
-
-    delete[] query;
-    ++count;
+    uint32 size = 0;
+    for (std::vector<PreparedStatementValue>::const_iterator itr = m_values.begin(); itr != m_values.end(); ++itr)
+    {
+        if (itr->type == PREPARED_TYPE_STRING)
+            size += uint32(itr->str.size());
+        else if (itr->type != PREPARED_TYPE_NULL)
+            size += sizeof(uint64);
+    }
+    return size;
 }
 
-void PreparedStatementHolder::LoadAuthserver(Database* db, uint32 &count)
-{
-    _prepareStatement("auth_ping", "SELECT 1 FROM realmlist LIMIT 1", db, count);
-};
-
-void PreparedStatementHolder::Execute(Database* db, const char* name)
+void PreparedStatement::BindParameters(std::vector<MYSQL_BIND>& binds)
 {
-    const char prefix[] = "EXECUTE ";
-    size_t querySize = 8 + strlen(name) + 1;
-    char* query = new char[querySize];
-    strcpy(query, prefix);
-    strcat(query, name);
-
-    sLog->outDebug("Prepared statement: %s", query);
-    db->Execute(query);
-    delete[] query;
+    binds.resize(m_values.size());
+    if (binds.empty())
+        return;
+
+    memset(&binds[0], 0, sizeof(MYSQL_BIND) * binds.size());
+
+    for (size_t i = 0; i < m_values.size(); ++i)
+    {
+        PreparedStatementValue& param = m_values[i];
+        MYSQL_BIND& bind = binds[i];
+
+        switch (param.type)
+        {
+            case PREPARED_TYPE_INT64:
+            case PREPARED_TYPE_UINT64:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = &param.value;
+                bind.is_unsigned = param.type == PREPARED_TYPE_UINT64 ? 1 : 0;
+                break;
+            case PREPARED_TYPE_DOUBLE:
+                bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                bind.buffer = &param.value.f;
+                break;
+            case PREPARED_TYPE_STRING:
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer = const_cast<char*>(param.str.c_str());
+                bind.buffer_length = param.str.length();
+                break;
+            case PREPARED_TYPE_NULL:
+                bind.buffer_type = MYSQL_TYPE_NULL;
+                break;
+        }
+    }
 }
 
-void PreparedStatementHolder::PExecute(Database* db, const char* name, const char* args)
+void PreparedStatementHolder::_prepareStatement(uint32 index, const char* sql, Database* db, uint32 &count)
 {
-    // NOTE: if args == NULL, we're crashing here. No need to waste performance on checking;
-    // devs must make sure they use PExecute for args and Execute for no args.
-
-    const char prefix[] = "EXECUTE ";
-    size_t querySize = 8 + strlen(name) + 7 + strlen(args) + 1;
-    char* query = new char[querySize];
-    strcpy(query, prefix);
-    strcat(query, name);
-    strcat(query, " USING ");
-    strcat(query, args);
-
-    sLog->outDebug("Prepared statement (parsed args): %s", query);
-    db->Execute(query);
-    delete[] query;
+    sLog->outDebug("Preparing statement %u: %s", index, sql);
+    db->PrepareStatement(index, sql);
+    ++count;
 }
 
-QueryResult_AutoPtr PreparedStatementHolder::Query(Database* db, const char* name)
+void PreparedStatementHolder::LoadCharacters(Database* db, uint32 &count)
 {
-    QueryResult_AutoPtr _return = QueryResult_AutoPtr(NULL);
-
-    const char prefix[] = "EXECUTE ";
-    size_t querySize = 8 + strlen(name) + 1;
-    char* query = new char[querySize];
-    strcpy(query, prefix);
-    strcat(query, name);
-
-    sLog->outDebug("Prepared statement with resultset: %s", query);
-    _return = db->Query(query);
-    delete[] query;
-    return _return;
+    _prepareStatement(CHAR_REP_CHARACTER, "REPLACE INTO characters (guid, account, name, race, class, gender, level, xp, money, playerBytes, playerBytes2, playerFlags, "
+        "map, instance_id, dungeon_difficulty, position_x, position_y, position_z, orientation, data, "
+        "taximask, online, cinematic, "
+        "totaltime, leveltime, rest_bonus, logout_time, is_logout_resting, resettalents_cost, resettalents_time, "
+        "trans_x, trans_y, trans_z, trans_o, transguid, extra_flags, stable_slots, at_login, zone, "
+        "death_expire_time, taxi_path, arenaPoints, totalHonorPoints, todayHonorPoints, yesterdayHonorPoints, "
+        "totalKills, todayKills, yesterdayKills, chosenTitle, watchedFaction, drunk, health, "
+        "powerMana, powerRage, powerFocus, powerEnergy, powerHappiness, latency, specCount, activeSpec, characterMode) VALUES ("
+        "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+        "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", db, count);
+    _prepareStatement(CHAR_DEL_CHARACTER_AURAS, "DELETE FROM character_aura WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_DEL_CHARACTER_INVENTORY_BY_ITEM, "DELETE FROM character_inventory WHERE item = ?", db, count);
+    _prepareStatement(CHAR_DEL_CHARACTER_INVENTORY_BY_BAG_SLOT, "DELETE FROM character_inventory WHERE bag = ? AND slot = ?", db, count);
+    _prepareStatement(CHAR_INS_CHARACTER_INVENTORY, "INSERT INTO character_inventory (guid, bag, slot, item, item_template) VALUES (?, ?, ?, ?, ?)", db, count);
+    _prepareStatement(CHAR_UPD_CHARACTER_INVENTORY, "UPDATE character_inventory SET guid = ?, bag = ?, slot = ?, item_template = ? WHERE item = ?", db, count);
+    _prepareStatement(CHAR_REP_ITEM_INSTANCE, "REPLACE INTO item_instance (guid, owner_guid, data) VALUES (?, ?, ?)", db, count);
+    _prepareStatement(CHAR_UPD_ITEM_INSTANCE, "UPDATE item_instance SET data = ?, owner_guid = ? WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_DEL_ITEM_INSTANCE, "DELETE FROM item_instance WHERE guid = ?", db, count);
+
+    // NOTE: all fields in `characters` must be read to prevent lost character data at next save in case wrong DB structure.
+    // !!! NOTE: including unused `zone`, `online`
+    _prepareStatement(CHAR_SEL_CHARACTER, "SELECT guid, account, data, name, race, class, gender, level, xp, "
+        "money, playerBytes, playerBytes2, playerFlags, position_x, "
+        "position_y, position_z, map, orientation, taximask, cinematic, "
+        "totaltime, leveltime, rest_bonus, logout_time, is_logout_resting, "
+        "resettalents_cost, resettalents_time, trans_x, trans_y, trans_z, "
+        "trans_o, transguid, extra_flags, stable_slots, at_login, zone, "
+        "online, death_expire_time, taxi_path, dungeon_difficulty, "
+        "arenaPoints, totalHonorPoints, todayHonorPoints, "
+        "yesterdayHonorPoints, totalKills, todayKills, yesterdayKills, "
+        "chosenTitle, watchedFaction, drunk, health, "
+        "powerMana, powerRage, powerFocus, powerEnergy, powerHappiness, instance_id, "
+        "specCount, activeSpec, characterMode "
+        "FROM characters WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_GROUP, "SELECT leaderGuid FROM group_member WHERE memberGuid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_BOUND_INSTANCES, "SELECT id, permanent, map, difficulty, resettime FROM character_instance LEFT JOIN instance ON instance = id WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_AURAS, "SELECT caster_guid, spell, effect_index, stackcount, amount, maxduration, remaintime, remaincharges FROM character_aura WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_SPELLS, "SELECT spell, active, disabled FROM character_spell WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_QUESTSTATUS, "SELECT quest, status, rewarded, explored, timer, mobcount1, mobcount2, mobcount3, mobcount4, itemcount1, itemcount2, itemcount3, itemcount4 FROM character_queststatus WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_DAILYQUESTSTATUS, "SELECT quest, time FROM character_queststatus_daily WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_TUTORIALS, "SELECT tut0, tut1, tut2, tut3, tut4, tut5, tut6, tut7 FROM character_tutorial WHERE account = ? AND realmid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_REPUTATION, "SELECT faction, standing, flags FROM character_reputation WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_INVENTORY, "SELECT data, bag, slot, item, item_template FROM character_inventory JOIN item_instance ON character_inventory.item = item_instance.guid WHERE character_inventory.guid = ? ORDER BY bag, slot", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_MAILCOUNT, "SELECT COUNT(id) FROM mail WHERE receiver = ? AND (checked & 1) = 0 AND deliver_time <= ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_MAILDATE, "SELECT MIN(deliver_time) FROM mail WHERE receiver = ? AND (checked & 1) = 0", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_SOCIALLIST, "SELECT friend, flags, note FROM character_social WHERE guid = ? LIMIT 255", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_HOMEBIND, "SELECT map, zone, position_x, position_y, position_z FROM character_homebind WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_SPELLCOOLDOWNS, "SELECT spell, item, time FROM character_spell_cooldown WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_DECLINEDNAMES, "SELECT genitive, dative, accusative, instrumental, prepositional FROM character_declinedname WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_GUILD, "SELECT guildid, rank FROM guild_member WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_ARENAINFO, "SELECT arenateamid, played_week, played_season, personal_rating FROM arena_team_member WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_BGDATA, "SELECT instance_id, team, join_x, join_y, join_z, join_o, join_map, taxi_start, taxi_end, mount_spell FROM character_battleground_data WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_SKILLS, "SELECT skill, value, max FROM character_skills WHERE guid = ?", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_TALENTS, "SELECT spell, spec FROM character_talent WHERE guid = ?", db, count);
+    // actions of all specs, the active one is only known after the character row is loaded
+    _prepareStatement(CHAR_SEL_CHARACTER_ACTIONS, "SELECT button, action, type, misc, spec FROM character_action WHERE guid = ? ORDER BY button", db, count);
+    // current pet (slot 0) and its data, only used for hunters and warlocks
+    _prepareStatement(CHAR_SEL_CHARACTER_PET, "SELECT id, entry, owner, modelid, level, exp, Reactstate, loyaltypoints, loyalty, trainpoint, slot, name, renamed, curhealth, curmana, curhappiness, "
+        "abdata, TeachSpelldata, savetime, resettalents_cost, resettalents_time, CreatedBySpell, PetType FROM character_pet WHERE owner = ? AND slot = 0", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_PET_AURAS, "SELECT caster_guid, spell, effect_index, stackcount, amount, maxduration, remaintime, remaincharges FROM pet_aura "
+        "WHERE guid = (SELECT id FROM character_pet WHERE owner = ? AND slot = 0 LIMIT 1)", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_PET_SPELLS, "SELECT spell, active FROM pet_spell WHERE guid = (SELECT id FROM character_pet WHERE owner = ? AND slot = 0 LIMIT 1)", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_PET_SPELLCOOLDOWNS, "SELECT spell, time FROM pet_spell_cooldown WHERE guid = (SELECT id FROM character_pet WHERE owner = ? AND slot = 0 LIMIT 1)", db, count);
+    _prepareStatement(CHAR_SEL_CHARACTER_PET_DECLINEDNAMES, "SELECT genitive, dative, accusative, instrumental, prepositional FROM character_pet_declinedname "
+        "WHERE owner = ? AND id = (SELECT id FROM character_pet WHERE owner = ? AND slot = 0 LIMIT 1)", db, count);
 }
-
-QueryResult_AutoPtr PreparedStatementHolder::PQuery(Database* db, const char* name, const char* args)
-{
-    // NOTE: if args == NULL, we're crashing here. No need to waste performance on checking;
-    // devs must make sure they use PQuery for args and Query for no args.
-
-    QueryResult_AutoPtr _return = QueryResult_AutoPtr(NULL);
-
-    const char prefix[] = "EXECUTE ";
-    size_t querySize = 8 + strlen(name) + 7 + strlen(args) + 1;
-    char* query = new char[querySize];
-    strcpy(query, prefix);
-    strcat(query, name);
-    strcat(query, " USING ");
-    strcat(query, args);
-
-    sLog->outDebug("Prepared statement with resultset (parsed args): %s", query);
-    _return = db->Query(query);
-    delete[] query;
-    return _return;
-}
\ No newline at end of file
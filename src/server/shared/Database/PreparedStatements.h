@@ -21,27 +21,125 @@
 #include "ace/Singleton.h"
 #include "DatabaseEnv.h"
 
-class PreparedStatementHolder
+#include <vector>
+#include <string>
+
+enum CharacterDatabaseStatements
+{
+    // Player::SaveToDB
+    CHAR_REP_CHARACTER,
+    CHAR_DEL_CHARACTER_AURAS,
+    CHAR_DEL_CHARACTER_INVENTORY_BY_ITEM,
+    CHAR_DEL_CHARACTER_INVENTORY_BY_BAG_SLOT,
+    CHAR_INS_CHARACTER_INVENTORY,
+    CHAR_UPD_CHARACTER_INVENTORY,
+    CHAR_REP_ITEM_INSTANCE,
+    CHAR_UPD_ITEM_INSTANCE,
+    CHAR_DEL_ITEM_INSTANCE,
+
+    // LoginQueryHolder
+    CHAR_SEL_CHARACTER,
+    CHAR_SEL_CHARACTER_GROUP,
+    CHAR_SEL_CHARACTER_BOUND_INSTANCES,
+    CHAR_SEL_CHARACTER_AURAS,
+    CHAR_SEL_CHARACTER_SPELLS,
+    CHAR_SEL_CHARACTER_QUESTSTATUS,
+    CHAR_SEL_CHARACTER_DAILYQUESTSTATUS,
+    CHAR_SEL_CHARACTER_TUTORIALS,
+    CHAR_SEL_CHARACTER_REPUTATION,
+    CHAR_SEL_CHARACTER_INVENTORY,
+    CHAR_SEL_CHARACTER_MAILCOUNT,
+    CHAR_SEL_CHARACTER_MAILDATE,
+    CHAR_SEL_CHARACTER_SOCIALLIST,
+    CHAR_SEL_CHARACTER_HOMEBIND,
+    CHAR_SEL_CHARACTER_SPELLCOOLDOWNS,
+    CHAR_SEL_CHARACTER_DECLINEDNAMES,
+    CHAR_SEL_CHARACTER_GUILD,
+    CHAR_SEL_CHARACTER_ARENAINFO,
+    CHAR_SEL_CHARACTER_BGDATA,
+    CHAR_SEL_CHARACTER_SKILLS,
+    CHAR_SEL_CHARACTER_TALENTS,
+    CHAR_SEL_CHARACTER_ACTIONS,
+    CHAR_SEL_CHARACTER_PET,
+    CHAR_SEL_CHARACTER_PET_AURAS,
+    CHAR_SEL_CHARACTER_PET_SPELLS,
+    CHAR_SEL_CHARACTER_PET_SPELLCOOLDOWNS,
+    CHAR_SEL_CHARACTER_PET_DECLINEDNAMES,
+
+    MAX_CHARACTER_DATABASE_STATEMENTS
+};
+
+enum PreparedStatementValueType
+{
+    PREPARED_TYPE_NULL,
+    PREPARED_TYPE_INT64,
+    PREPARED_TYPE_UINT64,
+    PREPARED_TYPE_DOUBLE,
+    PREPARED_TYPE_STRING
+};
+
+struct PreparedStatementValue
+{
+    PreparedStatementValue() : type(PREPARED_TYPE_NULL) { value.u = 0; }
+
+    PreparedStatementValueType type;
+    union
+    {
+        int64 i;
+        uint64 u;
+        double f;
+    } value;
+    std::string str;
+};
+
+// Parameters of one execution of a server side prepared statement registered with
+// PreparedStatementHolder. The Database methods taking a PreparedStatement* own and delete it.
+class PreparedStatement
 {
     public:
-        ///- Load prepare statements on database $db and increase $count for every statement
-        void LoadCharacters(Database* db, uint32 &count);
-        void LoadAuthserver(Database* db, uint32 &count);
-        void LoadWorldserver(Database* db, uint32 &count);
+        explicit PreparedStatement(uint32 index) : m_index(index) {}
+
+        uint32 GetIndex() const { return m_index; }
+
+        void SetUInt8(uint8 index, uint8 value) { _Set(index, PREPARED_TYPE_UINT64).value.u = value; }
+        void SetUInt16(uint8 index, uint16 value) { _Set(index, PREPARED_TYPE_UINT64).value.u = value; }
+        void SetUInt32(uint8 index, uint32 value) { _Set(index, PREPARED_TYPE_UINT64).value.u = value; }
+        void SetUInt64(uint8 index, uint64 value) { _Set(index, PREPARED_TYPE_UINT64).value.u = value; }
+        void SetInt32(uint8 index, int32 value) { _Set(index, PREPARED_TYPE_INT64).value.i = value; }
+        void SetInt64(uint8 index, int64 value) { _Set(index, PREPARED_TYPE_INT64).value.i = value; }
+        void SetFloat(uint8 index, float value) { _Set(index, PREPARED_TYPE_DOUBLE).value.f = value; }
+        void SetString(uint8 index, const std::string& value) { _Set(index, PREPARED_TYPE_STRING).str = value; }
+        void SetNull(uint8 index) { _Set(index, PREPARED_TYPE_NULL); }
+
+        uint32 GetParameterCount() const { return uint32(m_values.size()); }
+        // approximate amount of data sent to the server, used for save statistics
+        uint32 GetDataSize() const;
+
+        // binds the parameters for mysql_stmt_bind_param, valid as long as the statement is
+        void BindParameters(std::vector<MYSQL_BIND>& binds);
+
+    private:
+        PreparedStatementValue& _Set(uint8 index, PreparedStatementValueType type)
+        {
+            if (index >= m_values.size())
+                m_values.resize(index + 1);
 
-        ///- Executes prepared statement that doesn't require feedback with name $name on database $db
-        void Execute(Database* db, const char* name);
-        ///- Executes prepared statement that doesn't require feedback with name $name and args $args
-        ///- on database $db
-        void PExecute(Database* db, const char* name, const char* args);
+            m_values[index].type = type;
+            return m_values[index];
+        }
 
-        ///- Executes a prepared statement without args on db $db with name $name and puts the result set in a pointer.
-        QueryResult_AutoPtr Query(Database* db, const char* name);
-        ///- Executes a prepared statement with args $args on db $db with name $name and put the result set in a pointer.
-        QueryResult_AutoPtr PQuery(Database* db, const char* name, const char* args);
+        uint32 m_index;
+        std::vector<PreparedStatementValue> m_values;
+};
+
+class PreparedStatementHolder
+{
+    public:
+        ///- Register the prepared statements of database $db and increase $count for every statement
+        void LoadCharacters(Database* db, uint32 &count);
 
     private:
-        void _prepareStatement(const char* name, const char* sql, Database* db, uint32 &count);
+        void _prepareStatement(uint32 index, const char* sql, Database* db, uint32 &count);
 };
 #define sPreparedStatement ACE_Singleton<PreparedStatementHolder, ACE_Null_Mutex>::instance()
-#endif
\ No newline at end of file
+#endif
@@ -28,6 +28,10 @@ QueryResult::QueryResult(MYSQL_RES* result, MYSQL_FIELD* fields, uint64 rowCount
          mCurrentRow[i].SetType(ConvertNativeType(fields[i].type));
 }
 
+QueryResult::QueryResult(uint64 rowCount, uint32 fieldCount) : mCurrentRow(NULL), mFieldCount(fieldCount), mRowCount(rowCount), mResult(NULL)
+{
+}
+
 QueryResult::~QueryResult()
 {
     EndQuery();
@@ -99,3 +103,100 @@ enum Field::DataTypes QueryResult::ConvertNativeType(enum_field_types mysqlType)
             return Field::DB_TYPE_UNKNOWN;
     }
 }
+
+PreparedQueryResult::PreparedQueryResult(MYSQL_STMT* stmt, MYSQL_RES* metadata, uint64 rowCount, uint32 fieldCount) :
+QueryResult(rowCount, fieldCount), mRows(NULL), mRowIndex(0)
+{
+    MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+
+    std::vector<MYSQL_BIND> binds(mFieldCount);
+    std::vector<uint64> values(mFieldCount);
+    std::vector<unsigned long> lengths(mFieldCount);
+    std::vector<my_bool> nulls(mFieldCount);
+    std::vector<std::vector<char> > strings(mFieldCount);
+
+    memset(&binds[0], 0, sizeof(MYSQL_BIND) * mFieldCount);
+
+    // integers and floating point columns are fetched binary, everything else (strings, dates, decimals) as text
+    for (uint32 i = 0; i < mFieldCount; ++i)
+    {
+        binds[i].length = &lengths[i];
+        binds[i].is_null = &nulls[i];
+
+        switch (fields[i].type)
+        {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONGLONG:
+                binds[i].buffer_type = MYSQL_TYPE_LONGLONG;
+                binds[i].buffer = &values[i];
+                binds[i].is_unsigned = (fields[i].flags & UNSIGNED_FLAG) ? 1 : 0;
+                break;
+            case MYSQL_TYPE_FLOAT:
+            case MYSQL_TYPE_DOUBLE:
+                binds[i].buffer_type = MYSQL_TYPE_DOUBLE;
+                binds[i].buffer = &values[i];
+                break;
+            default:
+                strings[i].resize(fields[i].max_length + 1);
+                binds[i].buffer_type = MYSQL_TYPE_STRING;
+                binds[i].buffer = &strings[i][0];
+                binds[i].buffer_length = fields[i].max_length + 1;
+                break;
+        }
+    }
+
+    if (mysql_stmt_bind_result(stmt, &binds[0]))
+    {
+        sLog->outErrorDb("PreparedQueryResult: can't bind result: %s", mysql_stmt_error(stmt));
+        mRowCount = 0;
+        return;
+    }
+
+    mRows = new Field[size_t(mRowCount) * mFieldCount];
+
+    uint64 row = 0;
+    while (row < mRowCount && mysql_stmt_fetch(stmt) == 0)
+    {
+        Field* rowFields = &mRows[size_t(row) * mFieldCount];
+        for (uint32 i = 0; i < mFieldCount; ++i)
+        {
+            if (nulls[i])
+                rowFields[i].SetValue(NULL);
+            else if (binds[i].buffer_type == MYSQL_TYPE_LONGLONG)
+                rowFields[i].SetRawInt64(int64(values[i]));
+            else if (binds[i].buffer_type == MYSQL_TYPE_DOUBLE)
+                rowFields[i].SetRawDouble(*reinterpret_cast<double*>(&values[i]));
+            else
+            {
+                strings[i][std::min<size_t>(lengths[i], strings[i].size() - 1)] = '\0';
+                rowFields[i].SetValue(&strings[i][0]);
+                rowFields[i].SetType(Field::DB_TYPE_STRING);
+            }
+        }
+        ++row;
+    }
+
+    mRowCount = row;
+}
+
+PreparedQueryResult::~PreparedQueryResult()
+{
+    // the current row points into mRows, keep the base class from freeing it
+    mCurrentRow = NULL;
+    delete [] mRows;
+}
+
+bool PreparedQueryResult::NextRow()
+{
+    if (mRowIndex >= mRowCount)
+    {
+        mCurrentRow = NULL;
+        return false;
+    }
+
+    mCurrentRow = &mRows[size_t(mRowIndex++) * mFieldCount];
+    return true;
+}
@@ -37,9 +37,9 @@ class QueryResult
 {
     public:
         QueryResult(MYSQL_RES* result, MYSQL_FIELD* fields, uint64 rowCount, uint32 fieldCount);
-        ~QueryResult();
+        virtual ~QueryResult();
 
-        bool NextRow();
+        virtual bool NextRow();
 
         Field* Fetch() const { return mCurrentRow; }
 
@@ -49,6 +49,8 @@ class QueryResult
         uint64 GetRowCount() const { return mRowCount; }
 
     protected:
+        QueryResult(uint64 rowCount, uint32 fieldCount);
+
         Field* mCurrentRow;
         uint32 mFieldCount;
         uint64 mRowCount;
@@ -59,6 +61,20 @@ class QueryResult
         MYSQL_RES* mResult;
 };
 
+// result of a prepared statement, all rows are fetched in binary form at execution
+class PreparedQueryResult : public QueryResult
+{
+    public:
+        PreparedQueryResult(MYSQL_STMT* stmt, MYSQL_RES* metadata, uint64 rowCount, uint32 fieldCount);
+        ~PreparedQueryResult();
+
+        bool NextRow();
+
+    private:
+        Field* mRows;
+        uint64 mRowIndex;
+};
+
 typedef ACE_Refcounted_Auto_Ptr<QueryResult, ACE_Null_Mutex> QueryResult_AutoPtr;
 
 typedef std::vector<std::string> QueryFieldNames;
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2011-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SqlBatch.h"
+#include "DatabaseEnv.h"
+
+SqlBatch::SqlBatch(Database& db, const std::string& head, const char* tail)
+    : m_db(db), m_head(head), m_tail(tail), m_rows(0), m_writtenRows(0), m_writtenBytes(0)
+{
+}
+
+void SqlBatch::AddRow(const char* format, ...)
+{
+    va_list ap;
+    char szRow[MAX_QUERY_LEN];
+    va_start(ap, format);
+    int res = vsnprintf(szRow, MAX_QUERY_LEN, format, ap);
+    va_end(ap);
+
+    if (res < 0 || res >= MAX_QUERY_LEN)
+    {
+        sLog->outError("SQL batch row truncated (and not added) for format: %s", format);
+        return;
+    }
+
+    if (m_rows && m_sql.size() + res + m_tail.size() > SQL_BATCH_MAX_LEN)
+        Flush();
+
+    if (!m_rows)
+        m_sql = m_head;
+    else
+        m_sql.append(", ");
+
+    m_sql.append(szRow, res);
+    ++m_rows;
+}
+
+void SqlBatch::Flush()
+{
+    if (!m_rows)
+        return;
+
+    m_sql.append(m_tail);
+    m_db.Execute(m_sql.c_str());
+
+    m_writtenRows += m_rows;
+    m_writtenBytes += m_sql.size();
+
+    m_rows = 0;
+    m_sql.clear();
+}
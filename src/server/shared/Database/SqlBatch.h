@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2011-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SQLBATCH_H
+#define __SQLBATCH_H
+
+#include "Define.h"
+
+#include <string>
+
+class Database;
+
+// don't let a single statement grow beyond this, larger batches are split
+#define SQL_BATCH_MAX_LEN   64*1024
+
+/*! Collects the rows of one multi-row statement, e.g.
+      INSERT INTO t (guid, id, value) VALUES (1, 2, 3), (1, 4, 5) ON DUPLICATE KEY UPDATE value = VALUES(value)
+      DELETE FROM t WHERE guid = 1 AND id IN (2, 4)
+    and executes it with Database::Execute, so it joins the transaction of the calling thread. */
+class SqlBatch
+{
+    public:
+        // head is written before the rows and tail after them, rows are separated by ", "
+        SqlBatch(Database& db, const std::string& head, const char* tail = "");
+
+        void AddRow(const char* format, ...) ATTR_PRINTF(2, 3);
+
+        // executes the collected rows, if any
+        void Flush();
+
+        uint32 GetWrittenRows() const { return m_writtenRows; }
+        uint32 GetWrittenBytes() const { return m_writtenBytes; }
+
+    private:
+        Database& m_db;
+        std::string m_head;
+        std::string m_tail;
+        std::string m_sql;
+        uint32 m_rows;
+        uint32 m_writtenRows;
+        uint32 m_writtenBytes;
+};
+#endif
@@ -22,7 +22,7 @@
 #include "SqlOperations.h"
 #include "DatabaseEnv.h"
 
-SqlDelayThread::SqlDelayThread(Database* db) : m_dbEngine(db), m_running(true)
+SqlDelayThread::SqlDelayThread(Database* db, SqlConnection* conn) : m_dbEngine(db), m_connection(conn), m_running(true)
 {
 }
 
@@ -30,6 +30,9 @@ void SqlDelayThread::run()
 {
     mysql_thread_init();
 
+    // every statement executed from this thread goes to our own connection
+    m_dbEngine->_PinConnection(m_connection);
+
     SqlAsyncTask * s = NULL;
 
     ACE_Time_Value _time(2);
@@ -45,6 +48,8 @@ void SqlDelayThread::run()
         }
     }
 
+    m_dbEngine->_UnpinConnection(m_connection);
+
     mysql_thread_end();
 }
 
@@ -27,6 +27,7 @@
 
 class Database;
 class SqlOperation;
+struct SqlConnection;
 
 class SqlDelayThread : public ACE_Based::Runnable
 {
@@ -35,11 +36,12 @@ class SqlDelayThread : public ACE_Based::Runnable
     private:
         SqlQueue m_sqlQueue;                                // Queue of SQL statements
         Database* m_dbEngine;                               // Pointer to used Database engine
+        SqlConnection* m_connection;                        // Connection used by this thread only
         volatile bool m_running;
 
         SqlDelayThread();
     public:
-        SqlDelayThread(Database* db);
+        SqlDelayThread(Database* db, SqlConnection* conn);
 
         // Put sql statement to delay queue
         bool Delay(SqlOperation* sql);
@@ -22,6 +22,7 @@
 #include "SqlDelayThread.h"
 #include "DatabaseEnv.h"
 #include "DatabaseImpl.h"
+#include "PreparedStatements.h"
 
 // ASYNC STATEMENTS / TRANSACTIONS
 
@@ -31,10 +32,37 @@ void SqlStatement::Execute(Database *db)
     db->DirectExecute(m_sql);
 }
 
-void SqlTransaction::Execute(Database *db)
+SqlPreparedStatement::~SqlPreparedStatement()
+{
+    delete m_stmt;
+}
+
+void SqlPreparedStatement::Execute(Database *db)
+{
+    // the database takes ownership of the statement
+    db->DirectExecute(m_stmt);
+    m_stmt = NULL;
+}
+
+void SqlTransaction::_FreeElement(TransactionElement& element)
+{
+    if (element.sql)
+        free((void*)const_cast<char*>(element.sql));
+    delete element.stmt;
+}
+
+SqlTransaction::~SqlTransaction()
 {
-    const char* sql;
+    // rolled back or never executed
+    while (!m_queue.empty())
+    {
+        _FreeElement(m_queue.front());
+        m_queue.pop();
+    }
+}
 
+void SqlTransaction::Execute(Database *db)
+{
     m_Mutex.acquire();
     if (m_queue.empty())
     {
@@ -45,24 +73,31 @@ void SqlTransaction::Execute(Database *db)
     db->DirectExecute("START TRANSACTION");
     while (!m_queue.empty())
     {
-        sql = m_queue.front();
+        TransactionElement element = m_queue.front();
+        m_queue.pop();
+
+        bool res;
+        if (element.stmt)
+        {
+            res = db->DirectExecute(element.stmt);          // deletes the statement
+            element.stmt = NULL;
+        }
+        else
+            res = db->DirectExecute(element.sql);
+
+        _FreeElement(element);
 
-        if (!db->DirectExecute(sql))
+        if (!res)
         {
-            free((void*)const_cast<char*>(sql));
-            m_queue.pop();
             db->DirectExecute("ROLLBACK");
             while (!m_queue.empty())
             {
-                free((void*)const_cast<char*>(m_queue.front()));
+                _FreeElement(m_queue.front());
                 m_queue.pop();
             }
             m_Mutex.release();
             return;
         }
-
-        free((void*)const_cast<char*>(sql));
-        m_queue.pop();
     }
 
     db->DirectExecute("COMMIT");
@@ -148,6 +183,26 @@ bool SqlQueryHolder::SetPQuery(size_t index, const char *format, ...)
     return SetQuery(index, szQuery);
 }
 
+bool SqlQueryHolder::SetPreparedQuery(size_t index, PreparedStatement *stmt)
+{
+    if (m_queries.size() <= index)
+    {
+        sLog->outError("Query index (%u) out of range (size: %u) for prepared statement: %u", uint32(index), (uint32)m_queries.size(), stmt->GetIndex());
+        delete stmt;
+        return false;
+    }
+
+    if (m_queries[index].first != NULL || m_statements[index] != NULL)
+    {
+        sLog->outError("Attempt assign prepared statement %u to holder index (%u) where other query stored", stmt->GetIndex(), uint32(index));
+        delete stmt;
+        return false;
+    }
+
+    m_statements[index] = stmt;
+    return true;
+}
+
 QueryResult_AutoPtr SqlQueryHolder::GetResult(size_t index)
 {
     if (index < m_queries.size())
@@ -181,12 +236,16 @@ SqlQueryHolder::~SqlQueryHolder()
         if (m_queries[i].first != NULL)
             free((void*)(const_cast<char*>(m_queries[i].first)));
     }
+
+    for (size_t i = 0; i < m_statements.size(); i++)
+        delete m_statements[i];
 }
 
 void SqlQueryHolder::SetSize(size_t size)
 {
     // to optimize push_back, reserve the number of queries about to be executed
     m_queries.resize(size);
+    m_statements.resize(size, NULL);
 }
 
 void SqlQueryHolderEx::Execute(Database *db)
@@ -202,6 +261,11 @@ void SqlQueryHolderEx::Execute(Database *db)
         // execute all queries in the holder and pass the results
         char const *sql = queries[i].first;
         if (sql) m_holder->SetResult(i, db->Query(sql));
+        else if (PreparedStatement* stmt = m_holder->m_statements[i])
+        {
+            m_holder->m_statements[i] = NULL;               // deleted by the database
+            m_holder->SetResult(i, db->Query(stmt));
+        }
     }
 
     // sync with the caller thread
@@ -34,6 +34,7 @@
 
 class Database;
 class SqlDelayThread;
+class PreparedStatement;
 
 class SqlOperation
 {
@@ -55,19 +56,47 @@ class SqlStatement : public SqlOperation
         void Execute(Database *db);
 };
 
+class SqlPreparedStatement : public SqlOperation
+{
+    private:
+        PreparedStatement *m_stmt;
+    public:
+        SqlPreparedStatement(PreparedStatement *stmt) : m_stmt(stmt) {}
+        ~SqlPreparedStatement();
+        void Execute(Database *db);
+};
+
 class SqlTransaction : public SqlOperation
 {
     private:
-        std::queue<const char*> m_queue;
+        // either a plain sql string or a prepared statement
+        struct TransactionElement
+        {
+            TransactionElement(const char *_sql, PreparedStatement *_stmt) : sql(_sql), stmt(_stmt) {}
+
+            const char *sql;
+            PreparedStatement *stmt;
+        };
+
+        std::queue<TransactionElement> m_queue;
         ACE_Thread_Mutex m_Mutex;
+
+        void _FreeElement(TransactionElement& element);
     public:
         SqlTransaction() {}
+        ~SqlTransaction();
         void DelayExecute(const char *sql)
         {
             m_Mutex.acquire();
             char* _sql = strdup(sql);
             if (_sql)
-                m_queue.push(_sql);
+                m_queue.push(TransactionElement(_sql, NULL));
+            m_Mutex.release();
+        }
+        void DelayExecute(PreparedStatement *stmt)
+        {
+            m_Mutex.acquire();
+            m_queue.push(TransactionElement(NULL, stmt));
             m_Mutex.release();
         }
         void Execute(Database *db);
@@ -107,11 +136,13 @@ class SqlQueryHolder
     private:
         typedef std::pair<const char*, QueryResult_AutoPtr> SqlResultPair;
         std::vector<SqlResultPair> m_queries;
+        std::vector<PreparedStatement*> m_statements;       // prepared alternative to the sql at the same index
     public:
         SqlQueryHolder() {}
         ~SqlQueryHolder();
         bool SetQuery(size_t index, const char *sql);
         bool SetPQuery(size_t index, const char *format, ...) ATTR_PRINTF(3, 4);
+        bool SetPreparedQuery(size_t index, PreparedStatement *stmt);
         void SetSize(size_t size);
         QueryResult_AutoPtr GetResult(size_t index);
         void SetResult(size_t index, QueryResult_AutoPtr result);
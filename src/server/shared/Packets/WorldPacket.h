@@ -24,6 +24,9 @@
 #include "Common.h"
 #include "ByteBuffer.h"
 
+#include <ace/Refcounted_Auto_Ptr.h>
+#include <ace/Thread_Mutex.h>
+
 class WorldPacket : public ByteBuffer
 {
     public:
@@ -50,5 +53,8 @@ class WorldPacket : public ByteBuffer
     protected:
         uint16 m_opcode;
 };
+
+// packet shared by the output queues of several sockets, must not be modified once shared
+typedef ACE_Refcounted_Auto_Ptr<WorldPacket, ACE_Thread_Mutex> WorldPacketPtr;
 #endif
 
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2011-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MappedFile.h"
+
+#include <ace/OS_NS_fcntl.h>
+#include <cstdio>
+
+bool MappedFile::s_mappingEnabled = true;
+
+MappedFile::MappedFile() : i_data(NULL), i_buffer(NULL), i_size(0), i_writable(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(char const* fileName, bool writable)
+{
+    Close();
+
+    if (s_mappingEnabled && i_map.map(fileName, static_cast<size_t>(-1), O_RDONLY, ACE_DEFAULT_FILE_PERMS,
+        writable ? PROT_RDWR : PROT_READ, ACE_MAP_PRIVATE) == 0 && i_map.size())
+    {
+        // the mapping stays valid without the file handle, thousands of tiles would use up the descriptors otherwise
+        i_map.close_handle();
+        i_data = (uint8*)i_map.addr();
+        i_size = i_map.size();
+        i_writable = writable;
+        return true;
+    }
+    i_map.close();
+
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0)
+    {
+        fclose(file);
+        return false;
+    }
+
+    i_buffer = new uint8[size];
+    if (fread(i_buffer, size, 1, file) != 1)
+    {
+        fclose(file);
+        delete[] i_buffer;
+        i_buffer = NULL;
+        return false;
+    }
+    fclose(file);
+
+    i_data = i_buffer;
+    i_size = size_t(size);
+    i_writable = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (i_buffer)
+    {
+        delete[] i_buffer;
+        i_buffer = NULL;
+    }
+    else if (i_data)
+        i_map.close();
+
+    i_data = NULL;
+    i_size = 0;
+    i_writable = false;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2011-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_MAPPEDFILE_H
+#define TRINITY_MAPPEDFILE_H
+
+#include "Define.h"
+
+#include <ace/Mem_Map.h>
+
+/*
+  Read only view of a whole data file. The file is memory mapped, so processes and maps
+  loading the same file share the pages of the page cache and only the touched pages are
+  read from disk. When mapping is disabled or fails the file is read into one buffer, the
+  callers see the same contiguous data either way.
+*/
+class MappedFile
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        // writable gives a private copy on write mapping for data that is patched in place
+        bool Open(char const* fileName, bool writable = false);
+        void Close();
+
+        bool IsOpen() const { return i_data != NULL; }
+        uint8 const* GetData() const { return i_data; }
+        uint8* GetWritableData() const { return i_writable ? i_data : NULL; }
+        size_t GetSize() const { return i_size; }
+
+        // size bytes at offset, NULL if they are not inside the file
+        uint8 const* GetData(size_t offset, size_t size) const
+        {
+            return offset <= i_size && size <= i_size - offset ? i_data + offset : NULL;
+        }
+
+        // MemoryMappedDataFiles, data files are read into memory while disabled
+        static void SetMappingEnabled(bool enabled) { s_mappingEnabled = enabled; }
+        static bool IsMappingEnabled() { return s_mappingEnabled; }
+
+    private:
+        MappedFile(MappedFile const&);
+        MappedFile& operator=(MappedFile const&);
+
+        ACE_Mem_Map i_map;
+        uint8* i_data;
+        uint8* i_buffer;                                    // the read file if it is not mapped
+        size_t i_size;
+        bool i_writable;
+
+        static bool s_mappingEnabled;
+};
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2011-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TickTracer.h"
+
+#include <ace/OS_NS_sys_time.h>
+
+#include <vector>
+
+TickTraceRing::TickTraceRing() : head(0)
+{
+    memset(spans, 0, sizeof(spans));
+
+    TickTracer* tracer = sTickTracer;
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, tracer->i_lock);
+    threadId = ++tracer->i_nextThreadId;
+    tracer->i_rings.insert(this);
+}
+
+TickTraceRing::~TickTraceRing()
+{
+    TickTracer* tracer = sTickTracer;
+
+    ACE_GUARD(ACE_Thread_Mutex, guard, tracer->i_lock);
+    tracer->i_rings.erase(this);
+}
+
+TickTracer::TickTracer() : i_enabled(false), i_startTime(ACE_OS::gettimeofday()), i_nextThreadId(0)
+{
+}
+
+uint64 TickTracer::Now() const
+{
+    uint64 now;
+    (ACE_OS::gettimeofday() - i_startTime).to_usec(now);
+    return now;
+}
+
+void TickTracer::Record(char const* name, uint64 start, uint64 end)
+{
+    TickTraceRing* ring = i_ring;
+
+    TickTraceSpan& span = ring->spans[uint32(ring->head.value()) % TICK_TRACE_RING_SIZE];
+    span.name = name;
+    span.start = start;
+    span.end = end;
+
+    // the atomic increment publishes the complete span to Dump()
+    ++ring->head;
+}
+
+static void WriteJsonString(FILE* file, char const* str)
+{
+    fputc('"', file);
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', file);
+        if (uint8(*str) >= 0x20)
+            fputc(*str, file);
+    }
+    fputc('"', file);
+}
+
+bool TickTracer::Dump(std::string const& fileName, uint32 window)
+{
+    uint64 now = Now();
+    uint64 from = now > uint64(window) * 1000 ? now - uint64(window) * 1000 : 0;
+
+    // copy the spans under the lock, the file is written after releasing it
+    std::vector<std::pair<uint32, TickTraceSpan> > spans;
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, i_lock, false);
+
+        for (std::set<TickTraceRing*>::const_iterator itr = i_rings.begin(); itr != i_rings.end(); ++itr)
+        {
+            TickTraceRing const* ring = *itr;
+            uint32 head = uint32(ring->head.value());
+            uint32 count = std::min(head, uint32(TICK_TRACE_RING_SIZE));
+
+            // the owner keeps writing meanwhile, spans it overwrites in the oldest slots are skipped by the time check
+            for (uint32 i = head - count; i != head; ++i)
+            {
+                TickTraceSpan span = ring->spans[i % TICK_TRACE_RING_SIZE];
+                if (!span.name || span.end < from || span.end > now || span.start > span.end)
+                    continue;
+
+                spans.push_back(std::make_pair(ring->threadId, span));
+            }
+        }
+    }
+
+    FILE* file = fopen(fileName.c_str(), "w");
+    if (!file)
+        return false;
+
+    fprintf(file, "{\"traceEvents\":[");
+
+    for (size_t i = 0; i < spans.size(); ++i)
+    {
+        TickTraceSpan const& span = spans[i].second;
+
+        fprintf(file, "%s\n{\"name\":", i ? "," : "");
+        WriteJsonString(file, span.name);
+        fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":" UI64FMTD ",\"dur\":" UI64FMTD "}",
+            spans[i].first, span.start, span.end - span.start);
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
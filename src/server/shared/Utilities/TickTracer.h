@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2011-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_TICKTRACER_H
+#define TRINITY_TICKTRACER_H
+
+#include "Common.h"
+
+#include <ace/Singleton.h>
+#include <ace/TSS_T.h>
+#include <ace/Thread_Mutex.h>
+#include <ace/Atomic_Op.h>
+
+// spans kept per thread, older ones are overwritten
+#define TICK_TRACE_RING_SIZE    32768
+
+struct TickTraceSpan
+{
+    char const* name;
+    uint64 start;                                           // microseconds since the tracer was created
+    uint64 end;
+};
+
+// spans of one thread, written only by that thread
+struct TickTraceRing
+{
+    TickTraceRing();
+    ~TickTraceRing();
+
+    TickTraceSpan spans[TICK_TRACE_RING_SIZE];
+    ACE_Atomic_Op<ACE_Thread_Mutex, long> head;             // spans written so far
+    uint32 threadId;
+};
+
+/*
+  Scoped span tracer for the phases of the world and map update threads. Spans go to a
+  ring of the recording thread without locking, Dump() writes the spans of the last
+  milliseconds of every thread as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+*/
+class TickTracer
+{
+    friend class ACE_Singleton<TickTracer, ACE_Thread_Mutex>;
+    friend struct TickTraceRing;
+    TickTracer();
+
+    public:
+        void SetEnabled(bool enabled) { i_enabled = enabled; }
+        bool IsEnabled() const { return i_enabled; }
+
+        uint64 Now() const;
+        void Record(char const* name, uint64 start, uint64 end);
+
+        // writes the spans that ended in the last window milliseconds, false if the file can't be written
+        bool Dump(std::string const& fileName, uint32 window);
+
+    private:
+        volatile bool i_enabled;
+        ACE_Time_Value i_startTime;
+
+        ACE_TSS<TickTraceRing> i_ring;
+
+        ACE_Thread_Mutex i_lock;
+        std::set<TickTraceRing*> i_rings;
+        uint32 i_nextThreadId;
+};
+
+#define sTickTracer ACE_Singleton<TickTracer, ACE_Thread_Mutex>::instance()
+
+// records the time until the end of the scope, name must stay valid until the next Dump()
+class TickTraceScope
+{
+    public:
+        explicit TickTraceScope(char const* name) : i_name(sTickTracer->IsEnabled() ? name : NULL)
+        {
+            if (i_name)
+                i_start = sTickTracer->Now();
+        }
+
+        ~TickTraceScope()
+        {
+            if (i_name)
+                sTickTracer->Record(i_name, i_start, sTickTracer->Now());
+        }
+
+    private:
+        char const* i_name;
+        uint64 i_start;
+};
+
+#define TRACE_SPAN(name) TickTraceScope _tickTraceScope(name)
+
+#endif
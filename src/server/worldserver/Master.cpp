@@ -30,6 +30,7 @@
 #include "WorldSocketMgr.h"
 #include "Config.h"
 #include "DatabaseEnv.h"
+#include "PreparedStatements.h"
 #include "CliRunnable.h"
 #include "Log.h"
 #include "Master.h"
@@ -328,6 +329,7 @@ bool Master::_StartDB()
     sLog->SetLogDB(false);
     std::string dbstring;
     uint8 num_threads;
+    uint8 synch_threads;
 
     dbstring = ConfigMgr::GetStringDefault("WorldDatabaseInfo", "");
     if (dbstring.empty())
@@ -344,8 +346,16 @@ bool Master::_StartDB()
         return false;
     }
 
+    synch_threads = ConfigMgr::GetIntDefault("WorldDatabase.SynchThreads", 1);
+    if (synch_threads < 1 || synch_threads > 32)
+    {
+        sLog->outError("World database: invalid number of synch threads specified. "
+            "Please pick a value between 1 and 32.");
+        return false;
+    }
+
     ///- Initialize the world database
-    if ( !WorldDatabase.Initialize(dbstring.c_str()))
+    if ( !WorldDatabase.Initialize(dbstring.c_str(), synch_threads))
     {
         sLog->outError("Cannot connect to world database %s", dbstring.c_str());
         return false;
@@ -366,12 +376,26 @@ bool Master::_StartDB()
         return false;
     }
 
+    synch_threads = ConfigMgr::GetIntDefault("CharacterDatabase.SynchThreads", 1);
+    if (synch_threads < 1 || synch_threads > 32)
+    {
+        sLog->outError("Character database: invalid number of synch threads specified. "
+            "Please pick a value between 1 and 32.");
+        return false;
+    }
+
     ///- Initialize the Character database
-    if (!CharacterDatabase.Initialize(dbstring.c_str()))
+    if (!CharacterDatabase.Initialize(dbstring.c_str(), synch_threads))
     {
         sLog->outError("Cannot connect to Character database %s", dbstring.c_str());
         return false;
     }
+
+    ///- Register the prepared statements of the Character database
+    uint32 preparedStatements = 0;
+    sPreparedStatement->LoadCharacters(&CharacterDatabase, preparedStatements);
+    sLog->outString("Registered %u prepared statements for the Character database", preparedStatements);
+
     ///- Get login database info from configuration file
     dbstring = ConfigMgr::GetStringDefault("LoginDatabaseInfo", "");
     if (dbstring.empty())
@@ -388,8 +412,16 @@ bool Master::_StartDB()
         return false;
     }
 
+    synch_threads = ConfigMgr::GetIntDefault("LoginDatabase.SynchThreads", 1);
+    if (synch_threads < 1 || synch_threads > 32)
+    {
+        sLog->outError("Login database: invalid number of synch threads specified. "
+            "Please pick a value between 1 and 32.");
+        return false;
+    }
+
     ///- Initialize the login database
-    if (!LoginDatabase.Initialize(dbstring.c_str()))
+    if (!LoginDatabase.Initialize(dbstring.c_str(), synch_threads))
     {
         sLog->outError("Cannot connect to login database %s", dbstring.c_str());
         return false;
@@ -30,6 +30,7 @@
 #include "BattlegroundMgr.h"
 #include "MapManager.h"
 #include "Timer.h"
+#include "TickTracer.h"
 #include "WorldRunnable.h"
 
 #define WORLD_SLEEP_CONST 50
@@ -61,7 +62,11 @@ void WorldRunnable::run()
 
         uint32 diff = getMSTimeDiff(realPrevTime, realCurrTime);
 
-        sWorld->Update( diff );
+        {
+            TRACE_SPAN("World::Update");
+            sWorld->Update( diff );
+        }
+        sWorld->CheckTickBudget(getMSTimeDiff(realCurrTime, getMSTime()));
         realPrevTime = realCurrTime;
 
         // diff (D0) include time of previous sleep (d0) + tick time (t0)
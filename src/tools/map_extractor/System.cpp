@@ -252,7 +252,7 @@ void ReadLiquidTypeTableDBC()
 
 // Map file format data
 #define MAP_MAGIC             'SPAM'
-#define MAP_VERSION_MAGIC     '5.0w'
+#define MAP_VERSION_MAGIC     '7.0w'
 #define MAP_AREA_MAGIC        'AERA'
 #define MAP_HEIGHT_MAGIC      'TGHM'
 #define MAP_LIQUID_MAGIC      'QILM'
@@ -267,8 +267,27 @@ struct map_fileheader
     uint32 heightMapSize;
     uint32 liquidMapOffset;
     uint32 liquidMapSize;
+    uint32 holesOffset;
+    uint32 holesSize;
 };
 
+// sections start at multiples of this, so the server can use the arrays in place
+#define MAP_SECTION_ALIGN     16
+
+static uint32 AlignMapSection(uint32 offset)
+{
+    return (offset + MAP_SECTION_ALIGN - 1) & ~uint32(MAP_SECTION_ALIGN - 1);
+}
+
+// pads the file with zeros up to the start of the next section
+static void WriteMapPadding(FILE* output, uint32 offset)
+{
+    static char const zeros[MAP_SECTION_ALIGN] = { 0 };
+    long pos = ftell(output);
+    if (pos >= 0 && uint32(pos) < offset)
+        fwrite(zeros, 1, offset - uint32(pos), output);
+}
+
 #define MAP_AREA_NO_AREA      0x0001
 
 struct map_areaHeader
@@ -359,6 +378,8 @@ bool ConvertADT(char *filename, char *filename2, int cell_y, int cell_x)
     map_fileheader map;
     map.mapMagic = MAP_MAGIC;
     map.versionMagic = MAP_VERSION_MAGIC;
+    map.holesOffset = 0;
+    map.holesSize = 0;
 
     // Get area flags data
     for (int i = 0;i < ADT_CELLS_PER_GRID;i++)
@@ -394,7 +415,7 @@ bool ConvertADT(char *filename, char *filename2, int cell_y, int cell_x)
         }
     }
 
-    map.areaMapOffset = sizeof(map);
+    map.areaMapOffset = AlignMapSection(sizeof(map));
     map.areaMapSize   = sizeof(map_areaHeader);
 
     map_areaHeader areaHeader;
@@ -520,7 +541,7 @@ bool ConvertADT(char *filename, char *filename2, int cell_y, int cell_x)
             maxHeight = CONF_use_minHeight;
     }
 
-    map.heightMapOffset = map.areaMapOffset + map.areaMapSize;
+    map.heightMapOffset = AlignMapSection(map.areaMapOffset + map.areaMapSize);
     map.heightMapSize = sizeof(map_heightHeader);
 
     map_heightHeader heightHeader;
@@ -755,7 +776,7 @@ bool ConvertADT(char *filename, char *filename2, int cell_y, int cell_x)
                     liquid_height[y][x] = CONF_use_minHeight;
             }
         }
-        map.liquidMapOffset = map.heightMapOffset + map.heightMapSize;
+        map.liquidMapOffset = AlignMapSection(map.heightMapOffset + map.heightMapSize);
         map.liquidMapSize = sizeof(map_liquidHeader);
         liquidHeader.fourcc = MAP_LIQUID_MAGIC;
         liquidHeader.flags = 0;
@@ -794,11 +815,13 @@ bool ConvertADT(char *filename, char *filename2, int cell_y, int cell_x)
     }
     fwrite(&map, sizeof(map), 1, output);
     // Store area data
+    WriteMapPadding(output, map.areaMapOffset);
     fwrite(&areaHeader, sizeof(areaHeader), 1, output);
     if (!(areaHeader.flags&MAP_AREA_NO_AREA))
         fwrite(area_flags, sizeof(area_flags), 1, output);
 
     // Store height data
+    WriteMapPadding(output, map.heightMapOffset);
     fwrite(&heightHeader, sizeof(heightHeader), 1, output);
     if (!(heightHeader.flags & MAP_HEIGHT_NO_HEIGHT))
     {
@@ -822,6 +845,7 @@ bool ConvertADT(char *filename, char *filename2, int cell_y, int cell_x)
     // Store liquid data if need
     if (map.liquidMapOffset)
     {
+        WriteMapPadding(output, map.liquidMapOffset);
         fwrite(&liquidHeader, sizeof(liquidHeader), 1, output);
         if (!(liquidHeader.flags&MAP_LIQUID_NO_TYPE))
             fwrite(liquid_type, sizeof(liquid_type), 1, output);
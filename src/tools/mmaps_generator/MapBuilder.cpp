@@ -0,0 +1,573 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapBuilder.h"
+#include "TerrainBuilder.h"
+#include "SharedDefines.h"
+#include "Timer.h"
+
+#include "Recast.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshBuilder.h"
+
+#include <ace/OS_NS_sys_stat.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// one .mmtile covers a map grid, recast builds it in TILES_PER_MAP x TILES_PER_MAP subtiles
+#define BASE_UNIT_DIM       0.2666666f                      // yards per voxel
+#define VERTEX_PER_MAP      int(GRID_SIZE / BASE_UNIT_DIM + 0.5f)
+#define VERTEX_PER_TILE     80
+#define TILES_PER_MAP       (VERTEX_PER_MAP / VERTEX_PER_TILE)
+#define WALKABLE_RADIUS     2
+#define BORDER_SIZE         (WALKABLE_RADIUS + 3)           // voxels around a subtile for the erosion
+
+namespace
+{
+    // frees the intermediate recast data of a subtile whichever step fails
+    struct SubTileData
+    {
+        SubTileData() : solid(NULL), chf(NULL), cset(NULL) {}
+        ~SubTileData()
+        {
+            rcFreeHeightField(solid);
+            rcFreeCompactHeightfield(chf);
+            rcFreeContourSet(cset);
+        }
+
+        rcHeightfield* solid;
+        rcCompactHeightfield* chf;
+        rcContourSet* cset;
+    };
+
+    // triangle indices and areas of the triangles that touch one subtile
+    struct SubTileTris
+    {
+        std::vector<int> solidTris;
+        std::vector<uint8> solidAreas;
+        std::vector<int> liquidTris;
+        std::vector<uint8> liquidAreas;
+    };
+
+    // puts every triangle into the subtiles its bounding box overlaps, border included
+    void bucketTriangles(std::vector<float> const& verts, std::vector<int> const& tris, std::vector<uint8> const& areas,
+                         float const* bmin, float subTileSize, float border, std::vector<SubTileTris> &buckets, bool liquid)
+    {
+        for (size_t t = 0; t < areas.size(); ++t)
+        {
+            if (areas[t] == RC_NULL_AREA)
+                continue;
+
+            float tmin[2] = { FLT_MAX, FLT_MAX };
+            float tmax[2] = { -FLT_MAX, -FLT_MAX };
+            for (int i = 0; i < 3; ++i)
+            {
+                float const* v = &verts[tris[t * 3 + i] * 3];
+                tmin[0] = std::min(tmin[0], v[0]);
+                tmax[0] = std::max(tmax[0], v[0]);
+                tmin[1] = std::min(tmin[1], v[2]);
+                tmax[1] = std::max(tmax[1], v[2]);
+            }
+
+            int first[2], last[2];
+            for (int i = 0; i < 2; ++i)
+            {
+                float origin = bmin[i * 2];
+                first[i] = std::max(0, int(floorf((tmin[i] - origin - border) / subTileSize)));
+                last[i] = std::min(TILES_PER_MAP - 1, int(floorf((tmax[i] - origin + border) / subTileSize)));
+            }
+
+            for (int y = first[1]; y <= last[1]; ++y)
+            {
+                for (int x = first[0]; x <= last[0]; ++x)
+                {
+                    SubTileTris &bucket = buckets[y * TILES_PER_MAP + x];
+                    std::vector<int> &bucketTris = liquid ? bucket.liquidTris : bucket.solidTris;
+                    bucketTris.insert(bucketTris.end(), tris.begin() + t * 3, tris.begin() + t * 3 + 3);
+                    (liquid ? bucket.liquidAreas : bucket.solidAreas).push_back(areas[t]);
+                }
+            }
+        }
+    }
+}
+
+namespace MMAP
+{
+    MapBuilder::MapBuilder(float maxWalkableAngle, bool skipLiquid, bool skipExisting, char const* offMeshFilePath) :
+        m_queuePos(0), m_maxWalkableAngle(maxWalkableAngle), m_skipLiquid(skipLiquid),
+        m_skipExisting(skipExisting), m_offMeshFilePath(offMeshFilePath ? offMeshFilePath : "")
+    {
+    }
+
+    void MapBuilder::discoverTiles(int32 mapId)
+    {
+        char prefix[10] = "";
+        if (mapId >= 0)
+            sprintf(prefix, "%03i", mapId);
+
+        // maps/MMMXXYY.map
+        std::vector<std::string> files;
+        getDirContents(files, "maps", prefix, ".map");
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            if (files[i].size() != 11)
+                continue;
+
+            uint32 map = uint32(atoi(files[i].substr(0, 3).c_str()));
+            uint32 gx = uint32(atoi(files[i].substr(3, 2).c_str()));
+            uint32 gy = uint32(atoi(files[i].substr(5, 2).c_str()));
+            m_tiles[map].insert(std::make_pair(gx, gy));
+        }
+
+        // vmaps/MMM_YY_XX.vmtile, see StaticMapTree::getTileFileName
+        files.clear();
+        getDirContents(files, "vmaps", prefix, ".vmtile");
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            if (files[i].size() != 16)
+                continue;
+
+            uint32 map = uint32(atoi(files[i].substr(0, 3).c_str()));
+            uint32 gy = uint32(atoi(files[i].substr(4, 2).c_str()));
+            uint32 gx = uint32(atoi(files[i].substr(7, 2).c_str()));
+            m_tiles[map].insert(std::make_pair(gx, gy));
+        }
+    }
+
+    void MapBuilder::loadOffMeshConnections()
+    {
+        if (m_offMeshFilePath.empty())
+            return;
+
+        FILE* file = fopen(m_offMeshFilePath.c_str(), "rb");
+        if (!file)
+        {
+            printf("Could not open the off mesh connections file %s\n", m_offMeshFilePath.c_str());
+            return;
+        }
+
+        // mapId gy,gx (x y z) (x y z) radius
+        char buf[512];
+        while (fgets(buf, sizeof(buf), file))
+        {
+            OffMeshConnection connection;
+            float start[3], end[3];
+            if (sscanf(buf, "%u %u,%u (%f %f %f) (%f %f %f) %f", &connection.mapId, &connection.gy, &connection.gx,
+                &start[0], &start[1], &start[2], &end[0], &end[1], &end[2], &connection.radius) != 10)
+                continue;
+
+            connection.start[0] = start[1];
+            connection.start[1] = start[2];
+            connection.start[2] = start[0];
+            connection.end[0] = end[1];
+            connection.end[1] = end[2];
+            connection.end[2] = end[0];
+            m_offMeshConnections.push_back(connection);
+        }
+
+        fclose(file);
+    }
+
+    bool MapBuilder::writeNavMeshParams(uint32 mapId)
+    {
+        // detour tile x and y run along the recast x and z, see getGridBounds
+        dtNavMeshParams params;
+        params.orig[0] = -32 * GRID_SIZE;
+        params.orig[1] = 0.0f;
+        params.orig[2] = -32 * GRID_SIZE;
+        params.tileWidth = GRID_SIZE;
+        params.tileHeight = GRID_SIZE;
+        params.maxTiles = int(m_tiles[mapId].size());
+        params.maxPolys = 1 << STATIC_POLY_BITS;
+
+        char fileName[255];
+        sprintf(fileName, "mmaps/%03u.mmap", mapId);
+        FILE* file = fopen(fileName, "wb");
+        if (!file)
+        {
+            printf("Could not write %s\n", fileName);
+            return false;
+        }
+
+        fwrite(&params, sizeof(dtNavMeshParams), 1, file);
+        fclose(file);
+        return true;
+    }
+
+    void MapBuilder::buildMaps(int32 mapId, uint32 threads)
+    {
+        discoverTiles(mapId);
+        loadOffMeshConnections();
+        ACE_OS::mkdir("mmaps");
+
+        for (MapTileSet::const_iterator itr = m_tiles.begin(); itr != m_tiles.end(); ++itr)
+        {
+            if (!writeNavMeshParams(itr->first))
+                return;
+
+            for (TileSet::const_iterator tile = itr->second.begin(); tile != itr->second.end(); ++tile)
+                m_queue.push_back(TileId(itr->first, tile->first, tile->second));
+        }
+
+        if (m_queue.empty())
+        {
+            printf("No map or vmap tiles found, run the extractors first\n");
+            return;
+        }
+
+        printf("Building %u tiles of %u maps with %u threads\n", uint32(m_queue.size()), uint32(m_tiles.size()), threads);
+
+        uint32 startTime = getMSTime();
+        m_queuePos = 0;
+        activate(THR_NEW_LWP | THR_JOINABLE, int(threads));
+        wait();
+
+        printf("Built %u tiles in %u s\n", uint32(m_queue.size()), GetMSTimeDiffToNow(startTime) / IN_MILLISECONDS);
+    }
+
+    void MapBuilder::buildSingleTile(uint32 mapId, uint32 gx, uint32 gy)
+    {
+        discoverTiles(int32(mapId));
+
+        MapTileSet::const_iterator itr = m_tiles.find(mapId);
+        if (itr == m_tiles.end() || !itr->second.count(std::make_pair(gx, gy)))
+        {
+            printf("No map or vmap data for tile [%02u,%02u] of map %03u\n", gx, gy, mapId);
+            return;
+        }
+
+        loadOffMeshConnections();
+        ACE_OS::mkdir("mmaps");
+
+        // the tile count of the map is the same, the .mmap only has to exist
+        char fileName[255];
+        sprintf(fileName, "mmaps/%03u.mmap", mapId);
+        if (!fileExists(fileName) && !writeNavMeshParams(mapId))
+            return;
+
+        m_queue.push_back(TileId(mapId, gx, gy));
+        m_queuePos = 0;
+        svc();
+    }
+
+    bool MapBuilder::getNextTile(TileId &tile)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, m_queueLock, false);
+
+        if (m_queuePos >= m_queue.size())
+            return false;
+
+        tile = m_queue[m_queuePos++];
+        return true;
+    }
+
+    int MapBuilder::svc()
+    {
+        // VMapManager2 is not thread safe, every thread loads its own models
+        TerrainBuilder terrain(m_skipLiquid);
+
+        TileId tile(0, 0, 0);
+        while (getNextTile(tile))
+        {
+            uint32 startTime = getMSTime();
+            if (buildTile(terrain, tile))
+                printf("[Map %03u] Built tile [%02u,%02u] in %u ms\n", tile.mapId, tile.gx, tile.gy, GetMSTimeDiffToNow(startTime));
+        }
+
+        return 0;
+    }
+
+    bool MapBuilder::buildTile(TerrainBuilder &terrain, TileId const& tile)
+    {
+        char fileName[255];
+        sprintf(fileName, "mmaps/%03u%02u%02u.mmtile", tile.mapId, tile.gx, tile.gy);
+        if (m_skipExisting && fileExists(fileName))
+            return false;
+
+        // the terrain of the neighbours reaches into the border of the subtiles at the tile edges
+        MeshData meshData;
+        terrain.loadMap(tile.mapId, tile.gx, tile.gy, (BORDER_SIZE + 1) * BASE_UNIT_DIM, meshData);
+        terrain.loadVMap(tile.mapId, tile.gx, tile.gy, meshData);
+        terrain.unloadVMap(tile.mapId, tile.gx, tile.gy);
+
+        if (meshData.solidTris.empty() && meshData.liquidTris.empty())
+            return false;
+
+        for (std::vector<OffMeshConnection>::const_iterator itr = m_offMeshConnections.begin(); itr != m_offMeshConnections.end(); ++itr)
+        {
+            if (itr->mapId != tile.mapId || itr->gx != tile.gx || itr->gy != tile.gy)
+                continue;
+
+            meshData.offMeshConnections.insert(meshData.offMeshConnections.end(), itr->start, itr->start + 3);
+            meshData.offMeshConnections.insert(meshData.offMeshConnections.end(), itr->end, itr->end + 3);
+            meshData.offMeshConnectionRads.push_back(itr->radius);
+            meshData.offMeshConnectionDirs.push_back(DT_OFFMESH_CON_BIDIR);
+            meshData.offMeshConnectionsAreas.push_back(0xFF);
+            meshData.offMeshConnectionsFlags.push_back(0xFF);
+        }
+
+        return buildNavMeshTile(tile, meshData, fileName);
+    }
+
+    bool MapBuilder::buildNavMeshTile(TileId const& tile, MeshData &meshData, char const* fileName)
+    {
+        rcContext context(false);
+
+        int solidVertCount = int(meshData.solidVerts.size() / 3);
+        int solidTriCount = int(meshData.solidTris.size() / 3);
+
+        rcConfig config;
+        memset(&config, 0, sizeof(rcConfig));
+        getGridBounds(tile.gx, tile.gy, config.bmin, config.bmax);
+
+        // the height range of the heightfields is the one of the geometry
+        config.bmin[1] = FLT_MAX;
+        config.bmax[1] = -FLT_MAX;
+        for (size_t i = 1; i < meshData.solidVerts.size(); i += 3)
+        {
+            config.bmin[1] = std::min(config.bmin[1], meshData.solidVerts[i]);
+            config.bmax[1] = std::max(config.bmax[1], meshData.solidVerts[i]);
+        }
+        for (size_t i = 1; i < meshData.liquidVerts.size(); i += 3)
+        {
+            config.bmin[1] = std::min(config.bmin[1], meshData.liquidVerts[i]);
+            config.bmax[1] = std::max(config.bmax[1], meshData.liquidVerts[i]);
+        }
+
+        config.maxVertsPerPoly = DT_VERTS_PER_POLYGON;
+        config.cs = BASE_UNIT_DIM;
+        config.ch = BASE_UNIT_DIM;
+        config.walkableSlopeAngle = m_maxWalkableAngle;
+        config.tileSize = VERTEX_PER_TILE;
+        config.walkableRadius = WALKABLE_RADIUS;
+        config.borderSize = BORDER_SIZE;
+        config.maxEdgeLen = VERTEX_PER_TILE + 1;            // anything bigger than tileSize
+        config.walkableHeight = 6;
+        config.walkableClimb = 4;
+        config.minRegionArea = rcSqr(60);
+        config.mergeRegionArea = rcSqr(50);
+        config.maxSimplificationError = 2.0f;
+        config.detailSampleDist = config.cs * 64;
+        config.detailSampleMaxError = config.ch * 2;
+        config.width = config.tileSize + config.borderSize * 2;
+        config.height = config.tileSize + config.borderSize * 2;
+
+        // too steep triangles are no ground, liquids are walkable whatever their slope
+        std::vector<uint8> solidAreas(solidTriCount, NAV_GROUND);
+        if (solidTriCount)
+            rcClearUnwalkableTriangles(&context, config.walkableSlopeAngle, &meshData.solidVerts[0], solidVertCount,
+                                       &meshData.solidTris[0], solidTriCount, &solidAreas[0]);
+
+        // the terrain of a whole tile is millions of triangles, rasterizing all of them for
+        // every subtile is most of the build time
+        float const subTileSize = config.tileSize * config.cs;
+        float const border = config.borderSize * config.cs;
+        std::vector<SubTileTris> buckets(TILES_PER_MAP * TILES_PER_MAP);
+        bucketTriangles(meshData.solidVerts, meshData.solidTris, solidAreas, config.bmin, subTileSize, border, buckets, false);
+        bucketTriangles(meshData.liquidVerts, meshData.liquidTris, meshData.liquidType, config.bmin, subTileSize, border, buckets, true);
+
+        std::vector<rcPolyMesh*> polyMeshes;
+        std::vector<rcPolyMeshDetail*> detailMeshes;
+        bool success = true;
+
+        for (int y = 0; y < TILES_PER_MAP && success; ++y)
+        {
+            for (int x = 0; x < TILES_PER_MAP && success; ++x)
+            {
+                SubTileTris const& bucket = buckets[y * TILES_PER_MAP + x];
+                if (bucket.solidTris.empty() && bucket.liquidTris.empty())
+                    continue;
+
+                rcConfig subConfig = config;
+                subConfig.bmin[0] = config.bmin[0] + x * subTileSize - border;
+                subConfig.bmin[2] = config.bmin[2] + y * subTileSize - border;
+                subConfig.bmax[0] = config.bmin[0] + (x + 1) * subTileSize + border;
+                subConfig.bmax[2] = config.bmin[2] + (y + 1) * subTileSize + border;
+
+                rcPolyMesh* polyMesh = NULL;
+                rcPolyMeshDetail* detailMesh = NULL;
+                success = buildSubTile(context, subConfig, meshData, bucket.solidTris, bucket.solidAreas,
+                                       bucket.liquidTris, bucket.liquidAreas, polyMesh, detailMesh);
+
+                if (success && polyMesh->npolys)
+                {
+                    polyMeshes.push_back(polyMesh);
+                    detailMeshes.push_back(detailMesh);
+                }
+                else
+                {
+                    rcFreePolyMesh(polyMesh);
+                    rcFreePolyMeshDetail(detailMesh);
+                }
+            }
+        }
+
+        rcPolyMesh* polyMesh = NULL;
+        rcPolyMeshDetail* detailMesh = NULL;
+        if (success && !polyMeshes.empty())
+        {
+            polyMesh = rcAllocPolyMesh();
+            detailMesh = rcAllocPolyMeshDetail();
+            success = polyMesh && detailMesh &&
+                rcMergePolyMeshes(&context, &polyMeshes[0], int(polyMeshes.size()), *polyMesh) &&
+                rcMergePolyMeshDetails(&context, &detailMeshes[0], int(detailMeshes.size()), *detailMesh);
+        }
+
+        for (size_t i = 0; i < polyMeshes.size(); ++i)
+        {
+            rcFreePolyMesh(polyMeshes[i]);
+            rcFreePolyMeshDetail(detailMeshes[i]);
+        }
+
+        if (!success)
+            printf("[Map %03u] Failed to build tile [%02u,%02u]\n", tile.mapId, tile.gx, tile.gy);
+        else if (!polyMesh)
+            printf("[Map %03u] Tile [%02u,%02u] has no walkable area\n", tile.mapId, tile.gx, tile.gy);
+
+        if (!success || !polyMesh)
+        {
+            rcFreePolyMesh(polyMesh);
+            rcFreePolyMeshDetail(detailMesh);
+            return false;
+        }
+
+        // the pathfinder filters on the terrain type
+        for (int i = 0; i < polyMesh->npolys; ++i)
+            polyMesh->flags[i] = polyMesh->areas[i];
+
+        dtNavMeshCreateParams params;
+        memset(&params, 0, sizeof(params));
+        params.verts = polyMesh->verts;
+        params.vertCount = polyMesh->nverts;
+        params.polys = polyMesh->polys;
+        params.polyAreas = polyMesh->areas;
+        params.polyFlags = polyMesh->flags;
+        params.polyCount = polyMesh->npolys;
+        params.nvp = polyMesh->nvp;
+        params.detailMeshes = detailMesh->meshes;
+        params.detailVerts = detailMesh->verts;
+        params.detailVertsCount = detailMesh->nverts;
+        params.detailTris = detailMesh->tris;
+        params.detailTriCount = detailMesh->ntris;
+
+        params.offMeshConCount = int(meshData.offMeshConnectionRads.size());
+        if (params.offMeshConCount)
+        {
+            params.offMeshConVerts = &meshData.offMeshConnections[0];
+            params.offMeshConRad = &meshData.offMeshConnectionRads[0];
+            params.offMeshConFlags = &meshData.offMeshConnectionsFlags[0];
+            params.offMeshConAreas = &meshData.offMeshConnectionsAreas[0];
+            params.offMeshConDir = &meshData.offMeshConnectionDirs[0];
+        }
+
+        params.walkableHeight = BASE_UNIT_DIM * config.walkableHeight;
+        params.walkableRadius = BASE_UNIT_DIM * config.walkableRadius;
+        params.walkableClimb = BASE_UNIT_DIM * config.walkableClimb;
+        params.tileX = MAX_GRIDS_PER_MAP - 1 - tile.gy;
+        params.tileY = MAX_GRIDS_PER_MAP - 1 - tile.gx;
+        rcVcopy(params.bmin, polyMesh->bmin);
+        rcVcopy(params.bmax, polyMesh->bmax);
+        params.cs = config.cs;
+        params.ch = config.ch;
+        params.tileSize = VERTEX_PER_MAP;
+
+        unsigned char* navData = NULL;
+        int navDataSize = 0;
+        success = dtCreateNavMeshData(&params, &navData, &navDataSize);
+
+        rcFreePolyMesh(polyMesh);
+        rcFreePolyMeshDetail(detailMesh);
+
+        if (!success)
+        {
+            printf("[Map %03u] Failed to create the navmesh data of tile [%02u,%02u]\n", tile.mapId, tile.gx, tile.gy);
+            return false;
+        }
+
+        FILE* file = fopen(fileName, "wb");
+        if (!file)
+        {
+            printf("Could not write %s\n", fileName);
+            dtFree(navData);
+            return false;
+        }
+
+        MmapTileHeader header;
+        header.usesLiquids = !m_skipLiquid;
+        header.size = uint32(navDataSize);
+        fwrite(&header, sizeof(MmapTileHeader), 1, file);
+        fwrite(navData, sizeof(unsigned char), navDataSize, file);
+        fclose(file);
+
+        dtFree(navData);
+        return true;
+    }
+
+    bool MapBuilder::buildSubTile(rcContext &context, rcConfig const& config, MeshData const& meshData,
+                                  std::vector<int> const& solidTris, std::vector<uint8> const& solidAreas,
+                                  std::vector<int> const& liquidTris, std::vector<uint8> const& liquidAreas,
+                                  rcPolyMesh* &polyMesh, rcPolyMeshDetail* &detailMesh)
+    {
+        SubTileData data;
+
+        data.solid = rcAllocHeightfield();
+        if (!data.solid || !rcCreateHeightfield(&context, *data.solid, config.width, config.height, config.bmin, config.bmax, config.cs, config.ch))
+            return false;
+
+        if (!solidTris.empty())
+            rcRasterizeTriangles(&context, &meshData.solidVerts[0], int(meshData.solidVerts.size() / 3), &solidTris[0],
+                                 &solidAreas[0], int(solidAreas.size()), *data.solid, config.walkableClimb);
+
+        rcFilterLowHangingWalkableObstacles(&context, config.walkableClimb, *data.solid);
+        rcFilterLedgeSpans(&context, config.walkableHeight, config.walkableClimb, *data.solid);
+        rcFilterWalkableLowHeightSpans(&context, config.walkableHeight, *data.solid);
+
+        // liquids after the filters, their edges are no ledges
+        if (!liquidTris.empty())
+            rcRasterizeTriangles(&context, &meshData.liquidVerts[0], int(meshData.liquidVerts.size() / 3), &liquidTris[0],
+                                 &liquidAreas[0], int(liquidAreas.size()), *data.solid, config.walkableClimb);
+
+        data.chf = rcAllocCompactHeightfield();
+        if (!data.chf || !rcBuildCompactHeightfield(&context, config.walkableHeight, config.walkableClimb, *data.solid, *data.chf))
+            return false;
+
+        if (!rcErodeWalkableArea(&context, config.walkableRadius, *data.chf) ||
+            !rcBuildDistanceField(&context, *data.chf) ||
+            !rcBuildRegions(&context, *data.chf, config.borderSize, config.minRegionArea, config.mergeRegionArea))
+            return false;
+
+        data.cset = rcAllocContourSet();
+        if (!data.cset || !rcBuildContours(&context, *data.chf, config.maxSimplificationError, config.maxEdgeLen, *data.cset))
+            return false;
+
+        polyMesh = rcAllocPolyMesh();
+        if (!polyMesh || !rcBuildPolyMesh(&context, *data.cset, config.maxVertsPerPoly, *polyMesh))
+            return false;
+
+        detailMesh = rcAllocPolyMeshDetail();
+        if (!detailMesh || !rcBuildPolyMeshDetail(&context, *polyMesh, *data.chf, config.detailSampleDist, config.detailSampleMaxError, *detailMesh))
+            return false;
+
+        return true;
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MMAP_MAP_BUILDER_H
+#define _MMAP_MAP_BUILDER_H
+
+#include "PathCommon.h"
+
+#include <ace/Task.h>
+#include <ace/Thread_Mutex.h>
+#include <map>
+#include <set>
+
+struct rcConfig;
+struct rcPolyMesh;
+struct rcPolyMeshDetail;
+class rcContext;
+
+namespace MMAP
+{
+    class TerrainBuilder;
+
+    typedef std::set<std::pair<uint32, uint32> > TileSet;   // (gx, gy)
+    typedef std::map<uint32, TileSet> MapTileSet;
+
+    /*
+      Builds one .mmtile per map grid with recast and detour. The tiles are queued up front
+      and taken by the worker threads one by one, every worker has its own TerrainBuilder.
+      A tile is split into subtiles for recast and the subtile meshes are merged again, so
+      the .mmtile layout is the one MMapManager::loadMap expects.
+    */
+    class MapBuilder : public ACE_Task_Base
+    {
+        public:
+            MapBuilder(float maxWalkableAngle, bool skipLiquid, bool skipExisting, char const* offMeshFilePath);
+
+            // builds every tile of mapId, or of all maps with a negative mapId
+            void buildMaps(int32 mapId, uint32 threads);
+            // rebuilds one tile of mapId, gx and gy are the grid coordinates of the server
+            void buildSingleTile(uint32 mapId, uint32 gx, uint32 gy);
+
+            int svc();
+
+        private:
+            void discoverTiles(int32 mapId);
+            void loadOffMeshConnections();
+            bool writeNavMeshParams(uint32 mapId);
+
+            bool getNextTile(TileId &tile);
+            bool buildTile(TerrainBuilder &terrain, TileId const& tile);
+            bool buildNavMeshTile(TileId const& tile, MeshData &meshData, char const* fileName);
+            bool buildSubTile(rcContext &context, rcConfig const& config, MeshData const& meshData,
+                              std::vector<int> const& solidTris, std::vector<uint8> const& solidAreas,
+                              std::vector<int> const& liquidTris, std::vector<uint8> const& liquidAreas,
+                              rcPolyMesh* &polyMesh, rcPolyMeshDetail* &detailMesh);
+
+            MapTileSet m_tiles;
+            std::vector<OffMeshConnection> m_offMeshConnections;
+
+            std::vector<TileId> m_queue;
+            size_t m_queuePos;
+            ACE_Thread_Mutex m_queueLock;
+
+            float m_maxWalkableAngle;
+            bool m_skipLiquid;
+            bool m_skipExisting;
+            std::string m_offMeshFilePath;
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MMAP_COMMON_H
+#define _MMAP_COMMON_H
+
+#include "Define.h"
+
+#include <ace/Dirent.h>
+#include <ace/OS_NS_sys_stat.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define GRID_SIZE           533.33333f
+#define MAP_RESOLUTION      128
+#define GRID_PART_SIZE      (GRID_SIZE / MAP_RESOLUTION)
+#define V9_SIZE             (MAP_RESOLUTION + 1)
+#define V8_SIZE             MAP_RESOLUTION
+#define MAX_GRIDS_PER_MAP   64
+
+namespace MMAP
+{
+    // one navmesh tile is built per map grid, gx and gy are the grid coordinates of the
+    // server (Map::LoadMap), the .map, .vmtile and .mmtile files are named after them
+    struct TileId
+    {
+        TileId(uint32 map, uint32 x, uint32 y) : mapId(map), gx(x), gy(y) {}
+
+        bool operator<(TileId const& other) const
+        {
+            if (mapId != other.mapId)
+                return mapId < other.mapId;
+            if (gx != other.gx)
+                return gx < other.gx;
+            return gy < other.gy;
+        }
+
+        uint32 mapId;
+        uint32 gx;
+        uint32 gy;
+    };
+
+    struct OffMeshConnection
+    {
+        uint32 mapId;
+        uint32 gx;
+        uint32 gy;
+        float start[3];                                     // recast coordinates (y, z, x)
+        float end[3];
+        float radius;
+    };
+
+    // geometry of one tile in recast coordinates (y, z, x), triangles index the vertices
+    struct MeshData
+    {
+        std::vector<float> solidVerts;
+        std::vector<int> solidTris;
+
+        std::vector<float> liquidVerts;
+        std::vector<int> liquidTris;
+        std::vector<uint8> liquidType;                      // NavTerrain of each liquid triangle
+
+        std::vector<float> offMeshConnections;              // start and end of each connection
+        std::vector<float> offMeshConnectionRads;
+        std::vector<uint8> offMeshConnectionDirs;
+        std::vector<uint8> offMeshConnectionsAreas;
+        std::vector<uint16> offMeshConnectionsFlags;
+    };
+
+    // appends the names of the files in dirPath that start with prefix and end with suffix
+    inline bool getDirContents(std::vector<std::string> &fileList, std::string const& dirPath,
+                               std::string const& prefix, std::string const& suffix)
+    {
+        ACE_Dirent dir;
+        if (dir.open(dirPath.c_str()) == -1)
+            return false;
+
+        while (ACE_DIRENT* entry = dir.read())
+        {
+            std::string name = entry->d_name;
+            if (name.size() < prefix.size() + suffix.size())
+                continue;
+
+            if (name.compare(0, prefix.size(), prefix) == 0 &&
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+                fileList.push_back(name);
+        }
+
+        return true;
+    }
+
+    inline bool fileExists(char const* fileName)
+    {
+        ACE_stat st;
+        return ACE_OS::stat(fileName, &st) == 0;
+    }
+}
+
+#endif
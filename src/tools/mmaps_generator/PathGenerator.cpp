@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapBuilder.h"
+
+#include <ace/OS_NS_unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace MMAP;
+
+void Usage(char* prg)
+{
+    printf(
+        "Usage:\n"\
+        "%s [mapId] [--option value]\n"\
+        "mapId               build only this map, all maps by default\n"\
+        "--tile gx,gy        build only this grid of mapId, like the maps/MMMXXYY.map file name\n"\
+        "--threads n         number of worker threads, one per core by default\n"\
+        "--maxAngle degrees  steepest walkable slope, 60 by default\n"\
+        "--skipLiquid        do not build navmesh on liquids\n"\
+        "--skipExisting      keep the .mmtile files that already exist\n"\
+        "--offMeshInput file off mesh connections, offmesh.txt by default\n"\
+        "Run it in the directory that has the maps and vmaps directories.\n"\
+        "Example: %s 530 --threads 8\n", prg, prg);
+    exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+    int32 mapId = -1;
+    int32 gx = -1, gy = -1;
+    int32 threads = ACE_OS::num_processors_online();
+    float maxAngle = 60.0f;
+    bool skipLiquid = false;
+    bool skipExisting = false;
+    char const* offMeshInput = "offmesh.txt";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--tile") && hasValue)
+        {
+            if (sscanf(argv[++i], "%d,%d", &gx, &gy) != 2 || gx < 0 || gy < 0 || gx >= MAX_GRIDS_PER_MAP || gy >= MAX_GRIDS_PER_MAP)
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--threads") && hasValue)
+        {
+            threads = atoi(argv[++i]);
+            if (threads <= 0)
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--maxAngle") && hasValue)
+        {
+            maxAngle = float(atof(argv[++i]));
+            if (maxAngle < 45.0f || maxAngle > 90.0f)
+                Usage(argv[0]);
+        }
+        else if (!strcmp(argv[i], "--offMeshInput") && hasValue)
+            offMeshInput = argv[++i];
+        else if (!strcmp(argv[i], "--skipLiquid"))
+            skipLiquid = true;
+        else if (!strcmp(argv[i], "--skipExisting"))
+            skipExisting = true;
+        else if (argv[i][0] >= '0' && argv[i][0] <= '9' && mapId < 0)
+            mapId = atoi(argv[i]);
+        else
+            Usage(argv[0]);
+    }
+
+    if (gx >= 0 && mapId < 0)
+    {
+        printf("--tile needs a mapId\n");
+        Usage(argv[0]);
+    }
+
+    // num_processors_online returns -1 where it is not supported
+    if (threads <= 0)
+        threads = 1;
+
+    MapBuilder builder(maxAngle, skipLiquid, skipExisting, offMeshInput);
+    if (gx >= 0)
+        builder.buildSingleTile(uint32(mapId), uint32(gx), uint32(gy));
+    else
+        builder.buildMaps(mapId, uint32(threads));
+
+    return 0;
+}
@@ -0,0 +1,444 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TerrainBuilder.h"
+#include "SharedDefines.h"
+
+#include "VMapManager2.h"
+#include "MapTree.h"
+#include "ModelInstance.h"
+#include "WorldModel.h"
+#include "VMapDefinitions.h"
+
+#include <G3D/Matrix3.h>
+#include <cfloat>
+#include <cstdio>
+
+// Map file format data, see map_extractor
+#define MAP_MAGIC             'SPAM'
+#define MAP_VERSION_MAGIC     '7.0w'
+
+struct map_fileheader
+{
+    uint32 mapMagic;
+    uint32 versionMagic;
+    uint32 areaMapOffset;
+    uint32 areaMapSize;
+    uint32 heightMapOffset;
+    uint32 heightMapSize;
+    uint32 liquidMapOffset;
+    uint32 liquidMapSize;
+    uint32 holesOffset;
+    uint32 holesSize;
+};
+
+#define MAP_HEIGHT_NO_HEIGHT  0x0001
+#define MAP_HEIGHT_AS_INT16   0x0002
+#define MAP_HEIGHT_AS_INT8    0x0004
+
+struct map_heightHeader
+{
+    uint32 fourcc;
+    uint32 flags;
+    float  gridHeight;
+    float  gridMaxHeight;
+};
+
+#define MAP_LIQUID_TYPE_WATER       0x01
+#define MAP_LIQUID_TYPE_OCEAN       0x02
+#define MAP_LIQUID_TYPE_MAGMA       0x04
+#define MAP_LIQUID_TYPE_SLIME       0x08
+
+#define MAP_LIQUID_NO_TYPE    0x0001
+#define MAP_LIQUID_NO_HEIGHT  0x0002
+
+struct map_liquidHeader
+{
+    uint32 fourcc;
+    uint16 flags;
+    uint16 liquidType;
+    uint8  offsetX;
+    uint8  offsetY;
+    uint8  width;
+    uint8  height;
+    float  liquidLevel;
+};
+
+// the extractor stores this level where a grid has no liquid
+#define MAP_LIQUID_MIN_LEVEL  -500.0f
+
+namespace
+{
+    // takes server coordinates, stores recast coordinates
+    int addVertex(std::vector<float> &verts, float x, float y, float z)
+    {
+        verts.push_back(y);
+        verts.push_back(z);
+        verts.push_back(x);
+        return int(verts.size() / 3) - 1;
+    }
+
+    // recast treats triangles facing down as unwalkable, terrain and liquids always face up
+    void addUpTriangle(std::vector<float> const& verts, std::vector<int> &tris, int a, int b, int c)
+    {
+        float const* v0 = &verts[a * 3];
+        float const* v1 = &verts[b * 3];
+        float const* v2 = &verts[c * 3];
+
+        // y of (v1 - v0) x (v2 - v0)
+        if ((v1[2] - v0[2]) * (v2[0] - v0[0]) - (v1[0] - v0[0]) * (v2[2] - v0[2]) < 0.0f)
+            std::swap(b, c);
+
+        tris.push_back(a);
+        tris.push_back(b);
+        tris.push_back(c);
+    }
+
+    template<class T>
+    bool readPackedHeights(FILE* file, std::vector<float> &heights, float base, float multiplier)
+    {
+        std::vector<T> packed(heights.size());
+        if (fread(&packed[0], sizeof(T), packed.size(), file) != packed.size())
+            return false;
+
+        for (size_t i = 0; i < packed.size(); ++i)
+            heights[i] = base + packed[i] * multiplier;
+        return true;
+    }
+
+    uint8 getNavLiquidType(uint8 mapLiquidType)
+    {
+        if (mapLiquidType & MAP_LIQUID_TYPE_MAGMA)
+            return NAV_MAGMA;
+        if (mapLiquidType & MAP_LIQUID_TYPE_SLIME)
+            return NAV_SLIME;
+        if (mapLiquidType & (MAP_LIQUID_TYPE_WATER | MAP_LIQUID_TYPE_OCEAN))
+            return NAV_WATER;
+        return NAV_EMPTY;
+    }
+}
+
+namespace MMAP
+{
+    void getGridBounds(uint32 gx, uint32 gy, float* bmin, float* bmax)
+    {
+        // recast x is the server y, recast z the server x, both grow towards grid 0
+        bmax[0] = (32 - float(gy)) * GRID_SIZE;
+        bmax[2] = (32 - float(gx)) * GRID_SIZE;
+        bmin[0] = bmax[0] - GRID_SIZE;
+        bmin[2] = bmax[2] - GRID_SIZE;
+        bmin[1] = -FLT_MAX;
+        bmax[1] = FLT_MAX;
+    }
+
+    TerrainBuilder::TerrainBuilder(bool skipLiquid) : m_skipLiquid(skipLiquid)
+    {
+        m_vmapManager = new VMAP::VMapManager2();
+    }
+
+    TerrainBuilder::~TerrainBuilder()
+    {
+        delete m_vmapManager;
+    }
+
+    bool TerrainBuilder::loadMap(uint32 mapId, uint32 gx, uint32 gy, float margin, MeshData &meshData)
+    {
+        float bmin[3], bmax[3];
+        getGridBounds(gx, gy, bmin, bmax);
+        bmin[0] -= margin;
+        bmin[2] -= margin;
+        bmax[0] += margin;
+        bmax[2] += margin;
+
+        if (!loadGridMap(mapId, gx, gy, bmin, bmax, meshData))
+            return false;
+
+        for (int32 dx = -1; dx <= 1; ++dx)
+        {
+            for (int32 dy = -1; dy <= 1; ++dy)
+            {
+                int32 x = int32(gx) + dx;
+                int32 y = int32(gy) + dy;
+                if ((dx || dy) && x >= 0 && y >= 0 && x < MAX_GRIDS_PER_MAP && y < MAX_GRIDS_PER_MAP)
+                    loadGridMap(mapId, uint32(x), uint32(y), bmin, bmax, meshData);
+            }
+        }
+
+        return true;
+    }
+
+    bool TerrainBuilder::loadGridMap(uint32 mapId, uint32 gx, uint32 gy, float const* bmin, float const* bmax, MeshData &meshData)
+    {
+        char fileName[255];
+        sprintf(fileName, "maps/%03u%02u%02u.map", mapId, gx, gy);
+
+        FILE* file = fopen(fileName, "rb");
+        if (!file)
+            return false;
+
+        map_fileheader fheader;
+        if (fread(&fheader, sizeof(map_fileheader), 1, file) != 1 ||
+            fheader.mapMagic != MAP_MAGIC || fheader.versionMagic != MAP_VERSION_MAGIC)
+        {
+            printf("%s is not a map file of this version, extract the maps again\n", fileName);
+            fclose(file);
+            return false;
+        }
+
+        map_heightHeader hheader;
+        fseek(file, fheader.heightMapOffset, SEEK_SET);
+        if (fread(&hheader, sizeof(map_heightHeader), 1, file) != 1)
+        {
+            printf("%s has no height data\n", fileName);
+            fclose(file);
+            return false;
+        }
+
+        std::vector<float> V9(V9_SIZE * V9_SIZE, hheader.gridHeight);
+        std::vector<float> V8(V8_SIZE * V8_SIZE, hheader.gridHeight);
+        bool heightsRead = true;
+        if (hheader.flags & MAP_HEIGHT_NO_HEIGHT)
+            {}                                              // flat grid at gridHeight
+        else if (hheader.flags & MAP_HEIGHT_AS_INT16)
+        {
+            float multiplier = (hheader.gridMaxHeight - hheader.gridHeight) / 65535;
+            heightsRead = readPackedHeights<uint16>(file, V9, hheader.gridHeight, multiplier) &&
+                readPackedHeights<uint16>(file, V8, hheader.gridHeight, multiplier);
+        }
+        else if (hheader.flags & MAP_HEIGHT_AS_INT8)
+        {
+            float multiplier = (hheader.gridMaxHeight - hheader.gridHeight) / 255;
+            heightsRead = readPackedHeights<uint8>(file, V9, hheader.gridHeight, multiplier) &&
+                readPackedHeights<uint8>(file, V8, hheader.gridHeight, multiplier);
+        }
+        else
+            heightsRead = fread(&V9[0], sizeof(float), V9.size(), file) == V9.size() &&
+                fread(&V8[0], sizeof(float), V8.size(), file) == V8.size();
+
+        if (!heightsRead)
+        {
+            printf("%s has broken height data\n", fileName);
+            fclose(file);
+            return false;
+        }
+
+        map_liquidHeader lheader;
+        std::vector<uint8> liquidTypes;
+        std::vector<float> liquidLevels;
+        if (!m_skipLiquid && fheader.liquidMapOffset)
+        {
+            fseek(file, fheader.liquidMapOffset, SEEK_SET);
+            if (fread(&lheader, sizeof(map_liquidHeader), 1, file) == 1)
+            {
+                liquidTypes.assign(16 * 16, uint8(lheader.liquidType));
+                if (!(lheader.flags & MAP_LIQUID_NO_TYPE) && fread(&liquidTypes[0], 1, liquidTypes.size(), file) != liquidTypes.size())
+                    liquidTypes.clear();
+
+                if (!(lheader.flags & MAP_LIQUID_NO_HEIGHT))
+                {
+                    liquidLevels.resize(lheader.width * lheader.height);
+                    if (fread(&liquidLevels[0], sizeof(float), liquidLevels.size(), file) != liquidLevels.size())
+                        liquidTypes.clear();
+                }
+            }
+        }
+
+        fclose(file);
+
+        // rows go along the server x, columns along the server y, like in GridMap::getHeight
+        float const xTop = (32 - float(gx)) * GRID_SIZE;
+        float const yTop = (32 - float(gy)) * GRID_SIZE;
+        float const half = GRID_PART_SIZE / 2;
+
+        for (uint32 r = 0; r < V8_SIZE; ++r)
+        {
+            float x0 = xTop - r * GRID_PART_SIZE;
+            if (x0 < bmin[2] || x0 - GRID_PART_SIZE > bmax[2])
+                continue;
+
+            for (uint32 c = 0; c < V8_SIZE; ++c)
+            {
+                float y0 = yTop - c * GRID_PART_SIZE;
+                if (y0 < bmin[0] || y0 - GRID_PART_SIZE > bmax[0])
+                    continue;
+
+                float h00 = V9[r * V9_SIZE + c];
+                float h01 = V9[r * V9_SIZE + c + 1];
+                float h10 = V9[(r + 1) * V9_SIZE + c];
+                float h11 = V9[(r + 1) * V9_SIZE + c + 1];
+
+                // four triangles around the V8 height in the middle of the square
+                std::vector<float> &verts = meshData.solidVerts;
+                int i00 = addVertex(verts, x0, y0, h00);
+                int i01 = addVertex(verts, x0, y0 - GRID_PART_SIZE, h01);
+                int i10 = addVertex(verts, x0 - GRID_PART_SIZE, y0, h10);
+                int i11 = addVertex(verts, x0 - GRID_PART_SIZE, y0 - GRID_PART_SIZE, h11);
+                int center = addVertex(verts, x0 - half, y0 - half, V8[r * V8_SIZE + c]);
+
+                addUpTriangle(verts, meshData.solidTris, center, i00, i01);
+                addUpTriangle(verts, meshData.solidTris, center, i01, i11);
+                addUpTriangle(verts, meshData.solidTris, center, i11, i10);
+                addUpTriangle(verts, meshData.solidTris, center, i10, i00);
+
+                if (liquidTypes.empty())
+                    continue;
+
+                uint8 navType = getNavLiquidType(liquidTypes[(r >> 3) * 16 + (c >> 3)]);
+                int32 lr = int32(r) - lheader.offsetY;
+                int32 lc = int32(c) - lheader.offsetX;
+                if (navType == NAV_EMPTY || lr < 0 || lc < 0 || lr >= lheader.height || lc >= lheader.width)
+                    continue;
+
+                float level = liquidLevels.empty() ? lheader.liquidLevel : liquidLevels[lr * lheader.width + lc];
+
+                // no liquid here, or all of it is below the ground
+                if (level <= MAP_LIQUID_MIN_LEVEL ||
+                    (level < h00 && level < h01 && level < h10 && level < h11))
+                    continue;
+
+                std::vector<float> &liquidVerts = meshData.liquidVerts;
+                int l00 = addVertex(liquidVerts, x0, y0, level);
+                int l01 = addVertex(liquidVerts, x0, y0 - GRID_PART_SIZE, level);
+                int l10 = addVertex(liquidVerts, x0 - GRID_PART_SIZE, y0, level);
+                int l11 = addVertex(liquidVerts, x0 - GRID_PART_SIZE, y0 - GRID_PART_SIZE, level);
+
+                addUpTriangle(liquidVerts, meshData.liquidTris, l00, l01, l11);
+                addUpTriangle(liquidVerts, meshData.liquidTris, l00, l11, l10);
+                meshData.liquidType.push_back(navType);
+                meshData.liquidType.push_back(navType);
+            }
+        }
+
+        return true;
+    }
+
+    bool TerrainBuilder::loadVMap(uint32 mapId, uint32 gx, uint32 gy, MeshData &meshData)
+    {
+        if (m_vmapManager->loadMap("vmaps", mapId, gx, gy) != VMAP::VMAP_LOAD_RESULT_OK)
+            return false;
+
+        VMAP::InstanceTreeMap::const_iterator itr = m_vmapManager->getInstanceMapTree().find(mapId);
+        if (itr == m_vmapManager->getInstanceMapTree().end())
+            return false;
+
+        VMAP::ModelInstance* models = NULL;
+        uint32 count = 0;
+        itr->second->getModelInstances(models, count);
+
+        // inverse of VMapManager2::convertPositionToInternalRep
+        float const mid = 0.5f * 64.0f * 533.33333333f;
+        bool loaded = false;
+
+        for (uint32 i = 0; i < count; ++i)
+        {
+            VMAP::ModelInstance const& instance = models[i];
+
+            // spawns of the tiles that are not loaded have no model
+            VMAP::WorldModel const* worldModel = instance.getWorldModel();
+            if (!worldModel)
+                continue;
+
+            loaded = true;
+
+            // the inverse of the transformation ModelInstance::intersectRay applies to the ray
+            G3D::Matrix3 rotation = G3D::Matrix3::fromEulerAnglesZYX(G3D::pi()*instance.iRot.y/180.f,
+                G3D::pi()*instance.iRot.x/180.f, G3D::pi()*instance.iRot.z/180.f);
+
+            // M2 triangles are wound the other way round than WMO triangles
+            bool isM2 = instance.flags & VMAP::MOD_M2;
+
+            std::vector<VMAP::GroupModel> const& groups = worldModel->getGroupModels();
+            for (std::vector<VMAP::GroupModel>::const_iterator group = groups.begin(); group != groups.end(); ++group)
+            {
+                int offset = int(meshData.solidVerts.size() / 3);
+
+                std::vector<G3D::Vector3> const& vertices = group->GetVertices();
+                for (std::vector<G3D::Vector3>::const_iterator v = vertices.begin(); v != vertices.end(); ++v)
+                {
+                    G3D::Vector3 pos = rotation * (*v * instance.iScale) + instance.iPos;
+                    addVertex(meshData.solidVerts, mid - pos.x, mid - pos.y, pos.z);
+                }
+
+                std::vector<VMAP::MeshTriangle> const& triangles = group->GetTriangles();
+                for (std::vector<VMAP::MeshTriangle>::const_iterator t = triangles.begin(); t != triangles.end(); ++t)
+                {
+                    meshData.solidTris.push_back(offset + int(isM2 ? t->idx2 : t->idx0));
+                    meshData.solidTris.push_back(offset + int(t->idx1));
+                    meshData.solidTris.push_back(offset + int(isM2 ? t->idx0 : t->idx2));
+                }
+
+                VMAP::WmoLiquid* liquid = group->GetLiquid();
+                if (m_skipLiquid || !liquid || !liquid->GetFlagsStorage())
+                    continue;
+
+                uint32 tilesX, tilesY;
+                G3D::Vector3 corner;
+                liquid->getPosInfo(tilesX, tilesY, corner);
+
+                uint8 navType = NAV_WATER;
+                switch (liquid->GetType() & 3)
+                {
+                    case 2: navType = NAV_MAGMA; break;
+                    case 3: navType = NAV_SLIME; break;
+                }
+
+                int liquidOffset = int(meshData.liquidVerts.size() / 3);
+                float const* heights = liquid->GetHeightStorage();
+                for (uint32 y = 0; y <= tilesY; ++y)
+                {
+                    for (uint32 x = 0; x <= tilesX; ++x)
+                    {
+                        G3D::Vector3 v(corner.x + x * LIQUID_TILE_SIZE, corner.y + y * LIQUID_TILE_SIZE, heights[x + y * (tilesX + 1)]);
+                        G3D::Vector3 pos = rotation * (v * instance.iScale) + instance.iPos;
+                        addVertex(meshData.liquidVerts, mid - pos.x, mid - pos.y, pos.z);
+                    }
+                }
+
+                uint8 const* flags = liquid->GetFlagsStorage();
+                for (uint32 y = 0; y < tilesY; ++y)
+                {
+                    for (uint32 x = 0; x < tilesX; ++x)
+                    {
+                        // same check as WmoLiquid::GetLiquidHeight
+                        if ((flags[x + y * tilesX] & 0x0F) == 0x0F)
+                            continue;
+
+                        int i00 = liquidOffset + int(x + y * (tilesX + 1));
+                        int i10 = i00 + 1;
+                        int i01 = i00 + int(tilesX + 1);
+                        int i11 = i01 + 1;
+
+                        addUpTriangle(meshData.liquidVerts, meshData.liquidTris, i00, i10, i11);
+                        addUpTriangle(meshData.liquidVerts, meshData.liquidTris, i00, i11, i01);
+                        meshData.liquidType.push_back(navType);
+                        meshData.liquidType.push_back(navType);
+                    }
+                }
+            }
+        }
+
+        return loaded;
+    }
+
+    void TerrainBuilder::unloadVMap(uint32 mapId, uint32 gx, uint32 gy)
+    {
+        m_vmapManager->unloadMap(mapId, gx, gy);
+    }
+}
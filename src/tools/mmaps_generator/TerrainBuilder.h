@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MMAP_TERRAIN_BUILDER_H
+#define _MMAP_TERRAIN_BUILDER_H
+
+#include "PathCommon.h"
+
+namespace VMAP
+{
+    class VMapManager2;
+}
+
+namespace MMAP
+{
+    // Collects the geometry of one tile: the heights and liquids of the .map files and the
+    // models of the .vmtile. Every worker thread owns one, VMapManager2 is not thread safe.
+    class TerrainBuilder
+    {
+        public:
+            TerrainBuilder(bool skipLiquid);
+            ~TerrainBuilder();
+
+            // terrain of the tile and the border of its neighbours that recast needs to
+            // connect the tiles, margin is in yards around the tile
+            bool loadMap(uint32 mapId, uint32 gx, uint32 gy, float margin, MeshData &meshData);
+            bool loadVMap(uint32 mapId, uint32 gx, uint32 gy, MeshData &meshData);
+            void unloadVMap(uint32 mapId, uint32 gx, uint32 gy);
+
+            bool usesLiquids() const { return !m_skipLiquid; }
+
+        private:
+            bool loadGridMap(uint32 mapId, uint32 gx, uint32 gy, float const* bmin, float const* bmax, MeshData &meshData);
+
+            bool m_skipLiquid;
+            VMAP::VMapManager2* m_vmapManager;
+    };
+
+    // recast bounds (y, z, x) of a grid, the height range is left open
+    void getGridBounds(uint32 gx, uint32 gy, float* bmin, float* bmax);
+}
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2010-2012 Project SkyFire <http://www.projectskyfire.org/>
+ * Copyright (C) 2010-2012 Oregon <http://www.oregoncore.com/>
+ * Copyright (C) 2008-2012 TrinityCore <http://www.trinitycore.org/>
+ * Copyright (C) 2005-2012 MaNGOS <http://getmangos.com/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VMapManager2.h"
+#include "BoundingIntervalHierarchy.h"
+#include "Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace VMAP;
+
+#define GRID_SIZE       533.33333f
+#define MAX_GRIDS       64
+// rays per isInLineOfSight call of the batched run
+#define BATCH_SIZE      8
+
+void Usage(char* prg)
+{
+    printf(
+        "Usage:\n"\
+        "%s recordFile [--option value]\n"\
+        "recordFile      line of sight queries recorded by the worldserver (vmap.losRecordFile)\n"\
+        "--vmaps dir     vmaps directory, vmaps by default\n"\
+        "--loops n       number of times the queries are replayed, 10 by default\n"\
+        "Example: %s los.bin --loops 50\n", prg, prg);
+    exit(1);
+}
+
+bool ReadRecords(char const* fileName, std::vector<LineOfSightRecord>& records)
+{
+    FILE* file = fopen(fileName, "rb");
+    if (!file)
+    {
+        printf("Can not open %s\n", fileName);
+        return false;
+    }
+
+    char magic[4];
+    uint32 version;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, LOS_RECORD_MAGIC, 4) || fread(&version, sizeof(uint32), 1, file) != 1 || version != LOS_RECORD_VERSION)
+    {
+        printf("%s is not a line of sight record of this version\n", fileName);
+        fclose(file);
+        return false;
+    }
+
+    LineOfSightRecord record;
+    while (fread(&record, sizeof(LineOfSightRecord), 1, file) == 1)
+        records.push_back(record);
+    fclose(file);
+    return true;
+}
+
+void AddGrid(std::set<std::pair<uint32, uint32> >& grids, uint32 mapId, float x, float y)
+{
+    int gx = int(MAX_GRIDS / 2 - x / GRID_SIZE);
+    int gy = int(MAX_GRIDS / 2 - y / GRID_SIZE);
+    if (gx >= 0 && gy >= 0 && gx < MAX_GRIDS && gy < MAX_GRIDS)
+        grids.insert(std::make_pair(mapId, uint32(gx * MAX_GRIDS + gy)));
+}
+
+// runs all queries one by one and returns the time in ms
+uint32 RunSingle(VMapManager2& manager, std::vector<LineOfSightRecord> const& records, uint32 loops, std::vector<uint8>& results)
+{
+    uint32 startTime = getMSTime();
+    for (uint32 loop = 0; loop < loops; ++loop)
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            LineOfSightRecord const& r = records[i];
+            results[i] = manager.isInLineOfSight(r.mapId, r.x1, r.y1, r.z1, r.x2, r.y2, r.z2) ? 1 : 0;
+        }
+    return GetMSTimeDiffToNow(startTime);
+}
+
+// runs the queries in batches of following queries on the same map
+uint32 RunBatched(VMapManager2& manager, std::vector<LineOfSightRecord> const& records, uint32 loops, std::vector<uint8>& results)
+{
+    LineOfSightRay rays[BATCH_SIZE];
+    uint32 startTime = getMSTime();
+    for (uint32 loop = 0; loop < loops; ++loop)
+    {
+        size_t i = 0;
+        while (i < records.size())
+        {
+            uint32 count = 0;
+            uint32 mapId = records[i].mapId;
+            while (count < BATCH_SIZE && i + count < records.size() && records[i + count].mapId == mapId)
+            {
+                LineOfSightRecord const& r = records[i + count];
+                LineOfSightRay& ray = rays[count++];
+                ray.x1 = r.x1; ray.y1 = r.y1; ray.z1 = r.z1;
+                ray.x2 = r.x2; ray.y2 = r.y2; ray.z2 = r.z2;
+            }
+            manager.isInLineOfSight(mapId, rays, count);
+            for (uint32 k = 0; k < count; ++k)
+                results[i + k] = rays[k].result ? 1 : 0;
+            i += count;
+        }
+    }
+    return GetMSTimeDiffToNow(startTime);
+}
+
+void PrintResult(char const* name, uint32 time, size_t queries, std::vector<uint8> const& results, std::vector<uint8> const& reference)
+{
+    uint32 mismatches = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+        if (results[i] != reference[i])
+            ++mismatches;
+    printf("%-16s %6u ms %8.1f ns/query, %u results differ from scalar\n", name, time, queries ? time * 1000000.0 / queries : 0.0, mismatches);
+}
+
+int main(int argc, char* argv[])
+{
+    char const* recordFile = NULL;
+    std::string vmapsDir = "vmaps";
+    uint32 loops = 10;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--vmaps") && hasValue)
+            vmapsDir = argv[++i];
+        else if (!strcmp(argv[i], "--loops") && hasValue)
+        {
+            int value = atoi(argv[++i]);
+            if (value <= 0)
+                Usage(argv[0]);
+            loops = uint32(value);
+        }
+        else if (argv[i][0] != '-' && !recordFile)
+            recordFile = argv[i];
+        else
+            Usage(argv[0]);
+    }
+
+    if (!recordFile)
+        Usage(argv[0]);
+
+    std::vector<LineOfSightRecord> records;
+    if (!ReadRecords(recordFile, records))
+        return 1;
+    if (records.empty())
+    {
+        printf("%s has no queries\n", recordFile);
+        return 1;
+    }
+
+    // load the tiles the queries start and end in, like the grids of the maps in the worldserver
+    std::set<std::pair<uint32, uint32> > grids;
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        AddGrid(grids, records[i].mapId, records[i].x1, records[i].y1);
+        AddGrid(grids, records[i].mapId, records[i].x2, records[i].y2);
+    }
+
+    VMapManager2 manager;
+    uint32 loaded = 0;
+    for (std::set<std::pair<uint32, uint32> >::const_iterator itr = grids.begin(); itr != grids.end(); ++itr)
+        if (manager.loadMap(vmapsDir.c_str(), itr->first, itr->second / MAX_GRIDS, itr->second % MAX_GRIDS) == VMAP_LOAD_RESULT_OK)
+            ++loaded;
+    printf("%u queries, loaded %u of %u vmap tiles\n", uint32(records.size()), loaded, uint32(grids.size()));
+
+    size_t queries = records.size() * loops;
+    std::vector<uint8> reference(records.size()), results(records.size());
+
+    setRaySimdEnabled(false);
+    uint32 time = RunSingle(manager, records, loops, reference);
+    PrintResult("scalar", time, queries, reference, reference);
+
+    setRaySimdEnabled(true);
+    time = RunSingle(manager, records, loops, results);
+    PrintResult("simd", time, queries, results, reference);
+
+    time = RunBatched(manager, records, loops, results);
+    PrintResult("simd batched", time, queries, results, reference);
+
+#ifndef BIH_SSE2
+    printf("This build has no SSE2 support, simd runs the scalar code.\n");
+#endif
+    return 0;
+}